@@ -0,0 +1,386 @@
+#define _GNU_SOURCE
+/* Parser and collector microbenchmarks over captured /proc and cgroup fixtures.
+ *
+ *   bench_parsers [fixtures_dir] [out.json]
+ *
+ * Each benchmark is one call the way the monitors make it (open, parse, close)
+ * against a fixture file, repeated for at least BENCH_MIN_MS (default 200 ms).
+ * Reported per call: ns, heap allocations (malloc is interposed below) and
+ * syscalls (raw_syscalls:sys_enter perf tracepoint; null when tracefs or
+ * perf_event_open is unavailable). Large-host fixtures (10k interfaces, 200k
+ * sockets, 1024 disks) are generated into a temp directory; /proc/stat has
+ * none, as read_cpu_stats stops after the aggregate line.
+ * Readers bound to fixed /proc paths run with the fixture set as the root
+ * (see sysroot.h).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <linux/perf_event.h>
+#include "../include/monitors.h"
+#include "../include/process_monitor.h"
+#include "../include/resource_profiler.h"
+#include "../include/cgroup_v2.h"
+#include "../include/namespace_census.h"
+#include "../include/process_tree.h"
+#include "../include/sysroot.h"
+#include "../include/utils.h"
+
+/* Allocation counting: every malloc-family call in the process lands here */
+extern void *__libc_malloc(size_t n);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *p, size_t n);
+
+static unsigned long long alloc_count;
+
+void *malloc(size_t n) {
+    alloc_count++;
+    return __libc_malloc(n);
+}
+
+void *calloc(size_t n, size_t size) {
+    alloc_count++;
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *p, size_t n) {
+    alloc_count++;
+    return __libc_realloc(p, n);
+}
+
+/* Syscall counting through the sys_enter tracepoint on this thread */
+static int syscall_fd = -1;
+
+static void syscall_counter_open(void) {
+    static const char *const ids[] = {
+        "/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+        "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id",
+    };
+    for (size_t i = 0; i < sizeof(ids) / sizeof(ids[0]) && syscall_fd < 0; ++i) {
+        FILE *f = fopen(ids[i], "r");
+        if (!f) continue;
+        unsigned long long id = 0;
+        int ok = fscanf(f, "%llu", &id) == 1;
+        fclose(f);
+        if (!ok) continue;
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_TRACEPOINT;
+        attr.config = id;
+        attr.disabled = 1;
+        syscall_fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+    }
+}
+
+typedef struct {
+    const char *name;
+    const char *fixture;        /* relative to its fixture root */
+    int large;                  /* generated fixture */
+    int rooted;                 /* fixture root installed with sysroot_set */
+    int (*fn)(const char *path, const void *arg);
+    const void *arg;
+} Bench;
+
+typedef struct {
+    long long iterations;
+    double ns_per_op;
+    double allocs_per_op;
+    double syscalls_per_op;     /* < 0 when not counted */
+    long long bytes;
+    int failed;
+} BenchResult;
+
+static int b_cpu(const char *path, const void *arg) {
+    (void)arg;
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+    CPUStats s;
+    int rc = parse_cpu_stats(fp, &s);
+    fclose(fp);
+    return rc;
+}
+
+static int b_memory(const char *path, const void *arg) {
+    (void)arg;
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+    MemoryStats s;
+    int rc = parse_memory_stats(fp, &s);
+    fclose(fp);
+    return rc;
+}
+
+static int b_io(const char *path, const void *arg) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+    IOStats s;
+    memset(&s, 0, sizeof(s));
+    int rc = parse_io_stats(fp, arg, &s);
+    fclose(fp);
+    return rc;
+}
+
+static int b_network(const char *path, const void *arg) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+    NetworkStats s;
+    memset(&s, 0, sizeof(s));
+    int rc = parse_network_stats(fp, arg, &s);
+    fclose(fp);
+    return rc;
+}
+
+/* The single-PID entry point, through the fixture root */
+static int b_process_stat(const char *path, const void *arg) {
+    (void)path;
+    (void)arg;
+    ProcessStats s;
+    return read_process_stats(4242, &s);
+}
+
+static int b_sockets(const char *path, const void *arg) {
+    (void)arg;
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+    int n = rp_count_sockets(fp);
+    fclose(fp);
+    return n >= 0 ? 0 : -1;
+}
+
+/* cgroup_get_* take an absolute cgroup path as the name */
+static int b_cgroup_cpu(const char *path, const void *arg) {
+    (void)arg;
+    unsigned long long v;
+    return cgroup_get_cpu_usage(path, &v);
+}
+
+static int b_cgroup_memory(const char *path, const void *arg) {
+    (void)arg;
+    unsigned long v;
+    return cgroup_get_memory_usage(path, &v);
+}
+
+static int b_cgroup_io(const char *path, const void *arg) {
+    (void)arg;
+    unsigned long long r, w;
+    return cgroup_get_io_stats(path, &r, &w);
+}
+
+/* The seven ns/ links of one task, relative to an open proc directory */
+static int b_ns_links(const char *path, const void *arg) {
+    (void)arg;
+    int procfd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (procfd < 0) return -1;
+    ino_t ino[NS_TYPE_COUNT];
+    int n = namespace_read_inodes(procfd, 4242, ino);
+    close(procfd);
+    return n == NS_TYPE_COUNT ? 0 : -1;
+}
+
+/* Whole-table walk as rp --tree does it each sample */
+static ProcessTree tree;
+
+static int b_process_tree(const char *path, const void *arg) {
+    (void)path;
+    (void)arg;
+    return process_tree_refresh(&tree) > 0 ? 0 : -1;
+}
+
+static int b_process_batch(const char *path, const void *arg) {
+    (void)path;
+    (void)arg;
+    static const pid_t pids[1] = { 4242 };
+    ProcessStatsContext ctx = { 1 << 20, 4096, 100 };
+    ProcessStats out[1];
+    return read_process_stats_batch(&ctx, pids, 1, out, NULL) == 1 ? 0 : -1;
+}
+
+static const Bench benches[] = {
+    { "read_cpu_stats", "proc/stat", 0, 0, b_cpu, NULL },
+    { "read_memory_stats", "proc/meminfo", 0, 0, b_memory, NULL },
+    { "read_io_stats", "proc/diskstats", 0, 0, b_io, "vda" },
+    { "read_io_stats", "proc/diskstats", 1, 0, b_io, "nvme1023n1" },
+    { "read_network_stats", "proc/net/dev", 0, 0, b_network, "eth0" },
+    { "read_network_stats", "proc/net/dev", 1, 0, b_network, "veth9999" },
+    { "read_process_stats", "proc", 0, 1, b_process_stat, NULL },
+    { "rp_count_sockets", "proc/net/tcp", 0, 0, b_sockets, NULL },
+    { "rp_count_sockets", "proc/net/tcp", 1, 0, b_sockets, NULL },
+    { "cgroup_get_cpu_usage", "cgroup/app", 0, 0, b_cgroup_cpu, NULL },
+    { "cgroup_get_memory_usage", "cgroup/app", 0, 0, b_cgroup_memory, NULL },
+    { "cgroup_get_io_stats", "cgroup/app", 0, 0, b_cgroup_io, NULL },
+    { "namespace_read_inodes", "proc", 0, 0, b_ns_links, NULL },
+    { "read_process_stats_batch", "proc", 0, 1, b_process_batch, NULL },
+    { "process_tree_refresh", "proc", 0, 1, b_process_tree, NULL },
+};
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static long long path_bytes(const char *path) {
+    struct stat st;
+    if (stat(path, &st) != 0) return 0;
+    if (!S_ISDIR(st.st_mode)) return (long long)st.st_size;
+    return 0;
+}
+
+static void run_bench(const Bench *b, const char *path, double min_ns, BenchResult *r) {
+    memset(r, 0, sizeof(*r));
+    r->syscalls_per_op = -1.0;
+    r->bytes = path_bytes(path);
+    if (b->fn(path, b->arg) != 0) {
+        r->failed = 1;
+        return;
+    }
+    /* Calibrate a batch size that takes about 1/20 of the budget */
+    long long batch = 1;
+    for (;;) {
+        double t0 = now_ns();
+        for (long long i = 0; i < batch; ++i) b->fn(path, b->arg);
+        if (now_ns() - t0 >= min_ns / 20 || batch >= (1LL << 30)) break;
+        batch *= 2;
+    }
+
+    unsigned long long a0 = alloc_count;
+    if (syscall_fd >= 0) {
+        ioctl(syscall_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(syscall_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    double t0 = now_ns(), elapsed = 0.0;
+    long long n = 0;
+    do {
+        for (long long i = 0; i < batch; ++i) b->fn(path, b->arg);
+        n += batch;
+        elapsed = now_ns() - t0;
+    } while (elapsed < min_ns || n < 5);
+    if (syscall_fd >= 0) {
+        ioctl(syscall_fd, PERF_EVENT_IOC_DISABLE, 0);
+        unsigned long long count = 0;
+        /* The DISABLE ioctl itself entered the kernel while counting */
+        if (read(syscall_fd, &count, sizeof(count)) == (ssize_t)sizeof(count) && count > 0) {
+            r->syscalls_per_op = (double)(count - 1) / (double)n;
+        }
+    }
+    r->iterations = n;
+    r->ns_per_op = elapsed / (double)n;
+    r->allocs_per_op = (double)(alloc_count - a0) / (double)n;
+}
+
+/* Large-host fixtures, written once per run */
+static int write_file(const char *dir, const char *rel, void (*gen)(FILE *)) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, rel);
+    for (char *p = path + strlen(dir) + 1; (p = strchr(p, '/')) != NULL; ++p) {
+        *p = '\0';
+        mkdir(path, 0755);
+        *p = '/';
+    }
+    FILE *f = fopen(path, "w");
+    if (!f) return -1;
+    gen(f);
+    return fclose(f);
+}
+
+static void gen_net_dev_10k(FILE *f) {
+    fprintf(f, "Inter-|   Receive                                                |  Transmit\n");
+    fprintf(f, " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed\n");
+    fprintf(f, "    lo: 79551441    7825    0    0    0     0          0         0 79551441    7825    0    0    0     0       0          0\n");
+    for (int i = 0; i < 10000; ++i) {
+        fprintf(f, "veth%d: %llu %d 0 0 0 0 0 0 %llu %d 0 0 0 0 0 0\n", i, 1000000ULL + i * 977ULL, 7000 + i,
+                2000000ULL + i * 1531ULL, 9000 + i);
+    }
+}
+
+static void gen_tcp_200k(FILE *f) {
+    fprintf(f, "  sl  local_address rem_address   st tx_queue rx_queue tr tm->when retrnsmt   uid  timeout inode\n");
+    for (int i = 0; i < 200000; ++i) {
+        fprintf(f, "%4d: 0100007F:%04X 0A00020F:%04X 01 00000000:00000000 00:00000000 00000000  1000        0 %d 1 "
+                   "0000000000000000 20 4 30 10 -1\n", i, 1024 + i % 60000, 443, 100000 + i);
+    }
+}
+
+static void gen_diskstats_1024(FILE *f) {
+    for (int i = 0; i < 1024; ++i) {
+        fprintf(f, " 259 %7d nvme%dn1 32322 5067 1883258 7003 4262 4702 151232 2162 0 2880 9376 1371 0 58064 208 80 2\n",
+                i, i);
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *fixtures = argc > 1 ? argv[1] : "bench/fixtures";
+    const char *out_path = argc > 2 ? argv[2] : NULL;
+    const char *env = getenv("BENCH_MIN_MS");
+    double min_ns = (env && atoi(env) > 0 ? atoi(env) : 200) * 1e6;
+
+    char absfix[512];
+    if (!realpath(fixtures, absfix)) {
+        fprintf(stderr, "bench: fixtures %s: %s\n", fixtures, strerror(errno));
+        return 1;
+    }
+    char large[] = "/tmp/bench-fixtures-XXXXXX";
+    if (!mkdtemp(large) || write_file(large, "proc/net/dev", gen_net_dev_10k) != 0 ||
+        write_file(large, "proc/net/tcp", gen_tcp_200k) != 0 ||
+        write_file(large, "proc/diskstats", gen_diskstats_1024) != 0) {
+        fprintf(stderr, "bench: cannot write large fixtures: %s\n", strerror(errno));
+        return 1;
+    }
+    if (process_tree_init(&tree) != 0) return 1;
+    syscall_counter_open();
+    if (syscall_fd < 0) fprintf(stderr, "bench: syscall tracepoint unavailable, syscalls_per_op is null\n");
+
+    FILE *out = stdout;
+    if (out_path && !(out = fopen(out_path, "w"))) {
+        perror("fopen");
+        return 1;
+    }
+    struct utsname u;
+    fprintf(out, "{\n  \"kernel\": \"%s\",\n  \"fixtures\": \"%s\",\n  \"min_ms\": %.0f,\n  \"benchmarks\": [\n",
+            uname(&u) == 0 ? u.release : "unknown", fixtures, min_ns / 1e6);
+    int n = (int)(sizeof(benches) / sizeof(benches[0])), failed = 0;
+    for (int i = 0; i < n; ++i) {
+        const Bench *b = &benches[i];
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s", b->large ? large : absfix, b->fixture);
+        BenchResult r;
+        sysroot_set(b->rooted ? (b->large ? large : absfix) : NULL);
+        run_bench(b, path, min_ns, &r);
+        char fixture[128];
+        snprintf(fixture, sizeof(fixture), "%s%s", b->large ? "large:" : "", b->fixture);
+        fprintf(stderr, "  %-26s %-22s %12.0f ns/op %6.1f allocs/op\n", b->name, fixture, r.ns_per_op,
+                r.allocs_per_op);
+        fprintf(out, "    {\"name\": \"%s\", \"fixture\": \"%s\", \"bytes\": %lld, ", b->name, fixture, r.bytes);
+        if (r.failed) {
+            fprintf(out, "\"error\": \"parse failed\"}");
+            failed = 1;
+        } else {
+            fprintf(out, "\"iterations\": %lld, \"ns_per_op\": %.1f, \"allocs_per_op\": %.2f, \"syscalls_per_op\": ",
+                    r.iterations, r.ns_per_op, r.allocs_per_op);
+            if (r.syscalls_per_op >= 0) fprintf(out, "%.2f}", r.syscalls_per_op);
+            else fprintf(out, "null}");
+        }
+        fprintf(out, "%s\n", i + 1 < n ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+    process_tree_free(&tree);
+    if (out_path) fclose(out);
+
+    const char *rel[] = { "proc/net/dev", "proc/net/tcp", "proc/diskstats", "proc/net", "proc" };
+    for (size_t i = 0; i < sizeof(rel) / sizeof(rel[0]); ++i) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", large, rel[i]);
+        if (unlink(path) != 0) rmdir(path);
+    }
+    rmdir(large);
+    return failed;
+}
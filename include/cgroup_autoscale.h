@@ -0,0 +1,116 @@
+#ifndef CGROUP_AUTOSCALE_H
+#define CGROUP_AUTOSCALE_H
+
+#include <stdio.h>
+#include "cgroup_handle.h"
+
+/* A cgroup under control and the range its limits may move in */
+typedef struct {
+    char cgroup[256];               /* relative to the root */
+    int cpu;                        /* cpu.max is managed */
+    long long cpu_min_usec;         /* quota bounds, per period */
+    long long cpu_max_usec;
+    int mem;                        /* memory.high is managed */
+    unsigned long long mem_min;     /* memory.high bounds, bytes */
+    unsigned long long mem_max;
+} CgroupAutoscaleTarget;
+
+/* Feedback rule. Limits move by a bounded factor per step and each resource
+ * then holds for cooldown_ticks, so one noisy tick cannot swing a limit far. */
+typedef struct {
+    double throttle_hi;             /* raise the quota above this throttled/periods ratio */
+    double throttle_lo;             /* ... and allow lowering it only below this one */
+    double cpu_psi_hi;              /* cpu.pressure some avg10 (%) that also raises the quota */
+    double cpu_util_lo;             /* lower the quota when usage/quota stays below this */
+    double mem_psi_hi;              /* memory.pressure some avg10 (%) that raises memory.high */
+    double mem_psi_lo;              /* lower memory.high only below this pressure ... */
+    double mem_headroom;            /* ... and keep it >= memory.current * mem_headroom */
+    double step_up;                 /* multiplicative step when raising (> 1) */
+    double step_down;               /* multiplicative step when lowering (< 1) */
+    int cooldown_ticks;
+} CgroupAutoscalePolicy;
+
+/* Metrics of one tick for one cgroup */
+typedef struct {
+    int has_cpu;                    /* a cpu.stat delta is available */
+    double throttle_ratio;          /* d nr_throttled / d nr_periods */
+    double cpu_util;                /* d usage / (d nr_periods * quota) */
+    double cpu_some_avg10;
+    int has_mem;
+    double mem_some_avg10;
+    double mem_full_avg10;
+    unsigned long long memory_current;
+} CgroupAutoscaleInput;
+
+/* Current limits and cooldowns, carried between ticks */
+typedef struct {
+    long long quota_usec;           /* -1 = "max" */
+    long long period_usec;
+    unsigned long long mem_high;    /* ULLONG_MAX = "max" */
+    int cpu_cooldown;
+    int mem_cooldown;
+} CgroupAutoscaleState;
+
+typedef struct {
+    const char *cpu_reason;         /* NULL when nothing happened for the CPU */
+    int cpu_change;
+    long long new_quota_usec;
+    const char *mem_reason;
+    int mem_change;
+    unsigned long long new_mem_high;
+} CgroupAutoscaleDecision;
+
+void cgroup_autoscale_policy_default(CgroupAutoscalePolicy *p);
+
+/* The control rule, without I/O: decide from one tick of metrics and update
+ * the cooldowns in st (limits in st are updated by the caller once written). */
+void cgroup_autoscale_decide(const CgroupAutoscalePolicy *p, const CgroupAutoscaleTarget *t,
+                             const CgroupAutoscaleInput *in, CgroupAutoscaleState *st,
+                             CgroupAutoscaleDecision *d);
+
+/* Parse "<cgroup> [cpu=<min>-<max>] [mem=<min>-<max>]" lines (quota in usec,
+ * memory with K/M/G suffixes). Returns targets read (*out malloc'd), -1 on error. */
+int cgroup_autoscale_load(const char *path, CgroupAutoscaleTarget **out);
+
+/* One controlled cgroup: its held handle, limits and last cpu.stat */
+typedef struct {
+    CgroupAutoscaleTarget target;
+    CgroupHandle h;
+    CgroupAutoscaleState st;
+    int have_prev;
+    unsigned long long prev_usage;
+    unsigned long long prev_periods;
+    unsigned long long prev_throttled;
+} CgroupAutoscaleCgroup;
+
+typedef struct {
+    CgroupAutoscalePolicy policy;
+    CgroupAutoscaleCgroup *cg;
+    int count;
+    int dry_run;
+    FILE *log;
+    long long ticks;
+    int changes;
+} CgroupAutoscaler;
+
+/* Open every target (relative to root, NULL = /sys/fs/cgroup). Targets that
+ * cannot be opened are reported and dropped. Returns 0, -1 if none is left. */
+int cgroup_autoscale_init(CgroupAutoscaler *a, const char *root, const CgroupAutoscaleTarget *targets,
+                          int n, const CgroupAutoscalePolicy *p, int dry_run, FILE *log);
+void cgroup_autoscale_free(CgroupAutoscaler *a);
+
+/* One control step: read cpu.stat, cpu.pressure, memory.pressure, memory.current,
+ * cpu.max and memory.high of each cgroup through its handle, decide, and write
+ * cpu.max / memory.high (unless dry_run). The first tick only has memory input,
+ * CPU decisions need a cpu.stat delta. Every decision is logged as one CSV row:
+ * timestamp_ms,cgroup,resource,old,new,reason,throttle_ratio,cpu_util,cpu_some_avg10,
+ * mem_some_avg10,memory_current
+ * Returns the number of limits written (or that would be, on a dry run). */
+int cgroup_autoscale_tick(CgroupAutoscaler *a);
+
+/* CLI: load a targets file and tick every interval_ms (ticks <= 0: until killed),
+ * logging to output_file or stdout */
+int cgroup_autoscale(const char *targets_file, const char *root, int interval_ms, int ticks,
+                     int dry_run, const char *output_file);
+
+#endif // CGROUP_AUTOSCALE_H
@@ -0,0 +1,54 @@
+#ifndef CGROUP_BACKEND_H
+#define CGROUP_BACKEND_H
+
+#include "cgroup_sampler.h"
+
+typedef enum {
+    CG_MODE_NONE = 0,
+    CG_MODE_V1,         /* only v1 controller mounts */
+    CG_MODE_V2,         /* unified hierarchy only */
+    CG_MODE_HYBRID      /* v1 controllers plus a cgroup2 mount (systemd "hybrid") */
+} CgroupMode;
+
+/* v1 controllers the sampler reads; they are also its hierarchy indexes */
+typedef enum {
+    CG_V1_CPU = 0,
+    CG_V1_CPUACCT,
+    CG_V1_MEMORY,
+    CG_V1_BLKIO,
+    CG_V1_COUNT
+} CgroupV1Controller;
+
+typedef struct {
+    CgroupMode mode;
+    char v2[256];                       /* cgroup2 mount point, "" if none */
+    char v1[CG_V1_COUNT][256];          /* mount point per v1 controller, "" if not mounted */
+} CgroupMounts;
+
+const char *cgroup_mode_name(CgroupMode mode);
+
+/* Parse the text of /proc/<pid>/mountinfo. Returns 0, -1 if no cgroup mount was found. */
+int cgroup_mounts_parse(const char *mountinfo, CgroupMounts *out);
+/* Mounts of this process, read from /proc/self/mountinfo on first use */
+const CgroupMounts *cgroup_mounts(void);
+
+/* Unified hierarchy rooted at root: one file per metric group */
+void cgroup_backend_v2(CgroupBackend *b, const char *root);
+/* v1 controller mounts, sampled from relpath ("" = mount root) in each of them:
+ *   cpuacct.usage, cpuacct.stat       -> usage_usec, user_usec, system_usec
+ *   cpu.stat                          -> nr_periods, nr_throttled, throttled_usec
+ *   memory.usage_in_bytes             -> memory_current
+ *   memory.stat (total_* keys)        -> memstat[], mem_anon/file/shmem
+ *   blkio.throttle.io_service_bytes / io_serviced (the _recursive variants
+ *   when the kernel has them)         -> io_rbytes, io_wbytes, io_rios, io_wios
+ * v1 has no pressure files. The walked tree is the memory hierarchy's (or the
+ * first mounted one). Returns 0, -1 if none of the controllers is mounted. */
+int cgroup_backend_v1(CgroupBackend *b, const CgroupMounts *m, const char *relpath);
+
+/* Backend for a sampler root. NULL picks the host default: the unified
+ * hierarchy when it has the cpu or memory controller, else the v1 mounts.
+ * A path inside a v1 controller mount samples that subtree across all v1
+ * controllers; any other path is read as v2. Returns 0, or -1. */
+int cgroup_backend_resolve(CgroupBackend *b, const char *root);
+
+#endif // CGROUP_BACKEND_H
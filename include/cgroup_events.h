@@ -0,0 +1,79 @@
+#ifndef CGROUP_EVENTS_H
+#define CGROUP_EVENTS_H
+
+#include <stdio.h>
+
+/* Event files the kernel flags as modified (inotify IN_MODIFY) when a counter changes */
+typedef enum {
+    CG_EVENTS_MEMORY = 0,   /* memory.events: low, high, max, oom, oom_kill, oom_group_kill */
+    CG_EVENTS_CGROUP,       /* cgroup.events: populated, frozen */
+    CG_EVENTS_PIDS,         /* pids.events: max */
+    CG_EVENTS_FILE_COUNT
+} CgroupEventsFile;
+
+#define CG_EVENTS_MAX_KEYS 8
+
+typedef struct {
+    char key[24];
+    unsigned long long value;
+} CgroupEventCounter;
+
+/* One watched events file of one cgroup, with the counters last seen */
+typedef struct {
+    int wd;
+    int fd;
+    int group;
+    CgroupEventsFile kind;
+    int nkeys;
+    CgroupEventCounter keys[CG_EVENTS_MAX_KEYS];
+} CgroupEventsWatch;
+
+typedef struct {
+    char *path;     /* relative to the root, "" for the root */
+    int dir_wd;     /* watch on the directory itself, for new child cgroups */
+} CgroupEventsGroup;
+
+/* A counter change reported to the callback */
+typedef struct {
+    long long timestamp_ms;
+    const char *cgroup;     /* relative path, "" for the root */
+    const char *source;     /* "memory", "cgroup", "pids" */
+    const char *event;      /* key in the events file, e.g. "oom_kill", "populated" */
+    unsigned long long value;
+    long long delta;        /* change since the last read; -1/+1 for populated/frozen */
+} CgroupEvent;
+
+typedef void (*cgroup_event_cb)(const CgroupEvent *ev, void *ctx);
+
+/* Watches every cgroup under root through one inotify descriptor. Idle cost is a
+ * blocked poll(); counters are read only when the kernel flags a file modified.
+ */
+typedef struct {
+    char root[512];
+    int inotify_fd;
+    CgroupEventsGroup *groups;
+    int ngroups;
+    int groups_cap;
+    CgroupEventsWatch *watches;
+    int nwatches;
+    int watches_cap;
+    int *wd_map;    /* wd -> watch index + 1, or -(group index + 1) for directory watches */
+    int wd_map_len;
+} CgroupWatcher;
+
+/* root NULL = /sys/fs/cgroup. Reads the current counters as the baseline (no events). */
+int cgroup_watcher_init(CgroupWatcher *w, const char *root);
+void cgroup_watcher_free(CgroupWatcher *w);
+
+/* Wait up to timeout_ms (-1 = forever) and report every counter that changed.
+ * Returns the number of events reported, 0 on timeout, -1 on error. */
+int cgroup_watcher_poll(CgroupWatcher *w, int timeout_ms, cgroup_event_cb cb, void *ctx);
+
+/* Parse "key value" lines. Returns the number of counters written. */
+int cgroup_events_parse(const char *buf, CgroupEventCounter *out, int max);
+
+/* CLI: stream events as CSV (timestamp_ms,cgroup,source,event,value,delta) for duration_s
+ * seconds (0 = until interrupted). Writes to stdout when output_file is NULL. */
+int cgroup_watch_events(const char *root, int duration_s, const char *output_file);
+
+#endif // CGROUP_EVENTS_H
@@ -0,0 +1,70 @@
+#ifndef CGROUP_HANDLE_H
+#define CGROUP_HANDLE_H
+
+#include <stdatomic.h>
+#include <sys/types.h>
+
+/* Attribute files reachable through a handle */
+typedef enum {
+    CG_ATTR_PROCS = 0,
+    CG_ATTR_THREADS,
+    CG_ATTR_EVENTS,
+    CG_ATTR_SUBTREE_CONTROL,
+    CG_ATTR_CPU_MAX,
+    CG_ATTR_CPU_WEIGHT,
+    CG_ATTR_CPU_STAT,
+    CG_ATTR_CPU_PRESSURE,
+    CG_ATTR_MEMORY_CURRENT,
+    CG_ATTR_MEMORY_MAX,
+    CG_ATTR_MEMORY_HIGH,
+    CG_ATTR_MEMORY_STAT,
+    CG_ATTR_MEMORY_EVENTS,
+    CG_ATTR_MEMORY_PRESSURE,
+    CG_ATTR_IO_MAX,
+    CG_ATTR_IO_STAT,
+    CG_ATTR_IO_PRESSURE,
+    CG_ATTR_PIDS_MAX,
+    CG_ATTR_PIDS_CURRENT,
+    CG_ATTR_PIDS_EVENTS,
+    CG_ATTR_CPUSET_CPUS,
+    CG_ATTR_CONTROLLERS,
+    CG_ATTR_CPU_MAX_BURST,
+    /* cgroup v1 cpu / cpuacct */
+    CG_ATTR_CPU_CFS_PERIOD,
+    CG_ATTR_CPU_CFS_QUOTA,
+    CG_ATTR_CPU_CFS_BURST,
+    CG_ATTR_CPUACCT_USAGE,
+    CG_ATTR_COUNT
+} CgroupAttr;
+
+/* An open cgroup directory. All I/O goes through openat relative to dirfd and
+ * pread/pwrite at offset 0, so no path strings are built after open and no
+ * shared buffers are involved. Attribute descriptors are opened lazily on first
+ * use and published with a compare-and-swap, so one handle may be used from
+ * several threads at once. open/close must not race with other calls.
+ */
+typedef struct {
+    int dirfd;
+    _Atomic int rfds[CG_ATTR_COUNT];   /* O_RDONLY, -1 until first read */
+    _Atomic int wfds[CG_ATTR_COUNT];   /* O_WRONLY, -1 until first write */
+} CgroupHandle;
+
+const char *cgroup_attr_name(CgroupAttr attr);
+
+/* name: relative to /sys/fs/cgroup, or an absolute path. Returns 0, or -1 with errno set. */
+int cgroup_handle_open(CgroupHandle *h, const char *name);
+/* Open relpath relative to an already open directory (e.g. a parent handle's dirfd) */
+int cgroup_handle_openat(CgroupHandle *h, int parentfd, const char *relpath);
+void cgroup_handle_close(CgroupHandle *h);
+
+/* Read the whole attribute into buf (NUL-terminated). Returns length, or -1 with errno set. */
+ssize_t cgroup_handle_read(CgroupHandle *h, CgroupAttr attr, char *buf, size_t len);
+/* Write data with a single pwrite (one kernel write = one command). Returns 0, or -1 with errno set. */
+int cgroup_handle_write(CgroupHandle *h, CgroupAttr attr, const char *data);
+
+/* Single-value file (memory.current, pids.max ...). "max" reads as ULLONG_MAX. */
+int cgroup_handle_read_ull(CgroupHandle *h, CgroupAttr attr, unsigned long long *value);
+/* One "key value" line of a flat-keyed file (cpu.stat, memory.stat, memory.events ...) */
+int cgroup_handle_read_key(CgroupHandle *h, CgroupAttr attr, const char *key, unsigned long long *value);
+
+#endif // CGROUP_HANDLE_H
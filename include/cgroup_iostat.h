@@ -0,0 +1,87 @@
+#ifndef CGROUP_IOSTAT_H
+#define CGROUP_IOSTAT_H
+
+#include <stdio.h>
+#include "cgroup_sampler.h"
+
+/* One device line of io.stat */
+typedef struct {
+    unsigned int major;
+    unsigned int minor;
+    unsigned long long rbytes;
+    unsigned long long wbytes;
+    unsigned long long rios;
+    unsigned long long wios;
+    unsigned long long dbytes;
+    unsigned long long dios;
+    /* io.cost (iocost controller): cumulative usec */
+    int has_cost;
+    unsigned long long cost_usage;
+    unsigned long long cost_wait;
+    unsigned long long cost_indebt;
+    /* io.latency: current average completion latency (usec) */
+    int has_lat;
+    unsigned long long avg_lat;
+} CgroupIoDev;
+
+/* Per-(cgroup, device) rates over the last tick */
+typedef struct {
+    int node;                    /* sampler node index */
+    unsigned int major;
+    unsigned int minor;
+    const char *device;          /* resolved name, e.g. "nvme0n1", or "M:m" */
+    double rbps;
+    double wbps;
+    double dbps;
+    double riops;
+    double wiops;
+    double cost_wait_ms_per_s;   /* -1 when io.cost is not enabled */
+    long long avg_lat_us;        /* -1 when io.latency is not enabled */
+    double io_some_avg10;        /* io.pressure of the cgroup, -1 when absent */
+    double io_full_avg10;
+} CgroupIoRate;
+
+typedef struct {
+    unsigned long long key;      /* (node << 32) | dev, 0 = empty */
+    long long tick;
+    CgroupIoDev prev;
+} CgroupIoPrev;
+
+typedef struct {
+    unsigned int dev;
+    char name[32];
+} CgroupIoDevName;
+
+/* Incremental "IO hogs by cgroup and device" tracker on top of the hierarchy sampler */
+typedef struct {
+    CgroupSampler s;
+    CgroupIoPrev *slots;         /* open addressing, power-of-two size */
+    unsigned int nslots;
+    unsigned int used;
+    CgroupIoDevName *names;
+    int nnames;
+    int names_cap;
+    CgroupIoDev *devs;           /* scratch for parsing one io.stat, grown to its line count */
+    int devs_cap;
+} CgroupIoTop;
+
+/* Parse io.stat into out[0..max). Returns devices parsed. */
+int cgroup_parse_io_stat_devices(const char *buf, CgroupIoDev *out, int max);
+
+/* Name of block device major:minor from /sys/dev/block (cached in t) */
+const char *cgroup_iotop_device_name(CgroupIoTop *t, unsigned int major, unsigned int minor);
+
+int cgroup_iotop_init(CgroupIoTop *t, const char *root);
+void cgroup_iotop_free(CgroupIoTop *t);
+
+/* Sample io.stat and io.pressure of every cgroup and keep the top entries by bytes/s.
+ * out must hold top entries. The first tick only records a baseline and returns 0.
+ * Returns the number of entries written, -1 on error. */
+int cgroup_iotop_tick(CgroupIoTop *t, int top, CgroupIoRate *out);
+
+/* CLI: top-N per tick as CSV:
+ * timestamp_ms,rank,cgroup,device,rbps,wbps,dbps,riops,wiops,io_some_avg10,io_full_avg10,cost_wait_ms_per_s,avg_lat_us
+ * Writes to stdout when output_file is NULL. */
+int cgroup_iotop_report(const char *root, int interval_ms, int samples, int top, const char *output_file);
+
+#endif // CGROUP_IOSTAT_H
@@ -0,0 +1,84 @@
+#ifndef CGROUP_LIMITS_H
+#define CGROUP_LIMITS_H
+
+#include <stdio.h>
+#include "cgroup_handle.h"
+
+/* Batch limit changes read from a limits file, one setting per line:
+ *
+ *   # cgroup      attribute    value
+ *   web/api       cpu.max      50000 100000      (or 50000/100000, or max)
+ *   web/api       cpu.weight   200
+ *   web/api       memory.high  768M              (K/M/G/T suffixes, or max)
+ *   web/api       memory.max   1G
+ *   web/api       io.max       8:0 rbps=10485760 wbps=max
+ *
+ * A batch is validated as a whole before anything is written: every value is
+ * parsed and normalized, every cgroup is opened once, and the current value of
+ * every attribute is read (which also proves the controller is enabled) so the
+ * change can be reverted. Writes then go out in parallel through the shared
+ * handles, one pwrite per entry.
+ */
+
+typedef enum {
+    CG_LIMIT_PENDING = 0,
+    CG_LIMIT_INVALID,           /* rejected by validation, nothing written */
+    CG_LIMIT_APPLIED,
+    CG_LIMIT_FAILED,            /* the write itself failed, see err */
+    CG_LIMIT_SKIPPED,           /* not attempted because the batch was aborted */
+    CG_LIMIT_ROLLED_BACK,       /* applied, then restored to the old value */
+    CG_LIMIT_ROLLBACK_FAILED    /* applied, and restoring the old value failed */
+} CgroupLimitStatus;
+
+typedef struct {
+    int line;                   /* line number in the limits file */
+    char cgroup[256];
+    CgroupAttr attr;
+    char value[128];            /* normalized value, as written */
+    char old[128];              /* value restored on rollback */
+    int handle;                 /* index into CgroupLimitBatch.handles */
+    CgroupLimitStatus status;
+    int err;                    /* errno of the failed write */
+    char msg[96];               /* why validation rejected the entry */
+} CgroupLimit;
+
+typedef struct {
+    CgroupLimit *entries;
+    int count;
+    int capacity;
+    CgroupHandle *handles;      /* one per distinct cgroup */
+    char (*handle_names)[256];
+    int nhandles;
+    int handles_cap;
+    int invalid;                /* entries rejected by parse or validate */
+    int failed;                 /* entries whose write failed */
+} CgroupLimitBatch;
+
+void cgroup_limits_init(CgroupLimitBatch *b);
+void cgroup_limits_free(CgroupLimitBatch *b);
+
+/* Parse one "cgroup attribute value" line and append it. Blank lines and
+ * comments are ignored. Syntax errors are kept as CG_LIMIT_INVALID entries so
+ * they can be reported with the rest. Returns 0, or -1 on allocation failure. */
+int cgroup_limits_add_line(CgroupLimitBatch *b, const char *line, int lineno);
+/* "max" (ULLONG_MAX) or a byte count with an optional K/M/G/T suffix. Returns 0, or -1. */
+int cgroup_limits_parse_bytes(const char *s, unsigned long long *bytes);
+/* Parse a whole limits file. Returns entries read, -1 if it cannot be read. */
+int cgroup_limits_load(CgroupLimitBatch *b, const char *path);
+
+/* Open every cgroup (relative to root, NULL = /sys/fs/cgroup) and read the
+ * values to restore. Returns the number of invalid entries (0 = ready to apply). */
+int cgroup_limits_validate(CgroupLimitBatch *b, const char *root);
+
+/* Write all entries using up to `threads` workers. A batch with invalid entries
+ * is not applied. If any write fails and rollback is set, every applied entry
+ * is restored. Returns 0 when every entry was applied, -1 otherwise. */
+int cgroup_limits_apply(CgroupLimitBatch *b, int threads, int rollback);
+
+/* One line per entry that is not CG_LIMIT_APPLIED, then a summary line */
+void cgroup_limits_print(const CgroupLimitBatch *b, FILE *out);
+
+/* CLI: load, validate and (unless dry_run) apply a limits file */
+int cgroup_apply_limits(const char *path, const char *root, int threads, int rollback, int dry_run);
+
+#endif // CGROUP_LIMITS_H
@@ -0,0 +1,92 @@
+#ifndef CGROUP_MEMSTAT_H
+#define CGROUP_MEMSTAT_H
+
+/* Fields decoded from cgroup v2 memory.stat (bytes for sizes, counts for events).
+ * Keys the running kernel does not have stay 0. */
+typedef enum {
+    CG_MEMSTAT_ANON = 0,
+    CG_MEMSTAT_FILE,
+    CG_MEMSTAT_KERNEL,
+    CG_MEMSTAT_KERNEL_STACK,
+    CG_MEMSTAT_PAGETABLES,
+    CG_MEMSTAT_PERCPU,
+    CG_MEMSTAT_SOCK,
+    CG_MEMSTAT_VMALLOC,
+    CG_MEMSTAT_SHMEM,
+    CG_MEMSTAT_ZSWAP,
+    CG_MEMSTAT_FILE_MAPPED,
+    CG_MEMSTAT_FILE_DIRTY,
+    CG_MEMSTAT_FILE_WRITEBACK,
+    CG_MEMSTAT_SWAPCACHED,
+    CG_MEMSTAT_ANON_THP,
+    CG_MEMSTAT_INACTIVE_ANON,
+    CG_MEMSTAT_ACTIVE_ANON,
+    CG_MEMSTAT_INACTIVE_FILE,
+    CG_MEMSTAT_ACTIVE_FILE,
+    CG_MEMSTAT_UNEVICTABLE,
+    CG_MEMSTAT_SLAB_RECLAIMABLE,
+    CG_MEMSTAT_SLAB_UNRECLAIMABLE,
+    CG_MEMSTAT_SLAB,
+    CG_MEMSTAT_WORKINGSET_REFAULT,          /* kernels before 5.9 */
+    CG_MEMSTAT_WORKINGSET_REFAULT_ANON,
+    CG_MEMSTAT_WORKINGSET_REFAULT_FILE,
+    CG_MEMSTAT_WORKINGSET_ACTIVATE,         /* kernels before 5.9 */
+    CG_MEMSTAT_WORKINGSET_ACTIVATE_ANON,
+    CG_MEMSTAT_WORKINGSET_ACTIVATE_FILE,
+    CG_MEMSTAT_WORKINGSET_RESTORE_ANON,
+    CG_MEMSTAT_WORKINGSET_RESTORE_FILE,
+    CG_MEMSTAT_WORKINGSET_NODERECLAIM,
+    CG_MEMSTAT_PGFAULT,
+    CG_MEMSTAT_PGMAJFAULT,
+    CG_MEMSTAT_PGREFILL,
+    CG_MEMSTAT_PGSCAN,
+    CG_MEMSTAT_PGSTEAL,
+    CG_MEMSTAT_PGACTIVATE,
+    CG_MEMSTAT_PGDEACTIVATE,
+    CG_MEMSTAT_PGLAZYFREE,
+    CG_MEMSTAT_THP_FAULT_ALLOC,
+    CG_MEMSTAT_COUNT
+} CgroupMemStatField;
+
+#define CG_MEMSTAT_MAX_LINES 160
+
+/* Line order of memory.stat is fixed for a given kernel. The layout records, for each
+ * line position, which field it holds (-1 = not decoded) plus the key length and first
+ * character as a cheap check. Parsing then needs no string compares; a mismatch (new
+ * kernel, different file) triggers one rebuild. */
+typedef struct {
+    int nlines;
+    short field[CG_MEMSTAT_MAX_LINES];
+    unsigned char klen[CG_MEMSTAT_MAX_LINES];
+    char first[CG_MEMSTAT_MAX_LINES];
+    int rebuilds;
+} CgroupMemStatLayout;
+
+/* Derived per-interval metrics for right-sizing */
+typedef struct {
+    unsigned long long working_set;  /* memory.current - inactive_file (what kubelet evicts on) */
+    double refault_per_s;            /* pages evicted and needed again: the cgroup is too small */
+    double activate_per_s;
+    double pgscan_per_s;
+    double pgsteal_per_s;
+    double reclaim_efficiency;       /* pgsteal / pgscan over the interval, 0 without scanning */
+} CgroupMemDerived;
+
+const char *cgroup_memstat_name(CgroupMemStatField field);
+
+void cgroup_memstat_layout_init(CgroupMemStatLayout *layout);
+
+/* Decode buf into values[CG_MEMSTAT_COUNT]. Returns the number of lines read, -1 on bad input. */
+int cgroup_memstat_parse(CgroupMemStatLayout *layout, const char *buf, unsigned long long *values);
+
+/* prev may be NULL (rates are then 0); elapsed_s is the time between the two samples */
+void cgroup_memstat_derive(unsigned long long memory_current, const unsigned long long *curr,
+                           const unsigned long long *prev, double elapsed_s, CgroupMemDerived *out);
+
+/* CLI: per-cgroup memory.stat breakdown, working set and refault rates under root.
+ * CSV: timestamp_ms,cgroup,memory_current,working_set,working_set_peak,anon,file,kernel,sock,shmem,
+ *      active_file,inactive_file,refault_per_s,activate_per_s,pgscan_per_s,pgsteal_per_s,reclaim_efficiency
+ * Writes to stdout when output_file is NULL. */
+int cgroup_memstat_report(const char *root, int interval_ms, int samples, const char *output_file);
+
+#endif // CGROUP_MEMSTAT_H
@@ -0,0 +1,165 @@
+#ifndef CGROUP_SAMPLER_H
+#define CGROUP_SAMPLER_H
+
+#include <stdio.h>
+#include <sys/types.h>
+#include "cgroup_memstat.h"
+
+/* Metric groups read from every cgroup on each tick. On cgroup v2 each group is
+ * one file; a backend may feed a group from several files (see CgroupBackend). */
+typedef enum {
+    CG_FILE_CPU_STAT = 0,
+    CG_FILE_MEMORY_CURRENT,
+    CG_FILE_MEMORY_STAT,
+    CG_FILE_IO_STAT,
+    CG_FILE_CPU_PRESSURE,
+    CG_FILE_MEMORY_PRESSURE,
+    CG_FILE_IO_PRESSURE,
+    CG_FILE_COUNT
+} CgroupFile;
+
+typedef struct {
+    double avg10;
+    double avg60;
+    double avg300;
+    unsigned long long total_usec;
+} CgroupPsiLine;
+
+typedef struct {
+    CgroupPsiLine some;
+    CgroupPsiLine full;
+} CgroupPsi;
+
+typedef struct {
+    unsigned int valid;                 /* bit (1 << CgroupFile) set when that file was read */
+    /* cpu.stat */
+    unsigned long long usage_usec;
+    unsigned long long user_usec;
+    unsigned long long system_usec;
+    unsigned long long nr_periods;
+    unsigned long long nr_throttled;
+    unsigned long long throttled_usec;
+    /* memory.current / memory.stat (bytes) */
+    unsigned long long memory_current;
+    unsigned long long mem_anon;
+    unsigned long long mem_file;
+    unsigned long long mem_shmem;
+    unsigned long long mem_sock;
+    unsigned long long memstat[CG_MEMSTAT_COUNT];  /* full memory.stat, see cgroup_memstat.h */
+    /* io.stat, summed over devices */
+    unsigned long long io_rbytes;
+    unsigned long long io_wbytes;
+    unsigned long long io_rios;
+    unsigned long long io_wios;
+    /* *.pressure */
+    CgroupPsi cpu_psi;
+    CgroupPsi mem_psi;
+    CgroupPsi io_psi;
+} CgroupSample;
+
+#define CG_FD_MISSING -1   /* file does not exist in this cgroup (controller not enabled) */
+#define CG_FD_REOPEN  -2   /* exists, but out of descriptors: openat() on every tick */
+
+#define CG_HIER_MAX   4    /* hierarchies one backend reads from (v1 mounts controllers separately) */
+#define CG_SOURCE_MAX 8    /* files read per cgroup */
+
+typedef struct CgroupSampler CgroupSampler;
+
+/* One file read per cgroup per tick, and the parser that maps it onto CgroupSample */
+typedef struct {
+    const char *file;
+    int hier;                   /* index into CgroupBackend.hier_root */
+    CgroupFile group;           /* valid / files_mask bit this file feeds */
+    void (*parse)(CgroupSampler *s, const char *buf, CgroupSample *out);
+} CgroupSource;
+
+/* How a hierarchy is read, chosen once at init (see cgroup_backend.h), so the
+ * tick loop just walks the source table without checking versions per read. */
+typedef struct {
+    const char *name;                   /* "v2", "v1" */
+    int version;
+    int nhier;
+    int primary;                        /* hierarchy whose directory tree is walked */
+    char hier_root[CG_HIER_MAX][512];   /* sampled root in each hierarchy, "" if not mounted */
+    int nsources;
+    CgroupSource sources[CG_SOURCE_MAX];
+} CgroupBackend;
+
+typedef struct {
+    char *path;                 /* relative to the sampler root, "" for the root itself */
+    int parent;                 /* index into nodes, -1 for the root */
+    int depth;
+    int dirfd;                  /* directory in the primary hierarchy */
+    int fds[CG_SOURCE_MAX];     /* one per backend source */
+    int alive;                  /* cleared once the directory has been removed */
+} CgroupNode;
+
+/* Walks a cgroup hierarchy once and keeps a descriptor per cgroup and file,
+ * so each tick costs one pread per file and no path lookups.
+ * Samples land in a ring of max_ticks time-aligned rows: every row holds one
+ * CgroupSample per node, taken within the same tick.
+ */
+struct CgroupSampler {
+    char root[512];
+    int rootfd;                 /* primary hierarchy root */
+    CgroupBackend backend;
+    int hier_rootfd[CG_HIER_MAX];
+    CgroupNode *nodes;
+    int count;
+    int capacity;
+
+    int max_ticks;
+    long long ticks;            /* total ticks taken; row = tick % max_ticks */
+    long long *timestamps_ms;   /* CLOCK_REALTIME per row */
+    long long *mono_us;         /* CLOCK_MONOTONIC per row, for rates */
+    CgroupSample *samples;      /* max_ticks * capacity */
+
+    char *buf;
+    size_t buf_cap;
+    CgroupMemStatLayout memstat_layout;     /* memory.stat line order, resolved on first read */
+    unsigned int files_mask;    /* (1 << CgroupFile) bits parsed by each tick, all by default */
+};
+
+/* root: hierarchy to walk (NULL = the host's cgroup root, v1 or v2 as detected
+ * from /proc/self/mountinfo). max_ticks: ring length (>= 2 for rates).
+ * Returns 0 on success, -1 if root cannot be opened. */
+int cgroup_sampler_init(CgroupSampler *s, const char *root, int max_ticks);
+/* Same, with an explicit backend (see cgroup_backend.h) */
+int cgroup_sampler_init_backend(CgroupSampler *s, const CgroupBackend *backend, int max_ticks);
+void cgroup_sampler_free(CgroupSampler *s);
+
+/* Drop all descriptors and walk the hierarchy again (picks up new cgroups; resets the series) */
+int cgroup_sampler_rescan(CgroupSampler *s);
+
+/* Read every file of every live cgroup into the next row. Returns cgroups sampled,
+ * or -1 with errno ENODEV (and no row added) once the root cgroup itself is gone. */
+int cgroup_sampler_tick(CgroupSampler *s);
+
+/* Read the first file feeding `file` for node idx through its held descriptor without
+ * parsing it (its format is the backend's). *buf points into the sampler's buffer and
+ * stays valid until the next read. Returns length or -1. */
+ssize_t cgroup_sampler_read_file(CgroupSampler *s, int idx, CgroupFile file, const char **buf);
+
+/* Sample of node idx taken `back` ticks ago (0 = latest), NULL if not in the ring */
+const CgroupSample *cgroup_sampler_get(const CgroupSampler *s, int back, int idx);
+/* Elapsed seconds between the latest tick and the one `back` ticks before it */
+double cgroup_sampler_elapsed(const CgroupSampler *s, int back);
+
+/* Parsers for the individual files (exposed for tests and other collectors) */
+void cgroup_parse_cpu_stat(const char *buf, CgroupSample *out);
+/* layout caches the line order across calls (e.g. the sampler's memstat_layout) */
+void cgroup_parse_memory_stat(CgroupMemStatLayout *layout, const char *buf, CgroupSample *out);
+void cgroup_parse_io_stat(const char *buf, CgroupSample *out);
+int cgroup_parse_pressure(const char *buf, CgroupPsi *out);
+/* Set mem_anon/file/shmem/sock from memstat[] */
+void cgroup_sample_fill_memory(CgroupSample *out);
+
+/* Sample the hierarchy under root every interval_ms and write one CSV row per cgroup per tick:
+ * timestamp_ms,cgroup,cpu_usage_usec,cpu_percent,nr_throttled,throttled_usec,memory_current,
+ * anon,file,io_rbytes,io_wbytes,io_rios,io_wios,cpu_some_avg10,mem_some_avg10,mem_full_avg10,
+ * io_some_avg10,io_full_avg10
+ * Fields of files a cgroup does not have are left empty. Writes to stdout when output_file is NULL.
+ */
+int cgroup_sample_hierarchy(const char *root, int interval_ms, int samples, const char *output_file);
+
+#endif // CGROUP_SAMPLER_H
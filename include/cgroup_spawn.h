@@ -0,0 +1,46 @@
+#ifndef CGROUP_SPAWN_H
+#define CGROUP_SPAWN_H
+
+#include <sys/types.h>
+#include "cgroup_handle.h"
+
+typedef enum {
+    CG_SPAWN_NONE = 0,
+    CG_SPAWN_CLONE3,        /* clone3(CLONE_INTO_CGROUP): born inside the cgroup */
+    CG_SPAWN_FORK_MOVE      /* fork, then the child moves itself before running anything */
+} CgroupSpawnMethod;
+
+/* Start a child that is a member of the cgroup behind h from its first
+ * instruction, so limits and accounting cover its whole lifetime and every
+ * process it forks. Uses clone3(CLONE_INTO_CGROUP) on cgroup v2 (Linux 5.7+);
+ * otherwise the child writes itself into cgroup.procs before running fn or
+ * exec, which also works for v1 hierarchies. Errors in the child (the move or
+ * exec) are reported back through a close-on-exec pipe, so a returned pid is
+ * always a child that made it into the cgroup.
+ *
+ * The child is a plain fork-style copy: in a multithreaded caller only
+ * async-signal-safe work is safe in fn. Returns the child pid, or -1 with errno set.
+ */
+pid_t cgroup_spawn_fn(CgroupHandle *h, int (*fn)(void *), void *arg);
+/* Same, running argv via execvp */
+pid_t cgroup_spawn_exec(CgroupHandle *h, char *const argv[]);
+
+/* Reap a spawned child. Returns its exit status, 128+signal, or -1. */
+int cgroup_spawn_wait(pid_t pid);
+
+/* Method used by the calling thread's last successful spawn */
+CgroupSpawnMethod cgroup_spawn_last_method(void);
+
+/* Move whole processes (every thread) with one pwrite each on the held
+ * cgroup.procs descriptor. Pids that exited meanwhile are skipped.
+ * Returns the number moved, or -1 with errno set on the first other failure. */
+int cgroup_migrate_procs(CgroupHandle *h, const pid_t *pids, int n);
+/* Move every thread of pid through cgroup.threads (threaded cgroups).
+ * Returns the number of threads moved, or -1 with errno set. */
+int cgroup_migrate_threads(CgroupHandle *h, pid_t pid);
+
+/* CLI: run argv inside cgroup (relative to /sys/fs/cgroup or absolute) and
+ * wait for it. Returns the child's exit status, 128+signal, or -1. */
+int cgroup_run(const char *cgroup, char *const argv[]);
+
+#endif // CGROUP_SPAWN_H
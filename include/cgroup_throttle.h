@@ -0,0 +1,43 @@
+#ifndef CGROUP_THROTTLE_H
+#define CGROUP_THROTTLE_H
+
+#include <stdio.h>
+
+/* Throttling of one cgroup over an observation window, from cpu.stat deltas */
+typedef struct {
+    char path[256];                 /* relative to the root, "" for the root */
+    long long quota_usec;           /* cpu.max quota, -1 = max (unlimited) */
+    long long period_usec;
+    unsigned long long periods;     /* nr_periods delta */
+    unsigned long long throttled;   /* nr_throttled delta */
+    unsigned long long throttled_usec;
+    unsigned long long usage_usec;
+    double throttle_ratio;          /* throttled / periods */
+    double throttled_ms_per_period; /* throttled_usec / periods, in ms */
+    double demand_usec;             /* per-period CPU demand at the chosen percentile */
+    long long suggested_quota_usec; /* quota that covers demand_usec, -1 if no suggestion */
+} CgroupThrottleStat;
+
+/* Percentile (0-100) of values[0..n) by nearest rank; sorts values in place */
+double cgroup_throttle_percentile(double *values, int n, double p);
+
+/* Per-period demand for one interval: CPU actually used plus the time spent throttled,
+ * during which at least one thread was runnable and would have run. */
+double cgroup_throttle_demand(unsigned long long usage_usec, unsigned long long throttled_usec,
+                              unsigned long long periods);
+
+/* Quota covering the p-th percentile of per-interval demand, rounded up to 1 ms.
+ * Returns -1 when there is no demand sample. */
+long long cgroup_throttle_suggest_quota(double *demand, int n, double p);
+
+/* Sample cpu.stat for every cgroup under root (NULL = /sys/fs/cgroup) for samples ticks,
+ * interval_ms apart. Results for cgroups with a CPU controller are returned in *out (caller
+ * frees), worst first: by throttled time, then by throttle ratio. Returns the count or -1. */
+int cgroup_throttle_analyze(const char *root, int interval_ms, int samples, double percentile,
+                            CgroupThrottleStat **out);
+
+/* Ranked table of the top worst-throttled cgroups. Writes to stdout when output_file is NULL. */
+int cgroup_throttle_report(const char *root, int interval_ms, int samples, double percentile,
+                           int top, const char *output_file);
+
+#endif // CGROUP_THROTTLE_H
@@ -5,8 +5,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include "sysroot.h"
 
-#define CGROUP_BASE_PATH "/sys/fs/cgroup"
+/* /sys/fs/cgroup, moved along with the /sys root (see sysroot.h) */
+#define CGROUP_BASE_PATH sysroot_cgroup()
 #define MAX_PATH_LEN 512
 
 // Cgroup structure
@@ -21,6 +23,9 @@ int cgroup_create(const char *name);
 int cgroup_delete(const char *name);
 int cgroup_add_process(const char *name, pid_t pid);
 int cgroup_remove_process(const char *name, pid_t pid);
+// Start fn(arg) in a child that is inside the cgroup from its first instruction
+// (see cgroup_spawn.h). Returns the child pid or -1.
+pid_t cgroup_spawn_process(const char *name, int (*fn)(void *), void *arg);
 
 // CPU controller
 int cgroup_set_cpu_max(const char *name, long quota, long period);
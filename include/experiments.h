@@ -13,13 +13,120 @@ typedef struct {
     int samples;
 } OverheadResult;
 
+/* Overhead harness: a standard workload runs in a child while one of the
+ * monitors observes it from this process. Baseline and monitored trials
+ * alternate so that drift (thermal, frequency, neighbours) hits both equally.
+ */
+typedef enum {
+    OVH_WORK_CPU = 0,           /* integer ALU loop */
+    OVH_WORK_SYSCALL,           /* getppid() in a loop */
+    OVH_WORK_MEMORY,            /* memcpy between two 64 MB buffers */
+    OVH_WORK_COUNT
+} OverheadWorkload;
+
+typedef enum {
+    OVH_MON_PROFILER = 0,       /* rp_run on the child */
+    OVH_MON_PROCTREE,           /* process_tree_refresh of the whole process table */
+    OVH_MON_CGROUP,             /* cgroup_sampler_tick of the whole hierarchy */
+    OVH_MON_COUNT
+} OverheadMonitor;
+
+const char *overhead_workload_name(OverheadWorkload w);
+const char *overhead_monitor_name(OverheadMonitor m);
+/* Name -> enum value, -1 if unknown */
+int overhead_workload_from_name(const char *name);
+int overhead_monitor_from_name(const char *name);
+
+typedef struct {
+    OverheadWorkload workload;
+    OverheadMonitor monitor;
+    int interval_ms;
+    int trials;                 /* baseline/monitored pairs */
+    int trial_ms;               /* length of each trial */
+    int same_cpu;               /* pin monitor and workload to one CPU (worst case) */
+} OverheadCase;
+
+/* Means with 95% confidence half-widths (Student t over the trials) */
+typedef struct {
+    OverheadCase c;
+    double base_ops;            /* workload units per second, unmonitored */
+    double base_ci;
+    double mon_ops;             /* same, while monitored */
+    double mon_ci;
+    double delta_percent;       /* (mon_ops - base_ops) / base_ops * 100 */
+    double delta_ci;
+    double monitor_cpu_percent; /* monitor CPU time (/proc/self/stat) / wall time */
+    double monitor_cpu_ci;
+    double observations_per_sec;
+} OverheadCaseResult;
+
+int experiment_overhead_run(const OverheadCase *c, OverheadCaseResult *r);
+
+/* Every workload x monitor x interval in the comma-separated lists (NULL =
+ * all workloads, all monitors, 1,10,100,1000 ms). One CSV row per case:
+ * workload,monitor,interval_ms,trials,trial_ms,same_cpu,base_ops_per_s,base_ci95,
+ * mon_ops_per_s,mon_ci95,throughput_delta_pct,delta_ci95_pct,monitor_cpu_pct,
+ * monitor_cpu_ci95,observations_per_s
+ * Writes to stdout when output_file is NULL. */
+int experiment_overhead_sweep(const char *workloads, const char *monitors, const char *intervals,
+                              int trials, int trial_ms, int same_cpu, const char *output_file);
+
 typedef struct {
     double throttled_usage;
     double unthrottled_usage;
     double throttle_percent;
     int duration_seconds;
+    unsigned long long nr_throttled;    /* periods the throttled run hit its quota */
+    double throttled_ms;                /* time it spent throttled */
 } CPUThrottleResult;
 
+/* One point of the CPU throttling grid: quota_percent of one CPU per period_us
+ * (0 = no quota), burst_percent of the quota as cpu.max.burst */
+typedef struct {
+    int quota_percent;
+    int period_us;
+    int burst_percent;
+} ThrottleCell;
+
+/* Measured from the cell cgroup's own cpu.stat (and cpuacct.usage on v1), so
+ * other load on the host does not enter the numbers. Latencies are wall time
+ * per work unit of a CPU-bound loop: a unit that straddles a throttled stretch
+ * absorbs the wait, which is how period length shows up as tail latency. */
+typedef struct {
+    ThrottleCell cell;
+    int cpu;                        /* CPU the cell was pinned to */
+    long long quota_us;             /* -1 = max */
+    long long burst_us;
+    double configured_percent;      /* quota / period, at most one CPU */
+    double achieved_percent;        /* cgroup CPU time / wall time */
+    unsigned long long nr_periods;
+    unsigned long long nr_throttled;
+    double throttled_ms;
+    unsigned long long nr_bursts;
+    double units_per_sec;
+    double unit_p50_us;
+    double unit_p99_us;
+    double unit_max_us;
+    char error[64];                 /* empty on success */
+} ThrottleCellResult;
+
+/* Run n cells for duration_ms each in sibling cgroups, up to `parallel` at
+ * once (0 = one per CPU this process may use), each on its own CPU. Needs
+ * root and the cpu controller (v2, or v1 cpu + cpuacct). Returns 0, -1 when
+ * no cell could be set up. */
+int experiment_throttle_run(const ThrottleCell *cells, int n, int duration_ms, int parallel,
+                            ThrottleCellResult *out);
+
+/* Every quota x period x burst in the comma-separated lists (NULL = max,20,50,80 %;
+ * 10000,100000 us; 0 %). One CSV row per cell:
+ * quota_percent,period_us,burst_percent,quota_us,burst_us,cpu,configured_cpu_pct,
+ * achieved_cpu_pct,nr_periods,nr_throttled,throttled_periods_pct,throttled_ms,nr_bursts,
+ * units_per_s,unit_p50_us,unit_p99_us,unit_max_us,p99_vs_unlimited,error
+ * p99_vs_unlimited compares with the first "max" cell of the sweep.
+ * Writes to stdout when output_file is NULL. */
+int experiment_cpu_throttling_sweep(const char *quotas, const char *periods, const char *bursts,
+                                    int duration_ms, int parallel, const char *output_file);
+
 typedef struct {
     unsigned long limit_bytes;
     unsigned long peak_usage;
@@ -41,7 +148,11 @@ typedef struct {
 } NamespaceResult;
 
 // Experiment functions
+/* Quick run of the harness: CPU workload under rp_run at 1000/100/10 ms, CSV as above.
+ * result holds the 100 ms case, durations as seconds per workload unit. */
 int experiment_overhead(OverheadResult *result, const char *output_file);
+/* Unlimited vs throttle_percent at a 100 ms period, one after the other on the
+ * same CPU, measured as in experiment_throttle_run; text report. */
 int experiment_cpu_throttling(int throttle_percent, int duration, CPUThrottleResult *result, const char *output_file);
 int experiment_memory_limit(unsigned long limit_mb, MemoryLimitResult *result, const char *output_file);
 int experiment_io_limit(unsigned long limit_mbps, int duration, IOLimitResult *result, const char *output_file);
@@ -0,0 +1,72 @@
+#ifndef MEMORY_ACCOUNTING_H
+#define MEMORY_ACCOUNTING_H
+
+#include <sys/types.h>
+#include "process_tree.h"
+
+/* Proportional memory accounting from /proc/<pid>/smaps_rollup (all values in kB).
+ * Unlike RSS, PSS divides each shared page among the processes mapping it, so
+ * PSS can be summed across pre-fork workers without overcounting.
+ */
+typedef struct {
+    unsigned long rss_kb;
+    unsigned long pss_kb;
+    unsigned long pss_anon_kb;
+    unsigned long pss_file_kb;
+    unsigned long pss_shmem_kb;
+    unsigned long uss_kb;       /* Private_Clean + Private_Dirty */
+    unsigned long shared_kb;    /* Shared_Clean + Shared_Dirty */
+    unsigned long anon_kb;
+    unsigned long swap_kb;
+    unsigned long swap_pss_kb;
+} SmapsRollup;
+
+typedef struct {
+    pid_t pid;
+    unsigned long long start_time;  /* a different one means the pid was reused */
+    long long last_refresh_ms;
+    int valid;
+    SmapsRollup mem;
+} MemAcctEntry;
+
+/* Per-PID smaps_rollup cache. smaps walks every page table of the process, so it
+ * is refreshed only for a small selected set and on its own (slower) interval.
+ */
+typedef struct {
+    MemAcctEntry *entries;
+    int count;
+    int capacity;
+    int refresh_ms;
+} MemAcctCache;
+
+int read_smaps_rollup(pid_t pid, SmapsRollup *out);
+
+int mem_acct_init(MemAcctCache *cache, int refresh_ms);
+void mem_acct_free(MemAcctCache *cache);
+
+/* Make the cache track exactly pids[0..n): stale entries are re-read, unselected
+ * entries dropped. start_times are the pids' /proc start times (ProcessTreeNode
+ * start_time); an entry whose pid now belongs to another process is re-read at
+ * once. NULL reads them from /proc/<pid>/stat. Returns the number of
+ * smaps_rollup files read, -1 on error. */
+int mem_acct_update(MemAcctCache *cache, const pid_t *pids, const unsigned long long *start_times, int n);
+
+/* Cached values for pid, or NULL if not selected or unreadable */
+const SmapsRollup *mem_acct_get(const MemAcctCache *cache, pid_t pid);
+
+/* Rank the process table by RSS (the cheap counter) and keep up to k PIDs whose
+ * name contains name_filter (NULL = any). Returns the number of PIDs written. */
+int mem_acct_select_top_k(const ProcessTree *tree, int k, const char *name_filter, pid_t *out);
+
+/* PSS as a percentage of MemTotal */
+double mem_acct_percent(const SmapsRollup *mem, unsigned long mem_total_kb);
+
+/* Ranked PSS/USS report for the top k processes (optionally name-filtered).
+ * Fast counters are sampled every interval_ms; smaps_rollup every refresh_ms.
+ * Output CSV: timestamp_ms,pid,name,rss_kb,pss_kb,uss_kb,swap_pss_kb,pss_anon_kb,pss_file_kb,mem_percent
+ * (name is quoted when it contains a comma, quote or newline)
+ */
+int monitor_memory_accounting(int k, const char *name_filter, int interval_ms, int samples,
+                              int refresh_ms, const char *output_file);
+
+#endif // MEMORY_ACCOUNTING_H
@@ -67,19 +67,25 @@ typedef struct {
 
 // CPU Monitor functions
 int read_cpu_stats(CPUStats *stats);
+// The parse_* functions do the work of the read_* ones on an already open
+// file in the /proc format (used by the parser benchmarks in bench/)
+int parse_cpu_stats(FILE *fp, CPUStats *stats);
 double calculate_cpu_usage(CPUStats *prev, CPUStats *curr);
 int monitor_cpu(int duration_seconds, const char *output_file);
 
 // Memory Monitor functions
 int read_memory_stats(MemoryStats *stats);
+int parse_memory_stats(FILE *fp, MemoryStats *stats);
 int monitor_memory(int duration_seconds, const char *output_file);
 
 // I/O Monitor functions
 int read_io_stats(const char *device, IOStats *stats);
+int parse_io_stats(FILE *fp, const char *device, IOStats *stats);
 int monitor_io(const char *device, int duration_seconds, const char *output_file);
 
 // Network Monitor functions
 int read_network_stats(const char *interface, NetworkStats *stats);
+int parse_network_stats(FILE *fp, const char *interface, NetworkStats *stats);
 int monitor_network(const char *interface, int duration_seconds, const char *output_file);
 
 #endif // MONITORS_H
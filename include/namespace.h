@@ -19,5 +19,7 @@ int namespace_creation_overhead(const char *ns_type, int iterations);
 
 /* Print a global system report with per-namespace counts */
 int namespace_system_report(void);
+/* Same, counting every thread instead of every process (see namespace_census.h) */
+int namespace_census_report(int threads);
 
 #endif // NAMESPACE_H
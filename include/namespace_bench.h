@@ -0,0 +1,57 @@
+#ifndef NAMESPACE_BENCH_H
+#define NAMESPACE_BENCH_H
+
+#include <stdio.h>
+
+/* How a namespace set is created */
+typedef enum {
+    NS_BENCH_CLONE = 0,         /* clone() on a reused per-creator stack */
+    NS_BENCH_CLONE3,            /* clone3() without a stack (copy-on-write, like fork) */
+    NS_BENCH_UNSHARE,           /* fork(), then unshare() in the child */
+    NS_BENCH_METHOD_COUNT
+} NsBenchMethod;
+
+const char *namespace_bench_method_name(NsBenchMethod m);
+
+/* "none", "net", "user+pid+net", "container" (all seven types) ... -> CLONE_NEW* flags.
+ * Returns 0, -1 on an unknown type. */
+int namespace_bench_parse_flags(const char *spec, int *flags);
+
+typedef struct {
+    char label[64];             /* the spec the flags came from */
+    int flags;
+    NsBenchMethod method;
+    int threads;                /* parallel creators */
+    int iterations;             /* measured lifecycles per creator */
+    int warmup;                 /* unmeasured lifecycles per creator first */
+} NsBenchCase;
+
+/* Latency of one full lifecycle: create the namespaces, run the child to
+ * _exit() and reap it. Creators start together behind a barrier so that with
+ * threads > 1 they contend on the same kernel locks. */
+typedef struct {
+    NsBenchCase c;
+    int samples;                /* measured lifecycles that succeeded */
+    int failed;                 /* lifecycles whose create failed (errno in err) */
+    int err;
+    double min_us;
+    double mean_us;
+    double p50_us;
+    double p99_us;
+    double max_us;
+    double ops_per_sec;         /* measured lifecycles / wall time, all creators */
+} NsBenchResult;
+
+/* Run one case. Returns 0, -1 if nothing succeeded (see result->err). */
+int namespace_bench_run(const NsBenchCase *bc, NsBenchResult *result);
+
+/* Write results as CSV (with header) or a JSON document carrying the kernel release */
+void namespace_bench_write_csv(FILE *out, const NsBenchResult *r, int n);
+void namespace_bench_write_json(FILE *out, const NsBenchResult *r, int n);
+
+/* CLI: every spec in the comma-separated list (NULL = "none", each type and
+ * "container") x every method x concurrency 1, 2, 4 ... max_threads */
+int namespace_bench(const char *specs, int max_threads, int iterations, int warmup, int json,
+                    const char *output_file);
+
+#endif // NAMESPACE_BENCH_H
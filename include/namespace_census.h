@@ -0,0 +1,72 @@
+#ifndef NAMESPACE_CENSUS_H
+#define NAMESPACE_CENSUS_H
+
+#include <sys/types.h>
+
+typedef enum {
+    NS_MNT = 0,
+    NS_PID,
+    NS_NET,
+    NS_IPC,
+    NS_UTS,
+    NS_USER,
+    NS_CGROUP,
+    NS_TYPE_COUNT
+} NsType;
+
+/* "mnt", "pid" ... (the /proc/<pid>/ns entry names) */
+const char *namespace_type_name(NsType type);
+/* Accepts the entry names plus "mount"; returns -1 if unknown */
+int namespace_type_from_name(const char *name);
+
+/* One namespace, identified by the (st_dev, st_ino) of its nsfs inode */
+typedef struct {
+    dev_t dev;
+    ino_t ino;
+    NsType type;
+    int nmembers;
+    int first;                  /* members are census.members[first .. first + nmembers) */
+} NsEntry;
+
+typedef struct {
+    pid_t id;
+    int ns[NS_TYPE_COUNT];      /* index into NsCensus.ns, -1 = unreadable */
+} NsTask;
+
+/* All namespaces in use on the host, from a single walk of /proc. Each task's
+ * seven ns/ entries are read relative to its open ns/ directory and looked up
+ * by (dev, inode) in an open-addressing table, so no path is resolved more than
+ * once, no namespace strings are kept or compared, and every namespace is
+ * counted exactly once.
+ */
+typedef struct {
+    NsEntry *ns;                /* in order of discovery */
+    int count;
+    int capacity;
+    int *slots;                 /* index into ns, -1 = empty; power-of-two size */
+    unsigned int nslots;
+    NsTask *tasks;              /* tasks seen, by ascending id */
+    int ntasks;
+    int tasks_cap;
+    pid_t *members;             /* task ids grouped by namespace (see NsEntry.first) */
+    int per_type[NS_TYPE_COUNT];    /* namespaces of each type */
+    int tasks_per_type[NS_TYPE_COUNT];  /* tasks whose entry of that type was readable */
+    dev_t nsfs_dev;             /* st_dev of the nsfs, once one entry was stat'ed */
+    int have_nsfs_dev;
+} NsCensus;
+
+/* Walk proc_root (NULL = "/proc") once. With threads set every thread
+ * (/proc/<pid>/task/<tid>) is a member, otherwise one entry per process.
+ * Returns 0, or -1 if /proc cannot be read. */
+int namespace_census(NsCensus *c, const char *proc_root, int threads);
+void namespace_census_free(NsCensus *c);
+
+/* Index into c->ns of the namespace with that inode, or -1 */
+int namespace_census_find(const NsCensus *c, dev_t dev, ino_t ino);
+
+/* Namespace inode numbers of one task, read relative to an open /proc
+ * directory; ino[t] = 0 when that entry is unreadable. Returns the number of
+ * entries read, -1 if the task is gone. */
+int namespace_read_inodes(int procfd, pid_t pid, ino_t ino[NS_TYPE_COUNT]);
+
+#endif // NAMESPACE_CENSUS_H
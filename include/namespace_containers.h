@@ -0,0 +1,72 @@
+#ifndef NAMESPACE_CONTAINERS_H
+#define NAMESPACE_CONTAINERS_H
+
+#include <stdio.h>
+#include <sys/types.h>
+#include "process_tree.h"
+
+/* Namespaces that make up a container identity, in this order */
+#define CONTAINER_NS_COUNT 5        /* pid, net, mnt, uts, ipc */
+
+/* Processes sharing one (pid, net, mnt, uts, ipc) namespace tuple and cgroup.
+ * The identity is derived from /proc alone, so it works for any runtime (or
+ * none) and is stable for as long as the container's namespaces live. */
+typedef struct {
+    unsigned long long id;          /* FNV-1a of the inode tuple and cgroup path */
+    ino_t ns[CONTAINER_NS_COUNT];
+    char cgroup[256];               /* unified ("0::") path, else the first hierarchy's */
+    int host;                       /* same namespace tuple as PID 1 */
+    pid_t init_pid;                 /* lowest member PID */
+    char name[64];                  /* comm of init_pid */
+    ProcessTreeTotals totals;       /* sum of the members' own totals */
+} Container;
+
+/* Per-task cache entry, indexed like ProcessTree.nodes: a node keeps its slot
+ * for the lifetime of its PID. Runtimes move a task into its cgroup and
+ * namespaces after clone, so a task's links are read again after 2, 4, 8 ...
+ * refreshes (capped), and the interval starts over when the answer changes;
+ * tasks that could not be resolved back off the same way. */
+typedef struct {
+    pid_t pid;
+    unsigned long long start_time;
+    unsigned long long id;          /* container of the task, 0 = not resolved */
+    unsigned int recheck_at;        /* refresh number of the next read */
+    unsigned int backoff;           /* refreshes until the one after that */
+} ContainerTask;
+
+typedef struct {
+    ProcessTree tree;
+    int procfd;
+    ino_t host_ns[CONTAINER_NS_COUNT];
+    ContainerTask *tasks;
+    int tasks_cap;
+    Container *ctr;
+    int count;
+    int capacity;
+    int *slots;                     /* container index by id, -1 = empty; power of two */
+    unsigned int nslots;
+    long page_size;
+    int resolved;                   /* tasks whose namespaces were read on the last refresh */
+    unsigned int ticks;             /* refreshes so far */
+} ContainerMonitor;
+
+int container_monitor_init(ContainerMonitor *m);
+void container_monitor_free(ContainerMonitor *m);
+
+/* Refresh the process table, resolve the namespace tuple and cgroup of PIDs
+ * that appeared (and of cached ones that are due), and recompute
+ * per-container totals. Containers left without
+ * members are dropped; tasks whose namespace links are unreadable are not
+ * counted. Returns the number of containers, -1 on error. */
+int container_monitor_refresh(ContainerMonitor *m);
+
+/* "c" followed by the first 12 hex digits of the id */
+void container_format_id(unsigned long long id, char *buf, size_t len);
+
+/* CLI: per-container time series, one CSV row per container per sample:
+ * timestamp_ms,container,host,init_pid,name,cgroup,procs,threads,cpu_percent,
+ * rss_kb,io_read_bps,io_write_bps
+ * Groups in the host's namespaces are left out unless include_host is set. */
+int container_monitor_series(int interval_ms, int samples, int include_host, const char *output_file);
+
+#endif // NAMESPACE_CONTAINERS_H
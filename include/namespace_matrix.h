@@ -0,0 +1,53 @@
+#ifndef NAMESPACE_MATRIX_H
+#define NAMESPACE_MATRIX_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "namespace_census.h"
+
+/* PIDs chosen by a selector: "all", a list "12,34,56" or "comm=<name>"
+ * (exact /proc/<pid>/comm match). The result is ascending and malloc'd.
+ * Returns the count, -1 on a bad selector or if /proc cannot be read. */
+int namespace_select_pids(const char *proc_root, const char *selector, pid_t **pids);
+
+/* One namespace of one type and which of the selected PIDs are in it: bit i
+ * of the set stands for pids[i] (word i / 64, bit i % 64). */
+typedef struct {
+    NsType type;
+    ino_t ino;
+    int nmembers;
+    uint64_t *bits;             /* NsMatrix.words words, inside NsMatrix.bitsets */
+} NsMatrixGroup;
+
+/* Sharing matrix of a PID set, per namespace type. Each PID's seven ns/
+ * entries are read once; two PIDs share a type exactly when they fall in the
+ * same group. The pairwise matrix is never materialised. */
+typedef struct {
+    pid_t *pids;                /* columns, ascending; PIDs gone before reading are dropped */
+    int npids;
+    int words;                  /* 64-bit words per bitset */
+    NsMatrixGroup *groups;      /* by type, then ascending inode */
+    int ngroups;
+    int first[NS_TYPE_COUNT + 1];   /* groups of type t are [first[t], first[t + 1]) */
+    int *group_of;              /* group_of[t * npids + i]: group index, -1 = unreadable */
+    uint64_t *bitsets;
+} NsMatrix;
+
+/* Build the matrix for pids (any order, duplicates ignored). Returns 0, -1 on error. */
+int namespace_matrix_build(NsMatrix *m, const char *proc_root, const pid_t *pids, int n);
+void namespace_matrix_free(NsMatrix *m);
+
+/* 1 if columns i and j share the namespace of that type, 0 otherwise */
+int namespace_matrix_shared(const NsMatrix *m, NsType type, int i, int j);
+
+/* One row per group: type,ns,members,bitset,pids with the bitset as hex words
+ * (word 0 first) and the member PIDs space-separated. With shared_only, groups
+ * holding a single PID are left out. */
+void namespace_matrix_write_csv(FILE *out, const NsMatrix *m, int shared_only);
+void namespace_matrix_write_json(FILE *out, const NsMatrix *m, int shared_only);
+
+/* CLI: select, build and write the matrix (stdout when output_file is NULL) */
+int namespace_compare_many(const char *selector, int json, int shared_only, const char *output_file);
+
+#endif // NAMESPACE_MATRIX_H
@@ -0,0 +1,73 @@
+#ifndef NETNS_STATS_H
+#define NETNS_STATS_H
+
+#include <stddef.h>
+#include <time.h>
+#include <sys/types.h>
+#include <net/if.h>
+#include <linux/if_link.h>
+
+/* One interface of one network namespace */
+typedef struct {
+    int ifindex;
+    char name[IF_NAMESIZE];
+    struct rtnl_link_stats64 st;
+    double rx_bps;
+    double tx_bps;
+} NetnsLink;
+
+/* A network namespace held open for sampling. The netlink socket was created
+ * inside the namespace, so it keeps answering for it from any thread. */
+typedef struct {
+    ino_t ino;                  /* nsfs inode, as in "net:[ino]" */
+    pid_t pid;                  /* a member process, used to open it */
+    int sock;                   /* NETLINK_ROUTE socket inside the namespace, -1 if not open */
+    unsigned int seq;
+    unsigned int seen;          /* generation of the last rescan that found it */
+    int denied;                 /* setns refused: not retried while the namespace lives */
+    NetnsLink *links;           /* last dump */
+    int nlinks;
+    int cap;
+    NetnsLink *prev;            /* the dump before, for rates (swapped with links) */
+    int nprev;
+    int prev_cap;
+} NetnsEntry;
+
+typedef struct {
+    NetnsEntry *ns;
+    int count;
+    int capacity;
+    unsigned int generation;
+    ino_t self_ino;             /* our own namespace needs no setns */
+    struct timespec last;
+    int have_last;
+    int denied;                 /* held namespaces that could not be entered */
+} NetnsCollector;
+
+int netns_collector_init(NetnsCollector *c);
+void netns_collector_free(NetnsCollector *c);
+
+/* Find the distinct net namespaces in use (one /proc census), open a netlink
+ * socket inside each new one from a helper thread that setns()es into them in
+ * turn, and close the ones that are gone, so exited containers are not kept
+ * alive. A member PID that now points at another namespace (reused since the
+ * census) is skipped until the next rescan; a namespace that refused setns is
+ * remembered and not tried again. Returns the number of namespaces held, -1
+ * on error. */
+int netns_collector_rescan(NetnsCollector *c);
+
+/* RTM_GETLINK dump of every held namespace; updates counters and rates.
+ * Returns the number of namespaces that answered. */
+int netns_collector_tick(NetnsCollector *c);
+
+/* Append the RTM_NEWLINK replies in one netlink buffer to links (grown as
+ * needed). Returns 1 when NLMSG_DONE was seen, 0 if more is to come, -1 on a
+ * netlink error or allocation failure. */
+int netns_parse_links(const void *buf, size_t len, NetnsLink **links, int *n, int *cap);
+
+/* CLI: one CSV row per interface per namespace per sample:
+ * timestamp_ms,netns,pid,ifname,rx_bytes,tx_bytes,rx_packets,tx_packets,rx_errors,
+ * tx_errors,rx_dropped,tx_dropped,rx_bps,tx_bps */
+int netns_monitor(int interval_ms, int samples, const char *output_file);
+
+#endif // NETNS_STATS_H
@@ -0,0 +1,71 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <sys/types.h>
+
+/* perf_event_open() counters for a set of processes. CPU% says how much time a
+ * process got; these say what it did with it (IPC, cache and branch misses,
+ * faults, switches). Every thread gets two event groups read with one read()
+ * each via PERF_FORMAT_GROUP: a software group, always available, and a
+ * hardware group that is skipped when there is no PMU (most VMs, containers
+ * with perf_event_paranoid locked down).
+ */
+
+typedef enum {
+    PERF_TASK_CLOCK = 0,        /* software group */
+    PERF_CONTEXT_SWITCHES,
+    PERF_CPU_MIGRATIONS,
+    PERF_PAGE_FAULTS,
+    PERF_CYCLES,                /* hardware group */
+    PERF_INSTRUCTIONS,
+    PERF_CACHE_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_EVENT_COUNT
+} PerfEventId;
+
+/* "task_clock", "context_switches" ... */
+const char *perf_event_name(PerfEventId e);
+
+/* Counts summed over threads; task_clock is in ns. Hardware counts are
+ * scaled by time_enabled / time_running when the PMU was multiplexed. */
+typedef struct {
+    double v[PERF_EVENT_COUNT];
+} PerfValues;
+
+typedef struct {
+    pid_t tid;
+    int fd[PERF_EVENT_COUNT];   /* -1 = not open; the first open one of each group leads it */
+    double last[PERF_EVENT_COUNT];
+    unsigned int seen;
+} PerfThread;
+
+typedef struct {
+    PerfThread *threads;        /* sorted by tid */
+    int count;
+    int capacity;
+    unsigned int generation;
+    int available[PERF_EVENT_COUNT];    /* decided on the first thread attached */
+    int probed;
+    int user_only;              /* perf_event_paranoid forced exclude_kernel; context
+                                 * switches and migrations are then not counted */
+    int skipped;                /* threads not attached (fd limit, permissions) */
+    PerfValues retired;         /* final counts of threads that exited */
+} PerfCounters;
+
+int perf_counters_init(PerfCounters *pc);
+void perf_counters_free(PerfCounters *pc);
+
+/* Attach to threads of pids not seen before (walking /proc/<pid>/task), read
+ * every group, and retire threads that are gone, keeping their final counts so
+ * the totals never go backwards. Returns the number of threads counted, -1 if
+ * no event could be opened at all. */
+int perf_counters_read(PerfCounters *pc, const pid_t *pids, int n, PerfValues *total);
+
+/* 1 if the event is being counted */
+int perf_counters_available(const PerfCounters *pc, PerfEventId e);
+
+/* Parse one PERF_FORMAT_GROUP | TOTAL_TIME_ENABLED | TOTAL_TIME_RUNNING read:
+ * nr, enabled, running, then nr values, scaled. Returns nr, -1 if short. */
+int perf_parse_group(const void *buf, size_t len, double *values, int max);
+
+#endif // PERF_COUNTERS_H
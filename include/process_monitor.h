@@ -8,6 +8,7 @@
 // Process statistics structure
 typedef struct {
     pid_t pid;
+    pid_t ppid;
     char name[256];
     char state;
     unsigned long utime;
@@ -19,8 +20,24 @@ typedef struct {
     double mem_percent;
 } ProcessStats;
 
+// Per-tick constants shared by a batch of reads (refresh once per tick)
+typedef struct {
+    unsigned long total_mem_kb;
+    long page_size;
+    long clk_tck;
+} ProcessStatsContext;
+
 // Process monitoring functions
+int process_stats_context_init(ProcessStatsContext *ctx);
 int read_process_stats(pid_t pid, ProcessStats *stats);
+/* Read /proc/<pid>/stat for every PID in one call. status[i] (optional) is set to 0 on
+ * success or to -errno: -ENOENT/-ESRCH when the PID is gone, -EINVAL when the line
+ * does not parse; no separate existence check is made.
+ * Returns the number of PIDs read successfully. */
+int read_process_stats_batch(const ProcessStatsContext *ctx, const pid_t *pids, int count,
+                             ProcessStats *out, int *status);
+/* Parse one /proc/<pid>/stat line into name, state, ppid, times, threads, vsize, rss */
+int parse_process_stat(const char *buf, ProcessStats *stats);
 int monitor_process(pid_t pid, int duration_seconds, const char *output_file);
 int export_process_data_csv(const char *filename, ProcessStats *data, int count);
 int export_process_data_json(const char *filename, ProcessStats *data, int count);
@@ -29,5 +46,7 @@ int export_process_data_json(const char *filename, ProcessStats *data, int count
 int process_exists(pid_t pid);
 int get_process_name(pid_t pid, char *name, size_t size);
 double calculate_process_cpu_usage(ProcessStats *prev, ProcessStats *curr, double elapsed);
+double calculate_process_cpu_usage_ctx(const ProcessStatsContext *ctx, const ProcessStats *prev,
+                                       const ProcessStats *curr, double elapsed);
 
 #endif // PROCESS_MONITOR_H
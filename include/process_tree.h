@@ -0,0 +1,88 @@
+#ifndef PROCESS_TREE_H
+#define PROCESS_TREE_H
+
+#include <sys/types.h>
+#include <time.h>
+
+/* Per-subtree sums produced by the bottom-up roll-up */
+typedef struct {
+    int procs;
+    long threads;
+    double cpu_percent;            /* percent of one CPU over the last interval */
+    unsigned long long cpu_ticks;  /* utime+stime ticks consumed in the last interval */
+    unsigned long long utime;
+    unsigned long long stime;
+    unsigned long long vsize;
+    unsigned long long rss;        /* pages */
+    unsigned long long minflt;
+    unsigned long long majflt;
+    unsigned long long io_read_bytes;
+    unsigned long long io_write_bytes;
+    double io_read_bps;
+    double io_write_bps;
+} ProcessTreeTotals;
+
+typedef struct {
+    pid_t pid;
+    pid_t ppid;
+    char name[64];
+    char state;
+    unsigned long utime;
+    unsigned long stime;
+    unsigned long vsize;
+    unsigned long rss;
+    unsigned long minflt;
+    unsigned long majflt;
+    long num_threads;
+    unsigned long long io_read_bytes;
+    unsigned long long io_write_bytes;
+    unsigned long long start_time;  /* detects PID reuse between refreshes */
+    ProcessTreeTotals self;         /* this process alone */
+    ProcessTreeTotals subtree;      /* this process and all descendants */
+    /* Links are node indices, -1 when absent */
+    int parent;
+    int first_child;
+    int next_sibling;
+    int prev_sibling;
+    unsigned int seen;
+    int has_prev;
+    int relink;
+} ProcessTreeNode;
+
+/* Process table with an incrementally maintained parent/child map.
+ * Nodes are kept in a free-listed array and indexed by PID through an
+ * open-addressing hash, so refreshes only touch PIDs that appeared or vanished.
+ */
+typedef struct {
+    ProcessTreeNode *nodes;
+    int capacity;
+    int count;
+    int free_head;
+    int *slots;          /* PID hash: node index + 1, 0 = empty */
+    unsigned int nslots; /* power of two */
+    int *order;          /* parents-before-children traversal used by the roll-up */
+    unsigned int generation;
+    long clk_tck;
+    struct timespec last_refresh;
+    int refreshed;
+} ProcessTree;
+
+int process_tree_init(ProcessTree *tree);
+void process_tree_free(ProcessTree *tree);
+
+/* Rescan /proc, apply appeared/vanished PIDs to the parent map and recompute
+ * per-subtree totals. Returns the number of live processes, -1 on error. */
+int process_tree_refresh(ProcessTree *tree);
+
+const ProcessTreeNode *process_tree_find(const ProcessTree *tree, pid_t pid);
+
+/* Copy the rolled-up totals for pid's subtree. Returns 0 on success, -1 if pid is not tracked. */
+int process_tree_subtree_totals(const ProcessTree *tree, pid_t pid, ProcessTreeTotals *out);
+
+/* dst += src, field by field */
+void process_tree_totals_add(ProcessTreeTotals *dst, const ProcessTreeTotals *src);
+
+/* Collect the PIDs of pid's subtree (pid first). Returns the number written, at most max, -1 if unknown. */
+int process_tree_collect_subtree(const ProcessTree *tree, pid_t pid, pid_t *out, int max);
+
+#endif // PROCESS_TREE_H
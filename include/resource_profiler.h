@@ -1,8 +1,22 @@
 #ifndef RESOURCE_PROFILER_H
 #define RESOURCE_PROFILER_H
 
+#include <stdio.h>
 #include <sys/types.h>
 
+/* Profiler options. Zero-initialize and set the fields you need. */
+typedef struct {
+    pid_t pid;
+    int interval_ms;
+    int samples;
+    const char *outpath;
+    int tree;   /* aggregate pid and all of its descendants as one unit */
+    int pss;    /* append PSS/USS columns from smaps_rollup */
+    int pss_refresh_ms; /* smaps_rollup re-read interval, independent of interval_ms (default 5000) */
+    int sched;  /* append run-queue wait columns from schedstat */
+    int perf;   /* append perf_event counter columns */
+} rp_options_t;
+
 /* Run resource profiler: collect samples for pid with given interval (ms) and save to outpath.
  * If outpath ends with .json, emits JSON; otherwise CSV.
  * CSV includes: timestamp_ms,pid,utime_ticks,stime_ticks,cpu_percent,vsize_bytes,rss_pages,threads,
@@ -13,4 +27,29 @@
  */
 int rp_run(pid_t pid, int interval_ms, int samples, const char *outpath);
 
+/* Same as rp_run, driven by an options struct.
+ * With opts->tree set, each sample covers the whole process subtree rooted at opts->pid:
+ *   timestamp_ms,root_pid,procs,utime_ticks,stime_ticks,cpu_percent,vsize_bytes,rss_pages,threads,
+ *   minflt,majflt,io_read_bytes,io_write_bytes,io_read_bps,io_write_bps
+ * Counters are sums over the processes alive at sample time; cpu_percent and the bps
+ * rates are sums of per-process deltas, so exited children do not produce negative spikes.
+ * With opts->pss set, both modes append:
+ *   pss_kb,uss_kb,swap_pss_kb,pss_anon_kb,pss_file_kb,pss_mem_percent
+ * summed over the profiled processes (left empty / null when smaps_rollup is unreadable).
+ * With opts->sched set, both modes append (summed over all threads of the profiled processes):
+ *   sched_run_ms,sched_wait_ms,sched_timeslices,sched_wait_run_ratio,sched_avg_wait_us,
+ *   sched_wait_p50_us,sched_wait_p99_us
+ * The percentiles come from a log2 histogram of wait per timeslice accumulated over the run.
+ * With opts->perf set, both modes append interval deltas of perf_event counters on every
+ * thread of the profiled processes (see perf_counters.h):
+ *   perf_task_clock_ms,perf_context_switches,perf_cpu_migrations,perf_page_faults,
+ *   perf_cycles,perf_instructions,perf_ipc,perf_cache_misses,perf_branch_misses
+ * Hardware columns stay empty / null without a PMU; all of them when perf_event_open is denied.
+ */
+int rp_run_opts(const rp_options_t *opts);
+
+/* Entries in an open /proc/<pid>/net/{tcp,tcp6,udp,udp6} table (header excluded),
+ * as counted for the net_*_conns columns */
+int rp_count_sockets(FILE *f);
+
 #endif // RESOURCE_PROFILER_H
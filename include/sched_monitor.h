@@ -0,0 +1,70 @@
+#ifndef SCHED_MONITOR_H
+#define SCHED_MONITOR_H
+
+#include <stdio.h>
+#include <sys/types.h>
+
+/* Scheduler latency from schedstat (CONFIG_SCHED_INFO / CONFIG_SCHEDSTATS).
+ * CPU% says how long a task ran; run_delay says how long it sat runnable on a
+ * run queue waiting for a CPU, which is what shows up as tail latency.
+ */
+
+/* One task, or a sum of tasks: fields 1-3 of /proc/<pid>/task/<tid>/schedstat */
+typedef struct {
+    unsigned long long run_ns;      /* time spent on the CPU */
+    unsigned long long wait_ns;     /* time spent runnable, waiting on a run queue */
+    unsigned long long timeslices;  /* number of times run on a CPU */
+} SchedStat;
+
+/* Per-CPU line of /proc/schedstat */
+typedef struct {
+    int cpu;
+    unsigned long long yld_count;
+    unsigned long long sched_count;
+    unsigned long long sched_goidle;
+    unsigned long long ttwu_count;
+    unsigned long long ttwu_local;
+    SchedStat s;                    /* rq_cpu_time, run_delay, pcount */
+} CpuSchedStat;
+
+/* Interval rates derived from two samples */
+typedef struct {
+    double run_ms;
+    double wait_ms;
+    unsigned long long timeslices;
+    double wait_run_ratio;          /* wait_ns / run_ns, 0 when nothing ran */
+    double avg_wait_us;             /* wait per timeslice */
+} SchedDelta;
+
+/* log2 histogram of wait-per-timeslice: bucket 0 is < 1 us, bucket i is [2^(i-1), 2^i) us */
+#define SCHED_HIST_BUCKETS 32
+typedef struct {
+    unsigned long long buckets[SCHED_HIST_BUCKETS];
+    unsigned long long count;
+} SchedHistogram;
+
+/* Sum of all threads of pid. /proc/<pid>/schedstat alone only covers the leader thread. */
+int read_process_schedstat(pid_t pid, SchedStat *out);
+int read_task_schedstat(pid_t pid, pid_t tid, SchedStat *out);
+
+/* Parse /proc/schedstat text (versions 15-17). Returns CPUs written, -1 on bad input. */
+int sched_parse_system(const char *buf, CpuSchedStat *cpus, int max, int *version);
+/* Read /proc/schedstat. Returns CPUs written, -1 when unavailable (no CONFIG_SCHEDSTATS). */
+int read_system_schedstat(CpuSchedStat *cpus, int max, int *version);
+
+/* Counters are per-task and vanish with exiting threads, so a sum may go backwards;
+ * negative deltas are clamped to zero. */
+void sched_delta(const SchedStat *prev, const SchedStat *curr, SchedDelta *out);
+
+/* Record one interval: avg wait per timeslice, weighted by the timeslices in it */
+void sched_hist_add(SchedHistogram *h, const SchedDelta *d);
+/* Upper bound (us) of the bucket holding percentile p (0-100); 0 when empty */
+double sched_hist_percentile(const SchedHistogram *h, double p);
+void sched_hist_print(FILE *out, const SchedHistogram *h);
+
+/* System view: per-CPU run/wait every interval_ms, plus an "all" row.
+ * Output CSV: timestamp_ms,cpu,run_ms,wait_ms,timeslices,wait_run_ratio,avg_wait_us
+ * Writes to output_file, or stdout when NULL. */
+int monitor_system_schedstat(int interval_ms, int samples, const char *output_file);
+
+#endif // SCHED_MONITOR_H
@@ -0,0 +1,69 @@
+#ifndef SMAPS_ANALYZER_H
+#define SMAPS_ANALYZER_H
+
+#include <stdio.h>
+#include <sys/types.h>
+
+/* VMA classes reported by the memory map analyzer */
+typedef enum {
+    SMAPS_HEAP = 0,
+    SMAPS_STACK,
+    SMAPS_ANON,      /* anonymous mmap, including [anon:name] */
+    SMAPS_FILE,      /* file-backed, also broken down per path */
+    SMAPS_SHM,       /* /dev/shm, SysV shm, memfd */
+    SMAPS_HUGETLB,
+    SMAPS_SPECIAL,   /* [vdso], [vvar], [vsyscall] */
+    SMAPS_CLASS_COUNT
+} SmapsClass;
+
+/* All sizes in kB, as reported by the kernel */
+typedef struct {
+    unsigned long long vmas;
+    unsigned long long size_kb;
+    unsigned long long rss_kb;
+    unsigned long long pss_kb;
+    unsigned long long dirty_kb;      /* Shared_Dirty + Private_Dirty */
+    unsigned long long swap_kb;
+    unsigned long long anon_huge_kb;  /* AnonHugePages */
+} SmapsCounters;
+
+typedef struct {
+    unsigned int path_off;   /* offset into SmapsSnapshot.paths */
+    unsigned int hash;
+    SmapsCounters c;
+} SmapsFileEntry;
+
+typedef struct {
+    pid_t pid;
+    SmapsCounters total;
+    SmapsCounters classes[SMAPS_CLASS_COUNT];
+    /* Per-path breakdown of file-backed mappings. Paths live in one arena and are
+     * interned through an open-addressing index, so parsing allocates per distinct
+     * file, never per line or per VMA. */
+    SmapsFileEntry *files;
+    int nfiles;
+    int files_cap;
+    int *index;              /* file index + 1, 0 = empty */
+    unsigned int index_slots;
+    char *paths;
+    size_t paths_len;
+    size_t paths_cap;
+} SmapsSnapshot;
+
+const char *smaps_class_name(SmapsClass cls);
+
+/* Stream-parse /proc/<pid>/smaps (or any smaps-formatted fd) through a fixed-size buffer.
+ * snap must start zeroed; parsing into a used snapshot reuses its allocations. */
+int smaps_snapshot_read(pid_t pid, SmapsSnapshot *snap);
+int smaps_snapshot_parse_fd(int fd, SmapsSnapshot *snap);
+void smaps_snapshot_free(SmapsSnapshot *snap);
+
+void smaps_print_report(FILE *out, const SmapsSnapshot *snap, int top_files);
+/* Per-class and per-file growth from before to after, largest Rss changes first */
+void smaps_print_diff(FILE *out, const SmapsSnapshot *before, const SmapsSnapshot *after, int top_files);
+
+/* Analyzer mode: one snapshot, or two snapshots interval_ms apart plus their diff when interval_ms > 0.
+ * Writes to output_file, or stdout when NULL. */
+int smaps_analyze(pid_t pid, int interval_ms, int top_files, const char *output_file);
+
+#endif // SMAPS_ANALYZER_H
@@ -0,0 +1,72 @@
+#ifndef SYSROOT_H
+#define SYSROOT_H
+
+#include <stdio.h>
+#include <dirent.h>
+
+/* Root resolution for every /proc and /sys path the collectors read.
+ *
+ * Call sites keep writing the canonical path ("/proc/%d/stat",
+ * "/sys/fs/cgroup/app") and open it through sysroot_fopen/sysroot_open/
+ * sysroot_opendir, or turn it into the real path with sysroot_path. The
+ * leading /proc or /sys is replaced by the configured root:
+ *   RESMON_ROOT=/host        -> /host/proc and /host/sys (host bind-mounted
+ *                               into a container)
+ *   RESMON_PROC_ROOT, RESMON_SYS_ROOT override one tree each
+ * or by sysroot_set() from a command-line flag. Other paths pass unchanged,
+ * and so does /proc/self/..., which always describes the monitor itself.
+ *
+ * Record: between sysroot_record_start(dir) and sysroot_record_stop(), each
+ * file opened for reading through this layer is copied to
+ * <dir>/<tick>/proc/... or <dir>/<tick>/sys/... and the copy is what the
+ * caller reads; sysroot_next_tick() moves to a new tick directory.
+ * Replay: after sysroot_replay_start(dir), sysroot_next_tick() points the
+ * roots at the next recorded tick, so the unchanged collectors run from the
+ * recording as fast as they can read it.
+ *
+ * Configure before starting threads; recording is single-threaded.
+ */
+
+typedef enum {
+    SYSROOT_LIVE = 0,
+    SYSROOT_RECORD,
+    SYSROOT_REPLAY
+} SysrootMode;
+
+/* Roots in use ("/proc", "/sys", "/sys/fs/cgroup" unless overridden) */
+const char *sysroot_proc(void);
+const char *sysroot_sys(void);
+const char *sysroot_cgroup(void);
+/* Nonzero when either root differs from the live one */
+int sysroot_overridden(void);
+/* Nonzero when the /sys root (and with it the cgroup tree) was moved; our own
+ * mountinfo still describes the cgroups when only /proc was */
+int sysroot_sys_overridden(void);
+
+/* root: directory holding proc/ and sys/ (NULL = back to the environment,
+ * then the live trees). The single-tree setters take the tree itself. */
+int sysroot_set(const char *root);
+int sysroot_set_proc(const char *proc_root);
+int sysroot_set_sys(const char *sys_root);
+
+/* Resolve a canonical path into buf; -1 when it does not fit */
+int sysroot_path(char *buf, size_t size, const char *path);
+FILE *sysroot_fopen(const char *path, const char *mode);
+int sysroot_open(const char *path, int flags);
+DIR *sysroot_opendir(const char *path);
+
+SysrootMode sysroot_mode(void);
+/* interval_ms is kept in <dir>/interval_ms for the replay */
+int sysroot_record_start(const char *dir, int interval_ms);
+void sysroot_record_stop(void);
+/* Ticks found under dir (0 = none), recorded interval in *interval_ms */
+int sysroot_replay_start(const char *dir, int *interval_ms);
+void sysroot_replay_stop(void);
+/* Start tick n+1: new record directory, or the next recorded one (-1 at
+ * the end of the recording) */
+int sysroot_next_tick(void);
+/* Wall clock: now when live, the start of the current tick when recording or
+ * replaying, so both runs compute the same timestamps and rates */
+long long sysroot_time_ms(void);
+
+#endif // SYSROOT_H
@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <sys/types.h>
 
 // File utilities
 FILE* safe_fopen(const char *path, const char *mode);
@@ -15,6 +16,8 @@ char* read_file_content(const char *path);
 void trim_string(char *str);
 int parse_line_value(const char *line, const char *key, unsigned long *value);
 int parse_line_value_ull(const char *line, const char *key, unsigned long long *value);
+// PID of a /proc (or task/) entry name, 0 if it is not one
+pid_t parse_pid_name(const char *name);
 
 // Time utilities
 void get_timestamp(char *buffer, size_t size);
@@ -23,6 +26,9 @@ double get_elapsed_time(struct timespec *start, struct timespec *end);
 // Math utilities
 double calculate_percentage(unsigned long used, unsigned long total);
 double calculate_rate(unsigned long long current, unsigned long long previous, double time_diff);
+void sort_doubles(double *values, int n);
+// p-th percentile (0-100, nearest rank) of an ascending array
+double percentile_sorted(const double *sorted, int n, double p);
 
 // Logging utilities
 void log_message(const char *level, const char *format, ...);
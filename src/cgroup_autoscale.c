@@ -0,0 +1,430 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include "../include/cgroup_autoscale.h"
+#include "../include/cgroup_sampler.h"
+#include "../include/cgroup_limits.h"
+#include "../include/sysroot.h"
+
+#define QUOTA_GRAIN 1000ULL     /* usec; also the kernel's minimum quota */
+#define PAGE_GRAIN 4096ULL
+
+void cgroup_autoscale_policy_default(CgroupAutoscalePolicy *p) {
+    p->throttle_hi = 0.10;
+    p->throttle_lo = 0.01;
+    p->cpu_psi_hi = 20.0;
+    p->cpu_util_lo = 0.50;
+    p->mem_psi_hi = 10.0;
+    p->mem_psi_lo = 1.0;
+    p->mem_headroom = 1.25;
+    p->step_up = 1.25;
+    p->step_down = 0.90;
+    p->cooldown_ticks = 3;
+}
+
+static unsigned long long clamp_ull(unsigned long long v, unsigned long long lo, unsigned long long hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static unsigned long long round_up(double v, unsigned long long grain) {
+    unsigned long long x = (unsigned long long)v;
+    if ((double)x < v) x++;
+    return (x + grain - 1) / grain * grain;
+}
+
+static unsigned long long round_down(double v, unsigned long long grain) {
+    return (unsigned long long)v / grain * grain;
+}
+
+/* The action the rule wants for one resource, before cooldown is applied */
+typedef struct {
+    const char *reason;
+    unsigned long long cur;
+    unsigned long long next;
+} Want;
+
+static void want_cpu(const CgroupAutoscalePolicy *p, const CgroupAutoscaleTarget *t,
+                     const CgroupAutoscaleInput *in, const CgroupAutoscaleState *st, Want *w) {
+    unsigned long long lo = (unsigned long long)t->cpu_min_usec;
+    unsigned long long hi = (unsigned long long)t->cpu_max_usec;
+    w->cur = (st->quota_usec < 0) ? ULLONG_MAX : (unsigned long long)st->quota_usec;
+    if (w->cur < lo || w->cur > hi) {
+        w->reason = "clamp";
+        w->next = clamp_ull(w->cur, lo, hi);
+        return;
+    }
+    if (!in->has_cpu) return;
+    if (in->throttle_ratio > p->throttle_hi || in->cpu_some_avg10 > p->cpu_psi_hi) {
+        w->reason = (in->throttle_ratio > p->throttle_hi) ? "throttled" : "cpu-pressure";
+        w->next = clamp_ull(round_up((double)w->cur * p->step_up, QUOTA_GRAIN), lo, hi);
+        if (w->next == w->cur) w->reason = "at-max";
+    } else if (in->throttle_ratio <= p->throttle_lo && in->cpu_util < p->cpu_util_lo) {
+        unsigned long long next = round_down((double)w->cur * p->step_down, QUOTA_GRAIN);
+        if (next < QUOTA_GRAIN) next = QUOTA_GRAIN;
+        next = clamp_ull(next, lo, hi);
+        /* Sitting idle at the floor is the steady state, not worth a log line */
+        if (next < w->cur) {
+            w->reason = "idle";
+            w->next = next;
+        }
+    }
+}
+
+static void want_mem(const CgroupAutoscalePolicy *p, const CgroupAutoscaleTarget *t,
+                     const CgroupAutoscaleInput *in, const CgroupAutoscaleState *st, Want *w) {
+    w->cur = st->mem_high;
+    if (w->cur < t->mem_min || w->cur > t->mem_max) {
+        w->reason = "clamp";
+        w->next = clamp_ull(w->cur, t->mem_min, t->mem_max);
+        return;
+    }
+    if (!in->has_mem) return;
+    if (in->mem_some_avg10 > p->mem_psi_hi) {
+        w->reason = "memory-pressure";
+        w->next = clamp_ull(round_up((double)w->cur * p->step_up, PAGE_GRAIN), t->mem_min, t->mem_max);
+        if (w->next == w->cur) w->reason = "at-max";
+    } else if (in->mem_some_avg10 < p->mem_psi_lo) {
+        /* Shrink towards the working set, never below current usage plus headroom */
+        unsigned long long next = round_down((double)w->cur * p->step_down, PAGE_GRAIN);
+        unsigned long long floor = round_up((double)in->memory_current * p->mem_headroom, PAGE_GRAIN);
+        if (next < floor) next = floor;
+        next = clamp_ull(next, t->mem_min, t->mem_max);
+        if (next < w->cur) {
+            w->reason = "headroom";
+            w->next = next;
+        }
+    }
+}
+
+/* Clamping moves a limit back into its configured range and ignores the
+ * cooldown; every other change starts one. */
+static int settle(const Want *w, int *cooldown, int ticks, const char **reason) {
+    *reason = w->reason;
+    if (!w->reason) {
+        if (*cooldown > 0) (*cooldown)--;
+        return 0;
+    }
+    if (strcmp(w->reason, "clamp") != 0 && *cooldown > 0) {
+        (*cooldown)--;
+        *reason = "cooldown";
+        return 0;
+    }
+    if (w->next == w->cur) return 0;
+    *cooldown = ticks;
+    return 1;
+}
+
+void cgroup_autoscale_decide(const CgroupAutoscalePolicy *p, const CgroupAutoscaleTarget *t,
+                             const CgroupAutoscaleInput *in, CgroupAutoscaleState *st,
+                             CgroupAutoscaleDecision *d) {
+    memset(d, 0, sizeof(*d));
+    if (t->cpu) {
+        Want w = { NULL, 0, 0 };
+        want_cpu(p, t, in, st, &w);
+        d->cpu_change = settle(&w, &st->cpu_cooldown, p->cooldown_ticks, &d->cpu_reason);
+        d->new_quota_usec = d->cpu_change ? (long long)w.next : st->quota_usec;
+    }
+    if (t->mem) {
+        Want w = { NULL, 0, 0 };
+        want_mem(p, t, in, st, &w);
+        d->mem_change = settle(&w, &st->mem_cooldown, p->cooldown_ticks, &d->mem_reason);
+        d->new_mem_high = d->mem_change ? w.next : st->mem_high;
+    }
+}
+
+/* "<lo>-<hi>" with both ends parsed by parse */
+static int parse_range(const char *s, int (*parse)(const char *, unsigned long long *),
+                       unsigned long long *lo, unsigned long long *hi) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%s", s);
+    char *dash = strchr(buf, '-');
+    if (!dash) return -1;
+    *dash = '\0';
+    if (parse(buf, lo) != 0 || parse(dash + 1, hi) != 0) return -1;
+    return (*lo <= *hi && *hi != ULLONG_MAX) ? 0 : -1;
+}
+
+static int parse_usec(const char *s, unsigned long long *v) {
+    char *end;
+    if (*s < '0' || *s > '9') return -1;
+    errno = 0;
+    *v = strtoull(s, &end, 10);
+    return (errno || *end) ? -1 : 0;
+}
+
+int cgroup_autoscale_load(const char *path, CgroupAutoscaleTarget **out) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    CgroupAutoscaleTarget *v = NULL;
+    int n = 0, cap = 0, lineno = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        char *save = NULL;
+        char *tok = strtok_r(line, " \t\r\n", &save);
+        if (!tok) continue;
+        if (n == cap) {
+            cap = cap ? cap * 2 : 8;
+            CgroupAutoscaleTarget *nv = realloc(v, (size_t)cap * sizeof(*nv));
+            if (!nv) goto fail;
+            v = nv;
+        }
+        CgroupAutoscaleTarget *t = &v[n];
+        memset(t, 0, sizeof(*t));
+        snprintf(t->cgroup, sizeof(t->cgroup), "%s", tok);
+        while ((tok = strtok_r(NULL, " \t\r\n", &save)) != NULL) {
+            unsigned long long lo, hi;
+            if (strncmp(tok, "cpu=", 4) == 0 && parse_range(tok + 4, parse_usec, &lo, &hi) == 0 &&
+                lo >= QUOTA_GRAIN) {
+                t->cpu = 1;
+                t->cpu_min_usec = (long long)lo;
+                t->cpu_max_usec = (long long)hi;
+            } else if (strncmp(tok, "mem=", 4) == 0 &&
+                       parse_range(tok + 4, cgroup_limits_parse_bytes, &lo, &hi) == 0) {
+                t->mem = 1;
+                t->mem_min = lo;
+                t->mem_max = hi;
+            } else {
+                fprintf(stderr, "%s:%d: bad setting '%s'\n", path, lineno, tok);
+                goto fail;
+            }
+        }
+        if (!t->cpu && !t->mem) {
+            fprintf(stderr, "%s:%d: %s has neither cpu= nor mem=\n", path, lineno, t->cgroup);
+            goto fail;
+        }
+        n++;
+    }
+    fclose(f);
+    *out = v;
+    return n;
+fail:
+    fclose(f);
+    free(v);
+    return -1;
+}
+
+int cgroup_autoscale_init(CgroupAutoscaler *a, const char *root, const CgroupAutoscaleTarget *targets,
+                          int n, const CgroupAutoscalePolicy *p, int dry_run, FILE *log) {
+    memset(a, 0, sizeof(*a));
+    if (p) a->policy = *p;
+    else cgroup_autoscale_policy_default(&a->policy);
+    a->dry_run = dry_run;
+    a->log = log;
+    if (n <= 0) return -1;
+
+    int rootfd = open(root ? root : sysroot_cgroup(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (rootfd < 0) return -1;
+    a->cg = calloc((size_t)n, sizeof(*a->cg));
+    if (!a->cg) {
+        close(rootfd);
+        return -1;
+    }
+    for (int i = 0; i < n; ++i) {
+        CgroupAutoscaleCgroup *c = &a->cg[a->count];
+        if (cgroup_handle_openat(&c->h, rootfd, targets[i].cgroup) != 0) {
+            fprintf(stderr, "autoscale: cannot open %s: %s\n", targets[i].cgroup, strerror(errno));
+            continue;
+        }
+        c->target = targets[i];
+        /* A limit file that cannot be read means the controller is not enabled here */
+        char buf[64];
+        if (c->target.cpu && cgroup_handle_read(&c->h, CG_ATTR_CPU_MAX, buf, sizeof(buf)) <= 0) {
+            fprintf(stderr, "autoscale: %s: no cpu.max, not managing CPU\n", c->target.cgroup);
+            c->target.cpu = 0;
+        }
+        if (c->target.mem && cgroup_handle_read(&c->h, CG_ATTR_MEMORY_HIGH, buf, sizeof(buf)) <= 0) {
+            fprintf(stderr, "autoscale: %s: no memory.high, not managing memory\n", c->target.cgroup);
+            c->target.mem = 0;
+        }
+        if (!c->target.cpu && !c->target.mem) {
+            cgroup_handle_close(&c->h);
+            continue;
+        }
+        a->count++;
+    }
+    close(rootfd);
+    if (a->count == 0) {
+        cgroup_autoscale_free(a);
+        return -1;
+    }
+    return 0;
+}
+
+void cgroup_autoscale_free(CgroupAutoscaler *a) {
+    for (int i = 0; i < a->count; ++i) cgroup_handle_close(&a->cg[i].h);
+    free(a->cg);
+    a->cg = NULL;
+    a->count = 0;
+}
+
+/* Current limits: somebody else may have changed them since the last tick */
+static void read_limits(CgroupAutoscaleCgroup *c) {
+    char buf[64];
+    if (c->target.cpu && cgroup_handle_read(&c->h, CG_ATTR_CPU_MAX, buf, sizeof(buf)) > 0) {
+        char q[32];
+        long long period;
+        if (sscanf(buf, "%31s %lld", q, &period) == 2) {
+            c->st.quota_usec = (strcmp(q, "max") == 0) ? -1 : atoll(q);
+            c->st.period_usec = period;
+        }
+    }
+    if (c->target.mem) {
+        unsigned long long high;
+        if (cgroup_handle_read_ull(&c->h, CG_ATTR_MEMORY_HIGH, &high) == 0) c->st.mem_high = high;
+    }
+}
+
+static void read_input(CgroupAutoscaleCgroup *c, CgroupAutoscaleInput *in) {
+    char buf[1024];
+    CgroupPsi psi;
+    memset(in, 0, sizeof(*in));
+
+    if (c->target.cpu && cgroup_handle_read(&c->h, CG_ATTR_CPU_STAT, buf, sizeof(buf)) > 0) {
+        CgroupSample s;
+        memset(&s, 0, sizeof(s));
+        cgroup_parse_cpu_stat(buf, &s);
+        if (c->have_prev && s.nr_periods >= c->prev_periods) {
+            unsigned long long periods = s.nr_periods - c->prev_periods;
+            in->has_cpu = 1;
+            if (periods > 0) {
+                in->throttle_ratio = (double)(s.nr_throttled - c->prev_throttled) / (double)periods;
+                if (c->st.quota_usec > 0) {
+                    in->cpu_util = (double)(s.usage_usec - c->prev_usage) /
+                                   ((double)periods * (double)c->st.quota_usec);
+                }
+            }
+        }
+        c->have_prev = 1;
+        c->prev_usage = s.usage_usec;
+        c->prev_periods = s.nr_periods;
+        c->prev_throttled = s.nr_throttled;
+        if (cgroup_handle_read(&c->h, CG_ATTR_CPU_PRESSURE, buf, sizeof(buf)) > 0 &&
+            cgroup_parse_pressure(buf, &psi) == 0) {
+            in->cpu_some_avg10 = psi.some.avg10;
+        }
+    }
+    if (c->target.mem && cgroup_handle_read_ull(&c->h, CG_ATTR_MEMORY_CURRENT, &in->memory_current) == 0) {
+        in->has_mem = 1;
+        if (cgroup_handle_read(&c->h, CG_ATTR_MEMORY_PRESSURE, buf, sizeof(buf)) > 0 &&
+            cgroup_parse_pressure(buf, &psi) == 0) {
+            in->mem_some_avg10 = psi.some.avg10;
+            in->mem_full_avg10 = psi.full.avg10;
+        }
+    }
+}
+
+static void fmt_limit(char *buf, size_t len, unsigned long long v) {
+    if (v == ULLONG_MAX) snprintf(buf, len, "max");
+    else snprintf(buf, len, "%llu", v);
+}
+
+static void log_row(CgroupAutoscaler *a, long long ms, const CgroupAutoscaleCgroup *c, const char *resource,
+                    unsigned long long old, unsigned long long new, const char *reason,
+                    const CgroupAutoscaleInput *in) {
+    if (!a->log) return;
+    char o[32], n[32];
+    fmt_limit(o, sizeof(o), old);
+    fmt_limit(n, sizeof(n), new);
+    fprintf(a->log, "%lld,%s,%s,%s,%s,%s,%.4f,%.4f,%.2f,%.2f,%llu\n", ms, c->target.cgroup, resource,
+            o, n, reason, in->throttle_ratio, in->cpu_util, in->cpu_some_avg10, in->mem_some_avg10,
+            in->memory_current);
+}
+
+int cgroup_autoscale_tick(CgroupAutoscaler *a) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    long long ms = (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    int written = 0;
+
+    for (int i = 0; i < a->count; ++i) {
+        CgroupAutoscaleCgroup *c = &a->cg[i];
+        CgroupAutoscaleInput in;
+        CgroupAutoscaleDecision d;
+        read_limits(c);
+        read_input(c, &in);
+        long long old_quota = c->st.quota_usec;
+        unsigned long long old_high = c->st.mem_high;
+        cgroup_autoscale_decide(&a->policy, &c->target, &in, &c->st, &d);
+
+        if (d.cpu_change) {
+            char buf[64];
+            snprintf(buf, sizeof(buf), "%lld %lld\n", d.new_quota_usec,
+                     c->st.period_usec > 0 ? c->st.period_usec : 100000LL);
+            if (!a->dry_run && cgroup_handle_write(&c->h, CG_ATTR_CPU_MAX, buf) != 0) {
+                fprintf(stderr, "autoscale: %s cpu.max: %s\n", c->target.cgroup, strerror(errno));
+                d.cpu_reason = "write-failed";
+                c->st.cpu_cooldown = 0;
+            } else {
+                c->st.quota_usec = d.new_quota_usec;
+                written++;
+            }
+        }
+        if (d.cpu_reason) {
+            log_row(a, ms, c, "cpu.max", old_quota < 0 ? ULLONG_MAX : (unsigned long long)old_quota,
+                    (unsigned long long)d.new_quota_usec, d.cpu_reason, &in);
+        }
+
+        if (d.mem_change) {
+            char buf[32];
+            snprintf(buf, sizeof(buf), "%llu\n", d.new_mem_high);
+            if (!a->dry_run && cgroup_handle_write(&c->h, CG_ATTR_MEMORY_HIGH, buf) != 0) {
+                fprintf(stderr, "autoscale: %s memory.high: %s\n", c->target.cgroup, strerror(errno));
+                d.mem_reason = "write-failed";
+                c->st.mem_cooldown = 0;
+            } else {
+                c->st.mem_high = d.new_mem_high;
+                written++;
+            }
+        }
+        if (d.mem_reason) log_row(a, ms, c, "memory.high", old_high, d.new_mem_high, d.mem_reason, &in);
+    }
+    if (a->log) fflush(a->log);
+    a->ticks++;
+    a->changes += written;
+    return written;
+}
+
+int cgroup_autoscale(const char *targets_file, const char *root, int interval_ms, int ticks,
+                     int dry_run, const char *output_file) {
+    if (interval_ms <= 0) interval_ms = 1000;
+    CgroupAutoscaleTarget *targets = NULL;
+    int n = cgroup_autoscale_load(targets_file, &targets);
+    if (n < 0) {
+        fprintf(stderr, "autoscale: cannot load %s\n", targets_file);
+        return -1;
+    }
+
+    FILE *out = stdout;
+    if (output_file) {
+        out = fopen(output_file, "w");
+        if (!out) {
+            free(targets);
+            return -1;
+        }
+    }
+    CgroupAutoscaler a;
+    int rc = cgroup_autoscale_init(&a, root, targets, n, NULL, dry_run, out);
+    free(targets);
+    if (rc == 0) {
+        fprintf(out, "timestamp_ms,cgroup,resource,old,new,reason,throttle_ratio,cpu_util,"
+                     "cpu_some_avg10,mem_some_avg10,memory_current\n");
+        for (int t = 0; ticks <= 0 || t < ticks; ++t) {
+            if (t > 0) usleep((useconds_t)interval_ms * 1000);
+            cgroup_autoscale_tick(&a);
+        }
+        fprintf(stderr, "autoscale: %lld ticks, %d limit changes%s\n", a.ticks, a.changes,
+                dry_run ? " (dry run)" : "");
+        cgroup_autoscale_free(&a);
+    }
+    if (output_file) fclose(out);
+    return rc;
+}
@@ -0,0 +1,379 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/vfs.h>
+#include "../include/cgroup_backend.h"
+#include "../include/cgroup_memstat.h"
+#include "../include/sysroot.h"
+
+#ifndef CGROUP_SUPER_MAGIC
+#define CGROUP_SUPER_MAGIC 0x27e0eb
+#endif
+
+static const char *v1_names[CG_V1_COUNT] = { "cpu", "cpuacct", "memory", "blkio" };
+
+const char *cgroup_mode_name(CgroupMode mode) {
+    switch (mode) {
+    case CG_MODE_V1: return "v1";
+    case CG_MODE_V2: return "v2";
+    case CG_MODE_HYBRID: return "hybrid";
+    default: return "none";
+    }
+}
+
+/* mountinfo escapes blanks in paths as \040 etc. */
+static void unescape_path(const char *in, size_t len, char *out, size_t cap) {
+    size_t o = 0;
+    for (size_t i = 0; i < len && o + 1 < cap; ++i) {
+        if (in[i] == '\\' && i + 3 < len && in[i + 1] >= '0' && in[i + 1] <= '3') {
+            out[o++] = (char)(((in[i + 1] - '0') << 6) | ((in[i + 2] - '0') << 3) | (in[i + 3] - '0'));
+            i += 3;
+        } else {
+            out[o++] = in[i];
+        }
+    }
+    out[o] = '\0';
+}
+
+int cgroup_mounts_parse(const char *mountinfo, CgroupMounts *out) {
+    memset(out, 0, sizeof(*out));
+    int any_v1 = 0;
+    const char *line = mountinfo;
+    while (*line) {
+        const char *nl = strchr(line, '\n');
+        size_t llen = nl ? (size_t)(nl - line) : strlen(line);
+        /* id parent major:minor root mount-point options [optional...] - fstype source superoptions */
+        const char *p = line;
+        const char *end = line + llen;
+        const char *field[5];
+        size_t flen[5];
+        int nf = 0;
+        while (p < end && nf < 5) {
+            while (p < end && *p == ' ') p++;
+            field[nf] = p;
+            while (p < end && *p != ' ') p++;
+            flen[nf] = (size_t)(p - field[nf]);
+            nf++;
+        }
+        const char *sep = memmem(line, llen, " - ", 3);
+        if (nf == 5 && sep) {
+            char fstype[32], source[256], opts[512];
+            char rest[1024];
+            size_t rlen = (size_t)(end - (sep + 3));
+            if (rlen >= sizeof(rest)) rlen = sizeof(rest) - 1;
+            memcpy(rest, sep + 3, rlen);
+            rest[rlen] = '\0';
+            opts[0] = '\0';
+            if (sscanf(rest, "%31s %255s %511s", fstype, source, opts) >= 2) {
+                if (strcmp(fstype, "cgroup2") == 0 && !out->v2[0]) {
+                    unescape_path(field[4], flen[4], out->v2, sizeof(out->v2));
+                } else if (strcmp(fstype, "cgroup") == 0) {
+                    char *save;
+                    for (char *tok = strtok_r(opts, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+                        for (int c = 0; c < CG_V1_COUNT; ++c) {
+                            if (strcmp(tok, v1_names[c]) == 0 && !out->v1[c][0]) {
+                                unescape_path(field[4], flen[4], out->v1[c], sizeof(out->v1[c]));
+                                any_v1 = 1;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        if (!nl) break;
+        line = nl + 1;
+    }
+    if (any_v1) out->mode = out->v2[0] ? CG_MODE_HYBRID : CG_MODE_V1;
+    else out->mode = out->v2[0] ? CG_MODE_V2 : CG_MODE_NONE;
+    return (out->mode == CG_MODE_NONE) ? -1 : 0;
+}
+
+static CgroupMounts detected;
+static pthread_once_t detect_once = PTHREAD_ONCE_INIT;
+
+static void detect_mounts(void) {
+    FILE *f = fopen("/proc/self/mountinfo", "r");
+    if (!f) return;
+    size_t cap = 16384, len = 0;
+    char *buf = malloc(cap);
+    while (buf) {
+        size_t r = fread(buf + len, 1, cap - 1 - len, f);
+        len += r;
+        if (r == 0 || len < cap - 1) break;
+        char *nb = realloc(buf, cap * 2);
+        if (!nb) break;
+        buf = nb;
+        cap *= 2;
+    }
+    fclose(f);
+    if (!buf) return;
+    buf[len] = '\0';
+    cgroup_mounts_parse(buf, &detected);
+    free(buf);
+}
+
+const CgroupMounts *cgroup_mounts(void) {
+    pthread_once(&detect_once, detect_mounts);
+    return &detected;
+}
+
+/* --- v2 sources ---------------------------------------------------------- */
+
+static void v2_cpu_stat(CgroupSampler *s, const char *buf, CgroupSample *out) {
+    (void)s;
+    cgroup_parse_cpu_stat(buf, out);
+}
+
+static void v2_memory_current(CgroupSampler *s, const char *buf, CgroupSample *out) {
+    (void)s;
+    out->memory_current = strtoull(buf, NULL, 10);
+}
+
+static void v2_memory_stat(CgroupSampler *s, const char *buf, CgroupSample *out) {
+    cgroup_parse_memory_stat(&s->memstat_layout, buf, out);
+}
+
+static void v2_io_stat(CgroupSampler *s, const char *buf, CgroupSample *out) {
+    (void)s;
+    cgroup_parse_io_stat(buf, out);
+}
+
+static void v2_cpu_pressure(CgroupSampler *s, const char *buf, CgroupSample *out) {
+    (void)s;
+    cgroup_parse_pressure(buf, &out->cpu_psi);
+}
+
+static void v2_memory_pressure(CgroupSampler *s, const char *buf, CgroupSample *out) {
+    (void)s;
+    cgroup_parse_pressure(buf, &out->mem_psi);
+}
+
+static void v2_io_pressure(CgroupSampler *s, const char *buf, CgroupSample *out) {
+    (void)s;
+    cgroup_parse_pressure(buf, &out->io_psi);
+}
+
+static const CgroupSource v2_sources[] = {
+    { "cpu.stat", 0, CG_FILE_CPU_STAT, v2_cpu_stat },
+    { "memory.current", 0, CG_FILE_MEMORY_CURRENT, v2_memory_current },
+    { "memory.stat", 0, CG_FILE_MEMORY_STAT, v2_memory_stat },
+    { "io.stat", 0, CG_FILE_IO_STAT, v2_io_stat },
+    { "cpu.pressure", 0, CG_FILE_CPU_PRESSURE, v2_cpu_pressure },
+    { "memory.pressure", 0, CG_FILE_MEMORY_PRESSURE, v2_memory_pressure },
+    { "io.pressure", 0, CG_FILE_IO_PRESSURE, v2_io_pressure },
+};
+
+void cgroup_backend_v2(CgroupBackend *b, const char *root) {
+    memset(b, 0, sizeof(*b));
+    b->name = "v2";
+    b->version = 2;
+    b->nhier = 1;
+    b->primary = 0;
+    snprintf(b->hier_root[0], sizeof(b->hier_root[0]), "%s", root ? root : sysroot_cgroup());
+    b->nsources = (int)(sizeof(v2_sources) / sizeof(v2_sources[0]));
+    memcpy(b->sources, v2_sources, sizeof(v2_sources));
+}
+
+/* --- v1 sources ---------------------------------------------------------- */
+
+static long user_hz = 100;     /* cpuacct.stat unit, set when a v1 backend is built */
+
+static const char *next_line(const char *line) {
+    const char *nl = strchr(line, '\n');
+    return nl ? nl + 1 : line + strlen(line);
+}
+
+static void v1_cpuacct_usage(CgroupSampler *s, const char *buf, CgroupSample *out) {
+    (void)s;
+    out->usage_usec = strtoull(buf, NULL, 10) / 1000;   /* ns */
+}
+
+static void v1_cpuacct_stat(CgroupSampler *s, const char *buf, CgroupSample *out) {
+    (void)s;
+    unsigned long long per_tick = 1000000ULL / (unsigned long long)user_hz;
+    for (const char *line = buf; *line; line = next_line(line)) {
+        if (strncmp(line, "user ", 5) == 0) out->user_usec = strtoull(line + 5, NULL, 10) * per_tick;
+        else if (strncmp(line, "system ", 7) == 0) out->system_usec = strtoull(line + 7, NULL, 10) * per_tick;
+    }
+}
+
+static void v1_cpu_stat(CgroupSampler *s, const char *buf, CgroupSample *out) {
+    (void)s;
+    for (const char *line = buf; *line; line = next_line(line)) {
+        if (strncmp(line, "nr_periods ", 11) == 0) out->nr_periods = strtoull(line + 11, NULL, 10);
+        else if (strncmp(line, "nr_throttled ", 13) == 0) out->nr_throttled = strtoull(line + 13, NULL, 10);
+        else if (strncmp(line, "throttled_time ", 15) == 0) out->throttled_usec = strtoull(line + 15, NULL, 10) / 1000;
+    }
+}
+
+static void v1_memory_usage(CgroupSampler *s, const char *buf, CgroupSample *out) {
+    (void)s;
+    out->memory_current = strtoull(buf, NULL, 10);
+}
+
+/* Hierarchical (total_*) memory.stat keys, which match v2 memory.stat semantics */
+static const struct {
+    const char *key;
+    CgroupMemStatField field;
+} v1_memstat_keys[] = {
+    { "rss", CG_MEMSTAT_ANON },
+    { "cache", CG_MEMSTAT_FILE },
+    { "shmem", CG_MEMSTAT_SHMEM },
+    { "mapped_file", CG_MEMSTAT_FILE_MAPPED },
+    { "dirty", CG_MEMSTAT_FILE_DIRTY },
+    { "writeback", CG_MEMSTAT_FILE_WRITEBACK },
+    { "rss_huge", CG_MEMSTAT_ANON_THP },
+    { "inactive_anon", CG_MEMSTAT_INACTIVE_ANON },
+    { "active_anon", CG_MEMSTAT_ACTIVE_ANON },
+    { "inactive_file", CG_MEMSTAT_INACTIVE_FILE },
+    { "active_file", CG_MEMSTAT_ACTIVE_FILE },
+    { "unevictable", CG_MEMSTAT_UNEVICTABLE },
+    { "pgfault", CG_MEMSTAT_PGFAULT },
+    { "pgmajfault", CG_MEMSTAT_PGMAJFAULT },
+};
+
+static void v1_memory_stat(CgroupSampler *s, const char *buf, CgroupSample *out) {
+    (void)s;
+    const int nkeys = (int)(sizeof(v1_memstat_keys) / sizeof(v1_memstat_keys[0]));
+    for (const char *line = buf; *line; line = next_line(line)) {
+        if (strncmp(line, "total_", 6) != 0) continue;
+        const char *key = line + 6;
+        const char *sp = strchr(key, ' ');
+        if (!sp) break;
+        size_t klen = (size_t)(sp - key);
+        for (int k = 0; k < nkeys; ++k) {
+            if (strlen(v1_memstat_keys[k].key) == klen && memcmp(v1_memstat_keys[k].key, key, klen) == 0) {
+                out->memstat[v1_memstat_keys[k].field] = strtoull(sp + 1, NULL, 10);
+                break;
+            }
+        }
+    }
+    cgroup_sample_fill_memory(out);
+}
+
+/* "8:0 Read 4096" lines; the trailing "Total N" line has no device */
+static void sum_blkio(const char *buf, unsigned long long *rd, unsigned long long *wr) {
+    *rd = *wr = 0;
+    for (const char *line = buf; *line; line = next_line(line)) {
+        char op[16];
+        unsigned long long v;
+        if (sscanf(line, "%*u:%*u %15s %llu", op, &v) != 2) continue;
+        if (strcmp(op, "Read") == 0) *rd += v;
+        else if (strcmp(op, "Write") == 0) *wr += v;
+    }
+}
+
+static void v1_blkio_bytes(CgroupSampler *s, const char *buf, CgroupSample *out) {
+    (void)s;
+    sum_blkio(buf, &out->io_rbytes, &out->io_wbytes);
+}
+
+static void v1_blkio_ios(CgroupSampler *s, const char *buf, CgroupSample *out) {
+    (void)s;
+    sum_blkio(buf, &out->io_rios, &out->io_wios);
+}
+
+int cgroup_backend_v1(CgroupBackend *b, const CgroupMounts *m, const char *relpath) {
+    memset(b, 0, sizeof(*b));
+    b->name = "v1";
+    b->version = 1;
+    b->nhier = CG_V1_COUNT;
+    b->primary = -1;
+    static const CgroupV1Controller walk_order[] = { CG_V1_MEMORY, CG_V1_CPUACCT, CG_V1_CPU, CG_V1_BLKIO };
+    for (int i = 0; i < CG_V1_COUNT; ++i) {
+        CgroupV1Controller c = walk_order[i];
+        if (!m->v1[c][0]) continue;
+        if (relpath && relpath[0]) snprintf(b->hier_root[c], sizeof(b->hier_root[c]), "%s/%s", m->v1[c], relpath);
+        else snprintf(b->hier_root[c], sizeof(b->hier_root[c]), "%s", m->v1[c]);
+        if (b->primary < 0) b->primary = c;
+    }
+    if (b->primary < 0) return -1;
+
+    long hz = sysconf(_SC_CLK_TCK);
+    if (hz > 0) user_hz = hz;
+
+    /* Prefer the hierarchical blkio files so totals include child cgroups, as on v2 */
+    int recursive = 0;
+    if (b->hier_root[CG_V1_BLKIO][0]) {
+        char path[600];
+        snprintf(path, sizeof(path), "%s/blkio.throttle.io_service_bytes_recursive", b->hier_root[CG_V1_BLKIO]);
+        recursive = (access(path, F_OK) == 0);
+    }
+    const CgroupSource sources[] = {
+        { "cpuacct.usage", CG_V1_CPUACCT, CG_FILE_CPU_STAT, v1_cpuacct_usage },
+        { "cpuacct.stat", CG_V1_CPUACCT, CG_FILE_CPU_STAT, v1_cpuacct_stat },
+        { "cpu.stat", CG_V1_CPU, CG_FILE_CPU_STAT, v1_cpu_stat },
+        { "memory.usage_in_bytes", CG_V1_MEMORY, CG_FILE_MEMORY_CURRENT, v1_memory_usage },
+        { "memory.stat", CG_V1_MEMORY, CG_FILE_MEMORY_STAT, v1_memory_stat },
+        { recursive ? "blkio.throttle.io_service_bytes_recursive" : "blkio.throttle.io_service_bytes",
+          CG_V1_BLKIO, CG_FILE_IO_STAT, v1_blkio_bytes },
+        { recursive ? "blkio.throttle.io_serviced_recursive" : "blkio.throttle.io_serviced",
+          CG_V1_BLKIO, CG_FILE_IO_STAT, v1_blkio_ios },
+    };
+    for (size_t k = 0; k < sizeof(sources) / sizeof(sources[0]); ++k) {
+        if (b->hier_root[sources[k].hier][0]) b->sources[b->nsources++] = sources[k];
+    }
+    return 0;
+}
+
+/* --- selection ----------------------------------------------------------- */
+
+static int v2_has_controllers(const char *v2root) {
+    char path[300], buf[256];
+    snprintf(path, sizeof(path), "%s/cgroup.controllers", v2root);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) return 0;
+    buf[n] = '\0';
+    char *save;
+    for (char *tok = strtok_r(buf, " \n", &save); tok; tok = strtok_r(NULL, " \n", &save)) {
+        if (strcmp(tok, "cpu") == 0 || strcmp(tok, "memory") == 0) return 1;
+    }
+    return 0;
+}
+
+/* prefix is path or one of its ancestors */
+static int path_under(const char *path, const char *prefix) {
+    size_t len = strlen(prefix);
+    return len && strncmp(path, prefix, len) == 0 && (path[len] == '/' || path[len] == '\0');
+}
+
+static int resolve_default(CgroupBackend *b, const CgroupMounts *m) {
+    /* Our own mountinfo says nothing about a relocated /sys: assume v2 there */
+    if (sysroot_sys_overridden()) {
+        cgroup_backend_v2(b, sysroot_cgroup());
+        return 0;
+    }
+    int use_v1 = (m->mode == CG_MODE_V1) || (m->mode == CG_MODE_HYBRID && !v2_has_controllers(m->v2));
+    if (use_v1 && cgroup_backend_v1(b, m, "") == 0) return 0;
+    cgroup_backend_v2(b, m->v2[0] ? m->v2 : sysroot_cgroup());
+    return 0;
+}
+
+int cgroup_backend_resolve(CgroupBackend *b, const char *root) {
+    const CgroupMounts *m = cgroup_mounts();
+    if (!root) return resolve_default(b, m);
+
+    struct statfs st;
+    int is_v1 = (statfs(root, &st) == 0 && st.f_type == CGROUP_SUPER_MAGIC);
+    for (int c = 0; c < CG_V1_COUNT; ++c) {
+        if (!m->v1[c][0]) continue;
+        if (is_v1 && path_under(root, m->v1[c])) {
+            const char *rel = root + strlen(m->v1[c]);
+            while (*rel == '/') rel++;
+            return cgroup_backend_v1(b, m, rel);
+        }
+        /* The tmpfs holding the v1 mounts (/sys/fs/cgroup on v1 and hybrid hosts) */
+        if (!is_v1 && path_under(m->v1[c], root) && !(m->v2[0] && path_under(root, m->v2))) {
+            return resolve_default(b, m);
+        }
+    }
+    cgroup_backend_v2(b, root);
+    return 0;
+}
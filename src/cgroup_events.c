@@ -0,0 +1,287 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#include "../include/cgroup_events.h"
+#include "../include/sysroot.h"
+
+static const char *events_files[CG_EVENTS_FILE_COUNT] = { "memory.events", "cgroup.events", "pids.events" };
+static const char *events_sources[CG_EVENTS_FILE_COUNT] = { "memory", "cgroup", "pids" };
+
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int cgroup_events_parse(const char *buf, CgroupEventCounter *out, int max) {
+    int n = 0;
+    const char *line = buf;
+    while (*line && n < max) {
+        const char *sp = strchr(line, ' ');
+        const char *nl = strchr(line, '\n');
+        if (sp && (!nl || sp < nl) && (size_t)(sp - line) < sizeof(out[n].key)) {
+            memcpy(out[n].key, line, (size_t)(sp - line));
+            out[n].key[sp - line] = '\0';
+            out[n].value = strtoull(sp + 1, NULL, 10);
+            n++;
+        }
+        if (!nl) break;
+        line = nl + 1;
+    }
+    return n;
+}
+
+static int map_wd(CgroupWatcher *w, int wd, int value) {
+    if (wd >= w->wd_map_len) {
+        int len = w->wd_map_len ? w->wd_map_len : 256;
+        while (len <= wd) len *= 2;
+        int *m = realloc(w->wd_map, (size_t)len * sizeof(int));
+        if (!m) return -1;
+        memset(m + w->wd_map_len, 0, (size_t)(len - w->wd_map_len) * sizeof(int));
+        w->wd_map = m;
+        w->wd_map_len = len;
+    }
+    w->wd_map[wd] = value;
+    return 0;
+}
+
+static int read_counters(CgroupEventsWatch *watch) {
+    char buf[512];
+    ssize_t r = pread(watch->fd, buf, sizeof(buf) - 1, 0);
+    if (r < 0) return -1;
+    buf[r] = '\0';
+    watch->nkeys = cgroup_events_parse(buf, watch->keys, CG_EVENTS_MAX_KEYS);
+    return 0;
+}
+
+static void full_path(const CgroupWatcher *w, const char *rel, const char *file, char *out, size_t len) {
+    if (rel[0] && file) snprintf(out, len, "%s/%s/%s", w->root, rel, file);
+    else if (rel[0]) snprintf(out, len, "%s/%s", w->root, rel);
+    else if (file) snprintf(out, len, "%s/%s", w->root, file);
+    else snprintf(out, len, "%s", w->root);
+}
+
+static int add_group(CgroupWatcher *w, const char *rel) {
+    if (w->ngroups == w->groups_cap) {
+        int cap = w->groups_cap ? w->groups_cap * 2 : 64;
+        CgroupEventsGroup *g = realloc(w->groups, (size_t)cap * sizeof(CgroupEventsGroup));
+        if (!g) return -1;
+        w->groups = g;
+        w->groups_cap = cap;
+    }
+    int gi = w->ngroups;
+    CgroupEventsGroup *g = &w->groups[gi];
+    char path[1024];
+    full_path(w, rel, NULL, path, sizeof(path));
+    g->dir_wd = inotify_add_watch(w->inotify_fd, path, IN_CREATE | IN_MOVED_TO | IN_ONLYDIR);
+    if (g->dir_wd < 0) return -1;
+    g->path = strdup(rel);
+    if (!g->path || map_wd(w, g->dir_wd, -(gi + 1)) != 0) return -1;
+    w->ngroups++;
+
+    for (int f = 0; f < CG_EVENTS_FILE_COUNT; ++f) {
+        full_path(w, rel, events_files[f], path, sizeof(path));
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) continue;   /* controller not enabled here */
+        int wd = inotify_add_watch(w->inotify_fd, path, IN_MODIFY);
+        if (wd < 0) {
+            close(fd);
+            continue;
+        }
+        if (w->nwatches == w->watches_cap) {
+            int cap = w->watches_cap ? w->watches_cap * 2 : 128;
+            CgroupEventsWatch *nw = realloc(w->watches, (size_t)cap * sizeof(CgroupEventsWatch));
+            if (!nw) {
+                close(fd);
+                return -1;
+            }
+            w->watches = nw;
+            w->watches_cap = cap;
+        }
+        CgroupEventsWatch *watch = &w->watches[w->nwatches];
+        memset(watch, 0, sizeof(*watch));
+        watch->wd = wd;
+        watch->fd = fd;
+        watch->group = gi;
+        watch->kind = (CgroupEventsFile)f;
+        read_counters(watch);
+        if (map_wd(w, wd, w->nwatches + 1) != 0) return -1;
+        w->nwatches++;
+    }
+    return gi;
+}
+
+static int add_subtree(CgroupWatcher *w, const char *rel) {
+    if (add_group(w, rel) < 0) return -1;
+    char path[1024];
+    full_path(w, rel, NULL, path, sizeof(path));
+    DIR *dir = opendir(path);
+    if (!dir) return 0;
+    int dfd = dirfd(dir);
+    struct dirent *de;
+    while ((de = readdir(dir)) != NULL) {
+        if (de->d_name[0] == '.') continue;
+        if (de->d_type != DT_DIR) {
+            struct stat st;
+            if (de->d_type != DT_UNKNOWN) continue;
+            if (fstatat(dfd, de->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0 || !S_ISDIR(st.st_mode)) continue;
+        }
+        char child[1024];
+        if (rel[0]) snprintf(child, sizeof(child), "%s/%s", rel, de->d_name);
+        else snprintf(child, sizeof(child), "%s", de->d_name);
+        if (add_subtree(w, child) < 0) {
+            closedir(dir);
+            return -1;
+        }
+    }
+    closedir(dir);
+    return 0;
+}
+
+int cgroup_watcher_init(CgroupWatcher *w, const char *root) {
+    memset(w, 0, sizeof(*w));
+    snprintf(w->root, sizeof(w->root), "%s", root ? root : sysroot_cgroup());
+    w->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (w->inotify_fd < 0) return -1;
+    if (add_subtree(w, "") < 0) {
+        cgroup_watcher_free(w);
+        return -1;
+    }
+    return 0;
+}
+
+void cgroup_watcher_free(CgroupWatcher *w) {
+    for (int i = 0; i < w->nwatches; ++i) {
+        if (w->watches[i].fd >= 0) close(w->watches[i].fd);
+    }
+    for (int i = 0; i < w->ngroups; ++i) free(w->groups[i].path);
+    if (w->inotify_fd >= 0) close(w->inotify_fd);   /* drops all watches */
+    free(w->watches);
+    free(w->groups);
+    free(w->wd_map);
+    memset(w, 0, sizeof(*w));
+    w->inotify_fd = -1;
+}
+
+/* Re-read a modified file and report each counter that moved */
+static int report_changes(CgroupWatcher *w, CgroupEventsWatch *watch, cgroup_event_cb cb, void *ctx) {
+    CgroupEventCounter old[CG_EVENTS_MAX_KEYS];
+    int nold = watch->nkeys;
+    memcpy(old, watch->keys, sizeof(old));
+    if (read_counters(watch) != 0) return 0;
+
+    int reported = 0;
+    long long ts = now_ms();
+    for (int k = 0; k < watch->nkeys; ++k) {
+        unsigned long long prev = 0;
+        for (int j = 0; j < nold; ++j) {
+            if (strcmp(old[j].key, watch->keys[k].key) == 0) { prev = old[j].value; break; }
+        }
+        if (watch->keys[k].value == prev) continue;
+        CgroupEvent ev;
+        ev.timestamp_ms = ts;
+        ev.cgroup = w->groups[watch->group].path;
+        ev.source = events_sources[watch->kind];
+        ev.event = watch->keys[k].key;
+        ev.value = watch->keys[k].value;
+        ev.delta = (long long)(watch->keys[k].value - prev);
+        if (cb) cb(&ev, ctx);
+        reported++;
+    }
+    return reported;
+}
+
+int cgroup_watcher_poll(CgroupWatcher *w, int timeout_ms, cgroup_event_cb cb, void *ctx) {
+    struct pollfd pfd = { .fd = w->inotify_fd, .events = POLLIN };
+    int pr = poll(&pfd, 1, timeout_ms);
+    if (pr < 0) return (errno == EINTR) ? 0 : -1;
+    if (pr == 0) return 0;
+
+    char buf[8192] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int reported = 0;
+    for (;;) {
+        ssize_t len = read(w->inotify_fd, buf, sizeof(buf));
+        if (len <= 0) break;
+        for (char *p = buf; p < buf + len; ) {
+            const struct inotify_event *ie = (const struct inotify_event *)p;
+            p += sizeof(struct inotify_event) + ie->len;
+            if (ie->wd < 0 || ie->wd >= w->wd_map_len) continue;
+            int m = w->wd_map[ie->wd];
+            if (m > 0 && (ie->mask & IN_MODIFY)) {
+                reported += report_changes(w, &w->watches[m - 1], cb, ctx);
+            } else if (m > 0 && (ie->mask & IN_IGNORED)) {
+                /* cgroup removed: the kernel dropped the watch */
+                CgroupEventsWatch *watch = &w->watches[m - 1];
+                if (watch->fd >= 0) close(watch->fd);
+                watch->fd = -1;
+                w->wd_map[ie->wd] = 0;
+            } else if (m < 0 && (ie->mask & (IN_CREATE | IN_MOVED_TO)) && (ie->mask & IN_ISDIR) && ie->len) {
+                const char *parent = w->groups[-m - 1].path;
+                char rel[1024];
+                if (parent[0]) snprintf(rel, sizeof(rel), "%s/%s", parent, ie->name);
+                else snprintf(rel, sizeof(rel), "%s", ie->name);
+                add_subtree(w, rel);
+            } else if (m < 0 && (ie->mask & IN_IGNORED)) {
+                w->wd_map[ie->wd] = 0;
+            }
+        }
+    }
+    return reported;
+}
+
+static void write_event_csv(const CgroupEvent *ev, void *ctx) {
+    FILE *out = ctx;
+    fprintf(out, "%lld,/%s,%s,%s,%llu,%lld\n", ev->timestamp_ms, ev->cgroup, ev->source, ev->event, ev->value, ev->delta);
+    fflush(out);
+}
+
+int cgroup_watch_events(const char *root, int duration_s, const char *output_file) {
+    CgroupWatcher w;
+    if (cgroup_watcher_init(&w, root) != 0) {
+        fprintf(stderr, "cgroup_watch: cannot watch %s: %s\n", root ? root : sysroot_cgroup(), strerror(errno));
+        return -1;
+    }
+    FILE *out = stdout;
+    if (output_file) {
+        out = fopen(output_file, "w");
+        if (!out) {
+            perror("fopen");
+            cgroup_watcher_free(&w);
+            return -1;
+        }
+    }
+    fprintf(stderr, "cgroup_watch: %d cgroups, %d event files under %s\n", w.ngroups, w.nwatches, w.root);
+    fprintf(out, "timestamp_ms,cgroup,source,event,value,delta\n");
+    fflush(out);
+
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int rc = 0;
+    for (;;) {
+        int timeout = -1;
+        if (duration_s > 0) {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            long long left = (long long)duration_s * 1000 -
+                             ((now.tv_sec - start.tv_sec) * 1000LL + (now.tv_nsec - start.tv_nsec) / 1000000);
+            if (left <= 0) break;
+            timeout = (int)left;
+        }
+        if (cgroup_watcher_poll(&w, timeout, write_event_csv, out) < 0) {
+            rc = -1;
+            break;
+        }
+    }
+
+    if (output_file) fclose(out);
+    cgroup_watcher_free(&w);
+    return rc;
+}
@@ -0,0 +1,178 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../include/cgroup_handle.h"
+#include "../include/sysroot.h"
+
+static const char *attr_names[CG_ATTR_COUNT] = {
+    "cgroup.procs",
+    "cgroup.threads",
+    "cgroup.events",
+    "cgroup.subtree_control",
+    "cpu.max",
+    "cpu.weight",
+    "cpu.stat",
+    "cpu.pressure",
+    "memory.current",
+    "memory.max",
+    "memory.high",
+    "memory.stat",
+    "memory.events",
+    "memory.pressure",
+    "io.max",
+    "io.stat",
+    "io.pressure",
+    "pids.max",
+    "pids.current",
+    "pids.events",
+    "cpuset.cpus",
+    "cgroup.controllers",
+    "cpu.max.burst",
+    "cpu.cfs_period_us",
+    "cpu.cfs_quota_us",
+    "cpu.cfs_burst_us",
+    "cpuacct.usage",
+};
+
+const char *cgroup_attr_name(CgroupAttr attr) {
+    return (attr >= 0 && attr < CG_ATTR_COUNT) ? attr_names[attr] : "?";
+}
+
+static void init_fds(CgroupHandle *h) {
+    for (int i = 0; i < CG_ATTR_COUNT; ++i) {
+        atomic_init(&h->rfds[i], -1);
+        atomic_init(&h->wfds[i], -1);
+    }
+}
+
+int cgroup_handle_openat(CgroupHandle *h, int parentfd, const char *relpath) {
+    init_fds(h);
+    h->dirfd = openat(parentfd, relpath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    return (h->dirfd >= 0) ? 0 : -1;
+}
+
+int cgroup_handle_open(CgroupHandle *h, const char *name) {
+    if (name[0] == '/') return cgroup_handle_openat(h, AT_FDCWD, name);
+
+    int rootfd = open(sysroot_cgroup(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (rootfd < 0) {
+        init_fds(h);
+        h->dirfd = -1;
+        return -1;
+    }
+    int rc = cgroup_handle_openat(h, rootfd, name);
+    int saved = errno;
+    close(rootfd);
+    errno = saved;
+    return rc;
+}
+
+void cgroup_handle_close(CgroupHandle *h) {
+    for (int i = 0; i < CG_ATTR_COUNT; ++i) {
+        int fd = atomic_exchange(&h->rfds[i], -1);
+        if (fd >= 0) close(fd);
+        fd = atomic_exchange(&h->wfds[i], -1);
+        if (fd >= 0) close(fd);
+    }
+    if (h->dirfd >= 0) close(h->dirfd);
+    h->dirfd = -1;
+}
+
+/* Cached descriptor for attr, opening it on first use. Two threads may race to
+ * open the same file; the loser closes its copy and uses the published one. */
+static int attr_fd(CgroupHandle *h, CgroupAttr attr, int write) {
+    if (attr < 0 || attr >= CG_ATTR_COUNT) {
+        errno = EINVAL;
+        return -1;
+    }
+    _Atomic int *slot = write ? &h->wfds[attr] : &h->rfds[attr];
+    int fd = atomic_load_explicit(slot, memory_order_acquire);
+    if (fd >= 0) return fd;
+
+    fd = openat(h->dirfd, attr_names[attr], (write ? O_WRONLY : O_RDONLY) | O_CLOEXEC);
+    if (fd < 0) return -1;
+    int expected = -1;
+    if (!atomic_compare_exchange_strong_explicit(slot, &expected, fd,
+                                                 memory_order_acq_rel, memory_order_acquire)) {
+        close(fd);
+        fd = expected;
+    }
+    return fd;
+}
+
+ssize_t cgroup_handle_read(CgroupHandle *h, CgroupAttr attr, char *buf, size_t len) {
+    if (len == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    int fd = attr_fd(h, attr, 0);
+    if (fd < 0) return -1;
+    size_t off = 0;
+    while (off < len - 1) {
+        ssize_t r = pread(fd, buf + off, len - 1 - off, (off_t)off);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (r == 0) break;
+        off += (size_t)r;
+    }
+    buf[off] = '\0';
+    return (ssize_t)off;
+}
+
+int cgroup_handle_write(CgroupHandle *h, CgroupAttr attr, const char *data) {
+    int fd = attr_fd(h, attr, 1);
+    if (fd < 0) return -1;
+    size_t n = strlen(data);
+    ssize_t w;
+    do {
+        w = pwrite(fd, data, n, 0);
+    } while (w < 0 && errno == EINTR);
+    if (w < 0) return -1;
+    if ((size_t)w != n) {
+        errno = EIO;
+        return -1;
+    }
+    return 0;
+}
+
+int cgroup_handle_read_ull(CgroupHandle *h, CgroupAttr attr, unsigned long long *value) {
+    char buf[64];
+    if (cgroup_handle_read(h, attr, buf, sizeof(buf)) < 0) return -1;
+    if (strncmp(buf, "max", 3) == 0) {
+        *value = ULLONG_MAX;
+        return 0;
+    }
+    char *end;
+    errno = 0;
+    *value = strtoull(buf, &end, 10);
+    if (end == buf || errno) {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+int cgroup_handle_read_key(CgroupHandle *h, CgroupAttr attr, const char *key, unsigned long long *value) {
+    char buf[8192];
+    if (cgroup_handle_read(h, attr, buf, sizeof(buf)) < 0) return -1;
+    size_t klen = strlen(key);
+    const char *line = buf;
+    while (*line) {
+        if (strncmp(line, key, klen) == 0 && line[klen] == ' ') {
+            *value = strtoull(line + klen + 1, NULL, 10);
+            return 0;
+        }
+        const char *nl = strchr(line, '\n');
+        if (!nl) break;
+        line = nl + 1;
+    }
+    errno = ENOENT;
+    return -1;
+}
@@ -0,0 +1,286 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../include/cgroup_iostat.h"
+#include "../include/sysroot.h"
+
+int cgroup_parse_io_stat_devices(const char *buf, CgroupIoDev *out, int max) {
+    /* 259:0 rbytes=1 wbytes=2 rios=3 wios=4 dbytes=0 dios=0 [cost.usage=.. cost.wait=..] [avg_lat=..] */
+    int n = 0;
+    const char *line = buf;
+    while (*line && n < max) {
+        const char *nl = strchr(line, '\n');
+        const char *end = nl ? nl : line + strlen(line);
+        CgroupIoDev *d = &out[n];
+        memset(d, 0, sizeof(*d));
+        if (sscanf(line, "%u:%u", &d->major, &d->minor) == 2) {
+            const char *p = strchr(line, ' ');
+            while (p && p < end) {
+                while (*p == ' ') p++;
+                const char *eq = memchr(p, '=', (size_t)(end - p));
+                if (!eq) break;
+                size_t klen = (size_t)(eq - p);
+                char *vend;
+                unsigned long long v = strtoull(eq + 1, &vend, 10);
+                if (klen == 6 && !memcmp(p, "rbytes", 6)) d->rbytes = v;
+                else if (klen == 6 && !memcmp(p, "wbytes", 6)) d->wbytes = v;
+                else if (klen == 4 && !memcmp(p, "rios", 4)) d->rios = v;
+                else if (klen == 4 && !memcmp(p, "wios", 4)) d->wios = v;
+                else if (klen == 6 && !memcmp(p, "dbytes", 6)) d->dbytes = v;
+                else if (klen == 4 && !memcmp(p, "dios", 4)) d->dios = v;
+                else if (klen == 10 && !memcmp(p, "cost.usage", 10)) { d->cost_usage = v; d->has_cost = 1; }
+                else if (klen == 9 && !memcmp(p, "cost.wait", 9)) { d->cost_wait = v; d->has_cost = 1; }
+                else if (klen == 11 && !memcmp(p, "cost.indebt", 11)) { d->cost_indebt = v; d->has_cost = 1; }
+                else if (klen == 7 && !memcmp(p, "avg_lat", 7)) { d->avg_lat = v; d->has_lat = 1; }
+                p = memchr(vend, ' ', (size_t)(end - vend));
+            }
+            n++;
+        }
+        if (!nl) break;
+        line = nl + 1;
+    }
+    return n;
+}
+
+const char *cgroup_iotop_device_name(CgroupIoTop *t, unsigned int major, unsigned int minor) {
+    unsigned int dev = (major << 20) | minor;
+    for (int i = 0; i < t->nnames; ++i) {
+        if (t->names[i].dev == dev) return t->names[i].name;
+    }
+    if (t->nnames == t->names_cap) {
+        int cap = t->names_cap ? t->names_cap * 2 : 16;
+        CgroupIoDevName *n = realloc(t->names, (size_t)cap * sizeof(CgroupIoDevName));
+        if (!n) return "?";
+        t->names = n;
+        t->names_cap = cap;
+    }
+    CgroupIoDevName *e = &t->names[t->nnames++];
+    e->dev = dev;
+    snprintf(e->name, sizeof(e->name), "%u:%u", major, minor);
+
+    char path[64], buf[512];
+    snprintf(path, sizeof(path), "/sys/dev/block/%u:%u/uevent", major, minor);
+    int fd = sysroot_open(path, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        ssize_t r = read(fd, buf, sizeof(buf) - 1);
+        close(fd);
+        if (r > 0) {
+            buf[r] = '\0';
+            char *dn = strstr(buf, "DEVNAME=");
+            if (dn) {
+                dn += 8;
+                size_t len = strcspn(dn, "\n");
+                if (len >= sizeof(e->name)) len = sizeof(e->name) - 1;
+                memcpy(e->name, dn, len);
+                e->name[len] = '\0';
+            }
+        }
+    }
+    return e->name;
+}
+
+static unsigned int hash_key(unsigned long long k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    return (unsigned int)k;
+}
+
+static CgroupIoPrev *prev_slot(CgroupIoTop *t, unsigned long long key) {
+    unsigned int mask = t->nslots - 1;
+    for (unsigned int i = hash_key(key) & mask;; i = (i + 1) & mask) {
+        if (t->slots[i].key == key || t->slots[i].key == 0) return &t->slots[i];
+    }
+}
+
+/* Rehash into n slots; keep_tick >= 0 keeps only entries seen at that tick
+ * (a rescan restarts the tick count, so older entries may carry larger ticks) */
+static int rehash_slots(CgroupIoTop *t, unsigned int n, long long keep_tick) {
+    unsigned int old_n = t->nslots;
+    CgroupIoPrev *old = t->slots;
+    t->slots = calloc(n, sizeof(CgroupIoPrev));
+    if (!t->slots) {
+        t->slots = old;
+        return -1;
+    }
+    t->nslots = n;
+    t->used = 0;
+    for (unsigned int i = 0; i < old_n; ++i) {
+        if (!old[i].key || (keep_tick >= 0 && old[i].tick != keep_tick)) continue;
+        *prev_slot(t, old[i].key) = old[i];
+        t->used++;
+    }
+    free(old);
+    return 0;
+}
+
+/* Room for every device line of buf in the parse scratch */
+static int fit_devs(CgroupIoTop *t, const char *buf) {
+    int lines = 1;
+    for (const char *p = strchr(buf, '\n'); p; p = strchr(p + 1, '\n')) lines++;
+    if (lines <= t->devs_cap) return 0;
+    int cap = t->devs_cap;
+    while (cap < lines) cap *= 2;
+    CgroupIoDev *d = realloc(t->devs, (size_t)cap * sizeof(CgroupIoDev));
+    if (!d) return -1;
+    t->devs = d;
+    t->devs_cap = cap;
+    return 0;
+}
+
+static int grow_slots(CgroupIoTop *t) {
+    return rehash_slots(t, t->nslots ? t->nslots * 2 : 256, -1);
+}
+
+int cgroup_iotop_init(CgroupIoTop *t, const char *root) {
+    memset(t, 0, sizeof(*t));
+    if (cgroup_sampler_init(&t->s, root, 2) != 0) return -1;
+    if (t->s.backend.version != 2) {
+        /* Per-device parsing needs io.stat; v1 blkio totals are in the sampler's CgroupSample */
+        cgroup_iotop_free(t);
+        return -1;
+    }
+    /* io.stat is parsed here per device; the sampler only parses the pressure file */
+    t->s.files_mask = 1u << CG_FILE_IO_PRESSURE;
+    t->devs_cap = 64;
+    t->devs = malloc((size_t)t->devs_cap * sizeof(CgroupIoDev));
+    if (!t->devs || grow_slots(t) != 0) {
+        cgroup_iotop_free(t);
+        return -1;
+    }
+    return 0;
+}
+
+void cgroup_iotop_free(CgroupIoTop *t) {
+    cgroup_sampler_free(&t->s);
+    free(t->slots);
+    free(t->names);
+    free(t->devs);
+    memset(t, 0, sizeof(*t));
+}
+
+static double delta_rate(unsigned long long curr, unsigned long long prev, double elapsed) {
+    return (curr >= prev && elapsed > 0) ? (curr - prev) / elapsed : 0.0;
+}
+
+/* Insert r into out[0..*n) kept sorted by bytes/s descending, capped at top */
+static void top_insert(CgroupIoRate *out, int *n, int top, const CgroupIoRate *r) {
+    double key = r->rbps + r->wbps + r->dbps;
+    if (*n == top && key <= out[top - 1].rbps + out[top - 1].wbps + out[top - 1].dbps) return;
+    int pos = (*n < top) ? (*n)++ : top - 1;
+    while (pos > 0 && out[pos - 1].rbps + out[pos - 1].wbps + out[pos - 1].dbps < key) {
+        out[pos] = out[pos - 1];
+        pos--;
+    }
+    out[pos] = *r;
+}
+
+int cgroup_iotop_tick(CgroupIoTop *t, int top, CgroupIoRate *out) {
+    if (top <= 0) return 0;
+    CgroupSampler *s = &t->s;
+    if (cgroup_sampler_tick(s) < 0) return -1;
+    long long tick = s->ticks;
+    double elapsed = cgroup_sampler_elapsed(s, 1);
+    int n = 0;
+    unsigned int live = 0;
+
+    for (int i = 0; i < s->count; ++i) {
+        const char *buf;
+        if (cgroup_sampler_read_file(s, i, CG_FILE_IO_STAT, &buf) < 0) continue;
+        if (fit_devs(t, buf) != 0) return -1;
+        int ndev = cgroup_parse_io_stat_devices(buf, t->devs, t->devs_cap);
+        const CgroupSample *smp = cgroup_sampler_get(s, 0, i);
+        int has_psi = smp && (smp->valid & (1u << CG_FILE_IO_PRESSURE));
+
+        for (int d = 0; d < ndev; ++d) {
+            const CgroupIoDev *dev = &t->devs[d];
+            if ((t->used + 1) * 10 > t->nslots * 7 && grow_slots(t) != 0) return -1;
+            unsigned long long key = ((unsigned long long)(i + 1) << 32) | ((dev->major << 20) | dev->minor);
+            CgroupIoPrev *slot = prev_slot(t, key);
+            int have_prev = (slot->key == key && slot->tick == tick - 1);
+            if (slot->key == 0) {
+                slot->key = key;
+                t->used++;
+            }
+            if (have_prev) {
+                const CgroupIoDev *p = &slot->prev;
+                CgroupIoRate r;
+                r.node = i;
+                r.major = dev->major;
+                r.minor = dev->minor;
+                r.device = NULL;
+                r.rbps = delta_rate(dev->rbytes, p->rbytes, elapsed);
+                r.wbps = delta_rate(dev->wbytes, p->wbytes, elapsed);
+                r.dbps = delta_rate(dev->dbytes, p->dbytes, elapsed);
+                r.riops = delta_rate(dev->rios, p->rios, elapsed);
+                r.wiops = delta_rate(dev->wios, p->wios, elapsed);
+                r.cost_wait_ms_per_s = dev->has_cost ? delta_rate(dev->cost_wait, p->cost_wait, elapsed) / 1000.0 : -1.0;
+                r.avg_lat_us = dev->has_lat ? (long long)dev->avg_lat : -1;
+                r.io_some_avg10 = has_psi ? smp->io_psi.some.avg10 : -1.0;
+                r.io_full_avg10 = has_psi ? smp->io_psi.full.avg10 : -1.0;
+                if (r.rbps > 0 || r.wbps > 0 || r.dbps > 0 || r.riops > 0 || r.wiops > 0) top_insert(out, &n, top, &r);
+            }
+            slot->prev = *dev;
+            slot->tick = tick;
+            live++;
+        }
+    }
+    /* Cgroups and devices that went away: without this the table only grows */
+    if (t->used > live && rehash_slots(t, t->nslots, tick) != 0) return -1;
+    /* Resolve names last: the name cache may grow, which would move earlier pointers */
+    for (int k = 0; k < n; ++k) {
+        out[k].device = cgroup_iotop_device_name(t, out[k].major, out[k].minor);
+    }
+    return n;
+}
+
+int cgroup_iotop_report(const char *root, int interval_ms, int samples, int top, const char *output_file) {
+    if (interval_ms <= 0) interval_ms = 1000;
+    if (samples <= 0) samples = 5;
+    if (top <= 0) top = 10;
+
+    CgroupIoTop t;
+    if (cgroup_iotop_init(&t, root) != 0) {
+        fprintf(stderr, "cgroup_iotop: cannot open a cgroup v2 hierarchy at %s\n", root ? root : sysroot_cgroup());
+        return -1;
+    }
+    CgroupIoRate *rates = calloc((size_t)top, sizeof(CgroupIoRate));
+    FILE *out = stdout;
+    if (output_file) out = fopen(output_file, "w");
+    if (!rates || !out) {
+        if (!out) perror("fopen");
+        free(rates);
+        cgroup_iotop_free(&t);
+        return -1;
+    }
+
+    fprintf(out, "timestamp_ms,rank,cgroup,device,rbps,wbps,dbps,riops,wiops,io_some_avg10,io_full_avg10,cost_wait_ms_per_s,avg_lat_us\n");
+    int rc = 0;
+    /* One extra tick for the baseline */
+    for (int k = 0; k <= samples; ++k) {
+        int n = cgroup_iotop_tick(&t, top, rates);
+        if (n < 0) { rc = -1; break; }
+        int row = (int)((t.s.ticks - 1) % t.s.max_ticks);
+        for (int j = 0; j < n; ++j) {
+            const CgroupIoRate *r = &rates[j];
+            fprintf(out, "%lld,%d,/%s,%s,%.0f,%.0f,%.0f,%.1f,%.1f,", t.s.timestamps_ms[row], j + 1,
+                    t.s.nodes[r->node].path, r->device, r->rbps, r->wbps, r->dbps, r->riops, r->wiops);
+            if (r->io_some_avg10 >= 0) fprintf(out, "%.2f,%.2f,", r->io_some_avg10, r->io_full_avg10);
+            else fprintf(out, ",,");
+            if (r->cost_wait_ms_per_s >= 0) fprintf(out, "%.2f,", r->cost_wait_ms_per_s);
+            else fprintf(out, ",");
+            if (r->avg_lat_us >= 0) fprintf(out, "%lld\n", r->avg_lat_us);
+            else fprintf(out, "\n");
+        }
+        fflush(out);
+        if (k < samples) usleep((useconds_t)interval_ms * 1000);
+    }
+
+    if (output_file) fclose(out);
+    free(rates);
+    cgroup_iotop_free(&t);
+    return rc;
+}
@@ -0,0 +1,462 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "../include/cgroup_limits.h"
+#include "../include/sysroot.h"
+
+#define CGROUP_LIMITS_MAX_THREADS 64
+
+void cgroup_limits_init(CgroupLimitBatch *b) {
+    memset(b, 0, sizeof(*b));
+}
+
+void cgroup_limits_free(CgroupLimitBatch *b) {
+    for (int i = 0; i < b->nhandles; ++i) cgroup_handle_close(&b->handles[i]);
+    free(b->handles);
+    free(b->handle_names);
+    free(b->entries);
+    memset(b, 0, sizeof(*b));
+}
+
+static void invalid(CgroupLimit *e, const char *msg) {
+    e->status = CG_LIMIT_INVALID;
+    snprintf(e->msg, sizeof(e->msg), "%s", msg);
+}
+
+static int parse_ull(const char *s, unsigned long long *v, const char **end) {
+    if (!isdigit((unsigned char)*s)) return -1;
+    char *e;
+    errno = 0;
+    *v = strtoull(s, &e, 10);
+    if (errno) return -1;
+    *end = e;
+    return 0;
+}
+
+int cgroup_limits_parse_bytes(const char *s, unsigned long long *bytes) {
+    if (strcmp(s, "max") == 0) {
+        *bytes = ULLONG_MAX;
+        return 0;
+    }
+    unsigned long long v;
+    const char *end;
+    if (parse_ull(s, &v, &end) != 0) return -1;
+    int shift = 0;
+    switch (toupper((unsigned char)*end)) {
+    case '\0': break;
+    case 'K': shift = 10; break;
+    case 'M': shift = 20; break;
+    case 'G': shift = 30; break;
+    case 'T': shift = 40; break;
+    default: return -1;
+    }
+    if (shift && end[1] != '\0') return -1;
+    if (shift && v > (~0ULL >> shift)) return -1;
+    *bytes = v << shift;
+    return 0;
+}
+
+/* "max", or a byte count with an optional K/M/G/T suffix */
+static int normalize_bytes(const char *s, char *out, size_t len) {
+    unsigned long long v;
+    if (cgroup_limits_parse_bytes(s, &v) != 0) return -1;
+    if (v == ULLONG_MAX) snprintf(out, len, "max\n");
+    else snprintf(out, len, "%llu\n", v);
+    return 0;
+}
+
+/* "max [period]", "quota [period]" or "quota/period" */
+static int normalize_cpu_max(const char *s, char *out, size_t len) {
+    char q[32], p[32] = "";
+    char tmp[64];
+    snprintf(tmp, sizeof(tmp), "%s", s);
+    for (char *c = tmp; *c; ++c) {
+        if (*c == '/') *c = ' ';
+    }
+    char extra[2];
+    int n = sscanf(tmp, "%31s %31s %1s", q, p, extra);
+    if (n < 1 || n > 2) return -1;
+    unsigned long long quota = 0, period = 0;
+    const char *end;
+    if (strcmp(q, "max") != 0) {
+        /* The kernel accepts quotas from 1 ms up */
+        if (parse_ull(q, &quota, &end) != 0 || *end || quota < 1000) return -1;
+    }
+    if (n == 2 && (parse_ull(p, &period, &end) != 0 || *end || period < 1000 || period > 1000000)) return -1;
+    if (n == 2) snprintf(out, len, "%s %llu\n", q, period);
+    else snprintf(out, len, "%s\n", q);
+    return 0;
+}
+
+/* "M:m key=value ..." with keys rbps/wbps/riops/wiops and numeric or "max" values */
+static int normalize_io_max(const char *s, char *out, size_t len) {
+    unsigned int major, minor;
+    int off = 0;
+    if (sscanf(s, "%u:%u%n", &major, &minor, &off) != 2 || (s[off] != ' ' && s[off] != '\t')) return -1;
+    int w = snprintf(out, len, "%u:%u", major, minor);
+    const char *p = s + off;
+    int nkeys = 0;
+    while (*p) {
+        while (*p == ' ' || *p == '\t') p++;
+        if (!*p) break;
+        const char *eq = strchr(p, '=');
+        if (!eq) return -1;
+        size_t klen = (size_t)(eq - p);
+        if (!((klen == 4 && (!memcmp(p, "rbps", 4) || !memcmp(p, "wbps", 4))) ||
+              (klen == 5 && (!memcmp(p, "riops", 5) || !memcmp(p, "wiops", 5))))) return -1;
+        const char *v = eq + 1;
+        const char *vend;
+        unsigned long long num;
+        if (strncmp(v, "max", 3) == 0) vend = v + 3;
+        else if (parse_ull(v, &num, &vend) != 0) return -1;
+        if (*vend && *vend != ' ' && *vend != '\t') return -1;
+        w += snprintf(out + w, len - (size_t)w, " %.*s", (int)(vend - p), p);
+        if ((size_t)w >= len) return -1;
+        nkeys++;
+        p = vend;
+    }
+    if (nkeys == 0 || (size_t)w + 1 >= len) return -1;
+    out[w++] = '\n';
+    out[w] = '\0';
+    return 0;
+}
+
+int cgroup_limits_add_line(CgroupLimitBatch *b, const char *line, int lineno) {
+    while (isspace((unsigned char)*line)) line++;
+    if (!*line || *line == '#') return 0;
+
+    if (b->count == b->capacity) {
+        int cap = b->capacity ? b->capacity * 2 : 64;
+        CgroupLimit *n = realloc(b->entries, (size_t)cap * sizeof(CgroupLimit));
+        if (!n) return -1;
+        b->entries = n;
+        b->capacity = cap;
+    }
+    CgroupLimit *e = &b->entries[b->count++];
+    memset(e, 0, sizeof(*e));
+    e->line = lineno;
+    e->handle = -1;
+    e->attr = CG_ATTR_COUNT;
+
+    char attr[32], rest[256];
+    int off = 0;
+    if (sscanf(line, "%255s %31s %n", e->cgroup, attr, &off) != 2 || !line[off]) {
+        invalid(e, "expected: <cgroup> <attribute> <value>");
+        b->invalid++;
+        return 0;
+    }
+    snprintf(rest, sizeof(rest), "%s", line + off);
+    size_t rlen = strlen(rest);
+    while (rlen > 0 && isspace((unsigned char)rest[rlen - 1])) rest[--rlen] = '\0';
+
+    int rc;
+    if (strcmp(attr, "cpu.max") == 0) {
+        e->attr = CG_ATTR_CPU_MAX;
+        rc = normalize_cpu_max(rest, e->value, sizeof(e->value));
+    } else if (strcmp(attr, "cpu.weight") == 0) {
+        unsigned long long w;
+        const char *end;
+        e->attr = CG_ATTR_CPU_WEIGHT;
+        rc = (parse_ull(rest, &w, &end) == 0 && !*end && w >= 1 && w <= 10000) ? 0 : -1;
+        if (rc == 0) snprintf(e->value, sizeof(e->value), "%llu\n", w);
+    } else if (strcmp(attr, "memory.max") == 0 || strcmp(attr, "memory.high") == 0) {
+        e->attr = (attr[7] == 'm') ? CG_ATTR_MEMORY_MAX : CG_ATTR_MEMORY_HIGH;
+        rc = normalize_bytes(rest, e->value, sizeof(e->value));
+    } else if (strcmp(attr, "io.max") == 0) {
+        e->attr = CG_ATTR_IO_MAX;
+        rc = normalize_io_max(rest, e->value, sizeof(e->value));
+    } else {
+        invalid(e, "unsupported attribute (cpu.max, cpu.weight, memory.high, memory.max, io.max)");
+        b->invalid++;
+        return 0;
+    }
+    if (rc != 0) {
+        snprintf(e->value, sizeof(e->value), "%s", rest);
+        invalid(e, "malformed value");
+        b->invalid++;
+    }
+    return 0;
+}
+
+int cgroup_limits_load(CgroupLimitBatch *b, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    char *line = NULL;
+    size_t cap = 0;
+    int lineno = 0, rc = 0;
+    while (getline(&line, &cap, f) != -1) {
+        if (cgroup_limits_add_line(b, line, ++lineno) != 0) {
+            rc = -1;
+            break;
+        }
+    }
+    free(line);
+    fclose(f);
+    return rc < 0 ? -1 : b->count;
+}
+
+static int safe_relpath(const char *p) {
+    if (p[0] == '/' || p[0] == '\0') return 0;
+    for (const char *c = p; *c;) {
+        if (c[0] == '.' && c[1] == '.' && (c[2] == '/' || c[2] == '\0')) return 0;
+        const char *slash = strchr(c, '/');
+        if (!slash) break;
+        c = slash + 1;
+    }
+    return 1;
+}
+
+static int find_handle(CgroupLimitBatch *b, int rootfd, const char *name, int *err) {
+    for (int i = b->nhandles - 1; i >= 0; --i) {
+        if (strcmp(b->handle_names[i], name) == 0) return i;
+    }
+    if (b->nhandles == b->handles_cap) {
+        int cap = b->handles_cap ? b->handles_cap * 2 : 32;
+        CgroupHandle *h = realloc(b->handles, (size_t)cap * sizeof(CgroupHandle));
+        if (!h) return -1;
+        b->handles = h;
+        char (*n)[256] = realloc(b->handle_names, (size_t)cap * sizeof(*n));
+        if (!n) return -1;
+        b->handle_names = n;
+        b->handles_cap = cap;
+    }
+    CgroupHandle *h = &b->handles[b->nhandles];
+    if (cgroup_handle_openat(h, rootfd, name) != 0) {
+        *err = errno;
+        return -1;
+    }
+    snprintf(b->handle_names[b->nhandles], sizeof(b->handle_names[0]), "%s", name);
+    return b->nhandles++;
+}
+
+/* Value to write back: the whole file for single-value attributes, the device's
+ * line (or "no limit") for io.max, which holds one line per limited device. */
+static int capture_old(CgroupLimit *e, const char *cur) {
+    if (e->attr != CG_ATTR_IO_MAX) {
+        size_t n = strcspn(cur, "\n");
+        if (n == 0 || n + 2 > sizeof(e->old)) return -1;
+        snprintf(e->old, sizeof(e->old), "%.*s\n", (int)n, cur);
+        return 0;
+    }
+    unsigned int major, minor;
+    sscanf(e->value, "%u:%u", &major, &minor);
+    char dev[32];
+    int dlen = snprintf(dev, sizeof(dev), "%u:%u ", major, minor);
+    for (const char *line = cur; *line;) {
+        size_t n = strcspn(line, "\n");
+        if (strncmp(line, dev, (size_t)dlen) == 0) {
+            if (n + 2 > sizeof(e->old)) return -1;
+            snprintf(e->old, sizeof(e->old), "%.*s\n", (int)n, line);
+            return 0;
+        }
+        line += n;
+        if (*line) line++;
+    }
+    snprintf(e->old, sizeof(e->old), "%u:%u rbps=max wbps=max riops=max wiops=max\n", major, minor);
+    return 0;
+}
+
+static int same_target(const CgroupLimit *a, const CgroupLimit *b) {
+    if (a->handle != b->handle || a->attr != b->attr) return 0;
+    if (a->attr != CG_ATTR_IO_MAX) return 1;
+    return strncmp(a->value, b->value, strcspn(a->value, " ")) == 0 &&
+           strcspn(a->value, " ") == strcspn(b->value, " ");
+}
+
+int cgroup_limits_validate(CgroupLimitBatch *b, const char *root) {
+    int rootfd = open(root ? root : sysroot_cgroup(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (rootfd < 0) return -1;
+
+    char cur[4096];
+    for (int i = 0; i < b->count; ++i) {
+        CgroupLimit *e = &b->entries[i];
+        if (e->status == CG_LIMIT_INVALID) continue;
+        if (!safe_relpath(e->cgroup)) {
+            invalid(e, "cgroup must be a relative path below the root");
+            b->invalid++;
+            continue;
+        }
+        int err = 0;
+        e->handle = find_handle(b, rootfd, e->cgroup, &err);
+        if (e->handle < 0) {
+            invalid(e, err ? strerror(err) : "out of memory");
+            b->invalid++;
+            continue;
+        }
+        /* Reading the current value doubles as the "controller enabled" check */
+        if (cgroup_handle_read(&b->handles[e->handle], e->attr, cur, sizeof(cur)) < 0) {
+            invalid(e, errno == ENOENT ? "controller not enabled for this cgroup" : strerror(errno));
+            b->invalid++;
+            continue;
+        }
+        if (capture_old(e, cur) != 0) {
+            invalid(e, "cannot capture current value");
+            b->invalid++;
+            continue;
+        }
+        for (int j = i - 1; j >= 0; --j) {
+            if (b->entries[j].status != CG_LIMIT_INVALID && same_target(e, &b->entries[j])) {
+                char msg[48];
+                snprintf(msg, sizeof(msg), "duplicate of line %d", b->entries[j].line);
+                invalid(e, msg);
+                b->invalid++;
+                break;
+            }
+        }
+    }
+    close(rootfd);
+    return b->invalid;
+}
+
+typedef struct {
+    CgroupLimitBatch *b;
+    atomic_int next;
+    atomic_int abort;           /* set on the first failure when rolling back */
+    int rollback;
+    int restore;                /* 0: apply new values, 1: restore old ones */
+} ApplyCtx;
+
+static void *apply_worker(void *arg) {
+    ApplyCtx *c = arg;
+    CgroupLimitBatch *b = c->b;
+    for (;;) {
+        int i = atomic_fetch_add_explicit(&c->next, 1, memory_order_relaxed);
+        if (i >= b->count) break;
+        CgroupLimit *e = &b->entries[i];
+        CgroupHandle *h = &b->handles[e->handle];
+        if (c->restore) {
+            if (e->status != CG_LIMIT_APPLIED) continue;
+            if (cgroup_handle_write(h, e->attr, e->old) == 0) {
+                e->status = CG_LIMIT_ROLLED_BACK;
+            } else {
+                e->status = CG_LIMIT_ROLLBACK_FAILED;
+                e->err = errno;
+            }
+            continue;
+        }
+        if (atomic_load_explicit(&c->abort, memory_order_relaxed)) {
+            e->status = CG_LIMIT_SKIPPED;
+            continue;
+        }
+        if (cgroup_handle_write(h, e->attr, e->value) == 0) {
+            e->status = CG_LIMIT_APPLIED;
+        } else {
+            e->status = CG_LIMIT_FAILED;
+            e->err = errno;
+            if (c->rollback) atomic_store_explicit(&c->abort, 1, memory_order_relaxed);
+        }
+    }
+    return NULL;
+}
+
+static void run_workers(ApplyCtx *c, int threads) {
+    pthread_t tids[CGROUP_LIMITS_MAX_THREADS];
+    int started = 0;
+    atomic_store(&c->next, 0);
+    /* The calling thread is one of the workers */
+    for (int t = 1; t < threads; ++t) {
+        if (pthread_create(&tids[started], NULL, apply_worker, c) != 0) break;
+        started++;
+    }
+    apply_worker(c);
+    for (int t = 0; t < started; ++t) pthread_join(tids[t], NULL);
+}
+
+int cgroup_limits_apply(CgroupLimitBatch *b, int threads, int rollback) {
+    if (b->invalid > 0) return -1;
+    for (int i = 0; i < b->count; ++i) {
+        if (b->entries[i].handle < 0) return -1;   /* not validated */
+    }
+    if (threads <= 0) threads = 8;
+    if (threads > CGROUP_LIMITS_MAX_THREADS) threads = CGROUP_LIMITS_MAX_THREADS;
+    if (threads > b->count) threads = b->count ? b->count : 1;
+
+    ApplyCtx c = { .b = b, .rollback = rollback, .restore = 0 };
+    atomic_init(&c.next, 0);
+    atomic_init(&c.abort, 0);
+    run_workers(&c, threads);
+
+    b->failed = 0;
+    for (int i = 0; i < b->count; ++i) {
+        if (b->entries[i].status == CG_LIMIT_FAILED) b->failed++;
+    }
+    if (b->failed == 0) return 0;
+    if (rollback) {
+        c.restore = 1;
+        run_workers(&c, threads);
+    }
+    return -1;
+}
+
+static const char *status_name(CgroupLimitStatus s) {
+    switch (s) {
+    case CG_LIMIT_PENDING: return "pending";
+    case CG_LIMIT_INVALID: return "invalid";
+    case CG_LIMIT_APPLIED: return "applied";
+    case CG_LIMIT_FAILED: return "failed";
+    case CG_LIMIT_SKIPPED: return "skipped";
+    case CG_LIMIT_ROLLED_BACK: return "rolled back";
+    case CG_LIMIT_ROLLBACK_FAILED: return "ROLLBACK FAILED";
+    }
+    return "?";
+}
+
+void cgroup_limits_print(const CgroupLimitBatch *b, FILE *out) {
+    int counts[CG_LIMIT_ROLLBACK_FAILED + 1] = {0};
+    for (int i = 0; i < b->count; ++i) {
+        const CgroupLimit *e = &b->entries[i];
+        counts[e->status]++;
+        if (e->status == CG_LIMIT_APPLIED || e->status == CG_LIMIT_PENDING) continue;
+        const char *why = e->msg[0] ? e->msg : (e->err ? strerror(e->err) : "");
+        fprintf(out, "line %d: %s %s %.*s: %s%s%s\n", e->line, e->cgroup,
+                e->attr < CG_ATTR_COUNT ? cgroup_attr_name(e->attr) : "?",
+                (int)strcspn(e->value, "\n"), e->value, status_name(e->status), why[0] ? ": " : "", why);
+    }
+    fprintf(out, "%d entries across %d cgroups: %d applied, %d invalid, %d failed, %d skipped, %d rolled back",
+            b->count, b->nhandles, counts[CG_LIMIT_APPLIED], counts[CG_LIMIT_INVALID], counts[CG_LIMIT_FAILED],
+            counts[CG_LIMIT_SKIPPED], counts[CG_LIMIT_ROLLED_BACK]);
+    if (counts[CG_LIMIT_ROLLBACK_FAILED]) fprintf(out, ", %d rollback failures", counts[CG_LIMIT_ROLLBACK_FAILED]);
+    fprintf(out, "\n");
+}
+
+int cgroup_apply_limits(const char *path, const char *root, int threads, int rollback, int dry_run) {
+    CgroupLimitBatch b;
+    cgroup_limits_init(&b);
+    if (cgroup_limits_load(&b, path) < 0) {
+        perror(path);
+        cgroup_limits_free(&b);
+        return -1;
+    }
+    if (cgroup_limits_validate(&b, root) < 0) {
+        perror(root ? root : sysroot_cgroup());
+        cgroup_limits_free(&b);
+        return -1;
+    }
+    int rc;
+    if (b.invalid > 0) {
+        fprintf(stderr, "Validation failed, nothing was written\n");
+        cgroup_limits_print(&b, stderr);
+        rc = -1;
+    } else if (dry_run) {
+        for (int i = 0; i < b.count; ++i) {
+            const CgroupLimit *e = &b.entries[i];
+            printf("%s %s: %.*s -> %.*s\n", e->cgroup, cgroup_attr_name(e->attr), (int)strcspn(e->old, "\n"),
+                   e->old, (int)strcspn(e->value, "\n"), e->value);
+        }
+        printf("%d entries across %d cgroups validated (dry run)\n", b.count, b.nhandles);
+        rc = 0;
+    } else {
+        rc = cgroup_limits_apply(&b, threads, rollback);
+        cgroup_limits_print(&b, rc == 0 ? stdout : stderr);
+    }
+    cgroup_limits_free(&b);
+    return rc;
+}
@@ -9,18 +9,10 @@
 #include <errno.h>
 #include <fcntl.h>
 #include "../include/cgroup.h"
+#include "../include/cgroup_handle.h"
+#include "../include/sysroot.h"
 
 /* Minimal helper: join base cgroup path for v2 (/sys/fs/cgroup) or accept full path */
-static const char *CGROUP_ROOT = "/sys/fs/cgroup";
-
-static int write_file(const char *path, const char *data) {
-    int fd = open(path, O_WRONLY | O_CLOEXEC);
-    if (fd < 0) return -1;
-    ssize_t w = write(fd, data, strlen(data));
-    close(fd);
-    return (w == (ssize_t)strlen(data)) ? 0 : -1;
-}
-
 int cgroup_read_metrics(const char *cgroup_path) {
     /* Try to read some common cgroup v2 files: cpu.stat, memory.current, io.stat, cgroup.stat */
     char path[512];
@@ -48,7 +40,7 @@ int cgroup_read_metrics(const char *cgroup_path) {
     if (!any) {
         /* try with root prefix */
         for (int i = 0; probes[i].file; ++i) {
-            snprintf(path, sizeof(path), "%s/%s/%s", CGROUP_ROOT, cgroup_path, probes[i].file);
+            snprintf(path, sizeof(path), "%s/%s/%s", sysroot_cgroup(), cgroup_path, probes[i].file);
             FILE *f = fopen(path, "r");
             if (!f) continue;
             printf("--- %s (%s) ---\n", probes[i].label, path);
@@ -59,7 +51,7 @@ int cgroup_read_metrics(const char *cgroup_path) {
         }
     }
     if (!any) {
-        fprintf(stderr, "No cgroup metrics found under '%s' or '%s/%s'\n", cgroup_path, CGROUP_ROOT, cgroup_path);
+        fprintf(stderr, "No cgroup metrics found under '%s' or '%s/%s'\n", cgroup_path, sysroot_cgroup(), cgroup_path);
         return -1;
     }
     return 0;
@@ -68,7 +60,7 @@ int cgroup_read_metrics(const char *cgroup_path) {
 int cgroup_create(const char *name) {
     /* Create a new subtree in cgroup v2 by making a directory under /sys/fs/cgroup/<name> */
     char path[512];
-    snprintf(path, sizeof(path), "%s/%s", CGROUP_ROOT, name);
+    snprintf(path, sizeof(path), "%s/%s", sysroot_cgroup(), name);
     if (mkdir(path, 0755) == 0) {
         printf("Created cgroup: %s\n", path);
         return 0;
@@ -82,61 +74,59 @@ int cgroup_create(const char *name) {
 }
 
 int cgroup_set_cpu_limit_quota(const char *name, long quota, long period) {
-    char path[512];
-    snprintf(path, sizeof(path), "%s/%s/cpu.max", CGROUP_ROOT, name);
-    FILE *f = fopen(path, "w");
-    if (!f) { perror("open cpu.max"); return -1; }
-    if (quota < 0) fprintf(f, "max %ld\n", period);
-    else fprintf(f, "%ld %ld\n", quota, period);
-    fclose(f);
+    CgroupHandle h;
+    if (cgroup_handle_open(&h, name) != 0) { perror("open cgroup"); return -1; }
+    char buf[64];
+    if (quota < 0) snprintf(buf, sizeof(buf), "max %ld\n", period);
+    else snprintf(buf, sizeof(buf), "%ld %ld\n", quota, period);
+    int rc = cgroup_handle_write(&h, CG_ATTR_CPU_MAX, buf);
+    if (rc != 0) perror("write cpu.max");
+    cgroup_handle_close(&h);
+    if (rc != 0) return -1;
     printf("cpu.max set for %s to %ld/%ld\n", name, quota, period);
     return 0;
 }
 
 int cgroup_set_memory_max(const char *name, unsigned long bytes) {
-    char path[512];
-    snprintf(path, sizeof(path), "%s/%s/memory.max", CGROUP_ROOT, name);
-    FILE *f = fopen(path, "w");
-    if (!f) { perror("open memory.max"); return -1; }
-    fprintf(f, "%lu\n", bytes);
-    fclose(f);
+    CgroupHandle h;
+    if (cgroup_handle_open(&h, name) != 0) { perror("open cgroup"); return -1; }
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%lu\n", bytes);
+    int rc = cgroup_handle_write(&h, CG_ATTR_MEMORY_MAX, buf);
+    if (rc != 0) perror("write memory.max");
+    cgroup_handle_close(&h);
+    if (rc != 0) return -1;
     printf("memory.max set for %s to %lu bytes\n", name, bytes);
     return 0;
 }
 
 int cgroup_move_pid(const char *cgroup_path, pid_t pid) {
-    /* Move a PID into a cgroup by writing to cgroup.procs (v2) or tasks (v1) */
-    char path[512];
-    int ret = -1;
-    /* try direct path */
-    snprintf(path, sizeof(path), "%s/%s", cgroup_path, "cgroup.procs");
-    if (access(path, W_OK) == 0) {
-        char tmp[64];
-        snprintf(tmp, sizeof(tmp), "%d", (int)pid);
-        ret = write_file(path, tmp);
-        if (ret == 0) {
-            printf("Moved pid %d to %s (via cgroup.procs)\n", (int)pid, cgroup_path);
-            return 0;
-        }
+    /* Move a PID into a cgroup by writing to cgroup.procs (v2, and v1 hierarchies
+     * that have it) or tasks (older v1). Absolute paths are used as given,
+     * anything else is relative to the cgroup root. */
+    CgroupHandle h;
+    if (cgroup_handle_open(&h, cgroup_path) != 0) {
+        fprintf(stderr, "Failed to open cgroup %s: %s\n", cgroup_path, strerror(errno));
+        return -1;
     }
-    /* try with root prefix */
-    snprintf(path, sizeof(path), "%s/%s/%s", CGROUP_ROOT, cgroup_path, "cgroup.procs");
-    if (access(path, W_OK) == 0) {
-        char tmp[64];
-        snprintf(tmp, sizeof(tmp), "%d", (int)pid);
-        ret = write_file(path, tmp);
-        if (ret == 0) {
-            printf("Moved pid %d to %s (via %s)\n", (int)pid, cgroup_path, path);
-            return 0;
-        }
+    char tmp[32];
+    snprintf(tmp, sizeof(tmp), "%d\n", (int)pid);
+    const char *via = "cgroup.procs";
+    int rc = cgroup_handle_write(&h, CG_ATTR_PROCS, tmp);
+    if (rc != 0 && errno == ENOENT) {
+        via = "tasks";
+        int fd = openat(h.dirfd, "tasks", O_WRONLY | O_CLOEXEC);
+        rc = (fd >= 0 && write(fd, tmp, strlen(tmp)) == (ssize_t)strlen(tmp)) ? 0 : -1;
+        int err = errno;
+        if (fd >= 0) close(fd);
+        errno = err;
     }
-    /* fallback: try tasks file (cgroups v1) */
-    snprintf(path, sizeof(path), "%s/%s/%s", CGROUP_ROOT, cgroup_path, "tasks");
-    if (access(path, W_OK) == 0) {
-        char tmp[64]; snprintf(tmp, sizeof(tmp), "%d", (int)pid);
-        ret = write_file(path, tmp);
-        if (ret == 0) { printf("Moved pid %d to %s (via tasks)\n", (int)pid, path); return 0; }
+    int err = errno;
+    cgroup_handle_close(&h);
+    if (rc != 0) {
+        fprintf(stderr, "Failed to move pid %d into cgroup %s: %s\n", (int)pid, cgroup_path, strerror(err));
+        return -1;
     }
-    fprintf(stderr, "Failed to move pid %d into cgroup %s (no writable cgroup.procs/tasks found)\n", (int)pid, cgroup_path);
-    return -1;
+    printf("Moved pid %d to %s (via %s)\n", (int)pid, cgroup_path, via);
+    return 0;
 }
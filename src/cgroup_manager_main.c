@@ -3,14 +3,33 @@
 #include <string.h>
 #include <unistd.h>
 #include "../include/cgroup.h"
+#include "../include/cgroup_sampler.h"
+#include "../include/cgroup_events.h"
+#include "../include/cgroup_throttle.h"
+#include "../include/cgroup_memstat.h"
+#include "../include/cgroup_iostat.h"
+#include "../include/cgroup_limits.h"
+#include "../include/cgroup_spawn.h"
+#include "../include/cgroup_autoscale.h"
+#include "../include/experiments.h"
 
 static void usage(const char *p) {
     fprintf(stderr, "Usage:\n");
     fprintf(stderr, "  %s read <cgroup_path>\n", p);
     fprintf(stderr, "  %s create <name>\n", p);
     fprintf(stderr, "  %s move <cgroup_path> <pid>\n", p);
+    fprintf(stderr, "  %s run <cgroup> [--] <command> [args...]\n", p);
     fprintf(stderr, "  %s set-cpu <name> <quota> <period>\n", p);
     fprintf(stderr, "  %s set-mem <name> <bytes>\n", p);
+    fprintf(stderr, "  %s apply <limits-file> [--dry-run] [--no-rollback] [--threads N] [--root DIR]\n", p);
+    fprintf(stderr, "  %s autoscale <targets-file> [--interval ms] [--ticks N] [--dry-run] [--root DIR] [--out log.csv]\n", p);
+    fprintf(stderr, "  %s sample [root] [interval_ms] [samples] [out.csv]\n", p);
+    fprintf(stderr, "  %s watch [root] [duration_s] [out.csv]\n", p);
+    fprintf(stderr, "  %s throttle [root] [interval_ms] [samples] [percentile] [top]\n", p);
+    fprintf(stderr, "  %s memstat [root] [interval_ms] [samples] [out.csv]\n", p);
+    fprintf(stderr, "  %s io-top [root] [interval_ms] [samples] [top] [out.csv]\n", p);
+    fprintf(stderr, "  %s throttle-sweep [--quotas max,20,50,80] [--periods 10000,100000] [--bursts 0,50]\n"
+                    "      [--duration ms] [--parallel N] [out.csv]\n", p);
 }
 
 int main(int argc, char **argv) {
@@ -25,6 +44,12 @@ int main(int argc, char **argv) {
         if (argc < 4) { usage(argv[0]); return 1; }
         pid_t pid = (pid_t)atoi(argv[3]);
         return cgroup_move_pid(argv[2], pid);
+    } else if (strcmp(argv[1], "run") == 0) {
+        int cmd = 3;
+        if (argc > cmd && strcmp(argv[cmd], "--") == 0) cmd++;
+        if (argc <= cmd) { usage(argv[0]); return 1; }
+        int rc = cgroup_run(argv[2], argv + cmd);
+        return rc < 0 ? 1 : rc;
     } else if (strcmp(argv[1], "set-cpu") == 0) {
         if (argc < 5) { usage(argv[0]); return 1; }
         long quota = atol(argv[3]);
@@ -34,6 +59,75 @@ int main(int argc, char **argv) {
         if (argc < 4) { usage(argv[0]); return 1; }
         unsigned long bytes = strtoul(argv[3], NULL, 10);
         return cgroup_set_memory_max(argv[2], bytes);
+    } else if (strcmp(argv[1], "apply") == 0) {
+        if (argc < 3) { usage(argv[0]); return 1; }
+        const char *root = NULL;
+        int threads = 0, rollback = 1, dry_run = 0;
+        for (int i = 3; i < argc; ++i) {
+            if (strcmp(argv[i], "--dry-run") == 0) dry_run = 1;
+            else if (strcmp(argv[i], "--no-rollback") == 0) rollback = 0;
+            else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--root") == 0 && i + 1 < argc) root = argv[++i];
+            else { usage(argv[0]); return 1; }
+        }
+        return cgroup_apply_limits(argv[2], root, threads, rollback, dry_run) == 0 ? 0 : 1;
+    } else if (strcmp(argv[1], "autoscale") == 0) {
+        if (argc < 3) { usage(argv[0]); return 1; }
+        const char *root = NULL, *out = NULL;
+        int interval = 1000, ticks = 0, dry_run = 0;
+        for (int i = 3; i < argc; ++i) {
+            if (strcmp(argv[i], "--dry-run") == 0) dry_run = 1;
+            else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) interval = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) ticks = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--root") == 0 && i + 1 < argc) root = argv[++i];
+            else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) out = argv[++i];
+            else { usage(argv[0]); return 1; }
+        }
+        return cgroup_autoscale(argv[2], root, interval, ticks, dry_run, out) == 0 ? 0 : 1;
+    } else if (strcmp(argv[1], "sample") == 0) {
+        const char *root = (argc > 2) ? argv[2] : NULL;
+        int interval = (argc > 3) ? atoi(argv[3]) : 1000;
+        int samples = (argc > 4) ? atoi(argv[4]) : 1;
+        const char *out = (argc > 5) ? argv[5] : NULL;
+        return cgroup_sample_hierarchy(root, interval, samples, out);
+    } else if (strcmp(argv[1], "watch") == 0) {
+        const char *root = (argc > 2) ? argv[2] : NULL;
+        int duration = (argc > 3) ? atoi(argv[3]) : 0;
+        const char *out = (argc > 4) ? argv[4] : NULL;
+        return cgroup_watch_events(root, duration, out);
+    } else if (strcmp(argv[1], "throttle") == 0) {
+        const char *root = (argc > 2) ? argv[2] : NULL;
+        int interval = (argc > 3) ? atoi(argv[3]) : 1000;
+        int samples = (argc > 4) ? atoi(argv[4]) : 10;
+        double pct = (argc > 5) ? atof(argv[5]) : 99.0;
+        int top = (argc > 6) ? atoi(argv[6]) : 10;
+        return cgroup_throttle_report(root, interval, samples, pct, top, NULL);
+    } else if (strcmp(argv[1], "memstat") == 0) {
+        const char *root = (argc > 2) ? argv[2] : NULL;
+        int interval = (argc > 3) ? atoi(argv[3]) : 1000;
+        int samples = (argc > 4) ? atoi(argv[4]) : 1;
+        const char *out = (argc > 5) ? argv[5] : NULL;
+        return cgroup_memstat_report(root, interval, samples, out);
+    } else if (strcmp(argv[1], "io-top") == 0) {
+        const char *root = (argc > 2) ? argv[2] : NULL;
+        int interval = (argc > 3) ? atoi(argv[3]) : 1000;
+        int samples = (argc > 4) ? atoi(argv[4]) : 5;
+        int top = (argc > 5) ? atoi(argv[5]) : 10;
+        const char *out = (argc > 6) ? argv[6] : NULL;
+        return cgroup_iotop_report(root, interval, samples, top, out);
+    } else if (strcmp(argv[1], "throttle-sweep") == 0) {
+        const char *quotas = NULL, *periods = NULL, *bursts = NULL, *out = NULL;
+        int duration = 2000, parallel = 0;
+        for (int i = 2; i < argc; ++i) {
+            if (strcmp(argv[i], "--quotas") == 0 && i + 1 < argc) quotas = argv[++i];
+            else if (strcmp(argv[i], "--periods") == 0 && i + 1 < argc) periods = argv[++i];
+            else if (strcmp(argv[i], "--bursts") == 0 && i + 1 < argc) bursts = argv[++i];
+            else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) duration = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--parallel") == 0 && i + 1 < argc) parallel = atoi(argv[++i]);
+            else if (argv[i][0] != '-' && !out) out = argv[i];
+            else { usage(argv[0]); return 1; }
+        }
+        return experiment_cpu_throttling_sweep(quotas, periods, bursts, duration, parallel, out) == 0 ? 0 : 1;
     } else {
         usage(argv[0]);
         return 1;
@@ -0,0 +1,191 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../include/cgroup_memstat.h"
+#include "../include/cgroup_sampler.h"
+#include "../include/sysroot.h"
+
+static const char *memstat_names[CG_MEMSTAT_COUNT] = {
+    "anon",
+    "file",
+    "kernel",
+    "kernel_stack",
+    "pagetables",
+    "percpu",
+    "sock",
+    "vmalloc",
+    "shmem",
+    "zswap",
+    "file_mapped",
+    "file_dirty",
+    "file_writeback",
+    "swapcached",
+    "anon_thp",
+    "inactive_anon",
+    "active_anon",
+    "inactive_file",
+    "active_file",
+    "unevictable",
+    "slab_reclaimable",
+    "slab_unreclaimable",
+    "slab",
+    "workingset_refault",
+    "workingset_refault_anon",
+    "workingset_refault_file",
+    "workingset_activate",
+    "workingset_activate_anon",
+    "workingset_activate_file",
+    "workingset_restore_anon",
+    "workingset_restore_file",
+    "workingset_nodereclaim",
+    "pgfault",
+    "pgmajfault",
+    "pgrefill",
+    "pgscan",
+    "pgsteal",
+    "pgactivate",
+    "pgdeactivate",
+    "pglazyfree",
+    "thp_fault_alloc",
+};
+
+const char *cgroup_memstat_name(CgroupMemStatField field) {
+    return (field >= 0 && field < CG_MEMSTAT_COUNT) ? memstat_names[field] : "?";
+}
+
+void cgroup_memstat_layout_init(CgroupMemStatLayout *layout) {
+    memset(layout, 0, sizeof(*layout));
+}
+
+static int layout_build(CgroupMemStatLayout *layout, const char *buf) {
+    int rebuilds = layout->rebuilds + 1;
+    memset(layout, 0, sizeof(*layout));
+    layout->rebuilds = rebuilds;
+    const char *line = buf;
+    while (*line && layout->nlines < CG_MEMSTAT_MAX_LINES) {
+        const char *sp = strchr(line, ' ');
+        const char *nl = strchr(line, '\n');
+        if (!sp || (nl && nl < sp) || sp - line > 255) return -1;
+        int i = layout->nlines++;
+        size_t klen = (size_t)(sp - line);
+        layout->klen[i] = (unsigned char)klen;
+        layout->first[i] = line[0];
+        layout->field[i] = -1;
+        for (int f = 0; f < CG_MEMSTAT_COUNT; ++f) {
+            if (strlen(memstat_names[f]) == klen && memcmp(memstat_names[f], line, klen) == 0) {
+                layout->field[i] = (short)f;
+                break;
+            }
+        }
+        if (!nl) break;
+        line = nl + 1;
+    }
+    return 0;
+}
+
+/* Fast path: walk lines by position and trust the layout */
+static int parse_with_layout(const CgroupMemStatLayout *layout, const char *buf, unsigned long long *values) {
+    const char *p = buf;
+    int i = 0;
+    for (; *p; ++i) {
+        if (i >= layout->nlines) return -1;
+        size_t klen = layout->klen[i];
+        if (p[0] != layout->first[i] || p[klen] != ' ') return -1;
+        char *end;
+        unsigned long long v = strtoull(p + klen + 1, &end, 10);
+        if (layout->field[i] >= 0) values[layout->field[i]] = v;
+        if (*end != '\n') {
+            if (*end) return -1;
+            p = end;
+            i++;
+            break;
+        }
+        p = end + 1;
+    }
+    return (i == layout->nlines) ? i : -1;
+}
+
+int cgroup_memstat_parse(CgroupMemStatLayout *layout, const char *buf, unsigned long long *values) {
+    memset(values, 0, CG_MEMSTAT_COUNT * sizeof(unsigned long long));
+    if (layout->nlines > 0) {
+        int n = parse_with_layout(layout, buf, values);
+        if (n >= 0) return n;
+        memset(values, 0, CG_MEMSTAT_COUNT * sizeof(unsigned long long));
+    }
+    if (layout_build(layout, buf) != 0) return -1;
+    return parse_with_layout(layout, buf, values);
+}
+
+static double rate(const unsigned long long *curr, const unsigned long long *prev, int field, double elapsed_s) {
+    if (!prev || elapsed_s <= 0 || curr[field] < prev[field]) return 0.0;
+    return (curr[field] - prev[field]) / elapsed_s;
+}
+
+void cgroup_memstat_derive(unsigned long long memory_current, const unsigned long long *curr,
+                           const unsigned long long *prev, double elapsed_s, CgroupMemDerived *out) {
+    unsigned long long inactive_file = curr[CG_MEMSTAT_INACTIVE_FILE];
+    out->working_set = (memory_current > inactive_file) ? memory_current - inactive_file : 0;
+    /* Older kernels report one combined counter, newer ones split anon/file */
+    out->refault_per_s = rate(curr, prev, CG_MEMSTAT_WORKINGSET_REFAULT, elapsed_s) +
+                         rate(curr, prev, CG_MEMSTAT_WORKINGSET_REFAULT_ANON, elapsed_s) +
+                         rate(curr, prev, CG_MEMSTAT_WORKINGSET_REFAULT_FILE, elapsed_s);
+    out->activate_per_s = rate(curr, prev, CG_MEMSTAT_WORKINGSET_ACTIVATE, elapsed_s) +
+                          rate(curr, prev, CG_MEMSTAT_WORKINGSET_ACTIVATE_ANON, elapsed_s) +
+                          rate(curr, prev, CG_MEMSTAT_WORKINGSET_ACTIVATE_FILE, elapsed_s);
+    out->pgscan_per_s = rate(curr, prev, CG_MEMSTAT_PGSCAN, elapsed_s);
+    out->pgsteal_per_s = rate(curr, prev, CG_MEMSTAT_PGSTEAL, elapsed_s);
+    out->reclaim_efficiency = (out->pgscan_per_s > 0) ? out->pgsteal_per_s / out->pgscan_per_s : 0.0;
+}
+
+int cgroup_memstat_report(const char *root, int interval_ms, int samples, const char *output_file) {
+    if (interval_ms <= 0) interval_ms = 1000;
+    if (samples <= 0) samples = 1;
+
+    CgroupSampler s;
+    if (cgroup_sampler_init(&s, root, 2) != 0) {
+        fprintf(stderr, "cgroup_memstat: cannot open hierarchy %s\n", root ? root : sysroot_cgroup());
+        return -1;
+    }
+    unsigned long long *peak = calloc((size_t)(s.count ? s.count : 1), sizeof(unsigned long long));
+    FILE *out = stdout;
+    if (output_file) out = fopen(output_file, "w");
+    if (!peak || !out) {
+        if (!out) perror("fopen");
+        free(peak);
+        cgroup_sampler_free(&s);
+        return -1;
+    }
+
+    fprintf(out, "timestamp_ms,cgroup,memory_current,working_set,working_set_peak,anon,file,kernel,sock,shmem,"
+                 "active_file,inactive_file,refault_per_s,activate_per_s,pgscan_per_s,pgsteal_per_s,reclaim_efficiency\n");
+    for (int t = 0; t < samples; ++t) {
+        cgroup_sampler_tick(&s);
+        int row = (int)((s.ticks - 1) % s.max_ticks);
+        double elapsed = cgroup_sampler_elapsed(&s, 1);
+        for (int i = 0; i < s.count; ++i) {
+            const CgroupSample *c = cgroup_sampler_get(&s, 0, i);
+            const unsigned int need = (1u << CG_FILE_MEMORY_STAT) | (1u << CG_FILE_MEMORY_CURRENT);
+            if (!s.nodes[i].alive || (c->valid & need) != need) continue;
+            const CgroupSample *p = cgroup_sampler_get(&s, 1, i);
+            CgroupMemDerived d;
+            cgroup_memstat_derive(c->memory_current, c->memstat,
+                                  (p && (p->valid & need) == need) ? p->memstat : NULL, elapsed, &d);
+            if (d.working_set > peak[i]) peak[i] = d.working_set;
+            const unsigned long long *m = c->memstat;
+            fprintf(out, "%lld,/%s,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%.1f,%.1f,%.1f,%.1f,%.3f\n",
+                    s.timestamps_ms[row], s.nodes[i].path, c->memory_current, d.working_set, peak[i],
+                    m[CG_MEMSTAT_ANON], m[CG_MEMSTAT_FILE], m[CG_MEMSTAT_KERNEL], m[CG_MEMSTAT_SOCK],
+                    m[CG_MEMSTAT_SHMEM], m[CG_MEMSTAT_ACTIVE_FILE], m[CG_MEMSTAT_INACTIVE_FILE],
+                    d.refault_per_s, d.activate_per_s, d.pgscan_per_s, d.pgsteal_per_s, d.reclaim_efficiency);
+        }
+        fflush(out);
+        if (t + 1 < samples) usleep((useconds_t)interval_ms * 1000);
+    }
+
+    if (output_file) fclose(out);
+    free(peak);
+    cgroup_sampler_free(&s);
+    return 0;
+}
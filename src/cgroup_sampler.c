@@ -0,0 +1,436 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include "../include/cgroup_sampler.h"
+#include "../include/cgroup_backend.h"
+#include "../include/sysroot.h"
+
+/* One descriptor per cgroup directory plus up to eight files: a few thousand
+ * cgroups need far more than the usual 1024 soft limit. */
+static void raise_nofile_limit(void) {
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+}
+
+static int add_node(CgroupSampler *s, const char *path, int parent, int depth, int dirfd) {
+    if (s->count == s->capacity) {
+        int cap = s->capacity ? s->capacity * 2 : 64;
+        CgroupNode *n = realloc(s->nodes, (size_t)cap * sizeof(CgroupNode));
+        if (!n) return -1;
+        s->nodes = n;
+        s->capacity = cap;
+    }
+    CgroupNode *node = &s->nodes[s->count];
+    node->path = strdup(path);
+    if (!node->path) return -1;
+    node->parent = parent;
+    node->depth = depth;
+    node->dirfd = dirfd;
+    node->alive = 1;
+    /* Same cgroup in the other hierarchies (v1), opened only while its files are */
+    int hdir[CG_HIER_MAX];
+    for (int h = 0; h < s->backend.nhier; ++h) {
+        if (h == s->backend.primary) hdir[h] = dirfd;
+        else if (s->hier_rootfd[h] < 0) hdir[h] = -1;
+        else hdir[h] = openat(s->hier_rootfd[h], path[0] ? path : ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    }
+    for (int k = 0; k < s->backend.nsources; ++k) {
+        const CgroupSource *src = &s->backend.sources[k];
+        int fd = (hdir[src->hier] >= 0) ? openat(hdir[src->hier], src->file, O_RDONLY | O_CLOEXEC) : -1;
+        if (fd >= 0) node->fds[k] = fd;
+        else node->fds[k] = (errno == EMFILE || errno == ENFILE) ? CG_FD_REOPEN : CG_FD_MISSING;
+    }
+    for (int h = 0; h < s->backend.nhier; ++h) {
+        if (h != s->backend.primary && hdir[h] >= 0) close(hdir[h]);
+    }
+    return s->count++;
+}
+
+static int walk(CgroupSampler *s, int dirfd, const char *path, int parent, int depth) {
+    int idx = add_node(s, path, parent, depth, dirfd);
+    if (idx < 0) {
+        close(dirfd);
+        return -1;
+    }
+    int scanfd = dup(dirfd);
+    DIR *dir = (scanfd >= 0) ? fdopendir(scanfd) : NULL;
+    if (!dir) {
+        if (scanfd >= 0) close(scanfd);
+        return 0;
+    }
+    /* scanfd shares its offset with dirfd: a rescan would start at the end */
+    rewinddir(dir);
+    struct dirent *de;
+    while ((de = readdir(dir)) != NULL) {
+        if (de->d_name[0] == '.') continue;
+        if (de->d_type != DT_DIR) {
+            struct stat st;
+            if (de->d_type != DT_UNKNOWN) continue;
+            if (fstatat(dirfd, de->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0 || !S_ISDIR(st.st_mode)) continue;
+        }
+        int child = openat(dirfd, de->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (child < 0) {
+            if (errno == EMFILE || errno == ENFILE) {
+                fprintf(stderr, "cgroup_sampler: out of descriptors, skipping %s/%s\n", path, de->d_name);
+            }
+            continue;
+        }
+        char child_path[1024];
+        if (path[0]) snprintf(child_path, sizeof(child_path), "%s/%s", path, de->d_name);
+        else snprintf(child_path, sizeof(child_path), "%s", de->d_name);
+        if (walk(s, child, child_path, idx, depth + 1) < 0) {
+            closedir(dir);
+            return -1;
+        }
+    }
+    closedir(dir);
+    return 0;
+}
+
+static void close_nodes(CgroupSampler *s) {
+    for (int i = 0; i < s->count; ++i) {
+        CgroupNode *node = &s->nodes[i];
+        for (int k = 0; k < s->backend.nsources; ++k) {
+            if (node->fds[k] >= 0) close(node->fds[k]);
+        }
+        if (node->dirfd >= 0) close(node->dirfd);
+        free(node->path);
+    }
+    s->count = 0;
+}
+
+static int alloc_series(CgroupSampler *s) {
+    free(s->samples);
+    free(s->timestamps_ms);
+    free(s->mono_us);
+    s->ticks = 0;
+    s->samples = calloc((size_t)s->max_ticks * (size_t)(s->capacity ? s->capacity : 1), sizeof(CgroupSample));
+    s->timestamps_ms = calloc((size_t)s->max_ticks, sizeof(long long));
+    s->mono_us = calloc((size_t)s->max_ticks, sizeof(long long));
+    return (s->samples && s->timestamps_ms && s->mono_us) ? 0 : -1;
+}
+
+int cgroup_sampler_rescan(CgroupSampler *s) {
+    close_nodes(s);
+    int dirfd = dup(s->rootfd);
+    if (dirfd < 0) return -1;
+    if (walk(s, dirfd, "", -1, 0) < 0) return -1;
+    return alloc_series(s);
+}
+
+int cgroup_sampler_init_backend(CgroupSampler *s, const CgroupBackend *backend, int max_ticks) {
+    memset(s, 0, sizeof(*s));
+    s->backend = *backend;
+    for (int h = 0; h < CG_HIER_MAX; ++h) s->hier_rootfd[h] = -1;
+    snprintf(s->root, sizeof(s->root), "%s", backend->hier_root[backend->primary]);
+    s->max_ticks = (max_ticks >= 2) ? max_ticks : 2;
+    s->buf_cap = 16384;
+    cgroup_memstat_layout_init(&s->memstat_layout);
+    s->files_mask = (1u << CG_FILE_COUNT) - 1;
+    s->buf = malloc(s->buf_cap);
+    for (int h = 0; h < backend->nhier; ++h) {
+        if (backend->hier_root[h][0]) {
+            s->hier_rootfd[h] = open(backend->hier_root[h], O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        }
+    }
+    s->rootfd = s->hier_rootfd[backend->primary];
+    if (!s->buf || s->rootfd < 0) {
+        cgroup_sampler_free(s);
+        return -1;
+    }
+    raise_nofile_limit();
+    if (cgroup_sampler_rescan(s) != 0) {
+        cgroup_sampler_free(s);
+        return -1;
+    }
+    return 0;
+}
+
+int cgroup_sampler_init(CgroupSampler *s, const char *root, int max_ticks) {
+    CgroupBackend backend;
+    if (cgroup_backend_resolve(&backend, root) != 0) {
+        memset(s, 0, sizeof(*s));
+        s->rootfd = -1;
+        return -1;
+    }
+    return cgroup_sampler_init_backend(s, &backend, max_ticks);
+}
+
+void cgroup_sampler_free(CgroupSampler *s) {
+    close_nodes(s);
+    for (int h = 0; h < CG_HIER_MAX; ++h) {
+        if (s->hier_rootfd[h] >= 0) close(s->hier_rootfd[h]);
+    }
+    free(s->nodes);
+    free(s->samples);
+    free(s->timestamps_ms);
+    free(s->mono_us);
+    free(s->buf);
+    memset(s, 0, sizeof(*s));
+    s->rootfd = -1;
+    for (int h = 0; h < CG_HIER_MAX; ++h) s->hier_rootfd[h] = -1;
+}
+
+/* Read a whole attribute file from offset 0 into s->buf. cgroup files are generated
+ * on each read, so pread at 0 on a held descriptor returns fresh values.
+ * Returns the length, -2 when the cgroup has no such file, -1 on read error. */
+static ssize_t read_attr(CgroupSampler *s, CgroupNode *node, int k) {
+    int fd = node->fds[k];
+    int transient = 0;
+    if (fd == CG_FD_MISSING) return -2;
+    if (fd == CG_FD_REOPEN) {
+        const CgroupSource *src = &s->backend.sources[k];
+        if (src->hier == s->backend.primary) {
+            fd = openat(node->dirfd, src->file, O_RDONLY | O_CLOEXEC);
+        } else {
+            char rel[1024];
+            if (node->path[0]) snprintf(rel, sizeof(rel), "%s/%s", node->path, src->file);
+            else snprintf(rel, sizeof(rel), "%s", src->file);
+            fd = openat(s->hier_rootfd[src->hier], rel, O_RDONLY | O_CLOEXEC);
+        }
+        if (fd < 0) return -1;
+        transient = 1;
+    }
+    size_t len = 0;
+    ssize_t r;
+    while ((r = pread(fd, s->buf + len, s->buf_cap - 1 - len, (off_t)len)) > 0) {
+        len += (size_t)r;
+        if (len < s->buf_cap - 1) break;
+        char *nb = realloc(s->buf, s->buf_cap * 2);
+        if (!nb) break;
+        s->buf = nb;
+        s->buf_cap *= 2;
+    }
+    if (transient) close(fd);
+    if (r < 0) return -1;
+    s->buf[len] = '\0';
+    return (ssize_t)len;
+}
+
+ssize_t cgroup_sampler_read_file(CgroupSampler *s, int idx, CgroupFile file, const char **buf) {
+    if (idx < 0 || idx >= s->count || !s->nodes[idx].alive) return -1;
+    for (int k = 0; k < s->backend.nsources; ++k) {
+        if (s->backend.sources[k].group != file) continue;
+        ssize_t len = read_attr(s, &s->nodes[idx], k);
+        if (len < 0) return -1;
+        *buf = s->buf;
+        return len;
+    }
+    return -1;
+}
+
+/* Parse "key value" lines; keys[] is NULL-terminated */
+static void parse_flat_keyed(const char *buf, const char *const *keys, unsigned long long *const *dst) {
+    const char *line = buf;
+    while (*line) {
+        for (int k = 0; keys[k]; ++k) {
+            size_t klen = strlen(keys[k]);
+            if (strncmp(line, keys[k], klen) == 0 && line[klen] == ' ') {
+                *dst[k] = strtoull(line + klen + 1, NULL, 10);
+                break;
+            }
+        }
+        const char *nl = strchr(line, '\n');
+        if (!nl) break;
+        line = nl + 1;
+    }
+}
+
+void cgroup_parse_cpu_stat(const char *buf, CgroupSample *out) {
+    static const char *const keys[] = {
+        "usage_usec", "user_usec", "system_usec", "nr_periods", "nr_throttled", "throttled_usec", NULL
+    };
+    unsigned long long *const dst[] = {
+        &out->usage_usec, &out->user_usec, &out->system_usec,
+        &out->nr_periods, &out->nr_throttled, &out->throttled_usec
+    };
+    parse_flat_keyed(buf, keys, dst);
+}
+
+void cgroup_sample_fill_memory(CgroupSample *out) {
+    out->mem_anon = out->memstat[CG_MEMSTAT_ANON];
+    out->mem_file = out->memstat[CG_MEMSTAT_FILE];
+    out->mem_shmem = out->memstat[CG_MEMSTAT_SHMEM];
+    out->mem_sock = out->memstat[CG_MEMSTAT_SOCK];
+}
+
+void cgroup_parse_memory_stat(CgroupMemStatLayout *layout, const char *buf, CgroupSample *out) {
+    cgroup_memstat_parse(layout, buf, out->memstat);
+    cgroup_sample_fill_memory(out);
+}
+
+void cgroup_parse_io_stat(const char *buf, CgroupSample *out) {
+    /* 8:0 rbytes=1 wbytes=2 rios=3 wios=4 dbytes=0 dios=0 */
+    out->io_rbytes = out->io_wbytes = out->io_rios = out->io_wios = 0;
+    const char *p = buf;
+    while (*p) {
+        const char *eq = strchr(p, '=');
+        const char *nl = strchr(p, '\n');
+        if (!eq) break;
+        if (nl && nl < eq) { p = nl + 1; continue; }
+        const char *key = eq;
+        while (key > p && key[-1] != ' ') key--;
+        char *end;
+        unsigned long long v = strtoull(eq + 1, &end, 10);
+        p = end;
+        size_t klen = (size_t)(eq - key);
+        if (klen == 6 && strncmp(key, "rbytes", 6) == 0) out->io_rbytes += v;
+        else if (klen == 6 && strncmp(key, "wbytes", 6) == 0) out->io_wbytes += v;
+        else if (klen == 4 && strncmp(key, "rios", 4) == 0) out->io_rios += v;
+        else if (klen == 4 && strncmp(key, "wios", 4) == 0) out->io_wios += v;
+    }
+}
+
+int cgroup_parse_pressure(const char *buf, CgroupPsi *out) {
+    memset(out, 0, sizeof(*out));
+    int lines = 0;
+    const char *line = buf;
+    while (*line) {
+        CgroupPsiLine *dst = NULL;
+        if (strncmp(line, "some ", 5) == 0) dst = &out->some;
+        else if (strncmp(line, "full ", 5) == 0) dst = &out->full;
+        if (dst && sscanf(line + 5, "avg10=%lf avg60=%lf avg300=%lf total=%llu",
+                          &dst->avg10, &dst->avg60, &dst->avg300, &dst->total_usec) == 4) {
+            lines++;
+        }
+        const char *nl = strchr(line, '\n');
+        if (!nl) break;
+        line = nl + 1;
+    }
+    return lines ? 0 : -1;
+}
+
+int cgroup_sampler_tick(CgroupSampler *s) {
+    int row = (int)(s->ticks % s->max_ticks);
+    CgroupSample *samples = &s->samples[(size_t)row * (size_t)s->capacity];
+    struct timespec rt, mono;
+    clock_gettime(CLOCK_REALTIME, &rt);
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    s->timestamps_ms[row] = (long long)rt.tv_sec * 1000 + rt.tv_nsec / 1000000;
+    s->mono_us[row] = (long long)mono.tv_sec * 1000000 + mono.tv_nsec / 1000;
+
+    int sampled = 0;
+    for (int i = 0; i < s->count; ++i) {
+        CgroupNode *node = &s->nodes[i];
+        CgroupSample *out = &samples[i];
+        memset(out, 0, sizeof(*out));
+        if (!node->alive) continue;
+
+        for (int k = 0; k < s->backend.nsources; ++k) {
+            const CgroupSource *src = &s->backend.sources[k];
+            if (!(s->files_mask & (1u << src->group))) continue;
+            ssize_t len = read_attr(s, node, k);
+            if (len < 0) {
+                /* Reads on a removed cgroup fail with ENODEV; stop sampling it */
+                if (len == -1 && (errno == ENODEV || errno == ENOENT)) node->alive = 0;
+                continue;
+            }
+            src->parse(s, s->buf, out);
+            out->valid |= 1u << src->group;
+        }
+        if (!node->alive) {
+            out->valid = 0;
+            continue;
+        }
+        sampled++;
+    }
+    if (s->count > 0 && !s->nodes[0].alive) {
+        errno = ENODEV;
+        return -1;
+    }
+    s->ticks++;
+    return sampled;
+}
+
+const CgroupSample *cgroup_sampler_get(const CgroupSampler *s, int back, int idx) {
+    if (idx < 0 || idx >= s->count || back < 0 || back >= s->max_ticks || back >= s->ticks) return NULL;
+    int row = (int)((s->ticks - 1 - back) % s->max_ticks);
+    return &s->samples[(size_t)row * (size_t)s->capacity + (size_t)idx];
+}
+
+double cgroup_sampler_elapsed(const CgroupSampler *s, int back) {
+    if (back <= 0 || back >= s->max_ticks || back >= s->ticks) return 0.0;
+    int last = (int)((s->ticks - 1) % s->max_ticks);
+    int first = (int)((s->ticks - 1 - back) % s->max_ticks);
+    return (s->mono_us[last] - s->mono_us[first]) / 1e6;
+}
+
+#define HAS(smp, f) ((smp)->valid & (1u << (f)))
+
+static void write_row(FILE *out, long long ms, const CgroupNode *node, const CgroupSample *c,
+                      const CgroupSample *p, double elapsed) {
+    fprintf(out, "%lld,/%s", ms, node->path);
+    if (HAS(c, CG_FILE_CPU_STAT)) {
+        double pct = 0.0;
+        if (p && HAS(p, CG_FILE_CPU_STAT) && elapsed > 0 && c->usage_usec >= p->usage_usec) {
+            pct = 100.0 * (c->usage_usec - p->usage_usec) / (elapsed * 1e6);
+        }
+        fprintf(out, ",%llu,%.2f,%llu,%llu", c->usage_usec, pct, c->nr_throttled, c->throttled_usec);
+    } else {
+        fprintf(out, ",,,,");
+    }
+    if (HAS(c, CG_FILE_MEMORY_CURRENT)) fprintf(out, ",%llu", c->memory_current);
+    else fprintf(out, ",");
+    if (HAS(c, CG_FILE_MEMORY_STAT)) fprintf(out, ",%llu,%llu", c->mem_anon, c->mem_file);
+    else fprintf(out, ",,");
+    if (HAS(c, CG_FILE_IO_STAT)) fprintf(out, ",%llu,%llu,%llu,%llu", c->io_rbytes, c->io_wbytes, c->io_rios, c->io_wios);
+    else fprintf(out, ",,,,");
+    if (HAS(c, CG_FILE_CPU_PRESSURE)) fprintf(out, ",%.2f", c->cpu_psi.some.avg10);
+    else fprintf(out, ",");
+    if (HAS(c, CG_FILE_MEMORY_PRESSURE)) fprintf(out, ",%.2f,%.2f", c->mem_psi.some.avg10, c->mem_psi.full.avg10);
+    else fprintf(out, ",,");
+    if (HAS(c, CG_FILE_IO_PRESSURE)) fprintf(out, ",%.2f,%.2f\n", c->io_psi.some.avg10, c->io_psi.full.avg10);
+    else fprintf(out, ",,\n");
+}
+
+int cgroup_sample_hierarchy(const char *root, int interval_ms, int samples, const char *output_file) {
+    if (interval_ms <= 0) interval_ms = 1000;
+    if (samples <= 0) samples = 1;
+
+    CgroupSampler s;
+    if (cgroup_sampler_init(&s, root, 2) != 0) {
+        fprintf(stderr, "cgroup_sampler: cannot open hierarchy %s\n", root ? root : sysroot_cgroup());
+        return -1;
+    }
+    FILE *out = stdout;
+    if (output_file) {
+        out = fopen(output_file, "w");
+        if (!out) {
+            perror("fopen");
+            cgroup_sampler_free(&s);
+            return -1;
+        }
+    }
+
+    fprintf(out, "timestamp_ms,cgroup,cpu_usage_usec,cpu_percent,nr_throttled,throttled_usec,memory_current,"
+                 "anon,file,io_rbytes,io_wbytes,io_rios,io_wios,cpu_some_avg10,mem_some_avg10,mem_full_avg10,"
+                 "io_some_avg10,io_full_avg10\n");
+    int rc = 0;
+    for (int t = 0; t < samples; ++t) {
+        if (cgroup_sampler_tick(&s) < 0) { rc = -1; break; }
+        int row = (int)((s.ticks - 1) % s.max_ticks);
+        double elapsed = cgroup_sampler_elapsed(&s, 1);
+        for (int i = 0; i < s.count; ++i) {
+            const CgroupSample *c = cgroup_sampler_get(&s, 0, i);
+            if (!s.nodes[i].alive || !c->valid) continue;
+            write_row(out, s.timestamps_ms[row], &s.nodes[i], c, cgroup_sampler_get(&s, 1, i), elapsed);
+        }
+        fflush(out);
+        if (t + 1 < samples) usleep((useconds_t)interval_ms * 1000);
+    }
+
+    if (output_file) fclose(out);
+    cgroup_sampler_free(&s);
+    return rc;
+}
@@ -0,0 +1,198 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <linux/sched.h>
+#include "../include/cgroup_spawn.h"
+#include "../include/sysroot.h"
+
+#if defined(SYS_clone3) && defined(CLONE_INTO_CGROUP)
+#define HAVE_CLONE_INTO_CGROUP 1
+#endif
+
+/* 0 = not tried yet, 1 = works, -1 = kernel without clone3 / CLONE_INTO_CGROUP */
+static atomic_int clone3_state;
+static _Thread_local CgroupSpawnMethod last_method;
+
+CgroupSpawnMethod cgroup_spawn_last_method(void) {
+    return last_method;
+}
+
+/* Child side: report errno to the parent and give up */
+static void child_fail(int fd, int code) {
+    int err = errno;
+    ssize_t w;
+    do {
+        w = write(fd, &err, sizeof(err));
+    } while (w < 0 && errno == EINTR);
+    _exit(code);
+}
+
+static void child_run(int errfd, int (*fn)(void *), void *arg, char *const argv[]) {
+    if (argv) {
+        /* errfd is close-on-exec: a successful exec reports nothing */
+        execvp(argv[0], argv);
+        child_fail(errfd, 127);
+    }
+    close(errfd);
+    exit(fn(arg));
+}
+
+#ifdef HAVE_CLONE_INTO_CGROUP
+static pid_t clone_into(int dirfd) {
+    struct clone_args ca;
+    memset(&ca, 0, sizeof(ca));
+    ca.flags = CLONE_INTO_CGROUP;
+    ca.exit_signal = SIGCHLD;
+    ca.cgroup = (unsigned long long)dirfd;
+    return (pid_t)syscall(SYS_clone3, &ca, sizeof(ca));
+}
+#endif
+
+static pid_t spawn(CgroupHandle *h, int (*fn)(void *), void *arg, char *const argv[]) {
+    int errpipe[2];
+    if (pipe2(errpipe, O_CLOEXEC) != 0) return -1;
+    /* Do not let the child flush a copy of our pending output */
+    fflush(NULL);
+
+    pid_t pid = -1;
+    CgroupSpawnMethod method = CG_SPAWN_FORK_MOVE;
+#ifdef HAVE_CLONE_INTO_CGROUP
+    if (atomic_load_explicit(&clone3_state, memory_order_relaxed) >= 0) {
+        pid = clone_into(h->dirfd);
+        if (pid == 0) {
+            close(errpipe[0]);
+            child_run(errpipe[1], fn, arg, argv);
+        }
+        if (pid > 0) {
+            method = CG_SPAWN_CLONE3;
+            atomic_store_explicit(&clone3_state, 1, memory_order_relaxed);
+        } else if (errno == ENOSYS || errno == E2BIG || errno == EINVAL) {
+            /* No clone3, or a kernel older than 5.7 that rejects the flag */
+            atomic_store_explicit(&clone3_state, -1, memory_order_relaxed);
+        } else if (errno != EBADF) {
+            /* EBADF: not a cgroup v2 directory, fall back. Anything else
+             * (EBUSY, EACCES ...) would fail the same way after a fork. */
+            int err = errno;
+            close(errpipe[0]);
+            close(errpipe[1]);
+            errno = err;
+            return -1;
+        }
+    }
+#endif
+    if (pid < 0) {
+        pid = fork();
+        if (pid == 0) {
+            close(errpipe[0]);
+            /* "0" moves the writer: the child joins before running anything */
+            if (cgroup_handle_write(h, CG_ATTR_PROCS, "0\n") != 0) child_fail(errpipe[1], 126);
+            child_run(errpipe[1], fn, arg, argv);
+        }
+    }
+    close(errpipe[1]);
+    if (pid < 0) {
+        int err = errno;
+        close(errpipe[0]);
+        errno = err;
+        return -1;
+    }
+
+    int child_err = 0;
+    ssize_t r;
+    do {
+        r = read(errpipe[0], &child_err, sizeof(child_err));
+    } while (r < 0 && errno == EINTR);
+    close(errpipe[0]);
+    if (r == (ssize_t)sizeof(child_err)) {
+        waitpid(pid, NULL, 0);
+        errno = child_err;
+        return -1;
+    }
+    last_method = method;
+    return pid;
+}
+
+pid_t cgroup_spawn_fn(CgroupHandle *h, int (*fn)(void *), void *arg) {
+    return spawn(h, fn, arg, NULL);
+}
+
+pid_t cgroup_spawn_exec(CgroupHandle *h, char *const argv[]) {
+    if (!argv || !argv[0]) {
+        errno = EINVAL;
+        return -1;
+    }
+    return spawn(h, NULL, NULL, argv);
+}
+
+int cgroup_spawn_wait(pid_t pid) {
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) return -1;
+    }
+    if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+    return WEXITSTATUS(status);
+}
+
+static int migrate_one(CgroupHandle *h, CgroupAttr attr, pid_t pid) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%d\n", (int)pid);
+    if (cgroup_handle_write(h, attr, buf) == 0) return 1;
+    return (errno == ESRCH) ? 0 : -1;
+}
+
+int cgroup_migrate_procs(CgroupHandle *h, const pid_t *pids, int n) {
+    int moved = 0;
+    for (int i = 0; i < n; ++i) {
+        int r = migrate_one(h, CG_ATTR_PROCS, pids[i]);
+        if (r < 0) return -1;
+        moved += r;
+    }
+    return moved;
+}
+
+int cgroup_migrate_threads(CgroupHandle *h, pid_t pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/task", (int)pid);
+    DIR *d = sysroot_opendir(path);
+    if (!d) return -1;
+    int moved = 0;
+    struct dirent *de;
+    while ((de = readdir(d)) != NULL) {
+        if (de->d_name[0] < '0' || de->d_name[0] > '9') continue;
+        int r = migrate_one(h, CG_ATTR_THREADS, (pid_t)atoi(de->d_name));
+        if (r < 0) {
+            int err = errno;
+            closedir(d);
+            errno = err;
+            return -1;
+        }
+        moved += r;
+    }
+    closedir(d);
+    return moved;
+}
+
+int cgroup_run(const char *cgroup, char *const argv[]) {
+    CgroupHandle h;
+    if (cgroup_handle_open(&h, cgroup) != 0) {
+        fprintf(stderr, "cgroup_run: cannot open cgroup %s: %s\n", cgroup, strerror(errno));
+        return -1;
+    }
+    pid_t pid = cgroup_spawn_exec(&h, argv);
+    int err = errno;
+    cgroup_handle_close(&h);
+    if (pid < 0) {
+        fprintf(stderr, "cgroup_run: cannot start %s in %s: %s\n", argv[0], cgroup, strerror(err));
+        return -1;
+    }
+    return cgroup_spawn_wait(pid);
+}
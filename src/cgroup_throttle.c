@@ -0,0 +1,164 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../include/cgroup_throttle.h"
+#include "../include/cgroup_sampler.h"
+#include "../include/cgroup_handle.h"
+#include "../include/sysroot.h"
+#include "../include/utils.h"
+
+double cgroup_throttle_percentile(double *values, int n, double p) {
+    sort_doubles(values, n);
+    return percentile_sorted(values, n, p);
+}
+
+double cgroup_throttle_demand(unsigned long long usage_usec, unsigned long long throttled_usec,
+                              unsigned long long periods) {
+    if (periods == 0) return 0.0;
+    return (double)(usage_usec + throttled_usec) / (double)periods;
+}
+
+long long cgroup_throttle_suggest_quota(double *demand, int n, double p) {
+    if (n <= 0) return -1;
+    double d = cgroup_throttle_percentile(demand, n, p);
+    long long q = ((long long)d + 999) / 1000 * 1000;
+    return q < 1000 ? 1000 : q;   /* the kernel minimum quota is 1 ms */
+}
+
+static int cmp_worst(const void *a, const void *b) {
+    const CgroupThrottleStat *x = a, *y = b;
+    if (x->throttled_usec != y->throttled_usec) return (x->throttled_usec < y->throttled_usec) ? 1 : -1;
+    return (x->throttle_ratio < y->throttle_ratio) - (x->throttle_ratio > y->throttle_ratio);
+}
+
+/* cpu.max of a sampled cgroup, read through its already open directory */
+static int read_cpu_max(int dirfd, long long *quota, long long *period) {
+    CgroupHandle h;
+    char buf[64];
+    if (cgroup_handle_openat(&h, dirfd, ".") != 0) return -1;
+    ssize_t n = cgroup_handle_read(&h, CG_ATTR_CPU_MAX, buf, sizeof(buf));
+    cgroup_handle_close(&h);
+    if (n <= 0) return -1;
+    char q[32];
+    if (sscanf(buf, "%31s %lld", q, period) != 2) return -1;
+    *quota = (strcmp(q, "max") == 0) ? -1 : atoll(q);
+    return 0;
+}
+
+int cgroup_throttle_analyze(const char *root, int interval_ms, int samples, double percentile,
+                            CgroupThrottleStat **out) {
+    if (interval_ms <= 0) interval_ms = 1000;
+    if (samples < 2) samples = 2;
+    *out = NULL;
+
+    CgroupSampler s;
+    if (cgroup_sampler_init(&s, root, 2) != 0) return -1;
+    s.files_mask = 1u << CG_FILE_CPU_STAT;
+
+    int n = s.count;
+    CgroupThrottleStat *stats = calloc((size_t)(n ? n : 1), sizeof(CgroupThrottleStat));
+    double *demand = calloc((size_t)(n ? n : 1) * (size_t)(samples - 1), sizeof(double));
+    int *ndemand = calloc((size_t)(n ? n : 1), sizeof(int));
+    if (!stats || !demand || !ndemand) {
+        free(stats);
+        free(demand);
+        free(ndemand);
+        cgroup_sampler_free(&s);
+        return -1;
+    }
+
+    for (int t = 0; t < samples; ++t) {
+        cgroup_sampler_tick(&s);
+        if (t > 0) {
+            for (int i = 0; i < n; ++i) {
+                const CgroupSample *c = cgroup_sampler_get(&s, 0, i);
+                const CgroupSample *p = cgroup_sampler_get(&s, 1, i);
+                if (!c || !p || !(c->valid & p->valid & (1u << CG_FILE_CPU_STAT))) continue;
+                if (c->nr_periods < p->nr_periods || c->usage_usec < p->usage_usec) continue;
+                unsigned long long dper = c->nr_periods - p->nr_periods;
+                unsigned long long dthr = c->nr_throttled - p->nr_throttled;
+                unsigned long long dthr_us = c->throttled_usec - p->throttled_usec;
+                unsigned long long duse = c->usage_usec - p->usage_usec;
+                stats[i].periods += dper;
+                stats[i].throttled += dthr;
+                stats[i].throttled_usec += dthr_us;
+                stats[i].usage_usec += duse;
+                if (dper > 0) {
+                    demand[(size_t)i * (size_t)(samples - 1) + (size_t)ndemand[i]++] =
+                        cgroup_throttle_demand(duse, dthr_us, dper);
+                }
+            }
+        }
+        if (t + 1 < samples) usleep((useconds_t)interval_ms * 1000);
+    }
+
+    int count = 0;
+    for (int i = 0; i < n; ++i) {
+        CgroupThrottleStat st = stats[i];
+        /* Only cgroups with the CPU controller have cpu.max and the period counters */
+        if (read_cpu_max(s.nodes[i].dirfd, &st.quota_usec, &st.period_usec) != 0) continue;
+        snprintf(st.path, sizeof(st.path), "%s", s.nodes[i].path);
+        st.throttle_ratio = st.periods ? (double)st.throttled / st.periods : 0.0;
+        st.throttled_ms_per_period = st.periods ? st.throttled_usec / 1000.0 / st.periods : 0.0;
+        double *d = &demand[(size_t)i * (size_t)(samples - 1)];
+        st.suggested_quota_usec = cgroup_throttle_suggest_quota(d, ndemand[i], percentile);
+        st.demand_usec = ndemand[i] ? cgroup_throttle_percentile(d, ndemand[i], percentile) : 0.0;
+        /* Only suggest raising a limit that actually throttled */
+        if (st.throttled == 0 || (st.quota_usec >= 0 && st.suggested_quota_usec <= st.quota_usec)) {
+            st.suggested_quota_usec = -1;
+        }
+        stats[count++] = st;
+    }
+    qsort(stats, (size_t)count, sizeof(CgroupThrottleStat), cmp_worst);
+
+    free(demand);
+    free(ndemand);
+    cgroup_sampler_free(&s);
+    *out = stats;
+    return count;
+}
+
+int cgroup_throttle_report(const char *root, int interval_ms, int samples, double percentile,
+                           int top, const char *output_file) {
+    if (percentile <= 0.0 || percentile > 100.0) percentile = 99.0;
+    if (top <= 0) top = 10;
+
+    CgroupThrottleStat *stats;
+    int n = cgroup_throttle_analyze(root, interval_ms, samples, percentile, &stats);
+    if (n < 0) {
+        fprintf(stderr, "cgroup_throttle: cannot sample %s\n", root ? root : sysroot_cgroup());
+        return -1;
+    }
+    FILE *out = stdout;
+    if (output_file) {
+        out = fopen(output_file, "w");
+        if (!out) {
+            perror("fopen");
+            free(stats);
+            return -1;
+        }
+    }
+
+    char pcol[32];
+    snprintf(pcol, sizeof(pcol), "p%g demand", percentile);
+    fprintf(out, "%-40s %14s %8s %8s %8s %12s %10s %12s %12s\n",
+            "cgroup", "cpu.max", "periods", "thrott", "ratio", "thrott_ms", "ms/period", pcol, "suggest");
+    for (int i = 0; i < n && i < top; ++i) {
+        const CgroupThrottleStat *st = &stats[i];
+        char quota[32], suggest[32];
+        if (st->quota_usec < 0) snprintf(quota, sizeof(quota), "max/%lld", st->period_usec);
+        else snprintf(quota, sizeof(quota), "%lld/%lld", st->quota_usec, st->period_usec);
+        if (st->suggested_quota_usec < 0) snprintf(suggest, sizeof(suggest), "-");
+        else snprintf(suggest, sizeof(suggest), "%lld", st->suggested_quota_usec);
+        fprintf(out, "%-40.40s %14s %8llu %8llu %7.1f%% %12.1f %10.2f %12.0f %12s\n",
+                st->path[0] ? st->path : "/", quota, st->periods, st->throttled, st->throttle_ratio * 100.0,
+                st->throttled_usec / 1000.0, st->throttled_ms_per_period, st->demand_usec, suggest);
+    }
+    if (n == 0) fprintf(out, "(no cgroups with the cpu controller under %s)\n", root ? root : sysroot_cgroup());
+
+    if (output_file) fclose(out);
+    free(stats);
+    return 0;
+}
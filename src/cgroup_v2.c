@@ -1,11 +1,18 @@
+#define _GNU_SOURCE
 #include "../include/cgroup_v2.h"
+#include "../include/cgroup_handle.h"
+#include "../include/cgroup_spawn.h"
 #include "../include/utils.h"
 #include <sys/stat.h>
 #include <errno.h>
 #include <fcntl.h>
 
+/* The string-based API below is a thin layer over CgroupHandle: each call opens
+ * the cgroup directory once and does its I/O with openat/pread/pwrite. Callers
+ * touching the same cgroup repeatedly should keep a CgroupHandle instead. */
+
 char* cgroup_get_full_path(const char *name) {
-    static char path[MAX_PATH_LEN];
+    static _Thread_local char path[MAX_PATH_LEN];
     snprintf(path, sizeof(path), "%s/%s", CGROUP_BASE_PATH, name);
     return path;
 }
@@ -20,10 +27,18 @@ int cgroup_is_v2_available(void) {
 
 int cgroup_exists(const char *name) {
     struct stat st;
-    char *path = cgroup_get_full_path(name);
+    char path[MAX_PATH_LEN];
+    snprintf(path, sizeof(path), "%s/%s", CGROUP_BASE_PATH, name);
     return (stat(path, &st) == 0 && S_ISDIR(st.st_mode));
 }
 
+static int open_or_log(CgroupHandle *h, const char *name) {
+    if (cgroup_handle_open(h, name) == 0) return 0;
+    if (errno == ENOENT || errno == ENOTDIR) log_error("Cgroup %s does not exist", name);
+    else log_error("Failed to open cgroup %s: %s", name, strerror(errno));
+    return -1;
+}
+
 // Commented out to avoid collision with cgroup_manager.c
 /*
 int cgroup_create(const char *name) {
@@ -45,15 +60,12 @@ int cgroup_create(const char *name) {
 */
 
 int cgroup_delete(const char *name) {
-    if (!cgroup_exists(name)) {
-        log_error("Cgroup %s does not exist", name);
-        return -1;
-    }
+    char path[MAX_PATH_LEN];
+    snprintf(path, sizeof(path), "%s/%s", CGROUP_BASE_PATH, name);
 
-    char *path = cgroup_get_full_path(name);
-    
     if (rmdir(path) == -1) {
-        log_error("Failed to delete cgroup %s: %s", name, strerror(errno));
+        if (errno == ENOENT) log_error("Cgroup %s does not exist", name);
+        else log_error("Failed to delete cgroup %s: %s", name, strerror(errno));
         return -1;
     }
 
@@ -62,124 +74,111 @@ int cgroup_delete(const char *name) {
 }
 
 int cgroup_add_process(const char *name, pid_t pid) {
-    if (!cgroup_exists(name)) {
-        log_error("Cgroup %s does not exist", name);
+    CgroupHandle h;
+    if (open_or_log(&h, name) != 0) return -1;
+
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%d\n", pid);
+    int rc = cgroup_handle_write(&h, CG_ATTR_PROCS, buf);
+    cgroup_handle_close(&h);
+    if (rc != 0) {
+        log_error("Failed to write cgroup.procs for %s: %s", name, strerror(errno));
         return -1;
     }
 
-    char path[MAX_PATH_LEN];
-    snprintf(path, sizeof(path), "%s/%s/cgroup.procs", CGROUP_BASE_PATH, name);
+    log_info("Added process %d to cgroup %s", pid, name);
+    return 0;
+}
 
-    FILE *fp = fopen(path, "w");
-    if (!fp) {
-        log_error("Failed to open cgroup.procs for %s: %s", name, strerror(errno));
+pid_t cgroup_spawn_process(const char *name, int (*fn)(void *), void *arg) {
+    CgroupHandle h;
+    if (open_or_log(&h, name) != 0) return -1;
+
+    pid_t pid = cgroup_spawn_fn(&h, fn, arg);
+    int err = errno;
+    cgroup_handle_close(&h);
+    if (pid < 0) {
+        log_error("Failed to start process in cgroup %s: %s", name, strerror(err));
         return -1;
     }
 
-    fprintf(fp, "%d\n", pid);
-    fclose(fp);
-
-    log_info("Added process %d to cgroup %s", pid, name);
-    return 0;
+    log_info("Started process %d in cgroup %s (%s)", pid, name,
+             cgroup_spawn_last_method() == CG_SPAWN_CLONE3 ? "clone3" : "fork+move");
+    return pid;
 }
 
 int cgroup_remove_process(const char *name, pid_t pid) {
     // Move process back to root cgroup
-    char path[MAX_PATH_LEN];
-    snprintf(path, sizeof(path), "%s/cgroup.procs", CGROUP_BASE_PATH);
-
-    FILE *fp = fopen(path, "w");
-    if (!fp) {
-        log_error("Failed to open root cgroup.procs: %s", strerror(errno));
+    CgroupHandle h;
+    if (cgroup_handle_open(&h, CGROUP_BASE_PATH) != 0) {
+        log_error("Failed to open root cgroup: %s", strerror(errno));
         return -1;
     }
 
-    fprintf(fp, "%d\n", pid);
-    fclose(fp);
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%d\n", pid);
+    int rc = cgroup_handle_write(&h, CG_ATTR_PROCS, buf);
+    cgroup_handle_close(&h);
+    if (rc != 0) {
+        log_error("Failed to write root cgroup.procs: %s", strerror(errno));
+        return -1;
+    }
 
     log_info("Removed process %d from cgroup %s", pid, name);
     return 0;
 }
 
 int cgroup_set_cpu_max(const char *name, long quota, long period) {
-    if (!cgroup_exists(name)) {
-        log_error("Cgroup %s does not exist", name);
-        return -1;
-    }
-
-    char path[MAX_PATH_LEN];
-    snprintf(path, sizeof(path), "%s/%s/cpu.max", CGROUP_BASE_PATH, name);
-
-    FILE *fp = fopen(path, "w");
-    if (!fp) {
-        log_error("Failed to open cpu.max for %s: %s", name, strerror(errno));
-        return -1;
-    }
+    CgroupHandle h;
+    if (open_or_log(&h, name) != 0) return -1;
 
+    char buf[64];
     if (quota < 0) {
-        fprintf(fp, "max %ld\n", period);
+        snprintf(buf, sizeof(buf), "max %ld\n", period);
     } else {
-        fprintf(fp, "%ld %ld\n", quota, period);
+        snprintf(buf, sizeof(buf), "%ld %ld\n", quota, period);
+    }
+    int rc = cgroup_handle_write(&h, CG_ATTR_CPU_MAX, buf);
+    cgroup_handle_close(&h);
+    if (rc != 0) {
+        log_error("Failed to write cpu.max for %s: %s", name, strerror(errno));
+        return -1;
     }
-    
-    fclose(fp);
 
     log_info("Set CPU limit for %s: quota=%ld, period=%ld", name, quota, period);
     return 0;
 }
 
 int cgroup_get_cpu_usage(const char *name, unsigned long long *usage) {
-    if (!cgroup_exists(name)) {
-        log_error("Cgroup %s does not exist", name);
-        return -1;
-    }
+    CgroupHandle h;
+    if (open_or_log(&h, name) != 0) return -1;
 
-    char path[MAX_PATH_LEN];
-    snprintf(path, sizeof(path), "%s/%s/cpu.stat", CGROUP_BASE_PATH, name);
-
-    FILE *fp = fopen(path, "r");
-    if (!fp) {
-        log_error("Failed to open cpu.stat for %s: %s", name, strerror(errno));
-        return -1;
-    }
-
-    char line[256];
-    int found = 0;
-    
-    while (fgets(line, sizeof(line), fp)) {
-        if (parse_line_value_ull(line, "usage_usec", usage)) {
-            found = 1;
-            break;
-        }
+    int rc = cgroup_handle_read_key(&h, CG_ATTR_CPU_STAT, "usage_usec", usage);
+    if (rc != 0 && errno != ENOENT) {
+        log_error("Failed to read cpu.stat for %s: %s", name, strerror(errno));
     }
-
-    fclose(fp);
-    return found ? 0 : -1;
+    cgroup_handle_close(&h);
+    return rc;
 }
 
 int cgroup_set_cpu_weight(const char *name, int weight) {
-    if (!cgroup_exists(name)) {
-        log_error("Cgroup %s does not exist", name);
-        return -1;
-    }
-
     if (weight < 1 || weight > 10000) {
         log_error("Invalid CPU weight %d (must be 1-10000)", weight);
         return -1;
     }
 
-    char path[MAX_PATH_LEN];
-    snprintf(path, sizeof(path), "%s/%s/cpu.weight", CGROUP_BASE_PATH, name);
+    CgroupHandle h;
+    if (open_or_log(&h, name) != 0) return -1;
 
-    FILE *fp = fopen(path, "w");
-    if (!fp) {
-        log_error("Failed to open cpu.weight for %s: %s", name, strerror(errno));
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%d\n", weight);
+    int rc = cgroup_handle_write(&h, CG_ATTR_CPU_WEIGHT, buf);
+    cgroup_handle_close(&h);
+    if (rc != 0) {
+        log_error("Failed to write cpu.weight for %s: %s", name, strerror(errno));
         return -1;
     }
 
-    fprintf(fp, "%d\n", weight);
-    fclose(fp);
-
     log_info("Set CPU weight for %s: %d", name, weight);
     return 0;
 }
@@ -210,101 +209,77 @@ int cgroup_set_memory_max(const char *name, unsigned long bytes) {
 */
 
 int cgroup_get_memory_usage(const char *name, unsigned long *usage) {
-    if (!cgroup_exists(name)) {
-        log_error("Cgroup %s does not exist", name);
-        return -1;
-    }
+    CgroupHandle h;
+    if (open_or_log(&h, name) != 0) return -1;
 
-    char path[MAX_PATH_LEN];
-    snprintf(path, sizeof(path), "%s/%s/memory.current", CGROUP_BASE_PATH, name);
-
-    FILE *fp = fopen(path, "r");
-    if (!fp) {
-        log_error("Failed to open memory.current for %s: %s", name, strerror(errno));
-        return -1;
-    }
-
-    if (fscanf(fp, "%lu", usage) != 1) {
-        fclose(fp);
-        return -1;
+    unsigned long long value;
+    int rc = cgroup_handle_read_ull(&h, CG_ATTR_MEMORY_CURRENT, &value);
+    if (rc != 0) {
+        log_error("Failed to read memory.current for %s: %s", name, strerror(errno));
+    } else {
+        *usage = (unsigned long)value;
     }
-
-    fclose(fp);
-    return 0;
+    cgroup_handle_close(&h);
+    return rc;
 }
 
 int cgroup_set_memory_high(const char *name, unsigned long bytes) {
-    if (!cgroup_exists(name)) {
-        log_error("Cgroup %s does not exist", name);
+    CgroupHandle h;
+    if (open_or_log(&h, name) != 0) return -1;
+
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%lu\n", bytes);
+    int rc = cgroup_handle_write(&h, CG_ATTR_MEMORY_HIGH, buf);
+    cgroup_handle_close(&h);
+    if (rc != 0) {
+        log_error("Failed to write memory.high for %s: %s", name, strerror(errno));
         return -1;
     }
 
-    char path[MAX_PATH_LEN];
-    snprintf(path, sizeof(path), "%s/%s/memory.high", CGROUP_BASE_PATH, name);
-
-    FILE *fp = fopen(path, "w");
-    if (!fp) {
-        log_error("Failed to open memory.high for %s: %s", name, strerror(errno));
-        return -1;
-    }
-
-    fprintf(fp, "%lu\n", bytes);
-    fclose(fp);
-
     log_info("Set memory high watermark for %s: %lu bytes", name, bytes);
     return 0;
 }
 
 int cgroup_set_io_max(const char *name, const char *device, unsigned long rbps, unsigned long wbps) {
-    if (!cgroup_exists(name)) {
-        log_error("Cgroup %s does not exist", name);
-        return -1;
-    }
-
-    char path[MAX_PATH_LEN];
-    snprintf(path, sizeof(path), "%s/%s/io.max", CGROUP_BASE_PATH, name);
-
-    FILE *fp = fopen(path, "w");
-    if (!fp) {
-        log_error("Failed to open io.max for %s: %s", name, strerror(errno));
+    CgroupHandle h;
+    if (open_or_log(&h, name) != 0) return -1;
+
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s rbps=%lu wbps=%lu\n", device, rbps, wbps);
+    int rc = cgroup_handle_write(&h, CG_ATTR_IO_MAX, buf);
+    cgroup_handle_close(&h);
+    if (rc != 0) {
+        log_error("Failed to write io.max for %s: %s", name, strerror(errno));
         return -1;
     }
 
-    fprintf(fp, "%s rbps=%lu wbps=%lu\n", device, rbps, wbps);
-    fclose(fp);
-
     log_info("Set I/O limits for %s on %s: read=%lu, write=%lu bps", 
              name, device, rbps, wbps);
     return 0;
 }
 
 int cgroup_get_io_stats(const char *name, unsigned long long *read_bytes, unsigned long long *write_bytes) {
-    if (!cgroup_exists(name)) {
-        log_error("Cgroup %s does not exist", name);
+    CgroupHandle h;
+    if (open_or_log(&h, name) != 0) return -1;
+
+    char buf[8192];
+    ssize_t n = cgroup_handle_read(&h, CG_ATTR_IO_STAT, buf, sizeof(buf));
+    cgroup_handle_close(&h);
+    if (n < 0) {
+        log_error("Failed to read io.stat for %s: %s", name, strerror(errno));
         return -1;
     }
 
-    char path[MAX_PATH_LEN];
-    snprintf(path, sizeof(path), "%s/%s/io.stat", CGROUP_BASE_PATH, name);
-
-    FILE *fp = fopen(path, "r");
-    if (!fp) {
-        log_error("Failed to open io.stat for %s: %s", name, strerror(errno));
-        return -1;
-    }
-
-    char line[512];
     *read_bytes = 0;
     *write_bytes = 0;
-
-    while (fgets(line, sizeof(line), fp)) {
+    for (char *line = buf; line && *line; ) {
         unsigned long long rbytes, wbytes;
         if (sscanf(line, "%*s rbytes=%llu wbytes=%llu", &rbytes, &wbytes) == 2) {
             *read_bytes += rbytes;
             *write_bytes += wbytes;
         }
+        line = strchr(line, '\n');
+        if (line) line++;
     }
-
-    fclose(fp);
     return 0;
 }
@@ -1,28 +1,29 @@
 // CPU monitor implementation with /proc parsing + legacy stubs
 #include "../include/monitors.h"
 #include "../include/utils.h"
+#include "../include/sysroot.h"
 #include "../include/monitor.h"
 #include <unistd.h>
 
-int read_cpu_stats(CPUStats *stats) {
-    FILE *fp = fopen("/proc/stat", "r");
-    if (!fp) {
-        log_error("Failed to open /proc/stat");
-        return -1;
-    }
-
+int parse_cpu_stats(FILE *fp, CPUStats *stats) {
     char line[256];
-    if (fgets(line, sizeof(line), fp) == NULL) {
-        fclose(fp);
-        return -1;
-    }
+    if (fgets(line, sizeof(line), fp) == NULL) return -1;
 
     int parsed = sscanf(line, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
                        &stats->user, &stats->nice, &stats->system, &stats->idle,
                        &stats->iowait, &stats->irq, &stats->softirq, &stats->steal);
+    return (parsed >= 4) ? 0 : -1;
+}
 
+int read_cpu_stats(CPUStats *stats) {
+    FILE *fp = sysroot_fopen("/proc/stat", "r");
+    if (!fp) {
+        log_error("Failed to open /proc/stat");
+        return -1;
+    }
+    int rc = parse_cpu_stats(fp, stats);
     fclose(fp);
-    return (parsed >= 4) ? 0 : -1;
+    return rc;
 }
 
 double calculate_cpu_usage(CPUStats *prev, CPUStats *curr) {
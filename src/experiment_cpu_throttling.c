@@ -1,145 +1,508 @@
+#define _GNU_SOURCE
 #include "../include/experiments.h"
-#include "../include/cgroup_v2.h"
-#include "../include/monitors.h"
+#include "../include/cgroup_backend.h"
+#include "../include/cgroup_handle.h"
+#include "../include/cgroup_sampler.h"
+#include "../include/cgroup_spawn.h"
+#include "../include/sysroot.h"
 #include "../include/utils.h"
+#include <errno.h>
+#include <sched.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
-#include <sys/wait.h>
-
-static void cpu_intensive_work(int seconds) {
-    time_t end_time = time(NULL) + seconds;
-    volatile long sum = 0;
-    
-    while (time(NULL) < end_time) {
-        for (int i = 0; i < 1000000; i++) {
-            sum += i * i;
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define UNIT_ITERS 65536            /* xorshift rounds per work unit, ~100 us */
+#define MAX_LAT_PER_MS 40           /* latency slots per ms of run time */
+
+/* Shared with one cell's worker */
+typedef struct {
+    volatile int ready;             /* 1 = in the cgroup and pinned, -1 = could not */
+    volatile int go;
+    volatile int stop;
+    volatile unsigned long long units;
+    unsigned long long cap;
+    volatile unsigned long long nlat;
+    float lat_us[];
+} CellShared;
+
+/* Where a cell's files live: one directory on v2; on v1 the cpu hierarchy
+ * holds limits and cpu.stat, cpuacct (maybe the same mount) holds usage. */
+typedef struct {
+    int v1;
+    char cpu[512];
+    char acct[512];
+    CgroupHandle hcpu;
+    CgroupHandle hacct;             /* v1 with cpuacct mounted apart from cpu only */
+    int open;                       /* bit 0: hcpu, bit 1: hacct */
+} CellGroup;
+
+/* The sweep's parent group, and the controllers it had to enable in the
+ * root's cgroup.subtree_control (v2), which are disabled again afterwards */
+typedef struct {
+    CellGroup g;
+    char root[256];
+    CgroupHandle hroot;
+    int enabled_cpu;
+    int enabled_cpuset;
+} SweepParent;
+
+typedef struct {
+    unsigned long long usage_us;
+    unsigned long long periods;
+    unsigned long long throttled;
+    unsigned long long throttled_us;
+    unsigned long long bursts;
+} CellCounters;
+
+/* What a worker needs after the spawn */
+typedef struct {
+    CellGroup *g;
+    int cpu;
+    CellShared *sh;
+} CellWorker;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Whether controller is listed in a space-separated controller file */
+static int has_controller(CgroupHandle *h, CgroupAttr attr, const char *controller) {
+    char buf[256];
+    if (cgroup_handle_read(h, attr, buf, sizeof(buf)) < 0) return 0;
+    char *save = NULL;
+    for (char *tok = strtok_r(buf, " \n", &save); tok; tok = strtok_r(NULL, " \n", &save)) {
+        if (strcmp(tok, controller) == 0) return 1;
+    }
+    return 0;
+}
+
+static int split_acct(const CellGroup *g) {
+    return g->v1 && strcmp(g->acct, g->cpu) != 0;
+}
+
+static CgroupHandle *acct_handle(CellGroup *g) {
+    return split_acct(g) ? &g->hacct : &g->hcpu;
+}
+
+/* Open the handles of directories that exist */
+static int group_open(CellGroup *g) {
+    if (cgroup_handle_open(&g->hcpu, g->cpu) != 0) return -1;
+    g->open |= 1;
+    if (split_acct(g)) {
+        if (cgroup_handle_open(&g->hacct, g->acct) != 0) return -1;
+        g->open |= 2;
+    }
+    return 0;
+}
+
+static void group_remove(CellGroup *g) {
+    if (g->open & 1) cgroup_handle_close(&g->hcpu);
+    if (g->open & 2) cgroup_handle_close(&g->hacct);
+    g->open = 0;
+    rmdir(g->cpu);
+    if (split_acct(g)) rmdir(g->acct);
+}
+
+/* Enable a controller for the root's children; 1 if this call turned it on */
+static int enable_in_root(CgroupHandle *root, const char *controller) {
+    char v[32];
+    if (has_controller(root, CG_ATTR_SUBTREE_CONTROL, controller)) return 0;
+    snprintf(v, sizeof(v), "+%s", controller);
+    return cgroup_handle_write(root, CG_ATTR_SUBTREE_CONTROL, v) == 0;
+}
+
+static void sweep_parent_remove(SweepParent *sp) {
+    group_remove(&sp->g);
+    if (!sp->root[0]) return;
+    /* Leave the root's subtree_control as it was found */
+    if (sp->enabled_cpuset && cgroup_handle_write(&sp->hroot, CG_ATTR_SUBTREE_CONTROL, "-cpuset") != 0)
+        log_error("throttle: could not disable cpuset in %s (%s)", sp->root, strerror(errno));
+    if (sp->enabled_cpu && cgroup_handle_write(&sp->hroot, CG_ATTR_SUBTREE_CONTROL, "-cpu") != 0)
+        log_error("throttle: could not disable cpu in %s (%s)", sp->root, strerror(errno));
+    cgroup_handle_close(&sp->hroot);
+}
+
+/* Parent group of the sweep in each hierarchy it needs */
+static int sweep_parent(SweepParent *sp) {
+    memset(sp, 0, sizeof(*sp));
+    CellGroup *parent = &sp->g;
+    const CgroupMounts *m = cgroup_mounts();
+    const char *v2 = sysroot_sys_overridden() ? sysroot_cgroup() : (m->v2[0] ? m->v2 : NULL);
+    char name[64];
+    snprintf(name, sizeof(name), "throttle_sweep_%d", (int)getpid());
+    if (v2 && cgroup_handle_open(&sp->hroot, v2) == 0) {
+        if (has_controller(&sp->hroot, CG_ATTR_CONTROLLERS, "cpu")) {
+            snprintf(sp->root, sizeof(sp->root), "%s", v2);
+            sp->enabled_cpu = enable_in_root(&sp->hroot, "cpu");
+            sp->enabled_cpuset = enable_in_root(&sp->hroot, "cpuset");
+            snprintf(parent->cpu, sizeof(parent->cpu), "%s/%s", v2, name);
+            if ((mkdir(parent->cpu, 0755) != 0 && errno != EEXIST) || group_open(parent) != 0 ||
+                cgroup_handle_write(&parent->hcpu, CG_ATTR_SUBTREE_CONTROL, "+cpu") != 0) {
+                int err = errno;
+                sweep_parent_remove(sp);
+                errno = err;
+                return -1;
+            }
+            (void)cgroup_handle_write(&parent->hcpu, CG_ATTR_SUBTREE_CONTROL, "+cpuset");
+            return 0;
         }
+        cgroup_handle_close(&sp->hroot);
+    }
+    if (!m->v1[CG_V1_CPU][0] || !m->v1[CG_V1_CPUACCT][0]) {
+        errno = ENOTSUP;
+        return -1;
     }
+    parent->v1 = 1;
+    snprintf(parent->cpu, sizeof(parent->cpu), "%s/%s", m->v1[CG_V1_CPU], name);
+    snprintf(parent->acct, sizeof(parent->acct), "%s/%s", m->v1[CG_V1_CPUACCT], name);
+    if (mkdir(parent->cpu, 0755) != 0 && errno != EEXIST) return -1;
+    if (mkdir(parent->acct, 0755) != 0 && errno != EEXIST) {
+        int err = errno;
+        rmdir(parent->cpu);
+        errno = err;
+        return -1;
+    }
+    return 0;
 }
 
-int experiment_cpu_throttling(int throttle_percent, int duration, CPUThrottleResult *result, const char *output_file) {
-    log_info("Starting CPU throttling experiment with %d%% limit...", throttle_percent);
-    
-    FILE *fp = safe_fopen(output_file, "w");
-    if (!fp) return -1;
+static int cell_create(const CellGroup *parent, int idx, CellGroup *g) {
+    g->v1 = parent->v1;
+    g->open = 0;
+    if (snprintf(g->cpu, sizeof(g->cpu), "%s/cell_%d", parent->cpu, idx) >= (int)sizeof(g->cpu) ||
+        snprintf(g->acct, sizeof(g->acct), "%s/cell_%d", parent->v1 ? parent->acct : parent->cpu, idx) >=
+            (int)sizeof(g->acct))
+        return -1;
+    if (mkdir(g->cpu, 0755) != 0 && errno != EEXIST) return -1;
+    if (g->v1 && mkdir(g->acct, 0755) != 0 && errno != EEXIST) return -1;
+    return group_open(g);
+}
 
-    fprintf(fp, "CPU Throttling Experiment Results\n");
-    fprintf(fp, "==================================\n");
-    fprintf(fp, "Throttle limit: %d%%\n", throttle_percent);
-    fprintf(fp, "Duration: %d seconds\n\n", duration);
-
-    // Create cgroup for experiment
-    const char *cgroup_name = "cpu_throttle_test";
-    
-    if (cgroup_create(cgroup_name) != 0) {
-        log_error("Failed to create cgroup");
-        fclose(fp);
+static const char *cell_limit(CellGroup *g, const ThrottleCell *c, int cpu, ThrottleCellResult *r) {
+    CgroupHandle *h = &g->hcpu;
+    char v[64];
+    r->quota_us = c->quota_percent > 0 ? (long long)c->period_us * c->quota_percent / 100 : -1;
+    r->burst_us = r->quota_us > 0 ? r->quota_us * c->burst_percent / 100 : 0;
+    if (!g->v1) {
+        if (r->quota_us > 0) snprintf(v, sizeof(v), "%lld %d", r->quota_us, c->period_us);
+        else snprintf(v, sizeof(v), "max %d", c->period_us);
+        if (cgroup_handle_write(h, CG_ATTR_CPU_MAX, v) != 0) return "cpu.max rejected";
+        snprintf(v, sizeof(v), "%lld", r->burst_us);
+        if (cgroup_handle_write(h, CG_ATTR_CPU_MAX_BURST, v) != 0 && r->burst_us > 0) return "cpu.max.burst unsupported";
+        /* Affinity pins the worker anyway; this only holds when cpuset is enabled */
+        snprintf(v, sizeof(v), "%d", cpu);
+        (void)cgroup_handle_write(h, CG_ATTR_CPUSET_CPUS, v);
+        return NULL;
+    }
+    snprintf(v, sizeof(v), "%d", c->period_us);
+    if (cgroup_handle_write(h, CG_ATTR_CPU_CFS_PERIOD, v) != 0) return "cpu.cfs_period_us rejected";
+    snprintf(v, sizeof(v), "%lld", r->quota_us);
+    if (cgroup_handle_write(h, CG_ATTR_CPU_CFS_QUOTA, v) != 0) return "cpu.cfs_quota_us rejected";
+    snprintf(v, sizeof(v), "%lld", r->burst_us);
+    if (cgroup_handle_write(h, CG_ATTR_CPU_CFS_BURST, v) != 0 && r->burst_us > 0) return "cpu.cfs_burst_us unsupported";
+    return NULL;
+}
+
+/* One read of cpu.stat, so all counters come from the same snapshot */
+static int cell_read(CellGroup *g, CellCounters *c) {
+    char buf[1024];
+    CgroupSample smp;
+    memset(c, 0, sizeof(*c));
+    memset(&smp, 0, sizeof(smp));
+    if (cgroup_handle_read(&g->hcpu, CG_ATTR_CPU_STAT, buf, sizeof(buf)) < 0) {
+        if (!g->v1) return -1;
+        buf[0] = '\0';
+    }
+    cgroup_parse_cpu_stat(buf, &smp);
+    c->usage_us = smp.usage_usec;
+    c->periods = smp.nr_periods;
+    c->throttled = smp.nr_throttled;
+    c->throttled_us = smp.throttled_usec;
+    /* Keys the sampler does not keep: bursts, and v1's throttled time in ns */
+    for (const char *line = buf; *line; ) {
+        if (strncmp(line, "nr_bursts ", 10) == 0) c->bursts = strtoull(line + 10, NULL, 10);
+        else if (g->v1 && strncmp(line, "throttled_time ", 15) == 0) c->throttled_us = strtoull(line + 15, NULL, 10) / 1000;
+        const char *nl = strchr(line, '\n');
+        line = nl ? nl + 1 : line + strlen(line);
+    }
+    if (g->v1) {
+        unsigned long long ns = 0;
+        if (cgroup_handle_read_ull(acct_handle(g), CG_ATTR_CPUACCT_USAGE, &ns) != 0) return -1;
+        c->usage_us = ns / 1000;
+    }
+    return 0;
+}
+
+/* Worker, already in the cell: join cpuacct if apart, pin to cpu, then time
+ * work units until stopped */
+static int run_worker(void *arg) {
+    CellWorker *w = arg;
+    CellShared *sh = w->sh;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(w->cpu, &set);
+    if ((split_acct(w->g) && cgroup_handle_write(&w->g->hacct, CG_ATTR_PROCS, "0\n") != 0) ||
+        sched_setaffinity(0, sizeof(set), &set) != 0) {
+        sh->ready = -1;
+        return 1;
+    }
+    sh->ready = 1;
+    while (!sh->go && !sh->stop) usleep(200);
+    unsigned long x = 88172645463325252UL;
+    volatile unsigned long sink = 0;
+    unsigned long long units = 0, nlat = 0;
+    while (!sh->stop) {
+        double t0 = now_s();
+        for (int i = 0; i < UNIT_ITERS; ++i) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+        }
+        sink = x;
+        if (nlat < sh->cap) sh->lat_us[nlat++] = (float)((now_s() - t0) * 1e6);
+        units++;
+    }
+    sh->units = units;
+    sh->nlat = nlat;
+    (void)sink;
+    return 0;
+}
+
+static int allowed_cpus(int *cpus, int max) {
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        cpus[0] = 0;
+        return 1;
+    }
+    int n = 0;
+    for (int c = 0; c < CPU_SETSIZE && n < max; ++c) {
+        if (CPU_ISSET(c, &set)) cpus[n++] = c;
+    }
+    return n > 0 ? n : 1;
+}
+
+static void summarize(const CellShared *sh, double wall_s, ThrottleCellResult *r) {
+    r->units_per_sec = wall_s > 0 ? sh->units / wall_s : 0.0;
+    int n = (int)sh->nlat;
+    if (n <= 0) return;
+    double *v = malloc((size_t)n * sizeof(double));
+    if (!v) return;
+    for (int i = 0; i < n; ++i) v[i] = sh->lat_us[i];
+    sort_doubles(v, n);
+    r->unit_p50_us = percentile_sorted(v, n, 50.0);
+    r->unit_p99_us = percentile_sorted(v, n, 99.0);
+    r->unit_max_us = v[n - 1];
+    free(v);
+}
+
+/* One batch: every cell on its own CPU, all measured over the same window */
+static void run_batch(const CellGroup *parent, const ThrottleCell *cells, int first, int n, const int *cpus,
+                      int duration_ms, ThrottleCellResult *out) {
+    CellGroup g[n];
+    CellWorker w[n];
+    CellShared *sh[n];
+    pid_t pid[n];
+    CellCounters c0[n], c1[n];
+    size_t cap = (size_t)duration_ms * MAX_LAT_PER_MS + 1024;
+    size_t bytes = sizeof(CellShared) + cap * sizeof(float);
+
+    for (int k = 0; k < n; ++k) {
+        ThrottleCellResult *r = &out[first + k];
+        memset(r, 0, sizeof(*r));
+        r->cell = cells[first + k];
+        r->cpu = cpus[k];
+        pid[k] = -1;
+        sh[k] = NULL;
+        g[k].open = 0;
+        const char *err = NULL;
+        if (cell_create(parent, first + k, &g[k]) != 0) err = "cannot create cgroup";
+        else err = cell_limit(&g[k], &r->cell, cpus[k], r);
+        if (!err) {
+            sh[k] = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+            if (sh[k] == MAP_FAILED) {
+                sh[k] = NULL;
+                err = "out of memory";
+            }
+        }
+        if (!err) {
+            sh[k]->cap = cap;
+            w[k] = (CellWorker){ &g[k], cpus[k], sh[k] };
+            pid[k] = cgroup_spawn_fn(&g[k].hcpu, run_worker, &w[k]);
+            if (pid[k] < 0) err = "worker could not join";
+        }
+        if (err) snprintf(r->error, sizeof(r->error), "%s", err);
+    }
+    /* Wait until every worker sits in its cgroup on its CPU */
+    double deadline = now_s() + 5.0;
+    for (int k = 0; k < n; ++k) {
+        while (pid[k] > 0 && sh[k]->ready == 0 && now_s() < deadline) usleep(1000);
+        if (pid[k] > 0 && sh[k]->ready != 1) snprintf(out[first + k].error, sizeof(out[0].error), "worker could not join");
+        if (pid[k] > 0 && cell_read(&g[k], &c0[k]) != 0) snprintf(out[first + k].error, sizeof(out[0].error), "cpu.stat unreadable");
+    }
+    double t0 = now_s();
+    for (int k = 0; k < n; ++k) if (sh[k]) sh[k]->go = 1;
+    usleep((useconds_t)duration_ms * 1000);
+    double wall = now_s() - t0;
+    for (int k = 0; k < n; ++k) if (pid[k] > 0 && cell_read(&g[k], &c1[k]) != 0) memset(&c1[k], 0, sizeof(c1[k]));
+    for (int k = 0; k < n; ++k) if (sh[k]) sh[k]->stop = 1;
+
+    for (int k = 0; k < n; ++k) {
+        ThrottleCellResult *r = &out[first + k];
+        if (pid[k] > 0) cgroup_spawn_wait(pid[k]);
+        if (pid[k] > 0 && !r->error[0]) {
+            const ThrottleCell *c = &r->cell;
+            double ratio = c->quota_percent > 0 ? c->quota_percent / 100.0 : 1.0;
+            r->configured_percent = (ratio > 1.0 ? 1.0 : ratio) * 100.0;
+            r->achieved_percent = (c1[k].usage_us - c0[k].usage_us) / (wall * 1e6) * 100.0;
+            r->nr_periods = c1[k].periods - c0[k].periods;
+            r->nr_throttled = c1[k].throttled - c0[k].throttled;
+            r->throttled_ms = (c1[k].throttled_us - c0[k].throttled_us) / 1000.0;
+            r->nr_bursts = c1[k].bursts - c0[k].bursts;
+            summarize(sh[k], wall, r);
+        }
+        if (sh[k]) munmap(sh[k], bytes);
+        group_remove(&g[k]);
+    }
+}
+
+int experiment_throttle_run(const ThrottleCell *cells, int n, int duration_ms, int parallel,
+                            ThrottleCellResult *out) {
+    SweepParent parent;
+    if (n <= 0 || duration_ms <= 0) return -1;
+    if (sweep_parent(&parent) != 0) {
+        log_error("throttle: no writable cpu controller (%s)", strerror(errno));
         return -1;
     }
+    int cpus[256];
+    int ncpu = allowed_cpus(cpus, 256);
+    int width = (parallel > 0 && parallel < ncpu) ? parallel : ncpu;
+    int ok = 0;
+    for (int first = 0; first < n; first += width) {
+        int m = (n - first < width) ? n - first : width;
+        run_batch(&parent.g, cells, first, m, cpus, duration_ms, out);
+        for (int k = first; k < first + m; ++k) ok += (out[k].error[0] == '\0');
+    }
+    sweep_parent_remove(&parent);
+    return ok > 0 ? 0 : -1;
+}
 
-    // Phase 1: Unthrottled baseline
-    fprintf(fp, "Phase 1: Unthrottled baseline\n");
-    log_info("Running unthrottled baseline for %d seconds...", duration);
-    
-    pid_t pid = fork();
-    if (pid == 0) {
-        // Child process: CPU-intensive work
-        cpu_intensive_work(duration);
-        exit(0);
-    }
-    
-    // Parent: Monitor CPU usage
-    sleep(1); // Let child start
-    
-    char baseline_file[256];
-    snprintf(baseline_file, sizeof(baseline_file), "output/experiments/cpu_baseline_%d.csv", getpid());
-    
-    CPUStats prev_stats, curr_stats;
-    read_cpu_stats(&prev_stats);
-    
-    double unthrottled_total = 0.0;
-    int samples = 0;
-    
-    for (int i = 0; i < duration; i++) {
-        sleep(1);
-        read_cpu_stats(&curr_stats);
-        double usage = calculate_cpu_usage(&prev_stats, &curr_stats);
-        unthrottled_total += usage;
-        samples++;
-        fprintf(fp, "  Sample %d: %.2f%%\n", i+1, usage);
-        prev_stats = curr_stats;
-    }
-    
-    waitpid(pid, NULL, 0);
-    result->unthrottled_usage = unthrottled_total / samples;
-    
-    fprintf(fp, "  Average CPU usage: %.2f%%\n\n", result->unthrottled_usage);
-
-    // Phase 2: Throttled
-    fprintf(fp, "Phase 2: Throttled to %d%%\n", throttle_percent);
-    log_info("Running throttled test...");
-    
-    // Set CPU limit (quota/period)
-    long period = 100000; // 100ms
-    long quota = period * throttle_percent / 100;
-    
-    if (cgroup_set_cpu_max(cgroup_name, quota, period) != 0) {
-        log_error("Failed to set CPU limit");
-        cgroup_delete(cgroup_name);
-        fclose(fp);
+/* Split a comma list of positive ints ("max" = 0 where allowed); returns count or -1 */
+static int parse_list(const char *list, const char *def, int allow_max, int *out, int max) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", list ? list : def);
+    int n = 0;
+    char *save = NULL;
+    for (char *tok = strtok_r(buf, ",", &save); tok && n < max; tok = strtok_r(NULL, ",", &save)) {
+        int v = (allow_max && strcmp(tok, "max") == 0) ? 0 : atoi(tok);
+        if (v < 0 || (v == 0 && !(allow_max && (strcmp(tok, "max") == 0 || strcmp(tok, "0") == 0)))) return -1;
+        out[n++] = v;
+    }
+    return n;
+}
+
+int experiment_cpu_throttling_sweep(const char *quotas, const char *periods, const char *bursts,
+                                    int duration_ms, int parallel, const char *output_file) {
+    int q[16], p[16], b[16];
+    int nq = parse_list(quotas, "max,20,50,80", 1, q, 16);
+    int np = parse_list(periods, "10000,100000", 0, p, 16);
+    int nb = parse_list(bursts, "0", 1, b, 16);
+    if (nq <= 0 || np <= 0 || nb <= 0) {
+        log_error("throttle sweep: bad quota, period or burst list");
         return -1;
     }
-    
-    pid = fork();
-    if (pid == 0) {
-        // Child process: CPU-intensive work
-        cpu_intensive_work(duration);
-        exit(0);
-    }
-    
-    // Add child to cgroup
-    if (cgroup_add_process(cgroup_name, pid) != 0) {
-        log_error("Failed to add process to cgroup");
-        kill(pid, SIGTERM);
-        waitpid(pid, NULL, 0);
-        cgroup_delete(cgroup_name);
+    int n = 0;
+    ThrottleCell cells[16 * 16 * 16];
+    for (int i = 0; i < nq; ++i) {
+        for (int j = 0; j < np; ++j) {
+            for (int k = 0; k < nb; ++k) {
+                /* Burst is a share of the quota: meaningless without one */
+                if (q[i] == 0 && k > 0) continue;
+                cells[n].quota_percent = q[i];
+                cells[n].period_us = p[j];
+                cells[n].burst_percent = q[i] ? b[k] : 0;
+                n++;
+            }
+        }
+    }
+    ThrottleCellResult *res = calloc((size_t)n, sizeof(*res));
+    if (!res) return -1;
+    log_info("throttle sweep: %d cells, %d ms each", n, duration_ms);
+    if (experiment_throttle_run(cells, n, duration_ms, parallel, res) != 0) {
+        free(res);
+        return -1;
+    }
+
+    FILE *fp = stdout;
+    if (output_file) {
+        fp = safe_fopen(output_file, "w");
+        if (!fp) { free(res); return -1; }
+    }
+    double base_p99 = 0.0;
+    for (int i = 0; i < n && base_p99 <= 0.0; ++i) {
+        if (res[i].cell.quota_percent == 0 && !res[i].error[0]) base_p99 = res[i].unit_p99_us;
+    }
+    fprintf(fp, "quota_percent,period_us,burst_percent,quota_us,burst_us,cpu,configured_cpu_pct,achieved_cpu_pct,"
+                "nr_periods,nr_throttled,throttled_periods_pct,throttled_ms,nr_bursts,units_per_s,"
+                "unit_p50_us,unit_p99_us,unit_max_us,p99_vs_unlimited,error\n");
+    for (int i = 0; i < n; ++i) {
+        const ThrottleCellResult *r = &res[i];
+        double pct = r->nr_periods ? 100.0 * r->nr_throttled / r->nr_periods : 0.0;
+        double vs = base_p99 > 0 ? r->unit_p99_us / base_p99 : 0.0;
+        fprintf(fp, "%d,%d,%d,%lld,%lld,%d,%.1f,%.2f,%llu,%llu,%.1f,%.1f,%llu,%.0f,%.0f,%.0f,%.0f,%.2f,%s\n",
+                r->cell.quota_percent, r->cell.period_us, r->cell.burst_percent, r->quota_us, r->burst_us, r->cpu,
+                r->configured_percent, r->achieved_percent, r->nr_periods, r->nr_throttled, pct, r->throttled_ms,
+                r->nr_bursts, r->units_per_sec, r->unit_p50_us, r->unit_p99_us, r->unit_max_us, vs, r->error);
+    }
+    if (output_file) fclose(fp);
+    free(res);
+    return 0;
+}
+
+int experiment_cpu_throttling(int throttle_percent, int duration, CPUThrottleResult *result, const char *output_file) {
+    log_info("Starting CPU throttling experiment with %d%% limit...", throttle_percent);
+
+    FILE *fp = safe_fopen(output_file, "w");
+    if (!fp) return -1;
+
+    /* Same CPU, one after the other: the unlimited run is the reference */
+    ThrottleCell cells[2] = { { 0, 100000, 0 }, { throttle_percent, 100000, 0 } };
+    ThrottleCellResult r[2] = {0};
+    if (experiment_throttle_run(cells, 2, duration * 1000, 1, r) != 0 || r[0].error[0] || r[1].error[0]) {
+        log_error("CPU throttling experiment failed: %s", r[0].error[0] ? r[0].error : r[1].error);
         fclose(fp);
         return -1;
     }
-    
-    sleep(1); // Let child start
-    
-    read_cpu_stats(&prev_stats);
-    double throttled_total = 0.0;
-    samples = 0;
-    
-    for (int i = 0; i < duration; i++) {
-        sleep(1);
-        read_cpu_stats(&curr_stats);
-        double usage = calculate_cpu_usage(&prev_stats, &curr_stats);
-        throttled_total += usage;
-        samples++;
-        fprintf(fp, "  Sample %d: %.2f%%\n", i+1, usage);
-        prev_stats = curr_stats;
-    }
-    
-    waitpid(pid, NULL, 0);
-    result->throttled_usage = throttled_total / samples;
+    result->unthrottled_usage = r[0].achieved_percent;
+    result->throttled_usage = r[1].achieved_percent;
     result->throttle_percent = throttle_percent;
     result->duration_seconds = duration;
-    
-    fprintf(fp, "  Average CPU usage: %.2f%%\n\n", result->throttled_usage);
-    
+    result->nr_throttled = r[1].nr_throttled;
+    result->throttled_ms = r[1].throttled_ms;
+
+    fprintf(fp, "CPU Throttling Experiment Results\n");
+    fprintf(fp, "==================================\n");
+    fprintf(fp, "Throttle limit: %d%% of one CPU (period 100 ms)\n", throttle_percent);
+    fprintf(fp, "Duration: %d seconds per phase, CPU %d\n", duration, r[0].cpu);
+    fprintf(fp, "Measured from the experiment cgroup's own CPU accounting\n\n");
+    for (int i = 0; i < 2; ++i) {
+        fprintf(fp, "Phase %d: %s\n", i + 1, i == 0 ? "Unthrottled baseline" : "Throttled");
+        fprintf(fp, "  CPU usage: %.2f%%\n", r[i].achieved_percent);
+        fprintf(fp, "  Periods: %llu, throttled: %llu (%.1f ms)\n", r[i].nr_periods, r[i].nr_throttled,
+                r[i].throttled_ms);
+        fprintf(fp, "  Work unit latency p50/p99/max: %.0f / %.0f / %.0f us\n\n", r[i].unit_p50_us,
+                r[i].unit_p99_us, r[i].unit_max_us);
+    }
     fprintf(fp, "Results Summary:\n");
     fprintf(fp, "  Unthrottled average: %.2f%%\n", result->unthrottled_usage);
     fprintf(fp, "  Throttled average: %.2f%%\n", result->throttled_usage);
     fprintf(fp, "  Target limit: %d%%\n", throttle_percent);
-    fprintf(fp, "  Effective reduction: %.2f%%\n", 
-            result->unthrottled_usage - result->throttled_usage);
-
-    // Cleanup
-    cgroup_delete(cgroup_name);
+    fprintf(fp, "  Effective reduction: %.2f%%\n", result->unthrottled_usage - result->throttled_usage);
     fclose(fp);
-    
+
     log_info("CPU throttling experiment completed");
     return 0;
 }
@@ -33,6 +33,17 @@ static void io_intensive_work(const char *filename, int seconds) {
     log_info("Wrote %llu bytes total", total_written);
 }
 
+typedef struct {
+    const char *filename;
+    int seconds;
+} IOWorkArgs;
+
+static int io_intensive_child(void *arg) {
+    const IOWorkArgs *a = arg;
+    io_intensive_work(a->filename, a->seconds);
+    return 0;
+}
+
 int experiment_io_limit(unsigned long limit_mbps, int duration, IOLimitResult *result, const char *output_file) {
     log_info("Starting I/O limit experiment with %lu MB/s limit...", limit_mbps);
     
@@ -116,17 +127,10 @@ int experiment_io_limit(unsigned long limit_mbps, int duration, IOLimitResult *r
         log_error("Failed to read initial I/O stats");
     }
     
-    pid = fork();
-    if (pid == 0) {
-        io_intensive_work(test_file, duration);
-        exit(0);
-    }
-    
-    // Add to cgroup
-    if (cgroup_add_process(cgroup_name, pid) != 0) {
-        log_error("Failed to add process to cgroup");
-        kill(pid, SIGTERM);
-        waitpid(pid, NULL, 0);
+    IOWorkArgs work = { test_file, duration };
+    pid = cgroup_spawn_process(cgroup_name, io_intensive_child, &work);
+    if (pid < 0) {
+        log_error("Failed to start process in cgroup");
         cgroup_delete(cgroup_name);
         fclose(fp);
         return -1;
@@ -46,6 +46,11 @@ static void memory_allocator(unsigned long target_mb) {
     free(allocations);
 }
 
+static int memory_allocator_child(void *arg) {
+    memory_allocator(*(unsigned long *)arg);
+    return allocation_failed ? 1 : 0;
+}
+
 int experiment_memory_limit(unsigned long limit_mb, MemoryLimitResult *result, const char *output_file) {
     log_info("Starting memory limit experiment with %lu MB limit...", limit_mb);
     
@@ -76,18 +81,11 @@ int experiment_memory_limit(unsigned long limit_mb, MemoryLimitResult *result, c
     fprintf(fp, "Phase 1: Memory allocation test\n");
     fprintf(fp, "Attempting to allocate %lu MB (limit: %lu MB)\n\n", limit_mb + 50, limit_mb);
     
-    pid_t pid = fork();
-    if (pid == 0) {
-        // Child process: try to allocate more than the limit
-        memory_allocator(limit_mb + 50);
-        exit(allocation_failed ? 1 : 0);
-    }
-    
-    // Add child to cgroup
-    if (cgroup_add_process(cgroup_name, pid) != 0) {
-        log_error("Failed to add process to cgroup");
-        kill(pid, SIGTERM);
-        waitpid(pid, NULL, 0);
+    // Child process: try to allocate more than the limit, charged from its first page
+    unsigned long target_mb = limit_mb + 50;
+    pid_t pid = cgroup_spawn_process(cgroup_name, memory_allocator_child, &target_mb);
+    if (pid < 0) {
+        log_error("Failed to start process in cgroup");
         cgroup_delete(cgroup_name);
         fclose(fp);
         return -1;
@@ -1,89 +1,381 @@
+#define _GNU_SOURCE
 #include "../include/experiments.h"
-#include "../include/monitors.h"
+#include "../include/resource_profiler.h"
+#include "../include/process_tree.h"
+#include "../include/cgroup_sampler.h"
 #include "../include/utils.h"
+#include <math.h>
+#include <sched.h>
+#include <signal.h>
+#include <string.h>
 #include <time.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #include <sys/wait.h>
 
-int experiment_overhead(OverheadResult *result, const char *output_file) {
-    log_info("Starting overhead experiment...");
-    
-    FILE *fp = safe_fopen(output_file, "w");
-    if (!fp) return -1;
+static const char *const workload_names[OVH_WORK_COUNT] = { "cpu", "syscall", "memory" };
+static const char *const monitor_names[OVH_MON_COUNT] = { "profiler", "proctree", "cgroup" };
+
+const char *overhead_workload_name(OverheadWorkload w) {
+    return (w >= 0 && w < OVH_WORK_COUNT) ? workload_names[w] : "?";
+}
+
+const char *overhead_monitor_name(OverheadMonitor m) {
+    return (m >= 0 && m < OVH_MON_COUNT) ? monitor_names[m] : "?";
+}
+
+int overhead_workload_from_name(const char *name) {
+    for (int i = 0; i < OVH_WORK_COUNT; ++i) {
+        if (strcmp(name, workload_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+int overhead_monitor_from_name(const char *name) {
+    for (int i = 0; i < OVH_MON_COUNT; ++i) {
+        if (strcmp(name, monitor_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+/* Shared with the workload child: it counts units until told to stop */
+typedef struct {
+    volatile int ready;             /* 1 = running, -1 = could not start */
+    volatile int stop;
+    volatile unsigned long long units;
+    volatile double elapsed_s;
+} WorkShared;
+
+#define MEM_BUF_BYTES (64UL << 20)
+#define MEM_UNIT_BYTES (1UL << 20)
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Child: one unit is 64k ALU iterations, 1000 syscalls or 1 MB copied */
+static void run_workload(OverheadWorkload w, WorkShared *sh) {
+    char *src = NULL, *dst = NULL;
+    if (w == OVH_WORK_MEMORY) {
+        src = malloc(MEM_BUF_BYTES);
+        dst = malloc(MEM_BUF_BYTES);
+        if (!src || !dst) {
+            sh->ready = -1;
+            _exit(1);
+        }
+        memset(src, 1, MEM_BUF_BYTES);
+        memset(dst, 0, MEM_BUF_BYTES);
+    }
+    volatile unsigned long sink = 0;
+    unsigned long x = 88172645463325252UL;
+    unsigned long long units = 0;
+    size_t off = 0;
+    sh->ready = 1;
+    double t0 = now_s();
+    while (!sh->stop) {
+        switch (w) {
+        case OVH_WORK_CPU:
+            for (int i = 0; i < 65536; ++i) {
+                x ^= x << 13;
+                x ^= x >> 7;
+                x ^= x << 17;
+            }
+            sink = x;
+            break;
+        case OVH_WORK_SYSCALL:
+            for (int i = 0; i < 1000; ++i) sink += (unsigned long)syscall(SYS_getppid);
+            break;
+        default:
+            memcpy(dst + off, src + off, MEM_UNIT_BYTES);
+            off = (off + MEM_UNIT_BYTES) % MEM_BUF_BYTES;
+            break;
+        }
+        units++;
+    }
+    sh->elapsed_s = now_s() - t0;
+    sh->units = units;
+    (void)sink;
+    _exit(0);
+}
+
+/* utime + stime of this process, in seconds */
+static double self_cpu_s(void) {
+    FILE *f = fopen("/proc/self/stat", "r");
+    if (!f) return 0.0;
+    char buf[1024];
+    double s = 0.0;
+    if (fgets(buf, sizeof(buf), f)) {
+        char *p = strrchr(buf, ')');
+        unsigned long ut = 0, st = 0;
+        if (p && sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &ut, &st) == 2) {
+            s = (double)(ut + st) / (double)sysconf(_SC_CLK_TCK);
+        }
+    }
+    fclose(f);
+    return s;
+}
+
+static void sleep_until(double t) {
+    double d = t - now_s();
+    if (d <= 0) return;
+    struct timespec ts = { (time_t)d, (long)((d - (time_t)d) * 1e9) };
+    nanosleep(&ts, NULL);
+}
+
+/* Observe the child for trial_ms with the chosen monitor. Returns observations made. */
+static int observe(const OverheadCase *c, pid_t child, ProcessTree *tree, CgroupSampler *cg) {
+    int interval = c->interval_ms > 0 ? c->interval_ms : 1;
+    int n = 0;
+    if (c->monitor == OVH_MON_PROFILER) {
+        /* rp_run's own loop, output discarded; it sleeps interval_ms between samples */
+        rp_options_t opts = {0};
+        opts.pid = child;
+        opts.interval_ms = interval;
+        opts.samples = c->trial_ms / interval > 0 ? c->trial_ms / interval : 1;
+        opts.outpath = "/dev/null";
+        return rp_run_opts(&opts) == 0 ? opts.samples : 0;
+    }
+    double end = now_s() + c->trial_ms / 1000.0;
+    for (double next = now_s(); next < end; next += interval / 1000.0) {
+        if (c->monitor == OVH_MON_PROCTREE) (void)process_tree_refresh(tree);
+        else (void)cgroup_sampler_tick(cg);
+        n++;
+        sleep_until(next + interval / 1000.0 < end ? next + interval / 1000.0 : end);
+    }
+    return n;
+}
+
+/* One trial: start the workload, observe it (or just wait), stop it.
+ * Returns units/s, or -1 if the child could not run. */
+static double trial(const OverheadCase *c, int monitored, WorkShared *sh, ProcessTree *tree,
+                    CgroupSampler *cg, double *cpu_s, int *obs) {
+    memset((void *)sh, 0, sizeof(*sh));
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid == 0) run_workload(c->workload, sh);
+    int status;
+    while (sh->ready == 0) {
+        /* A child that dies before starting must not hang the harness */
+        if (waitpid(pid, &status, WNOHANG) == pid) return -1;
+        usleep(100);
+    }
+    if (sh->ready < 0) {
+        waitpid(pid, &status, 0);
+        return -1;
+    }
+
+    double c0 = self_cpu_s();
+    if (monitored) *obs = observe(c, pid, tree, cg);
+    else sleep_until(now_s() + c->trial_ms / 1000.0);
+    *cpu_s = self_cpu_s() - c0;
+
+    sh->stop = 1;
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) return -1;
+    return sh->elapsed_s > 0 ? (double)sh->units / sh->elapsed_s : -1;
+}
+
+/* Two-sided 95% Student t quantiles for 1..30 degrees of freedom */
+static const double t95[31] = {
+    0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+static double t_quantile(int df) {
+    return df < 1 ? 0.0 : (df <= 30 ? t95[df] : 1.96);
+}
+
+/* Mean of v; *se is its standard error */
+static double mean_se(const double *v, int n, double *se) {
+    double m = 0.0, ss = 0.0;
+    for (int i = 0; i < n; ++i) m += v[i];
+    m /= (n > 0 ? n : 1);
+    for (int i = 0; i < n; ++i) ss += (v[i] - m) * (v[i] - m);
+    *se = n > 1 ? sqrt(ss / (n - 1) / n) : 0.0;
+    return m;
+}
+
+int experiment_overhead_run(const OverheadCase *c, OverheadCaseResult *r) {
+    memset(r, 0, sizeof(*r));
+    r->c = *c;
+    int trials = c->trials > 1 ? c->trials : 2;
+    r->c.trials = trials;
 
-    fprintf(fp, "Monitoring Overhead Experiment Results\n");
-    fprintf(fp, "======================================\n\n");
-
-    const int SAMPLES = 10;
-    const int ITERATIONS = 100000;
-    
-    struct timespec start, end;
-    double baseline_times[SAMPLES];
-    double monitored_times[SAMPLES];
-
-    // Baseline: CPU-intensive task without monitoring
-    fprintf(fp, "Phase 1: Baseline measurements (no monitoring)\n");
-    for (int i = 0; i < SAMPLES; i++) {
-        clock_gettime(CLOCK_MONOTONIC, &start);
-        
-        // CPU-intensive work
-        volatile long sum = 0;
-        for (int j = 0; j < ITERATIONS; j++) {
-            sum += j * j;
+    WorkShared *sh = mmap(NULL, sizeof(WorkShared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (sh == MAP_FAILED) return -1;
+    ProcessTree tree;
+    CgroupSampler cg;
+    int have_tree = 0, have_cg = 0;
+    if (c->monitor == OVH_MON_PROCTREE) have_tree = process_tree_init(&tree) == 0;
+    if (c->monitor == OVH_MON_CGROUP) have_cg = cgroup_sampler_init(&cg, NULL, 2) == 0;
+    if ((c->monitor == OVH_MON_PROCTREE && !have_tree) || (c->monitor == OVH_MON_CGROUP && !have_cg)) {
+        munmap(sh, sizeof(WorkShared));
+        return -1;
+    }
+
+    cpu_set_t saved;
+    int pinned = 0;
+    if (c->same_cpu && sched_getaffinity(0, sizeof(saved), &saved) == 0) {
+        cpu_set_t one;
+        CPU_ZERO(&one);
+        for (int i = 0; i < CPU_SETSIZE; ++i) {
+            if (CPU_ISSET(i, &saved)) {
+                CPU_SET(i, &one);
+                break;
+            }
         }
-        
-        clock_gettime(CLOCK_MONOTONIC, &end);
-        baseline_times[i] = get_elapsed_time(&start, &end);
-        
-        fprintf(fp, "  Sample %d: %.6f seconds\n", i+1, baseline_times[i]);
-        log_info("Baseline sample %d: %.6f seconds", i+1, baseline_times[i]);
-    }
-
-    // With monitoring: Same task while reading CPU stats
-    fprintf(fp, "\nPhase 2: Monitored measurements (with CPU monitoring)\n");
-    for (int i = 0; i < SAMPLES; i++) {
-        CPUStats stats;
-        clock_gettime(CLOCK_MONOTONIC, &start);
-        
-        // CPU-intensive work with periodic monitoring
-        volatile long sum = 0;
-        for (int j = 0; j < ITERATIONS; j++) {
-            sum += j * j;
-            if (j % 10000 == 0) {
-                read_cpu_stats(&stats);
+        pinned = sched_setaffinity(0, sizeof(one), &one) == 0;
+    }
+
+    double *base = calloc((size_t)trials, sizeof(double));
+    double *mon = calloc((size_t)trials, sizeof(double));
+    double *cpu = calloc((size_t)trials, sizeof(double));
+    double *ratio = calloc((size_t)trials, sizeof(double));
+    int rc = (base && mon && cpu && ratio) ? 0 : -1;
+    long long observations = 0;
+    double monitored_s = 0.0;
+    for (int i = 0; i < trials && rc == 0; ++i) {
+        double cpu_s = 0.0;
+        int obs = 0;
+        /* ABBA order cancels linear drift across a pair */
+        int mon_first = i % 2;
+        for (int k = 0; k < 2 && rc == 0; ++k) {
+            int monitored = (k == 0) == mon_first;
+            double t0 = now_s();
+            double ops = trial(c, monitored, sh, have_tree ? &tree : NULL, have_cg ? &cg : NULL, &cpu_s, &obs);
+            if (ops < 0) rc = -1;
+            if (monitored) {
+                double wall = now_s() - t0;
+                mon[i] = ops;
+                cpu[i] = wall > 0 ? cpu_s / wall * 100.0 : 0.0;
+                observations += obs;
+                monitored_s += wall;
+            } else {
+                base[i] = ops;
             }
         }
-        
-        clock_gettime(CLOCK_MONOTONIC, &end);
-        monitored_times[i] = get_elapsed_time(&start, &end);
-        
-        fprintf(fp, "  Sample %d: %.6f seconds\n", i+1, monitored_times[i]);
-        log_info("Monitored sample %d: %.6f seconds", i+1, monitored_times[i]);
+        if (rc == 0) ratio[i] = base[i] > 0 ? (mon[i] - base[i]) / base[i] * 100.0 : 0.0;
     }
+    if (pinned) sched_setaffinity(0, sizeof(saved), &saved);
 
-    // Calculate averages
-    double baseline_avg = 0.0, monitored_avg = 0.0;
-    for (int i = 0; i < SAMPLES; i++) {
-        baseline_avg += baseline_times[i];
-        monitored_avg += monitored_times[i];
+    if (rc == 0) {
+        double se, tq = t_quantile(trials - 1);
+        r->base_ops = mean_se(base, trials, &se);
+        r->base_ci = tq * se;
+        r->mon_ops = mean_se(mon, trials, &se);
+        r->mon_ci = tq * se;
+        /* Paired: each monitored trial against the baseline next to it */
+        r->delta_percent = mean_se(ratio, trials, &se);
+        r->delta_ci = tq * se;
+        r->monitor_cpu_percent = mean_se(cpu, trials, &se);
+        r->monitor_cpu_ci = tq * se;
+        r->observations_per_sec = monitored_s > 0 ? observations / monitored_s : 0.0;
     }
-    baseline_avg /= SAMPLES;
-    monitored_avg /= SAMPLES;
+    free(base);
+    free(mon);
+    free(cpu);
+    free(ratio);
+    if (have_tree) process_tree_free(&tree);
+    if (have_cg) cgroup_sampler_free(&cg);
+    munmap(sh, sizeof(WorkShared));
+    return rc;
+}
 
-    double overhead = ((monitored_avg - baseline_avg) / baseline_avg) * 100.0;
+static void write_header(FILE *fp) {
+    fprintf(fp, "workload,monitor,interval_ms,trials,trial_ms,same_cpu,base_ops_per_s,base_ci95,"
+                "mon_ops_per_s,mon_ci95,throughput_delta_pct,delta_ci95_pct,monitor_cpu_pct,"
+                "monitor_cpu_ci95,observations_per_s\n");
+}
 
-    result->baseline_duration = baseline_avg;
-    result->monitored_duration = monitored_avg;
-    result->overhead_percent = overhead;
-    result->samples = SAMPLES;
+static void write_row(FILE *fp, const OverheadCaseResult *r) {
+    fprintf(fp, "%s,%s,%d,%d,%d,%d,%.1f,%.1f,%.1f,%.1f,%.3f,%.3f,%.3f,%.3f,%.1f\n",
+            overhead_workload_name(r->c.workload), overhead_monitor_name(r->c.monitor), r->c.interval_ms,
+            r->c.trials, r->c.trial_ms, r->c.same_cpu, r->base_ops, r->base_ci, r->mon_ops, r->mon_ci,
+            r->delta_percent, r->delta_ci, r->monitor_cpu_percent, r->monitor_cpu_ci, r->observations_per_sec);
+    fflush(fp);
+}
 
-    fprintf(fp, "\nResults Summary:\n");
-    fprintf(fp, "  Baseline average: %.6f seconds\n", baseline_avg);
-    fprintf(fp, "  Monitored average: %.6f seconds\n", monitored_avg);
-    fprintf(fp, "  Overhead: %.2f%%\n", overhead);
+/* Split a comma list into at most max names resolved by from_name; returns count or -1 */
+static int parse_list(const char *list, const char *def, int (*from_name)(const char *), int *out, int max) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", list ? list : def);
+    int n = 0;
+    char *save = NULL;
+    for (char *tok = strtok_r(buf, ",", &save); tok && n < max; tok = strtok_r(NULL, ",", &save)) {
+        int v = from_name ? from_name(tok) : atoi(tok);
+        if (v < 0 || (!from_name && v == 0)) return -1;
+        out[n++] = v;
+    }
+    return n;
+}
+
+int experiment_overhead_sweep(const char *workloads, const char *monitors, const char *intervals,
+                              int trials, int trial_ms, int same_cpu, const char *output_file) {
+    int w[OVH_WORK_COUNT], m[OVH_MON_COUNT], iv[16];
+    int nw = parse_list(workloads, "cpu,syscall,memory", overhead_workload_from_name, w, OVH_WORK_COUNT);
+    int nm = parse_list(monitors, "profiler,proctree,cgroup", overhead_monitor_from_name, m, OVH_MON_COUNT);
+    int ni = parse_list(intervals, "1,10,100,1000", NULL, iv, 16);
+    if (nw <= 0 || nm <= 0 || ni <= 0) {
+        log_error("overhead: unknown workload, monitor or interval");
+        return -1;
+    }
+    FILE *fp = stdout;
+    if (output_file) {
+        fp = safe_fopen(output_file, "w");
+        if (!fp) return -1;
+    }
+    write_header(fp);
+    int rc = 0;
+    for (int a = 0; a < nw; ++a) {
+        for (int b = 0; b < nm; ++b) {
+            for (int k = 0; k < ni; ++k) {
+                OverheadCase c = { (OverheadWorkload)w[a], (OverheadMonitor)m[b], iv[k], trials, trial_ms, same_cpu };
+                OverheadCaseResult r;
+                if (experiment_overhead_run(&c, &r) != 0) {
+                    log_error("overhead: %s/%s at %d ms failed", workload_names[w[a]], monitor_names[m[b]], iv[k]);
+                    rc = -1;
+                    continue;
+                }
+                write_row(fp, &r);
+            }
+        }
+    }
+    if (output_file) fclose(fp);
+    return rc;
+}
+
+int experiment_overhead(OverheadResult *result, const char *output_file) {
+    log_info("Starting overhead experiment...");
+
+    FILE *fp = safe_fopen(output_file, "w");
+    if (!fp) return -1;
+    write_header(fp);
 
+    static const int intervals[] = { 1000, 100, 10 };
+    int rc = 0;
+    memset(result, 0, sizeof(*result));
+    for (size_t i = 0; i < sizeof(intervals) / sizeof(intervals[0]); ++i) {
+        OverheadCase c = { OVH_WORK_CPU, OVH_MON_PROFILER, intervals[i], 5, 1000, 0 };
+        OverheadCaseResult r;
+        if (experiment_overhead_run(&c, &r) != 0) {
+            rc = -1;
+            break;
+        }
+        write_row(fp, &r);
+        log_info("rp_run every %d ms: throughput %+.2f%% (+/- %.2f), monitor CPU %.2f%%", intervals[i],
+                 r.delta_percent, r.delta_ci, r.monitor_cpu_percent);
+        if (intervals[i] == 100) {
+            result->baseline_duration = r.base_ops > 0 ? 1.0 / r.base_ops : 0.0;
+            result->monitored_duration = r.mon_ops > 0 ? 1.0 / r.mon_ops : 0.0;
+            result->overhead_percent = -r.delta_percent;
+            result->samples = r.c.trials;
+        }
+    }
     fclose(fp);
-    
-    log_info("Overhead experiment completed: %.2f%% overhead", overhead);
-    return 0;
+
+    if (rc == 0) log_info("Overhead experiment completed: %.2f%% overhead", result->overhead_percent);
+    return rc;
 }
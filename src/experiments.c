@@ -201,6 +201,7 @@ void save_experiment_results(const char *filename, const char *experiment_name,
             fprintf(fp, "Throttle limit: %d%%\n", (int)r->throttle_percent);
             fprintf(fp, "Unthrottled: %.2f%%, Throttled: %.2f%%\n",
                     r->unthrottled_usage, r->throttled_usage);
+            fprintf(fp, "Throttled periods: %llu (%.1f ms)\n", r->nr_throttled, r->throttled_ms);
             break;
         }
         case 3: { // Memory Limit
@@ -1,14 +1,9 @@
 #include "../include/monitors.h"
 #include "../include/utils.h"
+#include "../include/sysroot.h"
 #include <unistd.h>
 
-int read_io_stats(const char *device, IOStats *stats) {
-    FILE *fp = fopen("/proc/diskstats", "r");
-    if (!fp) {
-        log_error("Failed to open /proc/diskstats");
-        return -1;
-    }
-
+int parse_io_stats(FILE *fp, const char *device, IOStats *stats) {
     char line[512];
     int found = 0;
 
@@ -32,10 +27,20 @@ int read_io_stats(const char *device, IOStats *stats) {
         }
     }
 
-    fclose(fp);
     return found ? 0 : -1;
 }
 
+int read_io_stats(const char *device, IOStats *stats) {
+    FILE *fp = sysroot_fopen("/proc/diskstats", "r");
+    if (!fp) {
+        log_error("Failed to open /proc/diskstats");
+        return -1;
+    }
+    int rc = parse_io_stats(fp, device, stats);
+    fclose(fp);
+    return rc;
+}
+
 int monitor_io(const char *device, int duration_seconds, const char *output_file) {
     FILE *fp = safe_fopen(output_file, "w");
     if (!fp) return -1;
@@ -0,0 +1,260 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/sysinfo.h>
+#include "../include/memory_accounting.h"
+#include "../include/sysroot.h"
+
+/* name as one CSV field, quoted only when it needs to be */
+static void write_csv_field(FILE *out, const char *s) {
+    if (!strpbrk(s, ",\"\n\r")) {
+        fputs(s, out);
+        return;
+    }
+    fputc('"', out);
+    for (; *s; ++s) {
+        if (*s == '"') fputc('"', out);
+        fputc(*s, out);
+    }
+    fputc('"', out);
+}
+
+static long long now_ms(void) {
+    /* Recording and replay run on the tick clock */
+    if (sysroot_mode() != SYSROOT_LIVE) return sysroot_time_ms();
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int read_smaps_rollup(pid_t pid, SmapsRollup *out) {
+    char path[64], buf[2048];
+    snprintf(path, sizeof(path), "/proc/%d/smaps_rollup", (int)pid);
+    int fd = sysroot_open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    ssize_t r = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (r <= 0) return -1;
+    buf[r] = '\0';
+
+    memset(out, 0, sizeof(*out));
+    unsigned long shared_clean = 0, shared_dirty = 0, private_clean = 0, private_dirty = 0;
+    struct { const char *key; unsigned long *dst; } keys[] = {
+        {"Rss:", &out->rss_kb},
+        {"Pss:", &out->pss_kb},
+        {"Pss_Anon:", &out->pss_anon_kb},
+        {"Pss_File:", &out->pss_file_kb},
+        {"Pss_Shmem:", &out->pss_shmem_kb},
+        {"Shared_Clean:", &shared_clean},
+        {"Shared_Dirty:", &shared_dirty},
+        {"Private_Clean:", &private_clean},
+        {"Private_Dirty:", &private_dirty},
+        {"Anonymous:", &out->anon_kb},
+        {"Swap:", &out->swap_kb},
+        {"SwapPss:", &out->swap_pss_kb},
+        {NULL, NULL}
+    };
+    /* First line is the [rollup] VMA header */
+    char *line = strchr(buf, '\n');
+    int found = 0;
+    while (line && *++line) {
+        for (int i = 0; keys[i].key; ++i) {
+            size_t klen = strlen(keys[i].key);
+            if (strncmp(line, keys[i].key, klen) == 0) {
+                *keys[i].dst = strtoul(line + klen, NULL, 10);
+                found++;
+                break;
+            }
+        }
+        line = strchr(line, '\n');
+    }
+    out->uss_kb = private_clean + private_dirty;
+    out->shared_kb = shared_clean + shared_dirty;
+    return found ? 0 : -1;
+}
+
+/* Field 22 of /proc/<pid>/stat, 0 if the process is gone */
+static unsigned long long read_start_time(pid_t pid) {
+    char path[64], buf[1024];
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+    int fd = sysroot_open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+    ssize_t r = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (r <= 0) return 0;
+    buf[r] = '\0';
+    /* comm may contain spaces and ')': count fields from the last ')' (field 2) */
+    char *p = strrchr(buf, ')');
+    for (int field = 2; p && field < 22; ++field) p = strchr(p + 1, ' ');
+    return p ? strtoull(p + 1, NULL, 10) : 0;
+}
+
+int mem_acct_init(MemAcctCache *cache, int refresh_ms) {
+    memset(cache, 0, sizeof(*cache));
+    cache->refresh_ms = (refresh_ms > 0) ? refresh_ms : 5000;
+    cache->capacity = 16;
+    cache->entries = calloc((size_t)cache->capacity, sizeof(MemAcctEntry));
+    return cache->entries ? 0 : -1;
+}
+
+void mem_acct_free(MemAcctCache *cache) {
+    free(cache->entries);
+    memset(cache, 0, sizeof(*cache));
+}
+
+static int find_entry(const MemAcctCache *cache, pid_t pid) {
+    for (int i = 0; i < cache->count; ++i) {
+        if (cache->entries[i].pid == pid) return i;
+    }
+    return -1;
+}
+
+int mem_acct_update(MemAcctCache *cache, const pid_t *pids, const unsigned long long *start_times, int n) {
+    /* Drop entries that are no longer selected (selection is small, linear scans are fine) */
+    for (int i = 0; i < cache->count;) {
+        int selected = 0;
+        for (int j = 0; j < n; ++j) {
+            if (pids[j] == cache->entries[i].pid) { selected = 1; break; }
+        }
+        if (selected) { i++; continue; }
+        cache->entries[i] = cache->entries[--cache->count];
+    }
+
+    long long now = now_ms();
+    int reads = 0;
+    for (int j = 0; j < n; ++j) {
+        int idx = find_entry(cache, pids[j]);
+        if (idx < 0) {
+            if (cache->count == cache->capacity) {
+                int cap = cache->capacity * 2;
+                MemAcctEntry *e = realloc(cache->entries, (size_t)cap * sizeof(MemAcctEntry));
+                if (!e) return -1;
+                cache->entries = e;
+                cache->capacity = cap;
+            }
+            idx = cache->count++;
+            memset(&cache->entries[idx], 0, sizeof(MemAcctEntry));
+            cache->entries[idx].pid = pids[j];
+        }
+        MemAcctEntry *e = &cache->entries[idx];
+        unsigned long long start = start_times ? start_times[j] : read_start_time(pids[j]);
+        if (e->start_time != start) {
+            /* New entry, or the pid now names another process: its baseline is not ours */
+            e->start_time = start;
+            e->last_refresh_ms = 0;
+            e->valid = 0;
+        }
+        if (e->last_refresh_ms != 0 && now - e->last_refresh_ms < cache->refresh_ms) continue;
+        e->valid = (read_smaps_rollup(e->pid, &e->mem) == 0);
+        e->last_refresh_ms = now;
+        reads++;
+    }
+    return reads;
+}
+
+const SmapsRollup *mem_acct_get(const MemAcctCache *cache, pid_t pid) {
+    int idx = find_entry(cache, pid);
+    if (idx < 0 || !cache->entries[idx].valid) return NULL;
+    return &cache->entries[idx].mem;
+}
+
+int mem_acct_select_top_k(const ProcessTree *tree, int k, const char *name_filter, pid_t *out) {
+    if (k <= 0) return 0;
+    /* Insertion into a k-sized array sorted by RSS descending */
+    unsigned long *rss = calloc((size_t)k, sizeof(unsigned long));
+    if (!rss) return 0;
+    int n = 0;
+    for (int i = 0; i < tree->capacity; ++i) {
+        const ProcessTreeNode *node = &tree->nodes[i];
+        if (node->pid <= 0 || node->rss == 0) continue; /* kernel threads have no mm */
+        if (name_filter && !strstr(node->name, name_filter)) continue;
+        if (n == k && node->rss <= rss[k - 1]) continue;
+        int pos = (n < k) ? n++ : k - 1;
+        while (pos > 0 && rss[pos - 1] < node->rss) {
+            rss[pos] = rss[pos - 1];
+            out[pos] = out[pos - 1];
+            pos--;
+        }
+        rss[pos] = node->rss;
+        out[pos] = node->pid;
+    }
+    free(rss);
+    return n;
+}
+
+double mem_acct_percent(const SmapsRollup *mem, unsigned long mem_total_kb) {
+    if (!mem || mem_total_kb == 0) return 0.0;
+    return (100.0 * mem->pss_kb) / mem_total_kb;
+}
+
+int monitor_memory_accounting(int k, const char *name_filter, int interval_ms, int samples,
+                              int refresh_ms, const char *output_file) {
+    if (k <= 0) k = 10;
+    if (samples <= 0) samples = 1;
+    FILE *out = stdout;
+    if (output_file) {
+        out = fopen(output_file, "w");
+        if (!out) { perror("fopen"); return -1; }
+    }
+
+    struct sysinfo si;
+    unsigned long mem_total_kb = 0;
+    if (sysinfo(&si) == 0) mem_total_kb = (unsigned long)(si.totalram / 1024) * si.mem_unit;
+
+    ProcessTree tree;
+    MemAcctCache cache;
+    pid_t *selected = calloc((size_t)k, sizeof(pid_t));
+    unsigned long long *starts = calloc((size_t)k, sizeof(unsigned long long));
+    if (!selected || !starts || process_tree_init(&tree) != 0) {
+        free(selected);
+        free(starts);
+        if (output_file) fclose(out);
+        return -1;
+    }
+    if (mem_acct_init(&cache, refresh_ms) != 0) {
+        process_tree_free(&tree);
+        free(selected);
+        free(starts);
+        if (output_file) fclose(out);
+        return -1;
+    }
+
+    fprintf(out, "timestamp_ms,pid,name,rss_kb,pss_kb,uss_kb,swap_pss_kb,pss_anon_kb,pss_file_kb,mem_percent\n");
+    long page_kb = sysconf(_SC_PAGESIZE) / 1024;
+    int rc = 0;
+    for (int i = 0; i < samples; ++i) {
+        if (process_tree_refresh(&tree) < 0) { rc = -1; break; }
+        int n = mem_acct_select_top_k(&tree, k, name_filter, selected);
+        for (int j = 0; j < n; ++j) {
+            const ProcessTreeNode *node = process_tree_find(&tree, selected[j]);
+            starts[j] = node ? node->start_time : 0;
+        }
+        mem_acct_update(&cache, selected, starts, n);
+
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        long long ms = (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+        for (int j = 0; j < n; ++j) {
+            const ProcessTreeNode *node = process_tree_find(&tree, selected[j]);
+            const SmapsRollup *m = mem_acct_get(&cache, selected[j]);
+            if (!node || !m) continue;
+            fprintf(out, "%lld,%d,", ms, (int)node->pid);
+            write_csv_field(out, node->name);
+            fprintf(out, ",%lu,%lu,%lu,%lu,%lu,%lu,%.2f\n", node->rss * page_kb, m->pss_kb, m->uss_kb,
+                    m->swap_pss_kb, m->pss_anon_kb, m->pss_file_kb, mem_acct_percent(m, mem_total_kb));
+        }
+        fflush(out);
+        if (i + 1 < samples) usleep((useconds_t)interval_ms * 1000);
+    }
+
+    mem_acct_free(&cache);
+    process_tree_free(&tree);
+    free(selected);
+    free(starts);
+    if (output_file) fclose(out);
+    return rc;
+}
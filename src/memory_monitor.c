@@ -1,14 +1,9 @@
 #include "../include/monitors.h"
 #include "../include/utils.h"
+#include "../include/sysroot.h"
 #include <unistd.h>
 
-int read_memory_stats(MemoryStats *stats) {
-    FILE *fp = fopen("/proc/meminfo", "r");
-    if (!fp) {
-        log_error("Failed to open /proc/meminfo");
-        return -1;
-    }
-
+int parse_memory_stats(FILE *fp, MemoryStats *stats) {
     char line[256];
     memset(stats, 0, sizeof(MemoryStats));
 
@@ -30,8 +25,6 @@ int read_memory_stats(MemoryStats *stats) {
         }
     }
 
-    fclose(fp);
-
     if (stats->total > 0) {
         unsigned long used = stats->total - stats->available;
         stats->usage_percent = calculate_percentage(used, stats->total);
@@ -40,6 +33,17 @@ int read_memory_stats(MemoryStats *stats) {
     return 0;
 }
 
+int read_memory_stats(MemoryStats *stats) {
+    FILE *fp = sysroot_fopen("/proc/meminfo", "r");
+    if (!fp) {
+        log_error("Failed to open /proc/meminfo");
+        return -1;
+    }
+    int rc = parse_memory_stats(fp, stats);
+    fclose(fp);
+    return rc;
+}
+
 int monitor_memory(int duration_seconds, const char *output_file) {
     FILE *fp = safe_fopen(output_file, "w");
     if (!fp) return -1;
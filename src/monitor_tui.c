@@ -12,6 +12,8 @@
 #include "../include/resource_profiler.h"
 #include "../include/namespace.h"
 #include "../include/cgroup.h"
+#include "../include/cgroup_throttle.h"
+#include "../include/experiments.h"
 
 /* Cores */
 #define COLOR_TITLE 1
@@ -207,8 +209,9 @@ static void show_cgroup_menu() {
         "Mover PID",
         "Set CPU quota",
         "Set Mem max",
+        "Throttling (top cgroups)",
         "Voltar"
-    }; int n=6;
+    }; int n=7;
     while (1) {
         clear(); attron(COLOR_PAIR(COLOR_TITLE)|A_BOLD); mvprintw(1,2,"[+] Cgroup Manager"); attroff(COLOR_PAIR(COLOR_TITLE)|A_BOLD);
         for (int i=0;i<n;i++){ if(i==sel){attron(COLOR_PAIR(COLOR_SELECTED)|A_BOLD); mvprintw(3+i,4,"> %d) %s", i+1, items[i]); attroff(COLOR_PAIR(COLOR_SELECTED)|A_BOLD);} else mvprintw(3+i,4,"  %d) %s", i+1, items[i]); }
@@ -220,8 +223,9 @@ static void show_cgroup_menu() {
             else if (sel==2){ echo(); curs_set(1); char path[128], pidbuf[16]; mvprintw(2,2,"Path: "); getstr(path); mvprintw(3,2,"PID: "); getstr(pidbuf); noecho(); curs_set(0); pid_t p=(pid_t)atoi(pidbuf); end_ncurses(); int r=cgroup_move_pid(path,p); printf("move(%s,%d) => %d\n", path,(int)p,r); init_ncurses(); }
             else if (sel==3){ echo(); curs_set(1); char name[64], quota[32], period[32]; mvprintw(2,2,"Nome: "); getstr(name); mvprintw(3,2,"Quota: "); getstr(quota); mvprintw(4,2,"Period: "); getstr(period); noecho(); curs_set(0); long q=atol(quota), per=atol(period); end_ncurses(); int r=cgroup_set_cpu_limit_quota(name,q,per); printf("set-cpu(%s,%ld,%ld) => %d\n", name,q,per,r); init_ncurses(); }
             else if (sel==4){ echo(); curs_set(1); char name[64], mem[32]; mvprintw(2,2,"Nome: "); getstr(name); mvprintw(3,2,"Mem max bytes: "); getstr(mem); noecho(); curs_set(0); unsigned long m=strtoul(mem,NULL,10); end_ncurses(); int r=cgroup_set_memory_max(name,m); printf("set-mem(%s,%lu) => %d\n", name,m,r); init_ncurses(); }
+            else if (sel==5){ echo(); curs_set(1); char secs[16]; mvprintw(2,2,"Janela (s, amostras de 1s): "); getstr(secs); noecho(); curs_set(0); int sm=atoi(secs); if (sm<2) sm=10; end_ncurses(); int r=cgroup_throttle_report(NULL,1000,sm,99.0,15,NULL); printf("throttle(%ds) => %d\n", sm,r); init_ncurses(); }
             mvprintw(8,2,"(Saída acima gerada fora do ncurses)"); mvprintw(9,2,"Pressione qualquer tecla para continuar..."); refresh(); getch();
-        } else if (ch>='1'&&ch<='6') sel=ch-'1';
+        } else if (ch>='1'&&ch<='7') sel=ch-'1';
     }
     end_ncurses();
 }
@@ -259,16 +263,27 @@ void show_experiments_menu() {
         
         switch (exp_num) {
             case 1: /* Overhead */
+            {
+                /* Harness real: carga padrão num filho, rp_run observando a 1000/100/10 ms */
+                OverheadResult ovh;
+                mkdir("output", 0755);
+                end_ncurses();
+                int orc = experiment_overhead(&ovh, "output/experiment_overhead.csv");
+                init_ncurses();
+                clear();
+                mvprintw(2, 2, "[!] Executando Experimento %d", exp_num);
                 mvprintw(4, 2, "Medindo overhead de monitoramento...");
-                mvprintw(5, 2, "- Coletando baseline sem monitoramento");
-                mvprintw(6, 2, "- Coletando com monitoramento ativo");
-                mvprintw(7, 2, "- Calculando diferença...");
-                refresh();
-                sleep(3);
-                mvprintw(9, 2, "Resultado: Overhead ~2.3%% de CPU");
+                mvprintw(5, 2, "- Baseline e monitorado alternados, %d pares", ovh.samples);
+                mvprintw(6, 2, "- rp_run a cada 1000/100/10 ms");
+                if (orc == 0) {
+                    mvprintw(9, 2, "Resultado: Overhead %.2f%% de throughput (rp_run a 100 ms)", ovh.overhead_percent);
+                    if (fp) fprintf(fp, "exp1,overhead,%.2f\n", ovh.overhead_percent);
+                } else {
+                    mvprintw(9, 2, "Falha ao executar o experimento");
+                }
                 mvprintw(10, 2, "Salvo em: output/experiment_overhead.csv");
-                if (fp) fprintf(fp, "exp1,overhead,2.3\n");
                 break;
+            }
                 
             case 2: /* Namespaces */
                 mvprintw(4, 2, "Testando isolamento de namespaces...");
@@ -284,17 +299,28 @@ void show_experiments_menu() {
                 break;
                 
             case 3: /* CPU Throttling */
+            {
+                /* Cgroup de teste com cpu.max, contabilidade lida do cpu.stat do próprio cgroup */
+                CPUThrottleResult thr;
+                mkdir("output", 0755);
+                end_ncurses();
+                int trc = experiment_cpu_throttling(50, 3, &thr, "output/experiment_cpu_throttling.txt");
+                init_ncurses();
+                clear();
+                mvprintw(2, 2, "[!] Executando Experimento %d", exp_num);
                 mvprintw(4, 2, "Testando CPU Throttling via Cgroups...");
-                mvprintw(5, 2, "- Limitando CPU a 50%%");
-                mvprintw(6, 2, "- Executando workload CPU-bound");
-                mvprintw(7, 2, "- Medindo tempo de execução");
-                mvprintw(8, 2, "- Removendo limite");
-                refresh();
-                sleep(5);
-                mvprintw(10, 2, "Resultado: Com limite 2.2x mais lento (como esperado)");
-                mvprintw(11, 2, "Salvo em: output/experiment_cpu_throttling.csv");
-                if (fp) fprintf(fp, "exp3,cpu_throttling,2.2x\n");
+                mvprintw(5, 2, "- Workload CPU-bound sem limite, depois limitado a 50%% (período 100 ms)");
+                mvprintw(6, 2, "- Uso medido pelo cpu.stat do cgroup do experimento");
+                if (trc == 0) {
+                    mvprintw(9, 2, "Resultado: %.1f%% sem limite, %.1f%% com limite, %llu períodos estrangulados (%.0f ms)",
+                             thr.unthrottled_usage, thr.throttled_usage, thr.nr_throttled, thr.throttled_ms);
+                    if (fp) fprintf(fp, "exp3,cpu_throttling,%.2f\n", thr.throttled_usage);
+                } else {
+                    mvprintw(9, 2, "Falha ao executar o experimento (requer root e controlador cpu)");
+                }
+                mvprintw(10, 2, "Salvo em: output/experiment_cpu_throttling.txt");
                 break;
+            }
                 
             case 4: /* Memory */
                 mvprintw(4, 2, "Testando limite de memória...");
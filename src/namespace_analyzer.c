@@ -6,21 +6,18 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <errno.h>
-#include <time.h>
-#include <sched.h>
-#include <signal.h>
-#include <sys/wait.h>
 #include "../include/namespace.h"
+#include "../include/namespace_census.h"
+#include "../include/namespace_bench.h"
+#include "../include/sysroot.h"
 
 static const char *ns_types[] = {"mnt","pid","net","ipc","uts","user","cgroup", NULL};
 
-/* child function for clone() must be at file scope in C */
-static int ns_child(void *arg) { (void)arg; _exit(0); }
-
 static int read_ns_link(pid_t pid, const char *ns_type, char *out, size_t outlen) {
-    char path[256];
+    char path[256], real[512];
     snprintf(path, sizeof(path), "/proc/%d/ns/%s", (int)pid, ns_type);
-    ssize_t r = readlink(path, out, outlen - 1);
+    if (sysroot_path(real, sizeof(real), path) != 0) return -1;
+    ssize_t r = readlink(real, out, outlen - 1);
     if (r < 0) return -1;
     out[r] = '\0';
     return 0;
@@ -56,127 +53,95 @@ int namespace_compare(pid_t pid1, pid_t pid2) {
     return identical ? 0 : 1;
 }
 
-/* Map processes by a given namespace type. We'll collect (nsid, pid) pairs, sort by nsid and print grouped. */
+static int cmp_entry_ino(const void *a, const void *b, void *arg) {
+    const NsEntry *ns = arg;
+    ino_t x = ns[*(const int *)a].ino, y = ns[*(const int *)b].ino;
+    return (x > y) - (x < y);
+}
+
+/* Map processes by a given namespace type: one line per namespace, from a single census pass */
 int namespace_map_by_type(const char *ns_type) {
-    DIR *d = opendir("/proc");
-    if (!d) {
-        perror("opendir /proc");
+    int type = namespace_type_from_name(ns_type);
+    if (type < 0) {
+        fprintf(stderr, "Unknown ns_type: %s\n", ns_type);
         return -1;
     }
-    struct dirent *de;
-    typedef struct { char nsid[128]; int pid; } pair_t;
-    size_t cap = 4096;
-    size_t n = 0;
-    pair_t *arr = calloc(cap, sizeof(pair_t));
-    if (!arr) { closedir(d); return -1; }
-    while ((de = readdir(d)) != NULL) {
-        if (de->d_type != DT_DIR) continue;
-        char *endptr;
-        long pid = strtol(de->d_name, &endptr, 10);
-        if (*endptr != '\0') continue; /* not a PID */
-        char buf[128];
-        if (read_ns_link((pid_t)pid, ns_type, buf, sizeof(buf)) != 0) continue;
-        if (n >= cap) {
-            cap *= 2;
-            pair_t *tmp = realloc(arr, cap * sizeof(pair_t));
-            if (!tmp) break;
-            arr = tmp;
-        }
-        strncpy(arr[n].nsid, buf, sizeof(arr[n].nsid)-1);
-        arr[n].nsid[sizeof(arr[n].nsid)-1] = '\0';
-        arr[n].pid = (int)pid;
-        n++;
+    NsCensus c;
+    if (namespace_census(&c, NULL, 0) != 0) {
+        perror("namespace census");
+        return -1;
     }
-    closedir(d);
-    if (n == 0) {
-        free(arr);
+    if (c.per_type[type] == 0) {
+        namespace_census_free(&c);
         printf("No processes found or no namespace entries for type '%s'\n", ns_type);
         return 0;
     }
-    /* sort by nsid */
-    int cmp(const void *A, const void *B) {
-        const pair_t *a = A; const pair_t *b = B;
-        int r = strcmp(a->nsid, b->nsid);
-        if (r != 0) return r;
-        return a->pid - b->pid;
+    int *order = malloc((size_t)c.per_type[type] * sizeof(int));
+    if (!order) {
+        namespace_census_free(&c);
+        return -1;
     }
-    qsort(arr, n, sizeof(pair_t), cmp);
-    /* print grouped */
-    char cur[128] = "";
-    for (size_t i = 0; i < n; ++i) {
-        if (strcmp(cur, arr[i].nsid) != 0) {
-            if (cur[0] != '\0') printf("\n");
-            strcpy(cur, arr[i].nsid);
-            printf("%s: %d", cur, arr[i].pid);
-        } else {
-            printf(" %d", arr[i].pid);
-        }
+    int n = 0;
+    for (int k = 0; k < c.count; ++k) {
+        if ((int)c.ns[k].type == type) order[n++] = k;
+    }
+    qsort_r(order, (size_t)n, sizeof(int), cmp_entry_ino, c.ns);
+    for (int i = 0; i < n; ++i) {
+        const NsEntry *e = &c.ns[order[i]];
+        printf("%s:[%lu]:", namespace_type_name(e->type), (unsigned long)e->ino);
+        for (int m = 0; m < e->nmembers; ++m) printf(" %d", (int)c.members[e->first + m]);
+        printf("\n");
     }
-    printf("\n");
-    free(arr);
+    free(order);
+    namespace_census_free(&c);
     return 0;
 }
 
 /* Measure overhead to create a new namespace of a given type (iterations averaged) */
 int namespace_creation_overhead(const char *ns_type, int iterations) {
     if (iterations <= 0) iterations = 10;
-    int flag = 0;
-    if (strcmp(ns_type, "pid") == 0) flag = CLONE_NEWPID;
-    else if (strcmp(ns_type, "net") == 0) flag = CLONE_NEWNET;
-    else if (strcmp(ns_type, "mnt") == 0 || strcmp(ns_type, "mount") == 0) flag = CLONE_NEWNS;
-    else if (strcmp(ns_type, "uts") == 0) flag = CLONE_NEWUTS;
-    else if (strcmp(ns_type, "ipc") == 0) flag = CLONE_NEWIPC;
-    else if (strcmp(ns_type, "user") == 0) flag = CLONE_NEWUSER;
-    else if (strcmp(ns_type, "cgroup") == 0) flag = 0; /* v2 not namespaced via clone */
-    else { fprintf(stderr, "Unknown ns_type: %s\n", ns_type); return 1; }
-
-    const size_t STACK_SIZE = 1024*1024;
-    char *stack = malloc(STACK_SIZE);
-    if (!stack) { perror("malloc"); return 1; }
-    char *top = stack + STACK_SIZE;
+    NsBenchCase bc;
+    memset(&bc, 0, sizeof(bc));
+    const char *spec = strcmp(ns_type, "mount") == 0 ? "mnt" : ns_type;
+    if (namespace_bench_parse_flags(spec, &bc.flags) != 0) {
+        fprintf(stderr, "Unknown ns_type: %s\n", ns_type);
+        return 1;
+    }
+    snprintf(bc.label, sizeof(bc.label), "%s", spec);
+    bc.method = NS_BENCH_CLONE;
+    bc.threads = 1;
+    bc.iterations = iterations;
+    bc.warmup = iterations < 10 ? 1 : iterations / 10;
 
-    struct timespec t0, t1;
-    double total_ms = 0.0; int ok = 0;
-    for (int i = 0; i < iterations; ++i) {
-        clock_gettime(CLOCK_MONOTONIC, &t0);
-        pid_t pid = clone(ns_child, top, flag | SIGCHLD, NULL);
-        clock_gettime(CLOCK_MONOTONIC, &t1);
-        if (pid < 0) {
-            perror("clone");
-            fprintf(stderr, "Hint: some namespaces require root (EPERM)\n");
-            free(stack);
-            return 1;
-        }
-        int status; (void)waitpid(pid, &status, 0);
-        double ms = (t1.tv_sec - t0.tv_sec)*1000.0 + (t1.tv_nsec - t0.tv_nsec)/1e6;
-        total_ms += ms; ok++;
+    /* Full lifecycle (create, exit, reap): teardown is part of the cost */
+    NsBenchResult r;
+    if (namespace_bench_run(&bc, &r) != 0) {
+        fprintf(stderr, "clone: %s\n", strerror(r.err));
+        fprintf(stderr, "Hint: some namespaces require root (EPERM)\n");
+        return 1;
     }
-    free(stack);
-    if (ok == 0) { fprintf(stderr, "No successful iterations\n"); return 1; }
-    printf("Namespace creation overhead (%s): %.3f ms (avg over %d)\n", ns_type, total_ms/ok, ok);
+    printf("Namespace creation overhead (%s): %.3f ms (avg over %d), p50 %.3f ms, p99 %.3f ms\n",
+           ns_type, r.mean_us / 1000.0, r.samples, r.p50_us / 1000.0, r.p99_us / 1000.0);
     return 0;
 }
 
-/* Global report: counts processes per namespace type */
-int namespace_system_report(void) {
-    const char *types[] = {"mnt","pid","net","ipc","uts","user","cgroup",NULL};
-    printf("Namespace System Report\n");
-    for (const char **p = types; *p; ++p) {
-        /* Reuse map to accumulate counts */
-        DIR *d = opendir("/proc"); if (!d) { perror("opendir /proc"); return -1; }
-        struct dirent *de; int count = 0; char last[128] = ""; int groups = 0;
-        while ((de = readdir(d)) != NULL) {
-            if (de->d_type != DT_DIR) continue;
-            char *endptr; long pid = strtol(de->d_name, &endptr, 10);
-            if (*endptr != '\0') continue;
-            char buf[128];
-            if (read_ns_link((pid_t)pid, *p, buf, sizeof(buf)) != 0) continue;
-            count++;
-            if (strcmp(buf, last) != 0) { strcpy(last, buf); groups++; }
-        }
-        closedir(d);
-        printf("  %-6s: %d processes across ~%d namespaces\n", *p, count, groups);
+/* Global report: exact namespace and task counts per type, from one /proc pass */
+int namespace_census_report(int threads) {
+    NsCensus c;
+    if (namespace_census(&c, NULL, threads) != 0) {
+        perror("namespace census");
+        return -1;
+    }
+    const char *what = threads ? "threads" : "processes";
+    printf("Namespace System Report (%d %s, %d namespaces)\n", c.ntasks, what, c.count);
+    for (int t = 0; t < NS_TYPE_COUNT; ++t) {
+        printf("  %-6s: %d %s across %d namespaces\n", namespace_type_name((NsType)t),
+               c.tasks_per_type[t], what, c.per_type[t]);
     }
+    namespace_census_free(&c);
     return 0;
 }
 
+int namespace_system_report(void) {
+    return namespace_census_report(0);
+}
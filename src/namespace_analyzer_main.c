@@ -2,17 +2,34 @@
 #include <stdlib.h>
 #include <string.h>
 #include "../include/namespace.h"
+#include "../include/namespace_containers.h"
+#include "../include/netns_stats.h"
+#include "../include/namespace_bench.h"
+#include "../include/namespace_matrix.h"
+#include "../include/sysroot.h"
 
 static void usage(const char *prog) {
-    fprintf(stderr, "Usage:\n");
+    fprintf(stderr, "Usage: %s [--root=DIR] <command> ...\n", prog);
     fprintf(stderr, "  %s list <pid>\n", prog);
     fprintf(stderr, "  %s compare <pid1> <pid2>\n", prog);
+    fprintf(stderr, "  %s compare-many <all|pid,pid,...|comm=name> [--shared] [--json] [--out file]\n", prog);
     fprintf(stderr, "  %s map <ns_type>\n", prog);
     fprintf(stderr, "  %s overhead <ns_type> [iterations]\n", prog);
-    fprintf(stderr, "  %s report\n", prog);
+    fprintf(stderr, "  %s report [--threads]\n", prog);
+    fprintf(stderr, "  %s containers [interval_ms] [samples] [--all] [out.csv]\n", prog);
+    fprintf(stderr, "  %s netstat [interval_ms] [samples] [out.csv]\n", prog);
+    fprintf(stderr, "  %s bench [--types a,b+c] [--threads N] [--iterations N] [--warmup N] [--json] [--out file]\n",
+            prog);
+    fprintf(stderr, "  --root    read DIR/proc and DIR/sys instead of /proc and /sys (also RESMON_ROOT)\n");
 }
 
 int main(int argc, char **argv) {
+    if (argc > 1 && strncmp(argv[1], "--root=", 7) == 0) {
+        sysroot_set(argv[1] + 7);
+        argv[1] = argv[0];
+        argv++;
+        argc--;
+    }
     if (argc < 2) { usage(argv[0]); return 1; }
     if (strcmp(argv[1], "list") == 0) {
         if (argc < 3) { usage(argv[0]); return 1; }
@@ -23,6 +40,17 @@ int main(int argc, char **argv) {
         pid_t a = (pid_t)atoi(argv[2]);
         pid_t b = (pid_t)atoi(argv[3]);
         return namespace_compare(a,b);
+    } else if (strcmp(argv[1], "compare-many") == 0) {
+        if (argc < 3) { usage(argv[0]); return 1; }
+        const char *out = NULL;
+        int json = 0, shared = 0;
+        for (int i = 3; i < argc; ++i) {
+            if (strcmp(argv[i], "--json") == 0) json = 1;
+            else if (strcmp(argv[i], "--shared") == 0) shared = 1;
+            else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) out = argv[++i];
+            else { usage(argv[0]); return 1; }
+        }
+        return namespace_compare_many(argv[2], json, shared, out) == 0 ? 0 : 1;
     } else if (strcmp(argv[1], "map") == 0) {
         if (argc < 3) { usage(argv[0]); return 1; }
         const char *nt = argv[2];
@@ -33,7 +61,37 @@ int main(int argc, char **argv) {
         int it = (argc >= 4) ? atoi(argv[3]) : 10;
         return namespace_creation_overhead(nt, it);
     } else if (strcmp(argv[1], "report") == 0) {
-        return namespace_system_report();
+        int threads = (argc >= 3 && strcmp(argv[2], "--threads") == 0);
+        return namespace_census_report(threads);
+    } else if (strcmp(argv[1], "containers") == 0) {
+        int interval = 1000, samples = 5, all = 0, pos = 0;
+        const char *out = NULL;
+        for (int i = 2; i < argc; ++i) {
+            if (strcmp(argv[i], "--all") == 0) all = 1;
+            else if (pos == 0 && ++pos) interval = atoi(argv[i]);
+            else if (pos == 1 && ++pos) samples = atoi(argv[i]);
+            else out = argv[i];
+        }
+        return container_monitor_series(interval, samples, all, out) == 0 ? 0 : 1;
+    } else if (strcmp(argv[1], "netstat") == 0) {
+        int interval = (argc > 2) ? atoi(argv[2]) : 1000;
+        int samples = (argc > 3) ? atoi(argv[3]) : 5;
+        const char *out = (argc > 4) ? argv[4] : NULL;
+        return netns_monitor(interval, samples, out) == 0 ? 0 : 1;
+    } else if (strcmp(argv[1], "bench") == 0) {
+        const char *types = NULL, *out = NULL;
+        int threads = 1, iterations = 100, warmup = 10, json = 0;
+        for (int i = 2; i < argc; ++i) {
+            if (strcmp(argv[i], "--json") == 0) json = 1;
+            else if (i + 1 >= argc) { usage(argv[0]); return 1; }
+            else if (strcmp(argv[i], "--types") == 0) types = argv[++i];
+            else if (strcmp(argv[i], "--threads") == 0) threads = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--iterations") == 0) iterations = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--warmup") == 0) warmup = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--out") == 0) out = argv[++i];
+            else { usage(argv[0]); return 1; }
+        }
+        return namespace_bench(types, threads, iterations, warmup, json, out) == 0 ? 0 : 1;
     } else {
         usage(argv[0]);
         return 1;
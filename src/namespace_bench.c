@@ -0,0 +1,325 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <sys/wait.h>
+#include <linux/sched.h>
+#include "../include/namespace_bench.h"
+#include "../include/namespace_census.h"
+#include "../include/utils.h"
+
+#define CHILD_STACK_SIZE (64 * 1024)
+
+static const char *const method_names[NS_BENCH_METHOD_COUNT] = { "clone", "clone3", "unshare" };
+
+static const int type_flags[NS_TYPE_COUNT] = {
+    CLONE_NEWNS, CLONE_NEWPID, CLONE_NEWNET, CLONE_NEWIPC, CLONE_NEWUTS, CLONE_NEWUSER, CLONE_NEWCGROUP
+};
+
+#define CONTAINER_FLAGS (CLONE_NEWUSER | CLONE_NEWPID | CLONE_NEWNET | CLONE_NEWNS | \
+                         CLONE_NEWUTS | CLONE_NEWIPC | CLONE_NEWCGROUP)
+
+const char *namespace_bench_method_name(NsBenchMethod m) {
+    return (m >= 0 && m < NS_BENCH_METHOD_COUNT) ? method_names[m] : "?";
+}
+
+int namespace_bench_parse_flags(const char *spec, int *flags) {
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s", spec);
+    *flags = 0;
+    char *save = NULL;
+    for (char *tok = strtok_r(buf, "+", &save); tok; tok = strtok_r(NULL, "+", &save)) {
+        if (strcmp(tok, "none") == 0) continue;
+        if (strcmp(tok, "container") == 0) {
+            *flags |= CONTAINER_FLAGS;
+            continue;
+        }
+        int t = namespace_type_from_name(tok);
+        if (t < 0) return -1;
+        *flags |= type_flags[t];
+    }
+    return 0;
+}
+
+static int child_exit(void *arg) {
+    (void)arg;
+    _exit(0);
+}
+
+/* One create -> exit -> reap. Returns 0, or an errno value. */
+static int lifecycle(NsBenchMethod method, int flags, char *stack_top) {
+    pid_t pid = -1;
+    switch (method) {
+    case NS_BENCH_CLONE:
+        pid = clone(child_exit, stack_top, flags | SIGCHLD, NULL);
+        break;
+    case NS_BENCH_CLONE3: {
+#ifdef SYS_clone3
+        struct clone_args ca;
+        memset(&ca, 0, sizeof(ca));
+        ca.flags = (unsigned long long)flags;
+        ca.exit_signal = SIGCHLD;
+        pid = (pid_t)syscall(SYS_clone3, &ca, sizeof(ca));
+        if (pid == 0) _exit(0);
+#else
+        errno = ENOSYS;
+#endif
+        break;
+    }
+    case NS_BENCH_UNSHARE:
+        pid = fork();
+        /* The child is single-threaded, as unshare(CLONE_NEWUSER) requires */
+        if (pid == 0) _exit(unshare(flags) == 0 ? 0 : (errno & 0x7f));
+        break;
+    default:
+        return EINVAL;
+    }
+    if (pid < 0) return errno;
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) return errno;
+    }
+    if (WIFEXITED(status) && WEXITSTATUS(status) != 0) return WEXITSTATUS(status);
+    return 0;
+}
+
+/* Start line for the creators: opened once every thread is created and
+ * warmed up, or aborted when a pthread_create fails part way */
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int arrived;
+    int state;                  /* 0 = waiting, 1 = go, -1 = abort */
+} StartGate;
+
+typedef struct {
+    const NsBenchCase *bc;
+    StartGate *start;
+    double *lat;                /* bc->iterations slots */
+    int n;
+    int failed;
+    int err;
+} Creator;
+
+static double elapsed_us(const struct timespec *a, const struct timespec *b) {
+    return (b->tv_sec - a->tv_sec) * 1e6 + (b->tv_nsec - a->tv_nsec) / 1e3;
+}
+
+static void *creator_main(void *arg) {
+    Creator *cr = arg;
+    const NsBenchCase *bc = cr->bc;
+    /* One stack per creator, reused: the child only calls _exit() on it */
+    char *stack = malloc(CHILD_STACK_SIZE);
+    char *top = stack ? stack + CHILD_STACK_SIZE : NULL;
+    if (!stack && bc->method == NS_BENCH_CLONE) cr->err = ENOMEM;
+
+    for (int i = 0; i < bc->warmup && !cr->err; ++i) {
+        int e = lifecycle(bc->method, bc->flags, top);
+        if (e) cr->err = e;
+    }
+    StartGate *g = cr->start;
+    pthread_mutex_lock(&g->lock);
+    g->arrived++;
+    pthread_cond_broadcast(&g->cond);
+    while (g->state == 0) pthread_cond_wait(&g->cond, &g->lock);
+    int go = g->state > 0;
+    pthread_mutex_unlock(&g->lock);
+    if (!go) {
+        free(stack);
+        cr->failed = bc->iterations;
+        return NULL;
+    }
+    for (int i = 0; i < bc->iterations; ++i) {
+        if (cr->err) {
+            cr->failed++;
+            continue;
+        }
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        int e = lifecycle(bc->method, bc->flags, top);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        if (e) {
+            cr->failed++;
+            cr->err = e;
+        } else {
+            cr->lat[cr->n++] = elapsed_us(&t0, &t1);
+        }
+    }
+    free(stack);
+    return NULL;
+}
+
+int namespace_bench_run(const NsBenchCase *bc, NsBenchResult *r) {
+    memset(r, 0, sizeof(*r));
+    r->c = *bc;
+    int threads = bc->threads > 0 ? bc->threads : 1;
+    r->c.threads = threads;
+    if (bc->iterations <= 0) return -1;
+
+    Creator *cr = calloc((size_t)threads, sizeof(*cr));
+    double *lat = malloc((size_t)threads * (size_t)bc->iterations * sizeof(double));
+    pthread_t *tid = calloc((size_t)threads, sizeof(*tid));
+    StartGate start = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0 };
+    if (!cr || !lat || !tid) {
+        free(cr);
+        free(lat);
+        free(tid);
+        r->err = ENOMEM;
+        return -1;
+    }
+
+    int started = 0;
+    for (int i = 0; i < threads; ++i) {
+        cr[i].bc = bc;
+        cr[i].start = &start;
+        cr[i].lat = lat + (size_t)i * (size_t)bc->iterations;
+        if (pthread_create(&tid[i], NULL, creator_main, &cr[i]) != 0) break;
+        started++;
+    }
+    struct timespec w0, w1;
+    pthread_mutex_lock(&start.lock);
+    if (started < threads) {
+        /* Not the requested concurrency: send the started creators home */
+        start.state = -1;
+    } else {
+        while (start.arrived < threads) pthread_cond_wait(&start.cond, &start.lock);
+        start.state = 1;
+    }
+    pthread_cond_broadcast(&start.cond);
+    pthread_mutex_unlock(&start.lock);
+    clock_gettime(CLOCK_MONOTONIC, &w0);
+    for (int i = 0; i < started; ++i) pthread_join(tid[i], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &w1);
+    pthread_cond_destroy(&start.cond);
+    pthread_mutex_destroy(&start.lock);
+    if (started < threads) {
+        r->err = EAGAIN;
+        for (int i = started; i < threads; ++i) cr[i].failed = bc->iterations;
+    }
+
+    /* Gather every creator's samples into one array */
+    int n = 0;
+    for (int i = 0; i < threads; ++i) {
+        memmove(lat + n, cr[i].lat, (size_t)cr[i].n * sizeof(double));
+        n += cr[i].n;
+        r->failed += cr[i].failed;
+        if (cr[i].err && !r->err) r->err = cr[i].err;
+    }
+    r->samples = n;
+    if (n > 0) {
+        sort_doubles(lat, n);
+        double sum = 0.0;
+        for (int i = 0; i < n; ++i) sum += lat[i];
+        r->min_us = lat[0];
+        r->mean_us = sum / n;
+        r->p50_us = percentile_sorted(lat, n, 50.0);
+        r->p99_us = percentile_sorted(lat, n, 99.0);
+        r->max_us = lat[n - 1];
+        double wall = elapsed_us(&w0, &w1) / 1e6;
+        r->ops_per_sec = wall > 0.0 ? n / wall : 0.0;
+    }
+    free(cr);
+    free(lat);
+    free(tid);
+    return n > 0 ? 0 : -1;
+}
+
+static const char *kernel_release(void) {
+    static struct utsname u;
+    if (!u.release[0] && uname(&u) != 0) return "unknown";
+    return u.release;
+}
+
+void namespace_bench_write_csv(FILE *out, const NsBenchResult *r, int n) {
+    fprintf(out, "kernel,case,flags,method,threads,samples,failed,min_us,mean_us,p50_us,p99_us,max_us,"
+                 "ops_per_sec,error\n");
+    for (int i = 0; i < n; ++i) {
+        fprintf(out, "%s,%s,0x%x,%s,%d,%d,%d,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%s\n", kernel_release(),
+                r[i].c.label, (unsigned)r[i].c.flags, namespace_bench_method_name(r[i].c.method),
+                r[i].c.threads, r[i].samples, r[i].failed, r[i].min_us, r[i].mean_us, r[i].p50_us,
+                r[i].p99_us, r[i].max_us, r[i].ops_per_sec, r[i].err ? strerror(r[i].err) : "");
+    }
+}
+
+void namespace_bench_write_json(FILE *out, const NsBenchResult *r, int n) {
+    fprintf(out, "{\n  \"kernel\": \"%s\",\n  \"results\": [\n", kernel_release());
+    for (int i = 0; i < n; ++i) {
+        fprintf(out, "    {\"case\": \"%s\", \"flags\": %d, \"method\": \"%s\", \"threads\": %d, "
+                     "\"samples\": %d, \"failed\": %d, \"min_us\": %.1f, \"mean_us\": %.1f, "
+                     "\"p50_us\": %.1f, \"p99_us\": %.1f, \"max_us\": %.1f, \"ops_per_sec\": %.1f, "
+                     "\"error\": \"%s\"}%s\n",
+                r[i].c.label, r[i].c.flags, namespace_bench_method_name(r[i].c.method), r[i].c.threads,
+                r[i].samples, r[i].failed, r[i].min_us, r[i].mean_us, r[i].p50_us, r[i].p99_us,
+                r[i].max_us, r[i].ops_per_sec, r[i].err ? strerror(r[i].err) : "",
+                i + 1 < n ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+int namespace_bench(const char *specs, int max_threads, int iterations, int warmup, int json,
+                    const char *output_file) {
+    if (!specs) specs = "none,mnt,pid,net,ipc,uts,user,cgroup,container";
+    if (max_threads <= 0) max_threads = 1;
+    if (iterations <= 0) iterations = 100;
+    if (warmup < 0) warmup = 0;
+
+    int levels[32], nlevels = 0;
+    for (int t = 1; t < max_threads && nlevels < 31; t *= 2) levels[nlevels++] = t;
+    levels[nlevels++] = max_threads;
+
+    char list[512];
+    snprintf(list, sizeof(list), "%s", specs);
+    int cap = 0;
+    for (const char *p = list; *p; ++p) cap += (*p == ',');
+    cap = (cap + 1) * NS_BENCH_METHOD_COUNT * nlevels;
+    NsBenchResult *res = calloc((size_t)cap, sizeof(*res));
+    if (!res) return -1;
+
+    int n = 0;
+    char *save = NULL;
+    for (char *spec = strtok_r(list, ",", &save); spec; spec = strtok_r(NULL, ",", &save)) {
+        NsBenchCase bc;
+        memset(&bc, 0, sizeof(bc));
+        if (namespace_bench_parse_flags(spec, &bc.flags) != 0) {
+            fprintf(stderr, "Unknown namespace set: %s\n", spec);
+            free(res);
+            return -1;
+        }
+        snprintf(bc.label, sizeof(bc.label), "%s", spec);
+        bc.iterations = iterations;
+        bc.warmup = warmup;
+        for (int m = 0; m < NS_BENCH_METHOD_COUNT; ++m) {
+            bc.method = (NsBenchMethod)m;
+            for (int l = 0; l < nlevels; ++l) {
+                bc.threads = levels[l];
+                namespace_bench_run(&bc, &res[n]);
+                fprintf(stderr, "  %-24s %-7s x%-3d p50 %8.1f us  p99 %8.1f us%s%s\n", bc.label,
+                        method_names[m], bc.threads, res[n].p50_us, res[n].p99_us,
+                        res[n].err ? "  " : "", res[n].err ? strerror(res[n].err) : "");
+                n++;
+            }
+        }
+    }
+
+    FILE *out = stdout;
+    if (output_file) {
+        out = fopen(output_file, "w");
+        if (!out) {
+            free(res);
+            return -1;
+        }
+    }
+    if (json) namespace_bench_write_json(out, res, n);
+    else namespace_bench_write_csv(out, res, n);
+    if (output_file) fclose(out);
+    free(res);
+    return 0;
+}
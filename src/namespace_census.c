@@ -0,0 +1,265 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../include/namespace_census.h"
+#include "../include/sysroot.h"
+#include "../include/utils.h"
+
+static const char *const type_names[NS_TYPE_COUNT] = {
+    "mnt", "pid", "net", "ipc", "uts", "user", "cgroup"
+};
+
+const char *namespace_type_name(NsType type) {
+    return (type >= 0 && type < NS_TYPE_COUNT) ? type_names[type] : "?";
+}
+
+int namespace_type_from_name(const char *name) {
+    if (strcmp(name, "mount") == 0) return NS_MNT;
+    for (int t = 0; t < NS_TYPE_COUNT; ++t) {
+        if (strcmp(name, type_names[t]) == 0) return t;
+    }
+    return -1;
+}
+
+static unsigned int hash_key(dev_t dev, ino_t ino) {
+    uint64_t h = ((uint64_t)ino ^ ((uint64_t)dev << 40)) * 0x9E3779B97F4A7C15ULL;
+    return (unsigned int)(h >> 32);
+}
+
+int namespace_census_find(const NsCensus *c, dev_t dev, ino_t ino) {
+    if (!c->nslots) return -1;
+    unsigned int mask = c->nslots - 1;
+    for (unsigned int i = hash_key(dev, ino) & mask;; i = (i + 1) & mask) {
+        int k = c->slots[i];
+        if (k < 0) return -1;
+        if (c->ns[k].ino == ino && c->ns[k].dev == dev) return k;
+    }
+}
+
+static int rehash(NsCensus *c, unsigned int nslots) {
+    int *slots = malloc(nslots * sizeof(int));
+    if (!slots) return -1;
+    memset(slots, 0xff, nslots * sizeof(int));
+    unsigned int mask = nslots - 1;
+    for (int k = 0; k < c->count; ++k) {
+        unsigned int i = hash_key(c->ns[k].dev, c->ns[k].ino) & mask;
+        while (slots[i] >= 0) i = (i + 1) & mask;
+        slots[i] = k;
+    }
+    free(c->slots);
+    c->slots = slots;
+    c->nslots = nslots;
+    return 0;
+}
+
+static int intern(NsCensus *c, dev_t dev, ino_t ino, NsType type) {
+    int k = namespace_census_find(c, dev, ino);
+    if (k >= 0) return k;
+    /* Keep the load factor under 1/2 so probe chains stay short */
+    if ((unsigned int)(c->count + 1) * 2 > c->nslots && rehash(c, c->nslots ? c->nslots * 2 : 256) != 0) return -1;
+    if (c->count == c->capacity) {
+        int cap = c->capacity ? c->capacity * 2 : 128;
+        NsEntry *ns = realloc(c->ns, (size_t)cap * sizeof(*ns));
+        if (!ns) return -1;
+        c->ns = ns;
+        c->capacity = cap;
+    }
+    k = c->count++;
+    c->ns[k].dev = dev;
+    c->ns[k].ino = ino;
+    c->ns[k].type = type;
+    c->ns[k].nmembers = 0;
+    c->ns[k].first = 0;
+    c->per_type[type]++;
+    unsigned int mask = c->nslots - 1;
+    unsigned int i = hash_key(dev, ino) & mask;
+    while (c->slots[i] >= 0) i = (i + 1) & mask;
+    c->slots[i] = k;
+    return k;
+}
+
+/* The link text "net:[4026531840]" carries the nsfs inode number. Reading it
+ * costs about half of an fstatat() through the magic link, which has to look up
+ * the namespace dentry; st_dev is the same for every namespace and is taken from
+ * the first fstatat(). Entries that are not such links are stat'ed. */
+static ssize_t read_ns_link(int nsfd, const char *name, ino_t *ino) {
+    char buf[64];
+    ssize_t n = readlinkat(nsfd, name, buf, sizeof(buf) - 1);
+    if (n <= 0) return n;
+    buf[n] = '\0';
+    const char *br = strchr(buf, '[');
+    char *end;
+    unsigned long long v = br ? strtoull(br + 1, &end, 10) : 0;
+    *ino = (br && *end == ']') ? (ino_t)v : 0;
+    return n;
+}
+
+static int ns_key(NsCensus *c, int nsfd, const char *name, dev_t *dev, ino_t *ino) {
+    ssize_t n = read_ns_link(nsfd, name, ino);
+    if (n > 0 && *ino && c->have_nsfs_dev) {
+        *dev = c->nsfs_dev;
+        return 0;
+    }
+    if (n < 0 && errno != EINVAL) return -1;
+    struct stat st;
+    if (fstatat(nsfd, name, &st, 0) != 0) return -1;
+    if (n > 0 && !c->have_nsfs_dev) {
+        c->nsfs_dev = st.st_dev;
+        c->have_nsfs_dev = 1;
+    }
+    *dev = st.st_dev;
+    *ino = st.st_ino;
+    return 0;
+}
+
+/* One task: key its seven ns/ entries relative to the open ns/ directory */
+static int visit(NsCensus *c, pid_t id, int nsfd) {
+    if (c->ntasks == c->tasks_cap) {
+        int cap = c->tasks_cap ? c->tasks_cap * 2 : 1024;
+        NsTask *t = realloc(c->tasks, (size_t)cap * sizeof(*t));
+        if (!t) return -1;
+        c->tasks = t;
+        c->tasks_cap = cap;
+    }
+    NsTask *task = &c->tasks[c->ntasks];
+    task->id = id;
+    int seen = 0;
+    for (int t = 0; t < NS_TYPE_COUNT; ++t) {
+        dev_t dev;
+        ino_t ino;
+        task->ns[t] = -1;
+        if (ns_key(c, nsfd, type_names[t], &dev, &ino) != 0) continue;
+        int k = intern(c, dev, ino, (NsType)t);
+        if (k < 0) return -1;
+        task->ns[t] = k;
+        c->ns[k].nmembers++;
+        c->tasks_per_type[t]++;
+        seen = 1;
+    }
+    /* A task that exited between readdir and fstatat leaves nothing behind */
+    if (seen) c->ntasks++;
+    return 0;
+}
+
+int namespace_read_inodes(int procfd, pid_t pid, ino_t ino[NS_TYPE_COUNT]) {
+    char path[64];
+    snprintf(path, sizeof(path), "%d/ns", (int)pid);
+    int nsfd = openat(procfd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (nsfd < 0) return -1;
+    int n = 0;
+    for (int t = 0; t < NS_TYPE_COUNT; ++t) {
+        ino[t] = 0;
+        ssize_t r = read_ns_link(nsfd, type_names[t], &ino[t]);
+        struct stat st;
+        if (r < 0 && errno == EINVAL && fstatat(nsfd, type_names[t], &st, 0) == 0) ino[t] = st.st_ino;
+        if (ino[t]) n++;
+    }
+    close(nsfd);
+    return n;
+}
+
+static int visit_threads(NsCensus *c, int procfd, pid_t pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "%d/task", (int)pid);
+    int taskfd = openat(procfd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (taskfd < 0) return 0;
+    DIR *d = fdopendir(taskfd);
+    if (!d) {
+        close(taskfd);
+        return 0;
+    }
+    int rc = 0;
+    struct dirent *de;
+    while (rc == 0 && (de = readdir(d)) != NULL) {
+        pid_t tid = parse_pid_name(de->d_name);
+        if (!tid) continue;
+        snprintf(path, sizeof(path), "%d/ns", (int)tid);
+        int nsfd = openat(taskfd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (nsfd < 0) continue;
+        rc = visit(c, tid, nsfd);
+        close(nsfd);
+    }
+    closedir(d);
+    return rc;
+}
+
+static int cmp_task(const void *a, const void *b) {
+    pid_t x = ((const NsTask *)a)->id, y = ((const NsTask *)b)->id;
+    return (x > y) - (x < y);
+}
+
+/* Lay the member lists out back to back, each in ascending task order */
+static int build_members(NsCensus *c) {
+    qsort(c->tasks, (size_t)c->ntasks, sizeof(NsTask), cmp_task);
+    size_t total = 0;
+    for (int k = 0; k < c->count; ++k) {
+        c->ns[k].first = (int)total;
+        total += (size_t)c->ns[k].nmembers;
+    }
+    c->members = malloc((total ? total : 1) * sizeof(pid_t));
+    if (!c->members) return -1;
+    int *fill = calloc((size_t)(c->count ? c->count : 1), sizeof(int));
+    if (!fill) return -1;
+    for (int i = 0; i < c->ntasks; ++i) {
+        for (int t = 0; t < NS_TYPE_COUNT; ++t) {
+            int k = c->tasks[i].ns[t];
+            if (k >= 0) c->members[c->ns[k].first + fill[k]++] = c->tasks[i].id;
+        }
+    }
+    free(fill);
+    return 0;
+}
+
+int namespace_census(NsCensus *c, const char *proc_root, int threads) {
+    memset(c, 0, sizeof(*c));
+    int procfd = open(proc_root ? proc_root : sysroot_proc(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (procfd < 0) return -1;
+    int dfd = dup(procfd);
+    DIR *d = (dfd >= 0) ? fdopendir(dfd) : NULL;
+    if (!d) {
+        if (dfd >= 0) close(dfd);
+        close(procfd);
+        return -1;
+    }
+
+    int rc = 0;
+    struct dirent *de;
+    while (rc == 0 && (de = readdir(d)) != NULL) {
+        pid_t pid = parse_pid_name(de->d_name);
+        if (!pid) continue;
+        if (threads) {
+            rc = visit_threads(c, procfd, pid);
+            continue;
+        }
+        char path[64];
+        snprintf(path, sizeof(path), "%d/ns", (int)pid);
+        int nsfd = openat(procfd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (nsfd < 0) continue;
+        rc = visit(c, pid, nsfd);
+        close(nsfd);
+    }
+    closedir(d);
+    close(procfd);
+    if (rc == 0) rc = build_members(c);
+    if (rc != 0) {
+        namespace_census_free(c);
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+void namespace_census_free(NsCensus *c) {
+    free(c->ns);
+    free(c->slots);
+    free(c->tasks);
+    free(c->members);
+    memset(c, 0, sizeof(*c));
+}
@@ -0,0 +1,275 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include "../include/namespace_containers.h"
+#include "../include/namespace_census.h"
+#include "../include/sysroot.h"
+
+#define RECHECK_FIRST 2             /* refreshes before a new task is read again */
+#define RECHECK_MAX 64              /* cap of the doubling interval */
+
+static const NsType identity_types[CONTAINER_NS_COUNT] = { NS_PID, NS_NET, NS_MNT, NS_UTS, NS_IPC };
+
+static unsigned long long fnv1a(unsigned long long h, const void *data, size_t len) {
+    const unsigned char *p = data;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+void container_format_id(unsigned long long id, char *buf, size_t len) {
+    snprintf(buf, len, "c%012llx", id >> 16);
+}
+
+/* Unified-hierarchy path from /proc/<pid>/cgroup, or the first line's on pure v1 */
+static int read_cgroup_path(int procfd, pid_t pid, char *out, size_t len) {
+    char path[64], buf[4096];
+    snprintf(path, sizeof(path), "%d/cgroup", (int)pid);
+    int fd = openat(procfd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) return -1;
+    buf[n] = '\0';
+    const char *p = NULL;
+    for (const char *line = buf; *line;) {
+        if (strncmp(line, "0::", 3) == 0) {
+            p = line + 3;
+            break;
+        }
+        const char *nl = strchr(line, '\n');
+        if (!nl) break;
+        line = nl + 1;
+    }
+    if (!p) {
+        p = strchr(buf, ':');
+        if (p) p = strchr(p + 1, ':');
+        if (!p) return -1;
+        p++;
+    }
+    size_t l = strcspn(p, "\n");
+    if (l >= len) l = len - 1;
+    memcpy(out, p, l);
+    out[l] = '\0';
+    return 0;
+}
+
+static int read_tuple(int procfd, pid_t pid, ino_t out[CONTAINER_NS_COUNT]) {
+    ino_t ino[NS_TYPE_COUNT];
+    if (namespace_read_inodes(procfd, pid, ino) <= 0) return -1;
+    for (int i = 0; i < CONTAINER_NS_COUNT; ++i) {
+        out[i] = ino[identity_types[i]];
+        if (!out[i]) return -1;     /* a partial tuple would invent a container */
+    }
+    return 0;
+}
+
+/* Namespace tuple, cgroup and identity of one task. Returns 0, -1 if it is gone
+ * or its links cannot be read (another user's task without CAP_SYS_PTRACE). */
+static int resolve(ContainerMonitor *m, pid_t pid, Container *c) {
+    memset(c, 0, sizeof(*c));
+    if (read_tuple(m->procfd, pid, c->ns) != 0) return -1;
+    if (read_cgroup_path(m->procfd, pid, c->cgroup, sizeof(c->cgroup)) != 0) return -1;
+    unsigned long long h = 0xcbf29ce484222325ULL;
+    h = fnv1a(h, c->ns, sizeof(c->ns));
+    h = fnv1a(h, c->cgroup, strlen(c->cgroup));
+    c->id = h ? h : 1;
+    c->host = memcmp(c->ns, m->host_ns, sizeof(c->ns)) == 0;
+    return 0;
+}
+
+static int find_container(const ContainerMonitor *m, unsigned long long id) {
+    if (!m->nslots) return -1;
+    unsigned int mask = m->nslots - 1;
+    for (unsigned int i = (unsigned int)(id >> 32) & mask;; i = (i + 1) & mask) {
+        int k = m->slots[i];
+        if (k < 0) return -1;
+        if (m->ctr[k].id == id) return k;
+    }
+}
+
+static int rebuild_index(ContainerMonitor *m, unsigned int nslots) {
+    int *slots = malloc(nslots * sizeof(int));
+    if (!slots) return -1;
+    memset(slots, 0xff, nslots * sizeof(int));
+    unsigned int mask = nslots - 1;
+    for (int k = 0; k < m->count; ++k) {
+        unsigned int i = (unsigned int)(m->ctr[k].id >> 32) & mask;
+        while (slots[i] >= 0) i = (i + 1) & mask;
+        slots[i] = k;
+    }
+    free(m->slots);
+    m->slots = slots;
+    m->nslots = nslots;
+    return 0;
+}
+
+static int add_container(ContainerMonitor *m, const Container *c) {
+    if ((unsigned int)(m->count + 1) * 2 > m->nslots && rebuild_index(m, m->nslots ? m->nslots * 2 : 64) != 0) return -1;
+    if (m->count == m->capacity) {
+        int cap = m->capacity ? m->capacity * 2 : 32;
+        Container *v = realloc(m->ctr, (size_t)cap * sizeof(*v));
+        if (!v) return -1;
+        m->ctr = v;
+        m->capacity = cap;
+    }
+    int k = m->count++;
+    m->ctr[k] = *c;
+    unsigned int mask = m->nslots - 1;
+    unsigned int i = (unsigned int)(c->id >> 32) & mask;
+    while (m->slots[i] >= 0) i = (i + 1) & mask;
+    m->slots[i] = k;
+    return k;
+}
+
+int container_monitor_init(ContainerMonitor *m) {
+    memset(m, 0, sizeof(*m));
+    m->procfd = open(sysroot_proc(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (m->procfd < 0) return -1;
+    if (process_tree_init(&m->tree) != 0) {
+        close(m->procfd);
+        return -1;
+    }
+    /* The host is whatever PID 1 lives in (our own namespaces if that is hidden) */
+    if (read_tuple(m->procfd, 1, m->host_ns) != 0) read_tuple(m->procfd, getpid(), m->host_ns);
+    m->page_size = sysconf(_SC_PAGESIZE);
+    return 0;
+}
+
+void container_monitor_free(ContainerMonitor *m) {
+    process_tree_free(&m->tree);
+    if (m->procfd >= 0) close(m->procfd);
+    free(m->tasks);
+    free(m->ctr);
+    free(m->slots);
+    memset(m, 0, sizeof(*m));
+    m->procfd = -1;
+}
+
+static int ensure_tasks(ContainerMonitor *m) {
+    int cap = m->tree.capacity;
+    if (cap <= m->tasks_cap) return 0;
+    ContainerTask *t = realloc(m->tasks, (size_t)cap * sizeof(*t));
+    if (!t) return -1;
+    memset(t + m->tasks_cap, 0, (size_t)(cap - m->tasks_cap) * sizeof(*t));
+    m->tasks = t;
+    m->tasks_cap = cap;
+    return 0;
+}
+
+int container_monitor_refresh(ContainerMonitor *m) {
+    if (process_tree_refresh(&m->tree) < 0 || ensure_tasks(m) != 0) return -1;
+    for (int k = 0; k < m->count; ++k) {
+        memset(&m->ctr[k].totals, 0, sizeof(m->ctr[k].totals));
+        m->ctr[k].init_pid = 0;
+    }
+    m->resolved = 0;
+    m->ticks++;
+
+    for (int i = 0; i < m->tree.capacity; ++i) {
+        const ProcessTreeNode *n = &m->tree.nodes[i];
+        ContainerTask *t = &m->tasks[i];
+        if (n->pid <= 0) {
+            t->id = 0;
+            continue;
+        }
+        int same = t->pid == n->pid && t->start_time == n->start_time;
+        if (!same) {
+            t->pid = n->pid;
+            t->start_time = n->start_time;
+            t->id = 0;
+            t->backoff = 0;
+        }
+        int k = -1;
+        if (same && (int)(m->ticks - t->recheck_at) < 0) {
+            if (!t->id) continue;                       /* unresolved, backing off */
+            k = find_container(m, t->id);
+        }
+        if (k < 0) {
+            Container c;
+            unsigned long long old = t->id;
+            int ok = resolve(m, n->pid, &c) == 0;
+            m->resolved++;
+            t->id = ok ? c.id : 0;
+            /* Stable answers are read less and less often */
+            if (!t->backoff || t->id != old) t->backoff = RECHECK_FIRST;
+            else if (t->backoff < RECHECK_MAX) t->backoff *= 2;
+            t->recheck_at = m->ticks + t->backoff;
+            if (!ok) continue;                          /* exited, or not ours to inspect */
+            k = find_container(m, c.id);
+            if (k < 0 && (k = add_container(m, &c)) < 0) return -1;
+        }
+        Container *c = &m->ctr[k];
+        process_tree_totals_add(&c->totals, &n->self);
+        if (c->init_pid == 0 || n->pid < c->init_pid) {
+            c->init_pid = n->pid;
+            memcpy(c->name, n->name, sizeof(c->name));
+        }
+    }
+
+    /* Drop containers whose last process exited */
+    int live = 0;
+    for (int k = 0; k < m->count; ++k) {
+        if (m->ctr[k].totals.procs == 0) continue;
+        if (live != k) m->ctr[live] = m->ctr[k];
+        live++;
+    }
+    if (live != m->count) {
+        m->count = live;
+        if (rebuild_index(m, m->nslots) != 0) return -1;
+    }
+    return m->count;
+}
+
+int container_monitor_series(int interval_ms, int samples, int include_host, const char *output_file) {
+    if (interval_ms <= 0) interval_ms = 1000;
+    if (samples <= 0) samples = 1;
+    ContainerMonitor m;
+    if (container_monitor_init(&m) != 0) {
+        perror("container monitor");
+        return -1;
+    }
+    FILE *out = stdout;
+    if (output_file) {
+        out = fopen(output_file, "w");
+        if (!out) {
+            container_monitor_free(&m);
+            return -1;
+        }
+    }
+
+    /* The first refresh only gives the rates a baseline */
+    int rc = container_monitor_refresh(&m) < 0 ? -1 : 0;
+    fprintf(out, "timestamp_ms,container,host,init_pid,name,cgroup,procs,threads,cpu_percent,"
+                 "rss_kb,io_read_bps,io_write_bps\n");
+    for (int s = 0; rc == 0 && s < samples; ++s) {
+        usleep((useconds_t)interval_ms * 1000);
+        if (container_monitor_refresh(&m) < 0) {
+            rc = -1;
+            break;
+        }
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        long long ms = (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+        for (int k = 0; k < m.count; ++k) {
+            const Container *c = &m.ctr[k];
+            if (c->host && !include_host) continue;
+            char id[24];
+            container_format_id(c->id, id, sizeof(id));
+            fprintf(out, "%lld,%s,%d,%d,%s,%s,%d,%ld,%.2f,%llu,%.0f,%.0f\n", ms, id, c->host,
+                    (int)c->init_pid, c->name, c->cgroup, c->totals.procs, c->totals.threads,
+                    c->totals.cpu_percent, c->totals.rss * (unsigned long long)m.page_size / 1024,
+                    c->totals.io_read_bps, c->totals.io_write_bps);
+        }
+        fflush(out);
+    }
+    if (output_file) fclose(out);
+    container_monitor_free(&m);
+    return rc;
+}
@@ -0,0 +1,284 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include "../include/namespace_matrix.h"
+#include "../include/sysroot.h"
+#include "../include/utils.h"
+
+static int cmp_pid(const void *a, const void *b) {
+    pid_t x = *(const pid_t *)a, y = *(const pid_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Sort and drop duplicates; returns the new count */
+static int sort_unique(pid_t *p, int n) {
+    if (n == 0) return 0;
+    qsort(p, (size_t)n, sizeof(pid_t), cmp_pid);
+    int k = 1;
+    for (int i = 1; i < n; ++i) {
+        if (p[i] != p[k - 1]) p[k++] = p[i];
+    }
+    return k;
+}
+
+static int push_pid(pid_t **p, int *n, int *cap, pid_t pid) {
+    if (*n == *cap) {
+        int nc = *cap ? *cap * 2 : 256;
+        pid_t *np = realloc(*p, (size_t)nc * sizeof(pid_t));
+        if (!np) return -1;
+        *p = np;
+        *cap = nc;
+    }
+    (*p)[(*n)++] = pid;
+    return 0;
+}
+
+static int comm_matches(int procfd, pid_t pid, const char *comm) {
+    char path[64], buf[64];
+    snprintf(path, sizeof(path), "%d/comm", (int)pid);
+    int fd = openat(procfd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+    ssize_t r = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (r <= 0) return 0;
+    buf[r] = '\0';
+    buf[strcspn(buf, "\n")] = '\0';
+    return strcmp(buf, comm) == 0;
+}
+
+int namespace_select_pids(const char *proc_root, const char *selector, pid_t **pids) {
+    *pids = NULL;
+    int n = 0, cap = 0;
+    const char *comm = NULL;
+    if (strncmp(selector, "comm=", 5) == 0) {
+        comm = selector + 5;
+        if (!*comm) return -1;
+    } else if (strcmp(selector, "all") != 0) {
+        /* Explicit list */
+        const char *p = selector;
+        while (*p) {
+            char *end;
+            long v = strtol(p, &end, 10);
+            if (end == p || v <= 0 || (*end != ',' && *end != '\0')) {
+                free(*pids);
+                *pids = NULL;
+                return -1;
+            }
+            if (push_pid(pids, &n, &cap, (pid_t)v) != 0) {
+                free(*pids);
+                *pids = NULL;
+                return -1;
+            }
+            p = (*end == ',') ? end + 1 : end;
+        }
+        return sort_unique(*pids, n);
+    }
+
+    int procfd = open(proc_root ? proc_root : sysroot_proc(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (procfd < 0) return -1;
+    int dfd = dup(procfd);
+    DIR *d = (dfd >= 0) ? fdopendir(dfd) : NULL;
+    if (!d) {
+        if (dfd >= 0) close(dfd);
+        close(procfd);
+        return -1;
+    }
+    int rc = 0;
+    struct dirent *de;
+    while (rc == 0 && (de = readdir(d)) != NULL) {
+        pid_t pid = parse_pid_name(de->d_name);
+        if (!pid || (comm && !comm_matches(procfd, pid, comm))) continue;
+        rc = push_pid(pids, &n, &cap, pid);
+    }
+    closedir(d);
+    close(procfd);
+    if (rc != 0) {
+        free(*pids);
+        *pids = NULL;
+        return -1;
+    }
+    return sort_unique(*pids, n);
+}
+
+typedef struct {
+    ino_t ino;
+    int col;
+} InoCol;
+
+static int cmp_inocol(const void *a, const void *b) {
+    const InoCol *x = a, *y = b;
+    if (x->ino != y->ino) return (x->ino > y->ino) - (x->ino < y->ino);
+    return x->col - y->col;
+}
+
+int namespace_matrix_build(NsMatrix *m, const char *proc_root, const pid_t *pids, int n) {
+    memset(m, 0, sizeof(*m));
+    int procfd = open(proc_root ? proc_root : sysroot_proc(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (procfd < 0) return -1;
+    size_t cols = n > 0 ? (size_t)n : 1;
+    m->pids = malloc(cols * sizeof(pid_t));
+    ino_t *ino = malloc(cols * NS_TYPE_COUNT * sizeof(ino_t));
+    InoCol *run = malloc(cols * sizeof(InoCol));
+    if (!m->pids || !ino || !run) goto fail;
+    if (n > 0) memcpy(m->pids, pids, (size_t)n * sizeof(pid_t));
+    n = sort_unique(m->pids, n);
+
+    /* One read of each PID's ns/ entries */
+    for (int i = 0; i < n; ++i) {
+        if (namespace_read_inodes(procfd, m->pids[i], &ino[(size_t)m->npids * NS_TYPE_COUNT]) < 0) continue;
+        m->pids[m->npids++] = m->pids[i];
+    }
+    close(procfd);
+    procfd = -1;
+
+    m->words = (m->npids + 63) / 64;
+    m->group_of = malloc((size_t)(m->npids ? m->npids : 1) * NS_TYPE_COUNT * sizeof(int));
+    if (!m->group_of) goto fail;
+    int cap = 0;
+    for (int t = 0; t < NS_TYPE_COUNT; ++t) {
+        m->first[t] = m->ngroups;
+        int k = 0;
+        for (int i = 0; i < m->npids; ++i) {
+            m->group_of[t * m->npids + i] = -1;
+            ino_t v = ino[(size_t)i * NS_TYPE_COUNT + t];
+            if (v) run[k++] = (InoCol){ v, i };
+        }
+        qsort(run, (size_t)k, sizeof(InoCol), cmp_inocol);
+        for (int j = 0; j < k; ++j) {
+            if (j == 0 || run[j].ino != run[j - 1].ino) {
+                if (m->ngroups == cap) {
+                    cap = cap ? cap * 2 : 64;
+                    NsMatrixGroup *g = realloc(m->groups, (size_t)cap * sizeof(*g));
+                    if (!g) goto fail;
+                    m->groups = g;
+                }
+                m->groups[m->ngroups++] = (NsMatrixGroup){ (NsType)t, run[j].ino, 0, NULL };
+            }
+            m->groups[m->ngroups - 1].nmembers++;
+            m->group_of[t * m->npids + run[j].col] = m->ngroups - 1;
+        }
+    }
+    m->first[NS_TYPE_COUNT] = m->ngroups;
+
+    m->bitsets = calloc((size_t)(m->ngroups ? m->ngroups : 1) * (size_t)(m->words ? m->words : 1),
+                        sizeof(uint64_t));
+    if (!m->bitsets) goto fail;
+    for (int g = 0; g < m->ngroups; ++g) m->groups[g].bits = m->bitsets + (size_t)g * (size_t)m->words;
+    for (int t = 0; t < NS_TYPE_COUNT; ++t) {
+        for (int i = 0; i < m->npids; ++i) {
+            int g = m->group_of[t * m->npids + i];
+            if (g >= 0) m->groups[g].bits[i / 64] |= (uint64_t)1 << (i % 64);
+        }
+    }
+    free(ino);
+    free(run);
+    return 0;
+
+fail:
+    if (procfd >= 0) close(procfd);
+    free(ino);
+    free(run);
+    namespace_matrix_free(m);
+    return -1;
+}
+
+void namespace_matrix_free(NsMatrix *m) {
+    free(m->pids);
+    free(m->groups);
+    free(m->group_of);
+    free(m->bitsets);
+    memset(m, 0, sizeof(*m));
+}
+
+int namespace_matrix_shared(const NsMatrix *m, NsType type, int i, int j) {
+    if (type < 0 || type >= NS_TYPE_COUNT || i < 0 || j < 0 || i >= m->npids || j >= m->npids) return 0;
+    int g = m->group_of[type * m->npids + i];
+    return g >= 0 && g == m->group_of[type * m->npids + j];
+}
+
+static void write_bits(FILE *out, const NsMatrixGroup *g, int words) {
+    for (int w = 0; w < words; ++w) fprintf(out, "%016llx", (unsigned long long)g->bits[w]);
+}
+
+/* Member PIDs of a group, walking its bitset */
+static void write_members(FILE *out, const NsMatrix *m, const NsMatrixGroup *g, const char *sep) {
+    int first = 1;
+    for (int w = 0; w < m->words; ++w) {
+        for (uint64_t b = g->bits[w]; b; b &= b - 1) {
+            int i = w * 64 + __builtin_ctzll(b);
+            fprintf(out, "%s%d", first ? "" : sep, (int)m->pids[i]);
+            first = 0;
+        }
+    }
+}
+
+void namespace_matrix_write_csv(FILE *out, const NsMatrix *m, int shared_only) {
+    fprintf(out, "type,ns,members,bitset,pids\n");
+    for (int g = 0; g < m->ngroups; ++g) {
+        const NsMatrixGroup *grp = &m->groups[g];
+        if (shared_only && grp->nmembers < 2) continue;
+        fprintf(out, "%s,%llu,%d,", namespace_type_name(grp->type), (unsigned long long)grp->ino,
+                grp->nmembers);
+        write_bits(out, grp, m->words);
+        fputc(',', out);
+        write_members(out, m, grp, " ");
+        fputc('\n', out);
+    }
+}
+
+void namespace_matrix_write_json(FILE *out, const NsMatrix *m, int shared_only) {
+    fprintf(out, "{\n  \"pids\": [");
+    for (int i = 0; i < m->npids; ++i) fprintf(out, "%s%d", i ? ", " : "", (int)m->pids[i]);
+    fprintf(out, "],\n  \"types\": {\n");
+    for (int t = 0; t < NS_TYPE_COUNT; ++t) {
+        fprintf(out, "    \"%s\": [", namespace_type_name((NsType)t));
+        int first = 1;
+        for (int g = m->first[t]; g < m->first[t + 1]; ++g) {
+            const NsMatrixGroup *grp = &m->groups[g];
+            if (shared_only && grp->nmembers < 2) continue;
+            fprintf(out, "%s\n      {\"ns\": %llu, \"members\": %d, \"bitset\": \"", first ? "" : ",",
+                    (unsigned long long)grp->ino, grp->nmembers);
+            write_bits(out, grp, m->words);
+            fprintf(out, "\", \"pids\": [");
+            write_members(out, m, grp, ", ");
+            fprintf(out, "]}");
+            first = 0;
+        }
+        fprintf(out, "%s]%s\n", first ? "" : "\n    ", t + 1 < NS_TYPE_COUNT ? "," : "");
+    }
+    fprintf(out, "  }\n}\n");
+}
+
+int namespace_compare_many(const char *selector, int json, int shared_only, const char *output_file) {
+    pid_t *pids = NULL;
+    int n = namespace_select_pids(NULL, selector, &pids);
+    if (n < 0) {
+        fprintf(stderr, "Bad PID selector: %s (all | pid,pid,... | comm=name)\n", selector);
+        return -1;
+    }
+    NsMatrix m;
+    int rc = namespace_matrix_build(&m, NULL, pids, n);
+    free(pids);
+    if (rc != 0) {
+        perror("namespace matrix");
+        return -1;
+    }
+    FILE *out = stdout;
+    if (output_file) {
+        out = fopen(output_file, "w");
+        if (!out) {
+            namespace_matrix_free(&m);
+            return -1;
+        }
+    }
+    if (json) namespace_matrix_write_json(out, &m, shared_only);
+    else namespace_matrix_write_csv(out, &m, shared_only);
+    if (output_file) fclose(out);
+    namespace_matrix_free(&m);
+    return 0;
+}
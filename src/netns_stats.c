@@ -0,0 +1,325 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include "../include/netns_stats.h"
+#include "../include/namespace_census.h"
+#include "../include/sysroot.h"
+
+#define NL_BUFSIZE 32768
+#define NETNS_RESCAN_MS 5000        /* census cadence of netns_monitor */
+
+static int open_rtnl(void) {
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) return -1;
+    struct sockaddr_nl sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.nl_family = AF_NETLINK;
+    if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int netns_collector_init(NetnsCollector *c) {
+    memset(c, 0, sizeof(*c));
+    struct stat st;
+    if (stat("/proc/self/ns/net", &st) != 0) return -1;
+    c->self_ino = st.st_ino;
+    return 0;
+}
+
+static void close_entry(NetnsEntry *e) {
+    if (e->sock >= 0) close(e->sock);
+    free(e->links);
+    free(e->prev);
+}
+
+void netns_collector_free(NetnsCollector *c) {
+    for (int i = 0; i < c->count; ++i) close_entry(&c->ns[i]);
+    free(c->ns);
+    memset(c, 0, sizeof(*c));
+}
+
+/* Work list for the helper thread: namespaces that still need a socket */
+typedef struct {
+    NetnsEntry **todo;
+    int n;
+} EnterJob;
+
+/* setns() only moves the calling thread, so the thread that hops between
+ * namespaces is a throwaway one and the caller's namespace is never touched.
+ * A socket keeps the namespace it was created in. */
+static void *enter_worker(void *arg) {
+    EnterJob *job = arg;
+    for (int i = 0; i < job->n; ++i) {
+        NetnsEntry *e = job->todo[i];
+        char path[64], real[512];
+        snprintf(path, sizeof(path), "/proc/%d/ns/net", (int)e->pid);
+        int nsfd = sysroot_path(real, sizeof(real), path) == 0 ? open(real, O_RDONLY | O_CLOEXEC) : -1;
+        if (nsfd < 0) continue;             /* member exited; next rescan finds another */
+        /* The PID may have been reused since the census */
+        struct stat st;
+        if (fstat(nsfd, &st) != 0 || st.st_ino != e->ino) {
+            close(nsfd);
+            continue;
+        }
+        if (setns(nsfd, CLONE_NEWNET) != 0) {
+            if (errno == EPERM) e->denied = 1;
+            close(nsfd);
+            continue;
+        }
+        close(nsfd);
+        e->sock = open_rtnl();
+    }
+    return NULL;
+}
+
+static NetnsEntry *find_entry(NetnsCollector *c, ino_t ino) {
+    for (int i = 0; i < c->count; ++i) {
+        if (c->ns[i].ino == ino) return &c->ns[i];
+    }
+    return NULL;
+}
+
+int netns_collector_rescan(NetnsCollector *c) {
+    NsCensus census;
+    if (namespace_census(&census, NULL, 0) != 0) return -1;
+    c->generation++;
+
+    for (int k = 0; k < census.count; ++k) {
+        const NsEntry *ns = &census.ns[k];
+        if (ns->type != NS_NET || ns->nmembers == 0) continue;
+        NetnsEntry *e = find_entry(c, ns->ino);
+        if (!e) {
+            if (c->count == c->capacity) {
+                int cap = c->capacity ? c->capacity * 2 : 16;
+                NetnsEntry *v = realloc(c->ns, (size_t)cap * sizeof(*v));
+                if (!v) {
+                    namespace_census_free(&census);
+                    return -1;
+                }
+                c->ns = v;
+                c->capacity = cap;
+            }
+            e = &c->ns[c->count++];
+            memset(e, 0, sizeof(*e));
+            e->ino = ns->ino;
+            e->sock = -1;
+        }
+        if (e->sock < 0) e->pid = census.members[ns->first];
+        e->seen = c->generation;
+    }
+    namespace_census_free(&census);
+
+    /* Drop namespaces nobody is in any more, so their sockets do not pin them */
+    int live = 0;
+    for (int i = 0; i < c->count; ++i) {
+        if (c->ns[i].seen != c->generation) {
+            close_entry(&c->ns[i]);
+            continue;
+        }
+        if (live != i) c->ns[live] = c->ns[i];
+        live++;
+    }
+    c->count = live;
+
+    NetnsEntry **todo = malloc((size_t)(c->count ? c->count : 1) * sizeof(*todo));
+    if (!todo) return -1;
+    EnterJob job = { todo, 0 };
+    for (int i = 0; i < c->count; ++i) {
+        NetnsEntry *e = &c->ns[i];
+        if (e->sock >= 0 || e->denied) continue;
+        if (e->ino == c->self_ino) e->sock = open_rtnl();
+        else todo[job.n++] = e;
+    }
+    if (job.n > 0) {
+        pthread_t th;
+        if (pthread_create(&th, NULL, enter_worker, &job) == 0) pthread_join(th, NULL);
+    }
+    free(todo);
+    c->denied = 0;
+    for (int i = 0; i < c->count; ++i) c->denied += c->ns[i].denied;
+    return c->count;
+}
+
+static NetnsLink *add_link(NetnsLink **links, int *n, int *cap) {
+    if (*n == *cap) {
+        int nc = *cap ? *cap * 2 : 8;
+        NetnsLink *v = realloc(*links, (size_t)nc * sizeof(*v));
+        if (!v) return NULL;
+        *links = v;
+        *cap = nc;
+    }
+    NetnsLink *l = &(*links)[(*n)++];
+    memset(l, 0, sizeof(*l));
+    return l;
+}
+
+int netns_parse_links(const void *buf, size_t len, NetnsLink **links, int *n, int *cap) {
+    for (const struct nlmsghdr *h = buf; NLMSG_OK(h, len); h = NLMSG_NEXT(h, len)) {
+        if (h->nlmsg_type == NLMSG_DONE) return 1;
+        if (h->nlmsg_type == NLMSG_ERROR) return -1;
+        if (h->nlmsg_type != RTM_NEWLINK) continue;
+        const struct ifinfomsg *ifi = NLMSG_DATA(h);
+        NetnsLink *l = add_link(links, n, cap);
+        if (!l) return -1;
+        l->ifindex = ifi->ifi_index;
+        int have64 = 0;
+        int alen = (int)IFLA_PAYLOAD(h);
+        for (const struct rtattr *a = IFLA_RTA(ifi); RTA_OK(a, alen); a = RTA_NEXT(a, alen)) {
+            if (a->rta_type == IFLA_IFNAME) {
+                snprintf(l->name, sizeof(l->name), "%s", (const char *)RTA_DATA(a));
+            } else if (a->rta_type == IFLA_STATS64 && RTA_PAYLOAD(a) >= sizeof(l->st)) {
+                memcpy(&l->st, RTA_DATA(a), sizeof(l->st));
+                have64 = 1;
+            } else if (a->rta_type == IFLA_STATS && !have64 && RTA_PAYLOAD(a) >= sizeof(struct rtnl_link_stats)) {
+                struct rtnl_link_stats s32;
+                memcpy(&s32, RTA_DATA(a), sizeof(s32));
+                l->st.rx_packets = s32.rx_packets;
+                l->st.tx_packets = s32.tx_packets;
+                l->st.rx_bytes = s32.rx_bytes;
+                l->st.tx_bytes = s32.tx_bytes;
+                l->st.rx_errors = s32.rx_errors;
+                l->st.tx_errors = s32.tx_errors;
+                l->st.rx_dropped = s32.rx_dropped;
+                l->st.tx_dropped = s32.tx_dropped;
+            }
+        }
+    }
+    return 0;
+}
+
+static int dump_links(NetnsEntry *e, char *buf) {
+    struct {
+        struct nlmsghdr h;
+        struct ifinfomsg ifi;
+    } req;
+    memset(&req, 0, sizeof(req));
+    req.h.nlmsg_len = NLMSG_LENGTH(sizeof(req.ifi));
+    req.h.nlmsg_type = RTM_GETLINK;
+    req.h.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.h.nlmsg_seq = ++e->seq;
+    req.ifi.ifi_family = AF_UNSPEC;
+    if (send(e->sock, &req, req.h.nlmsg_len, 0) < 0) return -1;
+
+    e->nlinks = 0;
+    for (;;) {
+        ssize_t r = recv(e->sock, buf, NL_BUFSIZE, 0);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        int rc = netns_parse_links(buf, (size_t)r, &e->links, &e->nlinks, &e->cap);
+        if (rc != 0) return rc > 0 ? 0 : -1;
+        if (r == 0) return -1;
+    }
+}
+
+static const NetnsLink *find_link(const NetnsLink *v, int n, int ifindex) {
+    for (int i = 0; i < n; ++i) {
+        if (v[i].ifindex == ifindex) return &v[i];
+    }
+    return NULL;
+}
+
+int netns_collector_tick(NetnsCollector *c) {
+    char *buf = malloc(NL_BUFSIZE);
+    if (!buf) return -1;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = c->have_last ? (now.tv_sec - c->last.tv_sec) + (now.tv_nsec - c->last.tv_nsec) / 1e9 : 0.0;
+
+    int answered = 0;
+    for (int i = 0; i < c->count; ++i) {
+        NetnsEntry *e = &c->ns[i];
+        if (e->sock < 0) continue;
+        /* The previous dump becomes the baseline for this one's rates */
+        NetnsLink *tl = e->prev;
+        int tc = e->prev_cap;
+        e->prev = e->links;
+        e->nprev = e->nlinks;
+        e->prev_cap = e->cap;
+        e->links = tl;
+        e->cap = tc;
+        if (dump_links(e, buf) != 0) {
+            e->nlinks = 0;
+            continue;
+        }
+        answered++;
+        for (int k = 0; k < e->nlinks; ++k) {
+            NetnsLink *l = &e->links[k];
+            const NetnsLink *p = find_link(e->prev, e->nprev, l->ifindex);
+            if (!p || elapsed <= 0.0) continue;
+            l->rx_bps = (l->st.rx_bytes >= p->st.rx_bytes) ? (l->st.rx_bytes - p->st.rx_bytes) / elapsed : 0.0;
+            l->tx_bps = (l->st.tx_bytes >= p->st.tx_bytes) ? (l->st.tx_bytes - p->st.tx_bytes) / elapsed : 0.0;
+        }
+    }
+    free(buf);
+    c->last = now;
+    c->have_last = 1;
+    return answered;
+}
+
+int netns_monitor(int interval_ms, int samples, const char *output_file) {
+    if (interval_ms <= 0) interval_ms = 1000;
+    if (samples <= 0) samples = 1;
+    NetnsCollector c;
+    if (netns_collector_init(&c) != 0 || netns_collector_rescan(&c) < 0) {
+        perror("netns collector");
+        /* init leaves c zeroed, so this is safe after either failure */
+        netns_collector_free(&c);
+        return -1;
+    }
+    if (c.denied) fprintf(stderr, "netns: %d namespaces could not be entered (needs CAP_SYS_ADMIN)\n", c.denied);
+    FILE *out = stdout;
+    if (output_file) {
+        out = fopen(output_file, "w");
+        if (!out) {
+            netns_collector_free(&c);
+            return -1;
+        }
+    }
+
+    fprintf(out, "timestamp_ms,netns,pid,ifname,rx_bytes,tx_bytes,rx_packets,tx_packets,rx_errors,"
+                 "tx_errors,rx_dropped,tx_dropped,rx_bps,tx_bps\n");
+    netns_collector_tick(&c);
+    int rescan_every = NETNS_RESCAN_MS / interval_ms > 0 ? NETNS_RESCAN_MS / interval_ms : 1;
+    for (int s = 0; s < samples; ++s) {
+        usleep((useconds_t)interval_ms * 1000);
+        /* Pick up new namespaces and release gone ones; a full /proc walk, so
+         * not on every sample */
+        if ((s + 1) % rescan_every == 0 && netns_collector_rescan(&c) < 0) break;
+        netns_collector_tick(&c);
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        long long ms = (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+        for (int i = 0; i < c.count; ++i) {
+            const NetnsEntry *e = &c.ns[i];
+            for (int k = 0; k < e->nlinks; ++k) {
+                const NetnsLink *l = &e->links[k];
+                fprintf(out, "%lld,%lu,%d,%s,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%.0f,%.0f\n", ms,
+                        (unsigned long)e->ino, (int)e->pid, l->name,
+                        (unsigned long long)l->st.rx_bytes, (unsigned long long)l->st.tx_bytes,
+                        (unsigned long long)l->st.rx_packets, (unsigned long long)l->st.tx_packets,
+                        (unsigned long long)l->st.rx_errors, (unsigned long long)l->st.tx_errors,
+                        (unsigned long long)l->st.rx_dropped, (unsigned long long)l->st.tx_dropped,
+                        l->rx_bps, l->tx_bps);
+            }
+        }
+        fflush(out);
+    }
+    if (output_file) fclose(out);
+    netns_collector_free(&c);
+    return 0;
+}
@@ -1,14 +1,9 @@
 #include "../include/monitors.h"
 #include "../include/utils.h"
+#include "../include/sysroot.h"
 #include <unistd.h>
 
-int read_network_stats(const char *interface, NetworkStats *stats) {
-    FILE *fp = fopen("/proc/net/dev", "r");
-    if (!fp) {
-        log_error("Failed to open /proc/net/dev");
-        return -1;
-    }
-
+int parse_network_stats(FILE *fp, const char *interface, NetworkStats *stats) {
     char line[512];
     int found = 0;
 
@@ -48,10 +43,20 @@ int read_network_stats(const char *interface, NetworkStats *stats) {
         }
     }
 
-    fclose(fp);
     return found ? 0 : -1;
 }
 
+int read_network_stats(const char *interface, NetworkStats *stats) {
+    FILE *fp = sysroot_fopen("/proc/net/dev", "r");
+    if (!fp) {
+        log_error("Failed to open /proc/net/dev");
+        return -1;
+    }
+    int rc = parse_network_stats(fp, interface, stats);
+    fclose(fp);
+    return rc;
+}
+
 int monitor_network(const char *interface, int duration_seconds, const char *output_file) {
     FILE *fp = safe_fopen(output_file, "w");
     if (!fp) return -1;
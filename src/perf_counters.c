@@ -0,0 +1,228 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "../include/perf_counters.h"
+#include "../include/sysroot.h"
+
+static const char *const event_names[PERF_EVENT_COUNT] = {
+    "task_clock", "context_switches", "cpu_migrations", "page_faults",
+    "cycles", "instructions", "cache_misses", "branch_misses"
+};
+
+static const struct {
+    unsigned int type;
+    unsigned long long config;
+} event_defs[PERF_EVENT_COUNT] = {
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+};
+
+/* Events [group_start[g], group_start[g + 1]) form group g */
+static const int group_start[3] = { PERF_TASK_CLOCK, PERF_CYCLES, PERF_EVENT_COUNT };
+
+#define READ_FORMAT (PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING)
+
+const char *perf_event_name(PerfEventId e) {
+    return (e >= 0 && e < PERF_EVENT_COUNT) ? event_names[e] : "?";
+}
+
+static int open_event(PerfEventId e, pid_t tid, int group_fd, int user_only) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event_defs[e].type;
+    attr.config = event_defs[e].config;
+    attr.read_format = READ_FORMAT;
+    attr.exclude_hv = 1;
+    attr.exclude_kernel = user_only ? 1 : 0;
+    return (int)syscall(SYS_perf_event_open, &attr, tid, -1, group_fd, PERF_FLAG_FD_CLOEXEC);
+}
+
+/* Counted as the kernel switches or moves the task: zero under exclude_kernel */
+static int kernel_side(PerfEventId e) {
+    return e == PERF_CONTEXT_SWITCHES || e == PERF_CPU_MIGRATIONS;
+}
+
+static int read_paranoid(void) {
+    FILE *f = fopen("/proc/sys/kernel/perf_event_paranoid", "r");
+    if (!f) return 2;
+    int v = 2;
+    if (fscanf(f, "%d", &v) != 1) v = 2;
+    fclose(f);
+    return v;
+}
+
+int perf_counters_init(PerfCounters *pc) {
+    memset(pc, 0, sizeof(*pc));
+    /* Above 1, unprivileged callers may only count user space */
+    pc->user_only = (geteuid() != 0 && read_paranoid() >= 2);
+    return 0;
+}
+
+static void close_thread(PerfThread *t) {
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        if (t->fd[e] >= 0) close(t->fd[e]);
+        t->fd[e] = -1;
+    }
+}
+
+void perf_counters_free(PerfCounters *pc) {
+    for (int i = 0; i < pc->count; ++i) close_thread(&pc->threads[i]);
+    free(pc->threads);
+    memset(pc, 0, sizeof(*pc));
+}
+
+int perf_counters_available(const PerfCounters *pc, PerfEventId e) {
+    return pc->probed && e >= 0 && e < PERF_EVENT_COUNT && pc->available[e];
+}
+
+int perf_parse_group(const void *buf, size_t len, double *values, int max) {
+    const uint64_t *w = buf;
+    if (len < 3 * sizeof(uint64_t)) return -1;
+    uint64_t nr = w[0], enabled = w[1], running = w[2];
+    if (nr > (uint64_t)max || len < (3 + nr) * sizeof(uint64_t)) return -1;
+    /* Multiplexed: extrapolate to the whole enabled time */
+    double scale = (running > 0 && running < enabled) ? (double)enabled / (double)running : 1.0;
+    for (uint64_t i = 0; i < nr; ++i) values[i] = (running > 0) ? (double)w[3 + i] * scale : 0.0;
+    return (int)nr;
+}
+
+/* Open both groups on one thread. The first thread also decides which events
+ * exist here: an event that fails to open then is never tried again. */
+static int attach(PerfCounters *pc, PerfThread *t) {
+    int opened = 0;
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) t->fd[e] = -1;
+    for (int g = 0; g < 2; ++g) {
+        int leader = -1;
+        for (int e = group_start[g]; e < group_start[g + 1]; ++e) {
+            if (pc->probed && !pc->available[e]) continue;
+            /* Would open fine and always read 0: report it as unavailable instead */
+            if (pc->user_only && kernel_side((PerfEventId)e)) continue;
+            int fd = open_event((PerfEventId)e, t->tid, leader, pc->user_only);
+            if (fd < 0) {
+                if (errno == ESRCH || pc->probed) {
+                    int err = errno;
+                    close_thread(t);
+                    errno = err;
+                    return -1;
+                }
+                continue;
+            }
+            if (!pc->probed) pc->available[e] = 1;
+            if (leader < 0) leader = fd;
+            t->fd[e] = fd;
+            opened++;
+        }
+    }
+    if (opened == 0) return -1;
+    pc->probed = 1;
+    return 0;
+}
+
+static int read_thread(PerfThread *t) {
+    for (int g = 0; g < 2; ++g) {
+        int leader = -1;
+        for (int e = group_start[g]; e < group_start[g + 1] && leader < 0; ++e) leader = t->fd[e];
+        if (leader < 0) continue;
+        uint64_t buf[3 + PERF_EVENT_COUNT];
+        ssize_t r = read(leader, buf, sizeof(buf));
+        double vals[PERF_EVENT_COUNT];
+        int nr = (r > 0) ? perf_parse_group(buf, (size_t)r, vals, PERF_EVENT_COUNT) : -1;
+        if (nr < 0) return -1;
+        /* Values come back in the order the members were opened */
+        int k = 0;
+        for (int e = group_start[g]; e < group_start[g + 1] && k < nr; ++e) {
+            if (t->fd[e] >= 0) t->last[e] = vals[k++];
+        }
+    }
+    return 0;
+}
+
+static int cmp_thread(const void *a, const void *b) {
+    pid_t x = ((const PerfThread *)a)->tid, y = ((const PerfThread *)b)->tid;
+    return (x > y) - (x < y);
+}
+
+static int add_thread(PerfCounters *pc, pid_t tid) {
+    if (pc->count == pc->capacity) {
+        int cap = pc->capacity ? pc->capacity * 2 : 64;
+        PerfThread *nt = realloc(pc->threads, (size_t)cap * sizeof(*nt));
+        if (!nt) return -1;
+        pc->threads = nt;
+        pc->capacity = cap;
+    }
+    PerfThread *t = &pc->threads[pc->count];
+    memset(t, 0, sizeof(*t));
+    t->tid = tid;
+    t->seen = pc->generation;
+    if (attach(pc, t) != 0) {
+        if (errno != ESRCH) pc->skipped++;
+        return 0;
+    }
+    pc->count++;
+    return 1;
+}
+
+/* Mark the threads of pid seen, attaching new ones. New entries go past the
+ * sorted prefix [0, sorted) and are merged in by the caller. */
+static int scan_threads(PerfCounters *pc, pid_t pid, int sorted) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/task", (int)pid);
+    DIR *d = sysroot_opendir(path);
+    if (!d) return 0;
+    int rc = 0;
+    struct dirent *de;
+    while (rc >= 0 && (de = readdir(d)) != NULL) {
+        if (de->d_name[0] < '1' || de->d_name[0] > '9') continue;
+        pid_t tid = (pid_t)atoi(de->d_name);
+        PerfThread key;
+        key.tid = tid;
+        PerfThread *t = bsearch(&key, pc->threads, (size_t)sorted, sizeof(PerfThread), cmp_thread);
+        if (t) t->seen = pc->generation;
+        else rc = add_thread(pc, tid);
+    }
+    closedir(d);
+    return rc < 0 ? -1 : 0;
+}
+
+int perf_counters_read(PerfCounters *pc, const pid_t *pids, int n, PerfValues *total) {
+    pc->generation++;
+    int sorted = pc->count;
+    for (int i = 0; i < n; ++i) {
+        if (scan_threads(pc, pids[i], sorted) != 0) return -1;
+    }
+    if (pc->count > sorted) qsort(pc->threads, (size_t)pc->count, sizeof(PerfThread), cmp_thread);
+    if (!pc->probed) return -1;
+
+    /* Exited threads still answer with their final counts: read, then retire */
+    memset(total, 0, sizeof(*total));
+    int k = 0;
+    for (int i = 0; i < pc->count; ++i) {
+        PerfThread *t = &pc->threads[i];
+        (void)read_thread(t);
+        if (t->seen != pc->generation) {
+            for (int e = 0; e < PERF_EVENT_COUNT; ++e) pc->retired.v[e] += t->last[e];
+            close_thread(t);
+            continue;
+        }
+        for (int e = 0; e < PERF_EVENT_COUNT; ++e) total->v[e] += t->last[e];
+        pc->threads[k++] = *t;
+    }
+    pc->count = k;
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) total->v[e] += pc->retired.v[e];
+    return k;
+}
@@ -1,24 +1,30 @@
+#define _GNU_SOURCE
 #include "../include/process_monitor.h"
 #include "../include/utils.h"
+#include "../include/sysroot.h"
 #include <unistd.h>
 #include <sys/sysinfo.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
 
 int process_exists(pid_t pid) {
     char path[256];
     snprintf(path, sizeof(path), "/proc/%d", pid);
     
+    char real[512];
     struct stat st;
-    return (stat(path, &st) == 0);
+    return (sysroot_path(real, sizeof(real), path) == 0 && stat(real, &st) == 0);
 }
 
 int get_process_name(pid_t pid, char *name, size_t size) {
     char path[256];
     snprintf(path, sizeof(path), "/proc/%d/comm", pid);
     
-    FILE *fp = fopen(path, "r");
+    FILE *fp = sysroot_fopen(path, "r");
     if (!fp) return -1;
     
     if (fgets(name, size, fp) == NULL) {
@@ -33,90 +39,152 @@ int get_process_name(pid_t pid, char *name, size_t size) {
     return 0;
 }
 
-int read_process_stats(pid_t pid, ProcessStats *stats) {
-    if (!process_exists(pid)) {
-        log_error("Process %d does not exist", pid);
-        return -1;
+int process_stats_context_init(ProcessStatsContext *ctx) {
+    struct sysinfo si;
+    ctx->total_mem_kb = 0;
+    if (sysinfo(&si) == 0) {
+        ctx->total_mem_kb = (unsigned long)(si.totalram / 1024) * si.mem_unit;
     }
+    ctx->page_size = sysconf(_SC_PAGESIZE);
+    ctx->clk_tck = sysconf(_SC_CLK_TCK);
+    return (ctx->page_size > 0 && ctx->clk_tck > 0) ? 0 : -1;
+}
 
-    char path[256];
-    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
-    
-    FILE *fp = fopen(path, "r");
-    if (!fp) {
-        log_error("Failed to open %s", path);
-        return -1;
-    }
+/* Parse one /proc/<pid>/stat line. The comm field may contain spaces and ')',
+ * so fields are located from the last ')'. */
+int parse_process_stat(const char *buf, ProcessStats *stats) {
+    const char *open_paren = strchr(buf, '(');
+    const char *close_paren = strrchr(buf, ')');
+    if (!open_paren || !close_paren || close_paren < open_paren ||
+        close_paren[1] != ' ' || close_paren[2] == '\0') return -1;
 
-    stats->pid = pid;
-    
-    int parsed = fscanf(fp, "%*d %s %c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu %*d %*d %*d %*d %ld %*d %*u %lu %lu",
-                       stats->name, &stats->state, &stats->utime, &stats->stime,
-                       &stats->num_threads, &stats->vsize, &stats->rss);
-    
-    fclose(fp);
-    
-    if (parsed < 7) {
-        log_error("Failed to parse process stats for PID %d", pid);
-        return -1;
+    size_t nlen = (size_t)(close_paren - open_paren - 1);
+    if (nlen >= sizeof(stats->name)) nlen = sizeof(stats->name) - 1;
+    memcpy(stats->name, open_paren + 1, nlen);
+    stats->name[nlen] = '\0';
+
+    const char *p = close_paren + 2;
+    stats->state = *p++;
+    /* Fields 4..24 of proc(5): ppid ... rss */
+    unsigned long long f[25] = {0};
+    for (int i = 4; i <= 24; ++i) {
+        char *end;
+        while (*p == ' ') p++;
+        if (*p == '-') p++; /* tty_nr/tpgid/priority can be negative; not used here */
+        f[i] = strtoull(p, &end, 10);
+        if (end == p) return -1;
+        p = end;
     }
+    stats->ppid = (pid_t)f[4];
+    stats->utime = (unsigned long)f[14];
+    stats->stime = (unsigned long)f[15];
+    stats->num_threads = (long)f[20];
+    stats->vsize = (unsigned long)f[23];
+    stats->rss = (unsigned long)f[24];
+    return 0;
+}
+
+int read_process_stats_batch(const ProcessStatsContext *ctx, const pid_t *pids, int count,
+                             ProcessStats *out, int *status) {
+    char path[64];
+    char buf[1024];
+    int ok = 0;
+
+    for (int i = 0; i < count; i++) {
+        ProcessStats *stats = &out[i];
+        int rc;
+        snprintf(path, sizeof(path), "/proc/%d/stat", pids[i]);
 
-    // Remove parentheses from name
-    if (stats->name[0] == '(') {
-        size_t len = strlen(stats->name);
-        if (stats->name[len-1] == ')') {
-            stats->name[len-1] = '\0';
-            memmove(stats->name, stats->name + 1, len);
+        int fd = sysroot_open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            rc = -errno;
+        } else {
+            ssize_t r = read(fd, buf, sizeof(buf) - 1);
+            /* A task that exits between open and read reads as ESRCH or empty */
+            rc = r < 0 ? -errno : (r == 0 ? -ESRCH : 0);
+            close(fd);
+            if (rc == 0) {
+                buf[r] = '\0';
+                stats->pid = pids[i];
+                if (parse_process_stat(buf, stats) != 0) rc = -EINVAL;
+            }
         }
+        if (rc == 0) {
+            unsigned long proc_mem = stats->rss * (unsigned long)ctx->page_size / 1024; // KB
+            stats->mem_percent = calculate_percentage(proc_mem, ctx->total_mem_kb);
+            ok++;
+        }
+        if (status) status[i] = rc;
     }
+    return ok;
+}
 
-    // Get memory percentage
-    struct sysinfo si;
-    if (sysinfo(&si) == 0) {
-        unsigned long total_mem = si.totalram * si.mem_unit / 1024; // KB
-        unsigned long proc_mem = stats->rss * getpagesize() / 1024; // KB
-        stats->mem_percent = calculate_percentage(proc_mem, total_mem);
-    }
+/* Page size and clock ticks never change; total memory only on hotplug */
+static ProcessStatsContext shared_ctx;
+static pthread_once_t shared_ctx_once = PTHREAD_ONCE_INIT;
+
+static void shared_ctx_init(void) {
+    process_stats_context_init(&shared_ctx);
+}
+
+int read_process_stats(pid_t pid, ProcessStats *stats) {
+    pthread_once(&shared_ctx_once, shared_ctx_init);
 
+    int status = -1;
+    read_process_stats_batch(&shared_ctx, &pid, 1, stats, &status);
+    if (status != 0) {
+        if (status == -ENOENT || status == -ESRCH) {
+            log_error("Process %d does not exist", pid);
+        } else {
+            log_error("Failed to read process stats for PID %d", pid);
+        }
+        return -1;
+    }
     return 0;
 }
 
-double calculate_process_cpu_usage(ProcessStats *prev, ProcessStats *curr, double elapsed) {
-    if (elapsed <= 0.0) return 0.0;
-    
+double calculate_process_cpu_usage_ctx(const ProcessStatsContext *ctx, const ProcessStats *prev,
+                                       const ProcessStats *curr, double elapsed) {
+    if (elapsed <= 0.0 || ctx->clk_tck <= 0) return 0.0;
+
     unsigned long total_time = (curr->utime + curr->stime) - (prev->utime + prev->stime);
-    long clk_tck = sysconf(_SC_CLK_TCK);
-    
-    if (clk_tck <= 0) return 0.0;
-    
-    double cpu_time_used = (double)total_time / clk_tck;
+    double cpu_time_used = (double)total_time / ctx->clk_tck;
     return (cpu_time_used / elapsed) * 100.0;
 }
 
+double calculate_process_cpu_usage(ProcessStats *prev, ProcessStats *curr, double elapsed) {
+    static long clk_tck = 0;
+    if (clk_tck <= 0) clk_tck = sysconf(_SC_CLK_TCK);
+
+    ProcessStatsContext ctx = {0};
+    ctx.clk_tck = clk_tck;
+    return calculate_process_cpu_usage_ctx(&ctx, prev, curr, elapsed);
+}
+
 int monitor_process(pid_t pid, int duration_seconds, const char *output_file) {
-    if (!process_exists(pid)) {
+    ProcessStatsContext ctx;
+    ProcessStats prev_stats, curr_stats;
+    struct timespec prev_time, curr_time;
+    int status;
+
+    process_stats_context_init(&ctx);
+    read_process_stats_batch(&ctx, &pid, 1, &prev_stats, &status);
+    if (status != 0) {
         log_error("Process %d does not exist", pid);
         return -1;
     }
+    clock_gettime(CLOCK_MONOTONIC, &prev_time);
 
     FILE *fp = safe_fopen(output_file, "w");
     if (!fp) return -1;
 
     fprintf(fp, "timestamp,pid,name,state,cpu_percent,mem_percent,vsize_kb,rss_kb,threads\n");
 
-    ProcessStats prev_stats, curr_stats;
-    struct timespec prev_time, curr_time;
-
-    if (read_process_stats(pid, &prev_stats) != 0) {
-        fclose(fp);
-        return -1;
-    }
-    clock_gettime(CLOCK_MONOTONIC, &prev_time);
-
     for (int i = 0; i < duration_seconds; i++) {
         sleep(1);
 
-        if (read_process_stats(pid, &curr_stats) != 0) {
+        read_process_stats_batch(&ctx, &pid, 1, &curr_stats, &status);
+        if (status != 0) {
             log_error("Process %d terminated or became inaccessible", pid);
             break;
         }
@@ -124,7 +192,7 @@ int monitor_process(pid_t pid, int duration_seconds, const char *output_file) {
         clock_gettime(CLOCK_MONOTONIC, &curr_time);
         double elapsed = get_elapsed_time(&prev_time, &curr_time);
         
-        curr_stats.cpu_percent = calculate_process_cpu_usage(&prev_stats, &curr_stats, elapsed);
+        curr_stats.cpu_percent = calculate_process_cpu_usage_ctx(&ctx, &prev_stats, &curr_stats, elapsed);
         
         char timestamp[64];
         get_timestamp(timestamp, sizeof(timestamp));
@@ -132,7 +200,7 @@ int monitor_process(pid_t pid, int duration_seconds, const char *output_file) {
         fprintf(fp, "%s,%d,%s,%c,%.2f,%.2f,%lu,%lu,%ld\n",
                 timestamp, curr_stats.pid, curr_stats.name, curr_stats.state,
                 curr_stats.cpu_percent, curr_stats.mem_percent,
-                curr_stats.vsize / 1024, curr_stats.rss * getpagesize() / 1024,
+                curr_stats.vsize / 1024, curr_stats.rss * (unsigned long)ctx.page_size / 1024,
                 curr_stats.num_threads);
         
         fflush(fp);
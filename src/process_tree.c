@@ -0,0 +1,390 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../include/process_tree.h"
+#include "../include/sysroot.h"
+
+/* Process table with parent/child links.
+ * Each refresh walks /proc once, reads /proc/<pid>/stat and /proc/<pid>/io,
+ * and only relinks PIDs that appeared, vanished or were reparented.
+ * Subtree totals are rolled up bottom-up over a parents-first ordering.
+ */
+
+static unsigned int pid_hash(pid_t pid, unsigned int mask) {
+    return ((unsigned int)pid * 2654435761u) & mask;
+}
+
+static int hash_lookup(const ProcessTree *tree, pid_t pid) {
+    unsigned int mask = tree->nslots - 1;
+    for (unsigned int i = pid_hash(pid, mask);; i = (i + 1) & mask) {
+        int idx = tree->slots[i] - 1;
+        if (idx < 0) return -1;
+        if (tree->nodes[idx].pid == pid) return idx;
+    }
+}
+
+static void hash_put(ProcessTree *tree, int idx) {
+    unsigned int mask = tree->nslots - 1;
+    unsigned int i = pid_hash(tree->nodes[idx].pid, mask);
+    while (tree->slots[i] != 0) i = (i + 1) & mask;
+    tree->slots[i] = idx + 1;
+}
+
+/* Linear-probing delete with backward shift, so no tombstones accumulate */
+static void hash_remove(ProcessTree *tree, pid_t pid) {
+    unsigned int mask = tree->nslots - 1;
+    unsigned int i = pid_hash(pid, mask);
+    while (tree->slots[i] != 0 && tree->nodes[tree->slots[i] - 1].pid != pid) i = (i + 1) & mask;
+    if (tree->slots[i] == 0) return;
+    tree->slots[i] = 0;
+    for (unsigned int j = (i + 1) & mask; tree->slots[j] != 0; j = (j + 1) & mask) {
+        unsigned int home = pid_hash(tree->nodes[tree->slots[j] - 1].pid, mask);
+        /* Move j back into the hole if its home slot is not in (i, j] */
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            tree->slots[i] = tree->slots[j];
+            tree->slots[j] = 0;
+            i = j;
+        }
+    }
+}
+
+static int hash_grow(ProcessTree *tree) {
+    unsigned int nslots = tree->nslots * 2;
+    int *slots = calloc(nslots, sizeof(int));
+    if (!slots) return -1;
+    free(tree->slots);
+    tree->slots = slots;
+    tree->nslots = nslots;
+    for (int i = 0; i < tree->capacity; ++i) {
+        if (tree->nodes[i].pid > 0) hash_put(tree, i);
+    }
+    return 0;
+}
+
+static int nodes_grow(ProcessTree *tree) {
+    int cap = tree->capacity * 2;
+    ProcessTreeNode *nodes = realloc(tree->nodes, (size_t)cap * sizeof(ProcessTreeNode));
+    if (!nodes) return -1;
+    int *order = realloc(tree->order, (size_t)cap * sizeof(int));
+    if (!order) { tree->nodes = nodes; return -1; }
+    tree->nodes = nodes;
+    tree->order = order;
+    for (int i = cap - 1; i >= tree->capacity; --i) {
+        memset(&nodes[i], 0, sizeof(nodes[i]));
+        nodes[i].next_sibling = tree->free_head;
+        tree->free_head = i;
+    }
+    tree->capacity = cap;
+    return 0;
+}
+
+int process_tree_init(ProcessTree *tree) {
+    memset(tree, 0, sizeof(*tree));
+    tree->capacity = 1024;
+    tree->nslots = 4096;
+    tree->nodes = calloc((size_t)tree->capacity, sizeof(ProcessTreeNode));
+    tree->order = calloc((size_t)tree->capacity, sizeof(int));
+    tree->slots = calloc(tree->nslots, sizeof(int));
+    if (!tree->nodes || !tree->order || !tree->slots) {
+        process_tree_free(tree);
+        return -1;
+    }
+    tree->free_head = -1;
+    for (int i = tree->capacity - 1; i >= 0; --i) {
+        tree->nodes[i].next_sibling = tree->free_head;
+        tree->free_head = i;
+    }
+    tree->clk_tck = sysconf(_SC_CLK_TCK);
+    if (tree->clk_tck <= 0) tree->clk_tck = 100;
+    return 0;
+}
+
+void process_tree_free(ProcessTree *tree) {
+    free(tree->nodes);
+    free(tree->order);
+    free(tree->slots);
+    memset(tree, 0, sizeof(*tree));
+}
+
+static void unlink_node(ProcessTree *tree, int idx) {
+    ProcessTreeNode *n = &tree->nodes[idx];
+    if (n->parent >= 0) {
+        if (n->prev_sibling >= 0) tree->nodes[n->prev_sibling].next_sibling = n->next_sibling;
+        else tree->nodes[n->parent].first_child = n->next_sibling;
+        if (n->next_sibling >= 0) tree->nodes[n->next_sibling].prev_sibling = n->prev_sibling;
+    }
+    n->parent = -1;
+    n->next_sibling = -1;
+    n->prev_sibling = -1;
+}
+
+static void link_node(ProcessTree *tree, int idx) {
+    ProcessTreeNode *n = &tree->nodes[idx];
+    int p = (n->ppid > 0 && n->ppid != n->pid) ? hash_lookup(tree, n->ppid) : -1;
+    if (p < 0) return; /* root (init, kthreadd, or parent not visible to us) */
+    n->parent = p;
+    n->prev_sibling = -1;
+    n->next_sibling = tree->nodes[p].first_child;
+    if (n->next_sibling >= 0) tree->nodes[n->next_sibling].prev_sibling = idx;
+    tree->nodes[p].first_child = idx;
+}
+
+static void remove_node(ProcessTree *tree, int idx) {
+    ProcessTreeNode *n = &tree->nodes[idx];
+    unlink_node(tree, idx);
+    /* Orphans are reattached once their new ppid is seen */
+    for (int c = n->first_child; c >= 0;) {
+        int next = tree->nodes[c].next_sibling;
+        tree->nodes[c].parent = -1;
+        tree->nodes[c].next_sibling = -1;
+        tree->nodes[c].prev_sibling = -1;
+        tree->nodes[c].relink = 1;
+        c = next;
+    }
+    hash_remove(tree, n->pid);
+    memset(n, 0, sizeof(*n));
+    n->next_sibling = tree->free_head;
+    tree->free_head = idx;
+    tree->count--;
+}
+
+static int insert_node(ProcessTree *tree, pid_t pid) {
+    if (tree->free_head < 0 && nodes_grow(tree) != 0) return -1;
+    if ((unsigned int)(tree->count + 1) * 2 > tree->nslots && hash_grow(tree) != 0) return -1;
+    int idx = tree->free_head;
+    ProcessTreeNode *n = &tree->nodes[idx];
+    tree->free_head = n->next_sibling;
+    memset(n, 0, sizeof(*n));
+    n->pid = pid;
+    n->parent = -1;
+    n->first_child = -1;
+    n->next_sibling = -1;
+    n->prev_sibling = -1;
+    n->relink = 1;
+    hash_put(tree, idx);
+    tree->count++;
+    return idx;
+}
+
+static ssize_t read_small_file(const char *path, char *buf, size_t len) {
+    int fd = sysroot_open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    ssize_t r = read(fd, buf, len - 1);
+    close(fd);
+    if (r < 0) return -1;
+    buf[r] = '\0';
+    return r;
+}
+
+typedef struct {
+    pid_t ppid;
+    char name[64];
+    char state;
+    unsigned long utime, stime, vsize, rss, minflt, majflt;
+    long num_threads;
+    unsigned long long start_time;
+} stat_fields_t;
+
+static int parse_stat(const char *buf, stat_fields_t *f) {
+    const char *open_paren = strchr(buf, '(');
+    const char *close_paren = strrchr(buf, ')');
+    if (!open_paren || !close_paren || close_paren < open_paren) return -1;
+    size_t nlen = (size_t)(close_paren - open_paren - 1);
+    if (nlen >= sizeof(f->name)) nlen = sizeof(f->name) - 1;
+    memcpy(f->name, open_paren + 1, nlen);
+    f->name[nlen] = '\0';
+    int ppid = 0;
+    int n = sscanf(close_paren + 2,
+        "%c %d %*d %*d %*d %*d %*u %lu %*u %lu %*u %lu %lu %*d %*d %*d %*d %ld %*d %llu %lu %lu",
+        &f->state, &ppid, &f->minflt, &f->majflt, &f->utime, &f->stime,
+        &f->num_threads, &f->start_time, &f->vsize, &f->rss);
+    f->ppid = (pid_t)ppid;
+    return (n == 10) ? 0 : -1;
+}
+
+static void read_io_bytes(pid_t pid, unsigned long long *rb, unsigned long long *wb) {
+    char path[64], buf[512];
+    snprintf(path, sizeof(path), "/proc/%d/io", (int)pid);
+    if (read_small_file(path, buf, sizeof(buf)) < 0) return; /* not permitted for other users' processes */
+    char *p = strstr(buf, "\nread_bytes: ");
+    if (p) *rb = strtoull(p + 13, NULL, 10);
+    p = strstr(buf, "\nwrite_bytes: ");
+    if (p) *wb = strtoull(p + 14, NULL, 10);
+}
+
+void process_tree_totals_add(ProcessTreeTotals *dst, const ProcessTreeTotals *src) {
+    dst->procs += src->procs;
+    dst->threads += src->threads;
+    dst->cpu_percent += src->cpu_percent;
+    dst->cpu_ticks += src->cpu_ticks;
+    dst->utime += src->utime;
+    dst->stime += src->stime;
+    dst->vsize += src->vsize;
+    dst->rss += src->rss;
+    dst->minflt += src->minflt;
+    dst->majflt += src->majflt;
+    dst->io_read_bytes += src->io_read_bytes;
+    dst->io_write_bytes += src->io_write_bytes;
+    dst->io_read_bps += src->io_read_bps;
+    dst->io_write_bps += src->io_write_bps;
+}
+
+static void update_node(ProcessTree *tree, int idx, const stat_fields_t *f, double elapsed) {
+    ProcessTreeNode *n = &tree->nodes[idx];
+    unsigned long long rb = n->io_read_bytes, wb = n->io_write_bytes;
+    read_io_bytes(n->pid, &rb, &wb);
+
+    ProcessTreeTotals *s = &n->self;
+    memset(s, 0, sizeof(*s));
+    if (n->has_prev && elapsed > 0.0) {
+        unsigned long prev_ticks = n->utime + n->stime;
+        unsigned long curr_ticks = f->utime + f->stime;
+        s->cpu_ticks = (curr_ticks > prev_ticks) ? curr_ticks - prev_ticks : 0;
+        s->cpu_percent = ((double)s->cpu_ticks / tree->clk_tck) / elapsed * 100.0;
+        s->io_read_bps = (rb > n->io_read_bytes) ? (rb - n->io_read_bytes) / elapsed : 0.0;
+        s->io_write_bps = (wb > n->io_write_bytes) ? (wb - n->io_write_bytes) / elapsed : 0.0;
+    }
+
+    if (n->ppid != f->ppid) n->relink = 1;
+    n->ppid = f->ppid;
+    memcpy(n->name, f->name, sizeof(n->name));
+    n->state = f->state;
+    n->utime = f->utime;
+    n->stime = f->stime;
+    n->vsize = f->vsize;
+    n->rss = f->rss;
+    n->minflt = f->minflt;
+    n->majflt = f->majflt;
+    n->num_threads = f->num_threads;
+    n->start_time = f->start_time;
+    n->io_read_bytes = rb;
+    n->io_write_bytes = wb;
+    n->has_prev = 1;
+
+    s->procs = 1;
+    s->threads = f->num_threads;
+    s->utime = f->utime;
+    s->stime = f->stime;
+    s->vsize = f->vsize;
+    s->rss = f->rss;
+    s->minflt = f->minflt;
+    s->majflt = f->majflt;
+    s->io_read_bytes = rb;
+    s->io_write_bytes = wb;
+}
+
+/* Parents-first BFS from every root, then fold each subtree into its parent in reverse order */
+static void rollup(ProcessTree *tree) {
+    int n = 0;
+    for (int i = 0; i < tree->capacity; ++i) {
+        if (tree->nodes[i].pid > 0 && tree->nodes[i].parent < 0) tree->order[n++] = i;
+    }
+    for (int k = 0; k < n; ++k) {
+        ProcessTreeNode *node = &tree->nodes[tree->order[k]];
+        node->subtree = node->self;
+        for (int c = node->first_child; c >= 0; c = tree->nodes[c].next_sibling) {
+            if (n < tree->capacity) tree->order[n++] = c;
+        }
+    }
+    for (int k = n - 1; k >= 0; --k) {
+        ProcessTreeNode *node = &tree->nodes[tree->order[k]];
+        if (node->parent >= 0) process_tree_totals_add(&tree->nodes[node->parent].subtree, &node->subtree);
+    }
+}
+
+int process_tree_refresh(ProcessTree *tree) {
+    DIR *d = sysroot_opendir("/proc");
+    if (!d) return -1;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (sysroot_mode() != SYSROOT_LIVE) {
+        /* Rates over the recorded ticks, not over the replay's pace */
+        long long ms = sysroot_time_ms();
+        now.tv_sec = (time_t)(ms / 1000);
+        now.tv_nsec = (long)(ms % 1000) * 1000000L;
+    }
+    double elapsed = 0.0;
+    if (tree->refreshed) {
+        elapsed = (now.tv_sec - tree->last_refresh.tv_sec) +
+                  (now.tv_nsec - tree->last_refresh.tv_nsec) / 1e9;
+    }
+    tree->generation++;
+
+    struct dirent *de;
+    char path[64], buf[1024];
+    while ((de = readdir(d)) != NULL) {
+        if (de->d_name[0] < '1' || de->d_name[0] > '9') continue;
+        char *end;
+        long pid = strtol(de->d_name, &end, 10);
+        if (*end != '\0') continue;
+        snprintf(path, sizeof(path), "/proc/%ld/stat", pid);
+        if (read_small_file(path, buf, sizeof(buf)) < 0) continue; /* exited during the walk */
+        stat_fields_t f;
+        if (parse_stat(buf, &f) != 0) continue;
+
+        int idx = hash_lookup(tree, (pid_t)pid);
+        if (idx >= 0 && tree->nodes[idx].start_time != f.start_time) {
+            remove_node(tree, idx); /* PID was reused */
+            idx = -1;
+        }
+        if (idx < 0) {
+            idx = insert_node(tree, (pid_t)pid);
+            if (idx < 0) { closedir(d); return -1; }
+        }
+        update_node(tree, idx, &f, elapsed);
+        tree->nodes[idx].seen = tree->generation;
+    }
+    closedir(d);
+
+    for (int i = 0; i < tree->capacity; ++i) {
+        if (tree->nodes[i].pid > 0 && tree->nodes[i].seen != tree->generation) remove_node(tree, i);
+    }
+    for (int i = 0; i < tree->capacity; ++i) {
+        ProcessTreeNode *n = &tree->nodes[i];
+        if (n->pid <= 0 || !n->relink) continue;
+        unlink_node(tree, i);
+        link_node(tree, i);
+        n->relink = 0;
+    }
+    rollup(tree);
+
+    tree->last_refresh = now;
+    tree->refreshed = 1;
+    return tree->count;
+}
+
+const ProcessTreeNode *process_tree_find(const ProcessTree *tree, pid_t pid) {
+    if (!tree->slots) return NULL;
+    int idx = hash_lookup(tree, pid);
+    return (idx >= 0) ? &tree->nodes[idx] : NULL;
+}
+
+int process_tree_subtree_totals(const ProcessTree *tree, pid_t pid, ProcessTreeTotals *out) {
+    const ProcessTreeNode *n = process_tree_find(tree, pid);
+    if (!n) return -1;
+    *out = n->subtree;
+    return 0;
+}
+
+int process_tree_collect_subtree(const ProcessTree *tree, pid_t pid, pid_t *out, int max) {
+    if (!tree->slots) return -1;
+    int root = hash_lookup(tree, pid);
+    if (root < 0) return -1;
+    int n = 0;
+    int cur = root;
+    while (cur >= 0 && n < max) {
+        out[n++] = tree->nodes[cur].pid;
+        if (tree->nodes[cur].first_child >= 0) {
+            cur = tree->nodes[cur].first_child;
+            continue;
+        }
+        while (cur != root && tree->nodes[cur].next_sibling < 0) cur = tree->nodes[cur].parent;
+        cur = (cur == root) ? -1 : tree->nodes[cur].next_sibling;
+    }
+    return n;
+}
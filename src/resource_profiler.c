@@ -6,6 +6,12 @@
 #include <inttypes.h>
 #include <time.h>
 #include "../include/resource_profiler.h"
+#include "../include/process_tree.h"
+#include "../include/memory_accounting.h"
+#include "../include/sched_monitor.h"
+#include "../include/perf_counters.h"
+#include "../include/sysroot.h"
+#include <sys/sysinfo.h>
 
 /* Resource profiler: reads /proc/<pid> to collect CPU, memory, IO and network metrics.
  * Calculates CPU% using /proc/stat and per-interval IO rates using /proc/<pid>/io.
@@ -33,6 +39,184 @@ typedef struct {
     unsigned long iowait;
 } cpu_stat_t;
 
+/* Optional column groups appended after the base columns of each row */
+typedef struct {
+    int pss_valid;
+    SmapsRollup pss;
+    double pss_mem_percent;
+    int sched_valid;
+    SchedDelta sched;
+    double sched_p50_us;
+    double sched_p99_us;
+    int perf_valid;
+    PerfValues perf;            /* interval deltas */
+} rp_extras_t;
+
+/* Run-queue wait tracking across samples for the --sched columns */
+typedef struct {
+    int have_prev;
+    SchedStat prev;
+    SchedHistogram hist;
+} rp_sched_state_t;
+
+/* perf_event counters across samples for the --perf columns */
+typedef struct {
+    PerfCounters pc;
+    int have_prev;
+    PerfValues prev;
+} rp_perf_state_t;
+
+static void emit_extra_header(FILE *out, const rp_options_t *opts) {
+    if (opts->pss) fprintf(out, ",pss_kb,uss_kb,swap_pss_kb,pss_anon_kb,pss_file_kb,pss_mem_percent");
+    if (opts->sched) fprintf(out, ",sched_run_ms,sched_wait_ms,sched_timeslices,sched_wait_run_ratio,sched_avg_wait_us,sched_wait_p50_us,sched_wait_p99_us");
+    if (opts->perf) fprintf(out, ",perf_task_clock_ms,perf_context_switches,perf_cpu_migrations,perf_page_faults,perf_cycles,perf_instructions,perf_ipc,perf_cache_misses,perf_branch_misses");
+}
+
+/* One --perf value: counted events print, the others stay empty / null */
+static void emit_perf_value(FILE *out, int emit_json, const char *name, int valid, double v, const char *fmt) {
+    if (emit_json) {
+        fprintf(out, ", \"%s\": ", name);
+        if (valid) fprintf(out, fmt, v);
+        else fprintf(out, "null");
+    } else {
+        fputc(',', out);
+        if (valid) fprintf(out, fmt, v);
+    }
+}
+
+static void emit_perf_values(FILE *out, int emit_json, const PerfCounters *pc, const rp_extras_t *x) {
+    /* Column order; ipc marks the derived instructions/cycles column */
+    static const struct { PerfEventId e; int ipc; } cols[] = {
+        { PERF_TASK_CLOCK, 0 }, { PERF_CONTEXT_SWITCHES, 0 }, { PERF_CPU_MIGRATIONS, 0 }, { PERF_PAGE_FAULTS, 0 },
+        { PERF_CYCLES, 0 }, { PERF_INSTRUCTIONS, 0 }, { PERF_INSTRUCTIONS, 1 }, { PERF_CACHE_MISSES, 0 },
+        { PERF_BRANCH_MISSES, 0 }
+    };
+    const PerfValues *d = &x->perf;
+    for (size_t i = 0; i < sizeof(cols) / sizeof(cols[0]); ++i) {
+        PerfEventId e = cols[i].e;
+        char name[48];
+        if (cols[i].ipc) {
+            int ok = x->perf_valid && perf_counters_available(pc, PERF_CYCLES) &&
+                     perf_counters_available(pc, PERF_INSTRUCTIONS) && d->v[PERF_CYCLES] > 0;
+            emit_perf_value(out, emit_json, "perf_ipc", ok,
+                            ok ? d->v[PERF_INSTRUCTIONS] / d->v[PERF_CYCLES] : 0.0, "%.3f");
+            continue;
+        }
+        int ok = x->perf_valid && perf_counters_available(pc, e);
+        if (e == PERF_TASK_CLOCK) {
+            emit_perf_value(out, emit_json, "perf_task_clock_ms", ok, d->v[e] / 1e6, "%.3f");
+        } else {
+            snprintf(name, sizeof(name), "perf_%s", perf_event_name(e));
+            emit_perf_value(out, emit_json, name, ok, d->v[e], "%.0f");
+        }
+    }
+}
+
+static void emit_extra_values(FILE *out, int emit_json, const rp_options_t *opts, const rp_extras_t *x,
+                              const rp_perf_state_t *perf) {
+    if (opts->pss) {
+        const SmapsRollup *m = &x->pss;
+        if (emit_json && x->pss_valid) {
+            fprintf(out, ", \"pss_kb\": %lu, \"uss_kb\": %lu, \"swap_pss_kb\": %lu, \"pss_anon_kb\": %lu, \"pss_file_kb\": %lu, \"pss_mem_percent\": %.2f",
+                    m->pss_kb, m->uss_kb, m->swap_pss_kb, m->pss_anon_kb, m->pss_file_kb, x->pss_mem_percent);
+        } else if (emit_json) {
+            fprintf(out, ", \"pss_kb\": null, \"uss_kb\": null, \"swap_pss_kb\": null, \"pss_anon_kb\": null, \"pss_file_kb\": null, \"pss_mem_percent\": null");
+        } else if (x->pss_valid) {
+            fprintf(out, ",%lu,%lu,%lu,%lu,%lu,%.2f",
+                    m->pss_kb, m->uss_kb, m->swap_pss_kb, m->pss_anon_kb, m->pss_file_kb, x->pss_mem_percent);
+        } else {
+            fprintf(out, ",,,,,,");
+        }
+    }
+    if (opts->sched) {
+        const SchedDelta *d = &x->sched;
+        if (emit_json && x->sched_valid) {
+            fprintf(out, ", \"sched_run_ms\": %.3f, \"sched_wait_ms\": %.3f, \"sched_timeslices\": %llu, \"sched_wait_run_ratio\": %.4f, \"sched_avg_wait_us\": %.2f, \"sched_wait_p50_us\": %.0f, \"sched_wait_p99_us\": %.0f",
+                    d->run_ms, d->wait_ms, d->timeslices, d->wait_run_ratio, d->avg_wait_us, x->sched_p50_us, x->sched_p99_us);
+        } else if (emit_json) {
+            fprintf(out, ", \"sched_run_ms\": null, \"sched_wait_ms\": null, \"sched_timeslices\": null, \"sched_wait_run_ratio\": null, \"sched_avg_wait_us\": null, \"sched_wait_p50_us\": null, \"sched_wait_p99_us\": null");
+        } else if (x->sched_valid) {
+            fprintf(out, ",%.3f,%.3f,%llu,%.4f,%.2f,%.0f,%.0f",
+                    d->run_ms, d->wait_ms, d->timeslices, d->wait_run_ratio, d->avg_wait_us, x->sched_p50_us, x->sched_p99_us);
+        } else {
+            fprintf(out, ",,,,,,,");
+        }
+    }
+    if (opts->perf) emit_perf_values(out, emit_json, &perf->pc, x);
+}
+
+/* Refresh smaps_rollup for pids (on the cache's own interval) and sum the result.
+ * starts: the pids' start times, NULL to let the cache read them. */
+static void collect_pss(MemAcctCache *cache, const pid_t *pids, const unsigned long long *starts, int n,
+                        unsigned long mem_total_kb, rp_extras_t *x) {
+    memset(&x->pss, 0, sizeof(x->pss));
+    x->pss_valid = 0;
+    mem_acct_update(cache, pids, starts, n);
+    for (int i = 0; i < n; ++i) {
+        const SmapsRollup *m = mem_acct_get(cache, pids[i]);
+        if (!m) continue;
+        x->pss.pss_kb += m->pss_kb;
+        x->pss.uss_kb += m->uss_kb;
+        x->pss.swap_pss_kb += m->swap_pss_kb;
+        x->pss.pss_anon_kb += m->pss_anon_kb;
+        x->pss.pss_file_kb += m->pss_file_kb;
+        x->pss_valid = 1;
+    }
+    x->pss_mem_percent = mem_acct_percent(&x->pss, mem_total_kb);
+}
+
+/* Sum schedstat over all threads of pids and turn it into an interval delta */
+static void collect_sched(rp_sched_state_t *st, const pid_t *pids, int n, rp_extras_t *x) {
+    SchedStat sum = {0};
+    int valid = 0;
+    for (int i = 0; i < n; ++i) {
+        SchedStat s;
+        if (read_process_schedstat(pids[i], &s) != 0) continue;
+        sum.run_ns += s.run_ns;
+        sum.wait_ns += s.wait_ns;
+        sum.timeslices += s.timeslices;
+        valid = 1;
+    }
+    x->sched_valid = valid;
+    if (!valid) return;
+    sched_delta(st->have_prev ? &st->prev : &sum, &sum, &x->sched);
+    sched_hist_add(&st->hist, &x->sched);
+    x->sched_p50_us = sched_hist_percentile(&st->hist, 50.0);
+    x->sched_p99_us = sched_hist_percentile(&st->hist, 99.0);
+    st->prev = sum;
+    st->have_prev = 1;
+}
+
+/* Read the perf groups of every thread of pids and turn the totals into an interval delta */
+static void collect_perf(rp_perf_state_t *st, const pid_t *pids, int n, rp_extras_t *x) {
+    PerfValues now;
+    x->perf_valid = perf_counters_read(&st->pc, pids, n, &now) >= 0;
+    if (!x->perf_valid) return;
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        double d = st->have_prev ? now.v[e] - st->prev.v[e] : 0.0;
+        x->perf.v[e] = d > 0.0 ? d : 0.0;   /* scaled counts may wobble */
+    }
+    st->prev = now;
+    st->have_prev = 1;
+}
+
+static void perf_report_fallback(const rp_perf_state_t *st) {
+    if (!st->pc.probed) {
+        fprintf(stderr, "rp_run: perf_event_open unavailable, --perf columns left empty\n");
+    } else if (!perf_counters_available(&st->pc, PERF_CYCLES)) {
+        fprintf(stderr, "rp_run: no hardware PMU, --perf reports software events only\n");
+    }
+    if (st->pc.probed && st->pc.user_only) {
+        fprintf(stderr, "rp_run: perf_event_paranoid limits counting to user space, context switches and migrations left empty\n");
+    }
+}
+
+static unsigned long read_mem_total_kb(void) {
+    struct sysinfo si;
+    if (sysinfo(&si) != 0) return 0;
+    return (unsigned long)(si.totalram / 1024) * si.mem_unit;
+}
+
 /* Helpers (C, not lambdas) */
 static int read_proc_io_fn(pid_t p, unsigned long long *rchar,
                            unsigned long long *wchar,
@@ -40,7 +224,7 @@ static int read_proc_io_fn(pid_t p, unsigned long long *rchar,
                            unsigned long long *write_bytes) {
     char ipath[256];
     snprintf(ipath, sizeof(ipath), "/proc/%d/io", (int)p);
-    FILE *iof = fopen(ipath, "r");
+    FILE *iof = sysroot_fopen(ipath, "r");
     if (!iof) return -1;
     char line[256];
     while (fgets(line, sizeof(line), iof)) {
@@ -53,21 +237,26 @@ static int read_proc_io_fn(pid_t p, unsigned long long *rchar,
     return 0;
 }
 
+int rp_count_sockets(FILE *f) {
+    char line[512];
+    int lines = 0;
+    while (fgets(line, sizeof(line), f)) lines++;
+    return (lines > 0) ? (lines - 1) : 0;
+}
+
 static int count_net_conns_fn(pid_t p, const char *proto) {
     char npath[256];
     snprintf(npath, sizeof(npath), "/proc/%d/net/%s", (int)p, proto);
-    FILE *nf = fopen(npath, "r");
+    FILE *nf = sysroot_fopen(npath, "r");
     if (!nf) return 0;
-    char line[512];
-    int lines = 0;
-    while (fgets(line, sizeof(line), nf)) lines++;
+    int n = rp_count_sockets(nf);
     fclose(nf);
-    return (lines > 0) ? (lines - 1) : 0;
+    return n;
 }
 
 /* Read CPU jiffies from /proc/stat (first line) */
 static int read_cpu_stat(cpu_stat_t *stat) {
-    FILE *f = fopen("/proc/stat", "r");
+    FILE *f = sysroot_fopen("/proc/stat", "r");
     if (!f) return -1;
     char buf[256];
     if (!fgets(buf, sizeof(buf), f)) { fclose(f); return -1; }
@@ -81,7 +270,7 @@ static int read_cpu_stat(cpu_stat_t *stat) {
 static int read_proc_stat(pid_t pid, proc_stat_t *stat) {
     char path[256];
     snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
-    FILE *f = fopen(path, "r");
+    FILE *f = sysroot_fopen(path, "r");
     if (!f) return -1;
     char buf[4096];
     if (!fgets(buf, sizeof(buf), f)) { fclose(f); return -1; }
@@ -132,7 +321,7 @@ static int read_proc_stat(pid_t pid, proc_stat_t *stat) {
     /* Read extra info from /proc/<pid>/status */
     char spath[256];
     snprintf(spath, sizeof(spath), "/proc/%d/status", (int)pid);
-    FILE *sf = fopen(spath, "r");
+    FILE *sf = sysroot_fopen(spath, "r");
     if (sf) {
         char line[256];
         while (fgets(line, sizeof(line), sf)) {
@@ -162,7 +351,133 @@ static double calc_cpu_percent(const proc_stat_t *prev, const proc_stat_t *curr,
     return (cpu_percent > 100.0) ? 100.0 : cpu_percent;
 }
 
+/* Tree mode: one row per sample with the rolled-up totals of pid's subtree */
+static int rp_run_tree(const rp_options_t *opts, FILE *out, int emit_json) {
+    pid_t pid = opts->pid;
+    int samples = opts->samples;
+    ProcessTree tree;
+    MemAcctCache pss_cache;
+    if (process_tree_init(&tree) != 0) {
+        fprintf(stderr, "rp_run: failed to allocate process table\n");
+        return -1;
+    }
+    if (mem_acct_init(&pss_cache, opts->pss_refresh_ms) != 0) {
+        process_tree_free(&tree);
+        return -1;
+    }
+    unsigned long mem_total_kb = read_mem_total_kb();
+    rp_sched_state_t sched_state = {0};
+    rp_perf_state_t perf_state = {0};
+    if (opts->perf) perf_counters_init(&perf_state.pc);
+    pid_t *members = NULL;
+    unsigned long long *starts = NULL;
+    int members_cap = 0;
+    if (emit_json) {
+        fprintf(out, "[\n");
+    } else {
+        fprintf(out, "timestamp_ms,root_pid,procs,utime_ticks,stime_ticks,cpu_percent,vsize_bytes,rss_pages,threads,minflt,majflt,io_read_bytes,io_write_bytes,io_read_bps,io_write_bps");
+        emit_extra_header(out, opts);
+        fprintf(out, "\n");
+    }
+
+    cpu_stat_t prev_cpu = {0}, curr_cpu = {0};
+    int rc = 0;
+    int rows = 0;
+    for (int i = 0; i < samples; ++i) {
+        if (sysroot_next_tick() < 0) {
+            fprintf(stderr, "rp_run: recording ended after %d samples\n", i);
+            break;
+        }
+        if (read_cpu_stat(&curr_cpu) != 0) {
+            fprintf(stderr, "rp_run: failed to read /proc/stat\n");
+            rc = -1;
+            break;
+        }
+        ProcessTreeTotals t;
+        if (process_tree_refresh(&tree) < 0 || process_tree_subtree_totals(&tree, pid, &t) != 0) {
+            fprintf(stderr, "rp_run: failed to read /proc for pid %d\n", pid);
+            rc = -1;
+            break;
+        }
+
+        long long ms = sysroot_time_ms();
+
+        /* Same scale as the single-PID mode: share of all system jiffies in the interval */
+        double cpu_pct = 0.0;
+        if (i > 0) {
+            unsigned long cpu_prev = prev_cpu.user + prev_cpu.nice + prev_cpu.system + prev_cpu.idle + prev_cpu.iowait;
+            unsigned long cpu_curr = curr_cpu.user + curr_cpu.nice + curr_cpu.system + curr_cpu.idle + curr_cpu.iowait;
+            if (cpu_curr > cpu_prev) cpu_pct = (t.cpu_ticks / (double)(cpu_curr - cpu_prev)) * 100.0;
+            if (cpu_pct > 100.0) cpu_pct = 100.0;
+        }
+
+        rp_extras_t extras = {0};
+        if (opts->pss || opts->sched || opts->perf) {
+            if (members_cap < tree.count) {
+                pid_t *m = realloc(members, (size_t)tree.count * sizeof(pid_t));
+                if (m) members = m;
+                unsigned long long *st = realloc(starts, (size_t)tree.count * sizeof(*starts));
+                if (st) starts = st;
+                if (m && st) members_cap = tree.count;
+            }
+            int n = members_cap ? process_tree_collect_subtree(&tree, pid, members, members_cap) : 0;
+            if (n < 0) n = 0;
+            for (int j = 0; j < n; ++j) {
+                const ProcessTreeNode *node = process_tree_find(&tree, members[j]);
+                starts[j] = node ? node->start_time : 0;
+            }
+            if (opts->pss) collect_pss(&pss_cache, members, starts, n, mem_total_kb, &extras);
+            if (opts->sched) collect_sched(&sched_state, members, n, &extras);
+            if (opts->perf) collect_perf(&perf_state, members, n, &extras);
+            if (opts->perf && i == 0) perf_report_fallback(&perf_state);
+        }
+
+        if (emit_json) {
+            if (rows++) fprintf(out, ",\n");
+            fprintf(out,
+            "  {\"timestamp_ms\": %lld, \"root_pid\": %d, \"procs\": %d, \"utime_ticks\": %llu, \"stime_ticks\": %llu, \"cpu_percent\": %.2f, \"vsize_bytes\": %llu, \"rss_pages\": %llu, \"threads\": %ld, \"minflt\": %llu, \"majflt\": %llu, \"io_read_bytes\": %llu, \"io_write_bytes\": %llu, \"io_read_bps\": %.2f, \"io_write_bps\": %.2f",
+            ms, (int)pid, t.procs, t.utime, t.stime, cpu_pct, t.vsize, t.rss, t.threads,
+            t.minflt, t.majflt, t.io_read_bytes, t.io_write_bytes, t.io_read_bps, t.io_write_bps);
+            emit_extra_values(out, emit_json, opts, &extras, &perf_state);
+            fprintf(out, " }");
+        } else {
+            fprintf(out, "%lld,%d,%d,%llu,%llu,%.2f,%llu,%llu,%ld,%llu,%llu,%llu,%llu,%.0f,%.0f",
+            ms, (int)pid, t.procs, t.utime, t.stime, cpu_pct, t.vsize, t.rss, t.threads,
+            t.minflt, t.majflt, t.io_read_bytes, t.io_write_bytes, t.io_read_bps, t.io_write_bps);
+            emit_extra_values(out, emit_json, opts, &extras, &perf_state);
+            fprintf(out, "\n");
+        }
+        fflush(out);
+
+        prev_cpu = curr_cpu;
+        if (i + 1 < samples && sysroot_mode() != SYSROOT_REPLAY) {
+            usleep((useconds_t)opts->interval_ms * 1000);
+        }
+    }
+    /* Close the array even when sampling stopped early, so what was written stays valid */
+    if (emit_json) fprintf(out, "%s]\n", rows ? "\n" : "");
+    free(members);
+    free(starts);
+    if (opts->perf) perf_counters_free(&perf_state.pc);
+    mem_acct_free(&pss_cache);
+    process_tree_free(&tree);
+    return rc;
+}
+
 int rp_run(pid_t pid, int interval_ms, int samples, const char *outpath) {
+    rp_options_t opts = {0};
+    opts.pid = pid;
+    opts.interval_ms = interval_ms;
+    opts.samples = samples;
+    opts.outpath = outpath;
+    return rp_run_opts(&opts);
+}
+
+int rp_run_opts(const rp_options_t *opts) {
+    pid_t pid = opts->pid;
+    int interval_ms = opts->interval_ms;
+    int samples = opts->samples;
+    const char *outpath = opts->outpath;
     if (samples <= 0) samples = 1;
     FILE *out = stdout;
     if (outpath) {
@@ -177,37 +492,59 @@ int rp_run(pid_t pid, int interval_ms, int samples, const char *outpath) {
         const char *dot = strrchr(outpath, '.');
         if (dot && strcmp(dot, ".json") == 0) emit_json = 1;
     }
+    if (opts->tree) {
+        rp_options_t tree_opts = *opts;
+        tree_opts.samples = samples;
+        int rc = rp_run_tree(&tree_opts, out, emit_json);
+        if (outpath) fclose(out);
+        return rc;
+    }
     /* Headers */
     if (emit_json) {
         fprintf(out, "[\n");
     } else {
-        fprintf(out, "timestamp_ms,pid,utime_ticks,stime_ticks,cpu_percent,vsize_bytes,rss_pages,threads,minflt,majflt,vm_swap_kb,ctx_voluntary,ctx_nonvoluntary,io_rchar,io_wchar,io_read_bytes,io_write_bytes,io_read_bps,io_write_bps,net_tcp_conns,net_udp_conns\n");
+        fprintf(out, "timestamp_ms,pid,utime_ticks,stime_ticks,cpu_percent,vsize_bytes,rss_pages,threads,minflt,majflt,vm_swap_kb,ctx_voluntary,ctx_nonvoluntary,io_rchar,io_wchar,io_read_bytes,io_write_bytes,io_read_bps,io_write_bps,net_tcp_conns,net_udp_conns");
+        emit_extra_header(out, opts);
+        fprintf(out, "\n");
+    }
+    MemAcctCache pss_cache;
+    if (mem_acct_init(&pss_cache, opts->pss_refresh_ms) != 0) {
+        if (outpath) fclose(out);
+        return -1;
     }
+    unsigned long mem_total_kb = read_mem_total_kb();
+    rp_sched_state_t sched_state = {0};
+    rp_perf_state_t perf_state = {0};
+    if (opts->perf) perf_counters_init(&perf_state.pc);
     
     proc_stat_t prev_proc = {0}, curr_proc = {0};
     cpu_stat_t prev_cpu = {0}, curr_cpu = {0};
     /* IO cumulative values for deltas */
     unsigned long long prev_read_bytes=0, prev_write_bytes=0;
     int first = 1;
+    int rows = 0;
+    int rc = 0;
     /* Small helpers moved to C static functions above */
     
     for (int i = 0; i < samples; ++i) {
+        if (sysroot_next_tick() < 0) {
+            fprintf(stderr, "rp_run: recording ended after %d samples\n", i);
+            break;
+        }
         /* Read current system and process stats */
         if (read_cpu_stat(&curr_cpu) != 0) {
             fprintf(stderr, "rp_run: failed to read /proc/stat\n");
-            if (outpath) fclose(out);
-            return -1;
+            rc = -1;
+            break;
         }
         if (read_proc_stat(pid, &curr_proc) != 0) {
             fprintf(stderr, "rp_run: failed to read /proc for pid %d\n", pid);
-            if (outpath) fclose(out);
-            return -1;
+            rc = -1;
+            break;
         }
         
         /* Get timestamp */
-        struct timespec ts;
-        clock_gettime(CLOCK_REALTIME, &ts);
-        long long ms = (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+        long long ms = sysroot_time_ms();
         
         /* Calculate CPU% (skip on first sample since no delta) */
         double cpu_pct = 0.0;
@@ -227,20 +564,30 @@ int rp_run(pid_t pid, int interval_ms, int samples, const char *outpath) {
         int tcp_conns = count_net_conns_fn(pid, "tcp") + count_net_conns_fn(pid, "tcp6");
         int udp_conns = count_net_conns_fn(pid, "udp") + count_net_conns_fn(pid, "udp6");
 
+        rp_extras_t extras = {0};
+        if (opts->pss) collect_pss(&pss_cache, &pid, NULL, 1, mem_total_kb, &extras);
+        if (opts->sched) collect_sched(&sched_state, &pid, 1, &extras);
+        if (opts->perf) collect_perf(&perf_state, &pid, 1, &extras);
+        if (opts->perf && first) perf_report_fallback(&perf_state);
+
         if (emit_json) {
+            if (rows++) fprintf(out, ",\n");
             fprintf(out,
-            "  {\"timestamp_ms\": %lld, \"pid\": %d, \"utime_ticks\": %lu, \"stime_ticks\": %lu, \"cpu_percent\": %.2f, \"vsize_bytes\": %lu, \"rss_pages\": %ld, \"threads\": %d, \"minflt\": %lu, \"majflt\": %lu, \"vm_swap_kb\": %lu, \"ctx_voluntary\": %lu, \"ctx_nonvoluntary\": %lu, \"io_rchar\": %llu, \"io_wchar\": %llu, \"io_read_bytes\": %llu, \"io_write_bytes\": %llu, \"io_read_bps\": %.2f, \"io_write_bps\": %.2f, \"net_tcp_conns\": %d, \"net_udp_conns\": %d }%s\n",
+            "  {\"timestamp_ms\": %lld, \"pid\": %d, \"utime_ticks\": %lu, \"stime_ticks\": %lu, \"cpu_percent\": %.2f, \"vsize_bytes\": %lu, \"rss_pages\": %ld, \"threads\": %d, \"minflt\": %lu, \"majflt\": %lu, \"vm_swap_kb\": %lu, \"ctx_voluntary\": %lu, \"ctx_nonvoluntary\": %lu, \"io_rchar\": %llu, \"io_wchar\": %llu, \"io_read_bytes\": %llu, \"io_write_bytes\": %llu, \"io_read_bps\": %.2f, \"io_write_bps\": %.2f, \"net_tcp_conns\": %d, \"net_udp_conns\": %d",
             ms, (int)pid, curr_proc.utime, curr_proc.stime, cpu_pct, curr_proc.vsize, curr_proc.rss,
             curr_proc.threads, curr_proc.minflt, curr_proc.majflt, curr_proc.vm_swap_kb,
             curr_proc.ctx_voluntary, curr_proc.ctx_nonvoluntary,
-            rchar, wchar, read_bytes, write_bytes, read_bps, write_bps, tcp_conns, udp_conns,
-            (i + 1 < samples) ? "," : "");
+            rchar, wchar, read_bytes, write_bytes, read_bps, write_bps, tcp_conns, udp_conns);
+            emit_extra_values(out, emit_json, opts, &extras, &perf_state);
+            fprintf(out, " }");
         } else {
-            fprintf(out, "%lld,%d,%lu,%lu,%.2f,%lu,%ld,%d,%lu,%lu,%lu,%lu,%lu,%llu,%llu,%llu,%llu,%.0f,%.0f,%d,%d\n",
+            fprintf(out, "%lld,%d,%lu,%lu,%.2f,%lu,%ld,%d,%lu,%lu,%lu,%lu,%lu,%llu,%llu,%llu,%llu,%.0f,%.0f,%d,%d",
             ms, (int)pid, curr_proc.utime, curr_proc.stime, cpu_pct, curr_proc.vsize, curr_proc.rss,
             curr_proc.threads, curr_proc.minflt, curr_proc.majflt, curr_proc.vm_swap_kb,
             curr_proc.ctx_voluntary, curr_proc.ctx_nonvoluntary,
             rchar, wchar, read_bytes, write_bytes, read_bps, write_bps, tcp_conns, udp_conns);
+            emit_extra_values(out, emit_json, opts, &extras, &perf_state);
+            fprintf(out, "\n");
         }
         fflush(out);
         
@@ -249,11 +596,13 @@ int rp_run(pid_t pid, int interval_ms, int samples, const char *outpath) {
         prev_cpu = curr_cpu;
         first = 0;
         
-        if (i + 1 < samples) {
+        if (i + 1 < samples && sysroot_mode() != SYSROOT_REPLAY) {
             usleep((useconds_t)interval_ms * 1000);
         }
     }
-    if (emit_json) fprintf(out, "]\n");
+    if (emit_json) fprintf(out, "%s]\n", rows ? "\n" : "");
+    perf_counters_free(&perf_state.pc);
+    mem_acct_free(&pss_cache);
     if (outpath) fclose(out);
-    return 0;
+    return rc;
 }
@@ -1,20 +1,142 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include "../include/resource_profiler.h"
+#include "../include/memory_accounting.h"
+#include "../include/smaps_analyzer.h"
+#include "../include/sched_monitor.h"
+#include "../include/experiments.h"
+#include "../include/sysroot.h"
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage:\n");
+    fprintf(stderr, "  %s [--tree] [--pss[=refresh_ms]] [--sched] [--perf] [--record=DIR | --replay=DIR]\n"
+                    "      <pid> [interval_ms] [samples] [out.csv]\n", prog);
+    fprintf(stderr, "  %s [--pss=refresh_ms] [--filter=name] mem-top <k> [interval_ms] [samples] [out.csv]\n", prog);
+    fprintf(stderr, "  %s smaps <pid> [interval_ms] [top_files] [out.txt]\n", prog);
+    fprintf(stderr, "  %s schedstat [interval_ms] [samples] [out.csv]\n", prog);
+    fprintf(stderr, "  %s overhead [--workloads cpu,syscall,memory] [--monitors profiler,proctree,cgroup]\n"
+                    "      [--intervals 1,10,100,1000] [--trials N] [--trial-ms ms] [--same-cpu] [out.csv]\n", prog);
+    fprintf(stderr, "  --tree     profile <pid> and all of its descendants as one unit\n");
+    fprintf(stderr, "  --pss      add PSS/USS columns (smaps_rollup re-read every refresh_ms, default 5000)\n");
+    fprintf(stderr, "  --sched    add run-queue wait columns from schedstat\n");
+    fprintf(stderr, "  --perf     add perf_event counter columns (IPC, cache/branch misses, faults, switches)\n");
+    fprintf(stderr, "  --filter   mem-top: only processes whose name contains <name>\n");
+    fprintf(stderr, "  --root     read DIR/proc and DIR/sys instead of /proc and /sys (also RESMON_ROOT)\n");
+    fprintf(stderr, "  --record   copy every /proc and /sys file read into DIR, one directory per sample\n");
+    fprintf(stderr, "  --replay   run from a recording at full speed (interval and samples default to the recorded ones)\n");
+}
 
 int main(int argc, char **argv) {
-    if (argc < 2) {
-        fprintf(stderr, "Usage: %s <pid> [interval_ms] [samples] [out.csv]\n", argv[0]);
+    rp_options_t opts = {0};
+    opts.interval_ms = 1000;
+    opts.samples = 1;
+    const char *name_filter = NULL;
+    const char *record_dir = NULL, *replay_dir = NULL;
+
+    int argi = 1;
+    for (; argi < argc && strncmp(argv[argi], "--", 2) == 0; ++argi) {
+        if (strcmp(argv[argi], "--tree") == 0) {
+            opts.tree = 1;
+        } else if (strncmp(argv[argi], "--pss", 5) == 0 && (argv[argi][5] == '\0' || argv[argi][5] == '=')) {
+            opts.pss = 1;
+            if (argv[argi][5] == '=') opts.pss_refresh_ms = atoi(argv[argi] + 6);
+        } else if (strcmp(argv[argi], "--sched") == 0) {
+            opts.sched = 1;
+        } else if (strcmp(argv[argi], "--perf") == 0) {
+            opts.perf = 1;
+        } else if (strncmp(argv[argi], "--filter=", 9) == 0) {
+            name_filter = argv[argi] + 9;
+        } else if (strncmp(argv[argi], "--root=", 7) == 0) {
+            sysroot_set(argv[argi] + 7);
+        } else if (strncmp(argv[argi], "--record=", 9) == 0) {
+            record_dir = argv[argi] + 9;
+        } else if (strncmp(argv[argi], "--replay=", 9) == 0) {
+            replay_dir = argv[argi] + 9;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (argi >= argc) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (strcmp(argv[argi], "mem-top") == 0) {
+        if (argc <= argi + 1) { usage(argv[0]); return 1; }
+        int k = atoi(argv[argi + 1]);
+        if (argc > argi + 2) opts.interval_ms = atoi(argv[argi + 2]);
+        if (argc > argi + 3) opts.samples = atoi(argv[argi + 3]);
+        if (argc > argi + 4) opts.outpath = argv[argi + 4];
+        return monitor_memory_accounting(k, name_filter, opts.interval_ms, opts.samples,
+                                         opts.pss_refresh_ms, opts.outpath);
+    }
+    if (strcmp(argv[argi], "smaps") == 0) {
+        if (argc <= argi + 1) { usage(argv[0]); return 1; }
+        pid_t pid = (pid_t)atoi(argv[argi + 1]);
+        int interval = (argc > argi + 2) ? atoi(argv[argi + 2]) : 0;
+        int top = (argc > argi + 3) ? atoi(argv[argi + 3]) : 10;
+        const char *out = (argc > argi + 4) ? argv[argi + 4] : NULL;
+        return smaps_analyze(pid, interval, top, out);
+    }
+    if (strcmp(argv[argi], "schedstat") == 0) {
+        if (argc > argi + 1) opts.interval_ms = atoi(argv[argi + 1]);
+        if (argc > argi + 2) opts.samples = atoi(argv[argi + 2]);
+        if (argc > argi + 3) opts.outpath = argv[argi + 3];
+        return monitor_system_schedstat(opts.interval_ms, opts.samples, opts.outpath);
+    }
+    if (strcmp(argv[argi], "overhead") == 0) {
+        const char *workloads = NULL, *monitors = NULL, *intervals = NULL, *out = NULL;
+        int trials = 5, trial_ms = 1000, same_cpu = 0;
+        for (int i = argi + 1; i < argc; ++i) {
+            if (strcmp(argv[i], "--same-cpu") == 0) same_cpu = 1;
+            else if (strncmp(argv[i], "--", 2) != 0) out = argv[i];
+            else if (i + 1 >= argc) { usage(argv[0]); return 1; }
+            else if (strcmp(argv[i], "--workloads") == 0) workloads = argv[++i];
+            else if (strcmp(argv[i], "--monitors") == 0) monitors = argv[++i];
+            else if (strcmp(argv[i], "--intervals") == 0) intervals = argv[++i];
+            else if (strcmp(argv[i], "--trials") == 0) trials = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--trial-ms") == 0) trial_ms = atoi(argv[++i]);
+            else { usage(argv[0]); return 1; }
+        }
+        return experiment_overhead_sweep(workloads, monitors, intervals, trials, trial_ms, same_cpu, out) == 0 ? 0 : 1;
+    }
+    opts.pid = (pid_t)atoi(argv[argi]);
+    if (argc > argi + 1) opts.interval_ms = atoi(argv[argi + 1]);
+    if (argc > argi + 2) opts.samples = atoi(argv[argi + 2]);
+    if (argc > argi + 3) opts.outpath = argv[argi + 3];
+    if (record_dir && replay_dir) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (record_dir && sysroot_record_start(record_dir, opts.interval_ms) != 0) {
+        perror(record_dir);
+        return 1;
+    }
+    if (!replay_dir) {
+        int rc = rp_run_opts(&opts);
+        if (record_dir) sysroot_record_stop();
+        return rc;
+    }
+
+    int interval_ms = opts.interval_ms;
+    int ticks = sysroot_replay_start(replay_dir, &interval_ms);
+    if (ticks <= 0) {
+        fprintf(stderr, "replay: no recorded samples in %s\n", replay_dir);
         return 1;
     }
-    pid_t pid = (pid_t)atoi(argv[1]);
-    int interval = 1000;
-    int samples = 1;
-    const char *out = NULL;
-    if (argc >= 3) interval = atoi(argv[2]);
-    if (argc >= 4) samples = atoi(argv[3]);
-    if (argc >= 5) out = argv[4];
-    return rp_run(pid, interval, samples, out);
+    /* Rates are over the recorded interval; samples default to all of them */
+    opts.interval_ms = interval_ms;
+    if (argc <= argi + 2 || opts.samples > ticks) opts.samples = ticks;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    int rc = rp_run_opts(&opts);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ms = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6;
+    fprintf(stderr, "replay: %d samples in %.1f ms (%.0f samples/s)\n", opts.samples, ms,
+            ms > 0 ? opts.samples * 1e3 / ms : 0.0);
+    sysroot_replay_stop();
+    return rc;
 }
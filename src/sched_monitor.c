@@ -0,0 +1,234 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <time.h>
+#include "../include/sched_monitor.h"
+#include "../include/sysroot.h"
+
+#define SCHED_MAX_CPUS 1024
+
+static int read_schedstat_file(const char *path, SchedStat *out) {
+    char buf[128];
+    int fd = sysroot_open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    ssize_t r = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (r <= 0) return -1;
+    buf[r] = '\0';
+    if (sscanf(buf, "%llu %llu %llu", &out->run_ns, &out->wait_ns, &out->timeslices) != 3) return -1;
+    return 0;
+}
+
+int read_task_schedstat(pid_t pid, pid_t tid, SchedStat *out) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/task/%d/schedstat", (int)pid, (int)tid);
+    return read_schedstat_file(path, out);
+}
+
+int read_process_schedstat(pid_t pid, SchedStat *out) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/task", (int)pid);
+    DIR *dir = sysroot_opendir(path);
+    if (!dir) return -1;
+
+    memset(out, 0, sizeof(*out));
+    int tasks = 0;
+    struct dirent *de;
+    while ((de = readdir(dir)) != NULL) {
+        if (de->d_name[0] < '0' || de->d_name[0] > '9') continue;
+        SchedStat t;
+        /* Threads may exit between readdir and open; skip them */
+        if (read_task_schedstat(pid, (pid_t)atoi(de->d_name), &t) != 0) continue;
+        out->run_ns += t.run_ns;
+        out->wait_ns += t.wait_ns;
+        out->timeslices += t.timeslices;
+        tasks++;
+    }
+    closedir(dir);
+    return tasks > 0 ? 0 : -1;
+}
+
+int sched_parse_system(const char *buf, CpuSchedStat *cpus, int max, int *version) {
+    int n = 0;
+    int ver = 0;
+    const char *line = buf;
+    while (line && *line) {
+        if (strncmp(line, "version ", 8) == 0) {
+            ver = atoi(line + 8);
+        } else if (strncmp(line, "cpu", 3) == 0 && line[3] >= '0' && line[3] <= '9' && n < max) {
+            /* cpuN yld_count legacy sched_count sched_goidle ttwu_count ttwu_local rq_cpu_time run_delay pcount */
+            CpuSchedStat *c = &cpus[n];
+            unsigned long long legacy;
+            if (sscanf(line + 3, "%d %llu %llu %llu %llu %llu %llu %llu %llu %llu",
+                       &c->cpu, &c->yld_count, &legacy, &c->sched_count, &c->sched_goidle,
+                       &c->ttwu_count, &c->ttwu_local,
+                       &c->s.run_ns, &c->s.wait_ns, &c->s.timeslices) == 10) {
+                n++;
+            }
+        }
+        line = strchr(line, '\n');
+        if (line) line++;
+    }
+    if (version) *version = ver;
+    /* Field layout of the cpu lines has been stable since version 15 */
+    if (ver < 15) return -1;
+    return n;
+}
+
+int read_system_schedstat(CpuSchedStat *cpus, int max, int *version) {
+    int fd = sysroot_open("/proc/schedstat", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    /* Each CPU also has one line per sched domain, so size by CPU count */
+    long ncpu = sysconf(_SC_NPROCESSORS_CONF);
+    size_t cap = (size_t)(ncpu > 0 ? ncpu : 1) * 2048 + 4096;
+    char *buf = malloc(cap);
+    if (!buf) { close(fd); return -1; }
+    size_t len = 0;
+    ssize_t r;
+    while ((r = read(fd, buf + len, cap - 1 - len)) > 0) {
+        len += (size_t)r;
+        if (len == cap - 1) {
+            char *nb = realloc(buf, cap * 2);
+            if (!nb) break;
+            buf = nb;
+            cap *= 2;
+        }
+    }
+    close(fd);
+    buf[len] = '\0';
+    int n = sched_parse_system(buf, cpus, max, version);
+    free(buf);
+    return n;
+}
+
+static unsigned long long clamp_sub(unsigned long long a, unsigned long long b) {
+    return a > b ? a - b : 0;
+}
+
+void sched_delta(const SchedStat *prev, const SchedStat *curr, SchedDelta *out) {
+    unsigned long long run = clamp_sub(curr->run_ns, prev->run_ns);
+    unsigned long long wait = clamp_sub(curr->wait_ns, prev->wait_ns);
+    out->timeslices = clamp_sub(curr->timeslices, prev->timeslices);
+    out->run_ms = run / 1e6;
+    out->wait_ms = wait / 1e6;
+    out->wait_run_ratio = run ? (double)wait / run : 0.0;
+    out->avg_wait_us = out->timeslices ? (wait / 1e3) / out->timeslices : 0.0;
+}
+
+void sched_hist_add(SchedHistogram *h, const SchedDelta *d) {
+    if (d->timeslices == 0) return;
+    unsigned long long us = (unsigned long long)d->avg_wait_us;
+    int b = 0;
+    while (us && b < SCHED_HIST_BUCKETS - 1) {
+        us >>= 1;
+        b++;
+    }
+    h->buckets[b] += d->timeslices;
+    h->count += d->timeslices;
+}
+
+double sched_hist_percentile(const SchedHistogram *h, double p) {
+    if (h->count == 0) return 0.0;
+    unsigned long long target = (unsigned long long)((p / 100.0) * h->count);
+    if (target == 0) target = 1;
+    unsigned long long seen = 0;
+    for (int b = 0; b < SCHED_HIST_BUCKETS; ++b) {
+        seen += h->buckets[b];
+        if (seen >= target) return (double)(1ULL << b);
+    }
+    return (double)(1ULL << (SCHED_HIST_BUCKETS - 1));
+}
+
+void sched_hist_print(FILE *out, const SchedHistogram *h) {
+    fprintf(out, "%-20s %12s %7s\n", "wait/slice (us)", "timeslices", "share");
+    for (int b = 0; b < SCHED_HIST_BUCKETS; ++b) {
+        if (!h->buckets[b]) continue;
+        char range[32];
+        if (b == 0) snprintf(range, sizeof(range), "< 1");
+        else snprintf(range, sizeof(range), "%llu - %llu", 1ULL << (b - 1), 1ULL << b);
+        fprintf(out, "%-20s %12llu %6.1f%%\n", range, h->buckets[b], 100.0 * h->buckets[b] / h->count);
+    }
+}
+
+int monitor_system_schedstat(int interval_ms, int samples, const char *output_file) {
+    if (interval_ms <= 0) interval_ms = 1000;
+    if (samples <= 0) samples = 1;
+
+    CpuSchedStat *prev = calloc(SCHED_MAX_CPUS, sizeof(CpuSchedStat));
+    CpuSchedStat *curr = calloc(SCHED_MAX_CPUS, sizeof(CpuSchedStat));
+    if (!prev || !curr) {
+        free(prev);
+        free(curr);
+        return -1;
+    }
+    int version = 0;
+    int nprev = read_system_schedstat(prev, SCHED_MAX_CPUS, &version);
+    if (nprev < 0) {
+        fprintf(stderr, "schedstat: /proc/schedstat unavailable or unsupported (version %d); kernel needs CONFIG_SCHEDSTATS\n", version);
+        free(prev);
+        free(curr);
+        return -1;
+    }
+
+    FILE *out = stdout;
+    if (output_file) {
+        out = fopen(output_file, "w");
+        if (!out) {
+            perror("fopen");
+            free(prev);
+            free(curr);
+            return -1;
+        }
+    }
+
+    fprintf(out, "timestamp_ms,cpu,run_ms,wait_ms,timeslices,wait_run_ratio,avg_wait_us\n");
+    int rc = 0;
+    for (int i = 0; i < samples; ++i) {
+        usleep((useconds_t)interval_ms * 1000);
+        int ncurr = read_system_schedstat(curr, SCHED_MAX_CPUS, &version);
+        if (ncurr < 0) { rc = -1; break; }
+
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        long long ms = (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+
+        SchedStat all_prev = {0}, all_curr = {0};
+        SchedDelta d;
+        /* CPUs can come and go with hotplug; match rows by CPU number */
+        for (int c = 0; c < ncurr; ++c) {
+            const CpuSchedStat *p = NULL;
+            for (int k = 0; k < nprev; ++k) {
+                if (prev[k].cpu == curr[c].cpu) { p = &prev[k]; break; }
+            }
+            if (!p) continue;
+            sched_delta(&p->s, &curr[c].s, &d);
+            fprintf(out, "%lld,%d,%.3f,%.3f,%llu,%.4f,%.2f\n",
+                    ms, curr[c].cpu, d.run_ms, d.wait_ms, d.timeslices, d.wait_run_ratio, d.avg_wait_us);
+            all_prev.run_ns += p->s.run_ns;
+            all_prev.wait_ns += p->s.wait_ns;
+            all_prev.timeslices += p->s.timeslices;
+            all_curr.run_ns += curr[c].s.run_ns;
+            all_curr.wait_ns += curr[c].s.wait_ns;
+            all_curr.timeslices += curr[c].s.timeslices;
+        }
+        sched_delta(&all_prev, &all_curr, &d);
+        fprintf(out, "%lld,all,%.3f,%.3f,%llu,%.4f,%.2f\n",
+                ms, d.run_ms, d.wait_ms, d.timeslices, d.wait_run_ratio, d.avg_wait_us);
+        fflush(out);
+
+        CpuSchedStat *tmp = prev;
+        prev = curr;
+        curr = tmp;
+        nprev = ncurr;
+    }
+
+    if (output_file) fclose(out);
+    free(prev);
+    free(curr);
+    return rc;
+}
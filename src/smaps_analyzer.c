@@ -0,0 +1,407 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../include/smaps_analyzer.h"
+#include "../include/sysroot.h"
+
+/* Memory map analyzer: streams /proc/<pid>/smaps through a fixed 64 KiB buffer.
+ * A VMA is a header line followed by "Key: value kB" lines; its counters are
+ * committed to the class (and file path) totals when the next header arrives.
+ */
+
+#define SMAPS_BUF_SIZE (64 * 1024)
+#define SMAPS_PATH_MAX 4096
+
+static const char *class_names[SMAPS_CLASS_COUNT] = {
+    "heap", "stack", "anon", "file", "shm", "hugetlb", "special"
+};
+
+const char *smaps_class_name(SmapsClass cls) {
+    return (cls >= 0 && cls < SMAPS_CLASS_COUNT) ? class_names[cls] : "?";
+}
+
+typedef struct {
+    SmapsClass cls;
+    int hugetlb_flag;
+    SmapsCounters c;
+    unsigned long long hugetlb_kb;  /* Shared_Hugetlb + Private_Hugetlb (not part of Rss) */
+    size_t path_len;
+    char path[SMAPS_PATH_MAX];
+} vma_t;
+
+static unsigned int hash_path(const char *s, size_t len) {
+    unsigned int h = 2166136261u;
+    for (size_t i = 0; i < len; ++i) h = (h ^ (unsigned char)s[i]) * 16777619u;
+    return h;
+}
+
+static void counters_add(SmapsCounters *dst, const SmapsCounters *src) {
+    dst->vmas += src->vmas;
+    dst->size_kb += src->size_kb;
+    dst->rss_kb += src->rss_kb;
+    dst->pss_kb += src->pss_kb;
+    dst->dirty_kb += src->dirty_kb;
+    dst->swap_kb += src->swap_kb;
+    dst->anon_huge_kb += src->anon_huge_kb;
+}
+
+static int index_grow(SmapsSnapshot *snap) {
+    unsigned int slots = snap->index_slots ? snap->index_slots * 2 : 1024;
+    int *index = calloc(slots, sizeof(int));
+    if (!index) return -1;
+    for (int i = 0; i < snap->nfiles; ++i) {
+        unsigned int j = snap->files[i].hash & (slots - 1);
+        while (index[j]) j = (j + 1) & (slots - 1);
+        index[j] = i + 1;
+    }
+    free(snap->index);
+    snap->index = index;
+    snap->index_slots = slots;
+    return 0;
+}
+
+static int find_file(const SmapsSnapshot *snap, const char *path, size_t len, unsigned int h) {
+    if (!snap->index_slots) return -1;
+    unsigned int mask = snap->index_slots - 1;
+    for (unsigned int j = h & mask; snap->index[j]; j = (j + 1) & mask) {
+        const SmapsFileEntry *e = &snap->files[snap->index[j] - 1];
+        const char *p = snap->paths + e->path_off;
+        if (e->hash == h && strncmp(p, path, len) == 0 && p[len] == '\0') return snap->index[j] - 1;
+    }
+    return -1;
+}
+
+static SmapsFileEntry *intern_file(SmapsSnapshot *snap, const char *path, size_t len) {
+    unsigned int h = hash_path(path, len);
+    int idx = find_file(snap, path, len, h);
+    if (idx >= 0) return &snap->files[idx];
+
+    if ((unsigned int)(snap->nfiles + 1) * 2 > snap->index_slots && index_grow(snap) != 0) return NULL;
+    if (snap->nfiles == snap->files_cap) {
+        int cap = snap->files_cap ? snap->files_cap * 2 : 256;
+        SmapsFileEntry *f = realloc(snap->files, (size_t)cap * sizeof(SmapsFileEntry));
+        if (!f) return NULL;
+        snap->files = f;
+        snap->files_cap = cap;
+    }
+    if (snap->paths_len + len + 1 > snap->paths_cap) {
+        size_t cap = snap->paths_cap ? snap->paths_cap * 2 : 64 * 1024;
+        while (cap < snap->paths_len + len + 1) cap *= 2;
+        char *p = realloc(snap->paths, cap);
+        if (!p) return NULL;
+        snap->paths = p;
+        snap->paths_cap = cap;
+    }
+    SmapsFileEntry *e = &snap->files[snap->nfiles];
+    memset(e, 0, sizeof(*e));
+    e->path_off = (unsigned int)snap->paths_len;
+    e->hash = h;
+    memcpy(snap->paths + snap->paths_len, path, len);
+    snap->paths[snap->paths_len + len] = '\0';
+    snap->paths_len += len + 1;
+
+    unsigned int mask = snap->index_slots - 1;
+    unsigned int j = h & mask;
+    while (snap->index[j]) j = (j + 1) & mask;
+    snap->index[j] = ++snap->nfiles;
+    return e;
+}
+
+static int commit_vma(SmapsSnapshot *snap, vma_t *v) {
+    if (v->c.vmas == 0) return 0;
+    if (v->hugetlb_flag) {
+        v->cls = SMAPS_HUGETLB;
+        v->c.rss_kb += v->hugetlb_kb;
+    }
+    counters_add(&snap->classes[v->cls], &v->c);
+    counters_add(&snap->total, &v->c);
+    if (v->cls == SMAPS_FILE) {
+        SmapsFileEntry *e = intern_file(snap, v->path, v->path_len);
+        if (!e) return -1;
+        counters_add(&e->c, &v->c);
+    }
+    v->c.vmas = 0;
+    return 0;
+}
+
+static SmapsClass classify(const char *path, size_t len) {
+    if (len == 0) return SMAPS_ANON;
+    if (path[0] == '[') {
+        if (strncmp(path, "[heap]", 6) == 0) return SMAPS_HEAP;
+        if (strncmp(path, "[stack", 6) == 0) return SMAPS_STACK;
+        if (strncmp(path, "[anon", 5) == 0) return SMAPS_ANON;
+        return SMAPS_SPECIAL;
+    }
+    if (strncmp(path, "/dev/shm/", 9) == 0 || strncmp(path, "/SYSV", 5) == 0 ||
+        strncmp(path, "/memfd:", 7) == 0) return SMAPS_SHM;
+    if (strncmp(path, "/anon_hugepage", 14) == 0) return SMAPS_HUGETLB;
+    return SMAPS_FILE;
+}
+
+/* "start-end perms offset dev inode   path" */
+static void parse_header(vma_t *v, const char *line, size_t len) {
+    const char *p = line, *end = line + len;
+    for (int field = 0; field < 5 && p < end; ++field) {
+        while (p < end && *p != ' ') p++;
+        while (p < end && *p == ' ') p++;
+    }
+    size_t plen = (size_t)(end - p);
+    if (plen >= sizeof(v->path)) plen = sizeof(v->path) - 1;
+    memcpy(v->path, p, plen);
+    v->path[plen] = '\0';
+    v->path_len = plen;
+    v->cls = classify(v->path, plen);
+    v->hugetlb_flag = 0;
+    v->hugetlb_kb = 0;
+    memset(&v->c, 0, sizeof(v->c));
+    v->c.vmas = 1;
+}
+
+static unsigned long long field_value(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == ':')) p++;
+    unsigned long long v = 0;
+    while (p < end && *p >= '0' && *p <= '9') v = v * 10 + (unsigned long long)(*p++ - '0');
+    return v;
+}
+
+#define KEY_IS(line, len, key) ((len) > sizeof(key) - 1 && memcmp((line), key, sizeof(key) - 1) == 0)
+
+static void parse_field(vma_t *v, const char *line, size_t len) {
+    const char *end = line + len;
+    switch (line[0]) {
+    case 'S':
+        if (KEY_IS(line, len, "Size:")) v->c.size_kb += field_value(line + 5, end);
+        else if (KEY_IS(line, len, "Shared_Dirty:")) v->c.dirty_kb += field_value(line + 13, end);
+        else if (KEY_IS(line, len, "Swap:")) v->c.swap_kb += field_value(line + 5, end);
+        else if (KEY_IS(line, len, "Shared_Hugetlb:")) v->hugetlb_kb += field_value(line + 15, end);
+        break;
+    case 'R':
+        if (KEY_IS(line, len, "Rss:")) v->c.rss_kb += field_value(line + 4, end);
+        break;
+    case 'P':
+        if (KEY_IS(line, len, "Pss:")) v->c.pss_kb += field_value(line + 4, end);
+        else if (KEY_IS(line, len, "Private_Dirty:")) v->c.dirty_kb += field_value(line + 14, end);
+        else if (KEY_IS(line, len, "Private_Hugetlb:")) v->hugetlb_kb += field_value(line + 16, end);
+        break;
+    case 'A':
+        if (KEY_IS(line, len, "AnonHugePages:")) v->c.anon_huge_kb += field_value(line + 14, end);
+        break;
+    case 'V':
+        /* VmFlags is the last line of a VMA; "ht" marks hugetlb mappings */
+        if (KEY_IS(line, len, "VmFlags:")) {
+            for (const char *p = line + 8; p + 1 < end; ++p) {
+                if (p[-1] == ' ' && p[0] == 'h' && p[1] == 't' && (p + 2 == end || p[2] == ' ')) {
+                    v->hugetlb_flag = 1;
+                    break;
+                }
+            }
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+int smaps_snapshot_parse_fd(int fd, SmapsSnapshot *snap) {
+    /* A reused snapshot keeps its tables and arena, emptied */
+    SmapsSnapshot keep = *snap;
+    memset(snap, 0, sizeof(*snap));
+    snap->pid = keep.pid;
+    snap->files = keep.files;
+    snap->files_cap = keep.files_cap;
+    snap->index = keep.index;
+    snap->index_slots = keep.index_slots;
+    snap->paths = keep.paths;
+    snap->paths_cap = keep.paths_cap;
+    if (snap->index) memset(snap->index, 0, snap->index_slots * sizeof(int));
+
+    char *buf = malloc(SMAPS_BUF_SIZE);
+    vma_t *v = calloc(1, sizeof(vma_t));
+    if (!buf || !v) { free(buf); free(v); return -1; }
+
+    size_t have = 0;
+    int rc = 0;
+    for (;;) {
+        ssize_t r = read(fd, buf + have, SMAPS_BUF_SIZE - have);
+        if (r < 0) { rc = -1; break; }
+        size_t avail = have + (size_t)r;
+        size_t start = 0;
+        for (;;) {
+            char *nl = memchr(buf + start, '\n', avail - start);
+            if (!nl) break;
+            size_t len = (size_t)(nl - (buf + start));
+            const char *line = buf + start;
+            if (len > 0) {
+                char c = line[0];
+                if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f')) {
+                    if (commit_vma(snap, v) != 0) { rc = -1; break; }
+                    parse_header(v, line, len);
+                } else if (v->c.vmas) {
+                    parse_field(v, line, len);
+                }
+            }
+            start += len + 1;
+        }
+        if (rc != 0) break;
+        if (r == 0) break;
+        /* Carry the incomplete tail line to the front of the buffer */
+        have = avail - start;
+        if (have == SMAPS_BUF_SIZE) have = 0; /* oversized line: drop it */
+        else if (start > 0) memmove(buf, buf + start, have);
+    }
+    if (rc == 0) rc = commit_vma(snap, v);
+    free(v);
+    free(buf);
+    return rc;
+}
+
+int smaps_snapshot_read(pid_t pid, SmapsSnapshot *snap) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/smaps", (int)pid);
+    int fd = sysroot_open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    snap->pid = pid;
+    int rc = smaps_snapshot_parse_fd(fd, snap);
+    close(fd);
+    if (rc == 0 && snap->total.vmas == 0) return -1; /* kernel thread or exited */
+    return rc;
+}
+
+void smaps_snapshot_free(SmapsSnapshot *snap) {
+    free(snap->files);
+    free(snap->index);
+    free(snap->paths);
+    memset(snap, 0, sizeof(*snap));
+}
+
+static void print_counters_header(FILE *out, const char *label) {
+    fprintf(out, "  %-56s %8s %12s %12s %12s %12s %12s\n",
+            label, "vmas", "rss_kb", "pss_kb", "dirty_kb", "swap_kb", "anonhuge_kb");
+}
+
+static void print_counters(FILE *out, const char *label, const SmapsCounters *c) {
+    fprintf(out, "  %-56.56s %8llu %12llu %12llu %12llu %12llu %12llu\n",
+            label, c->vmas, c->rss_kb, c->pss_kb, c->dirty_kb, c->swap_kb, c->anon_huge_kb);
+}
+
+static int cmp_file_rss(const void *a, const void *b, void *arg) {
+    const SmapsSnapshot *snap = arg;
+    const SmapsFileEntry *x = &snap->files[*(const int *)a];
+    const SmapsFileEntry *y = &snap->files[*(const int *)b];
+    if (x->c.rss_kb != y->c.rss_kb) return (x->c.rss_kb < y->c.rss_kb) ? 1 : -1;
+    return 0;
+}
+
+void smaps_print_report(FILE *out, const SmapsSnapshot *snap, int top_files) {
+    fprintf(out, "Memory map of pid %d\n", (int)snap->pid);
+    print_counters_header(out, "class");
+    for (int i = 0; i < SMAPS_CLASS_COUNT; ++i) print_counters(out, class_names[i], &snap->classes[i]);
+    print_counters(out, "total", &snap->total);
+
+    if (top_files <= 0 || snap->nfiles == 0) return;
+    int *order = malloc((size_t)snap->nfiles * sizeof(int));
+    if (!order) return;
+    for (int i = 0; i < snap->nfiles; ++i) order[i] = i;
+    qsort_r(order, (size_t)snap->nfiles, sizeof(int), cmp_file_rss, (void *)snap);
+    fprintf(out, "\nTop %d file-backed mappings by Rss\n", top_files);
+    print_counters_header(out, "path");
+    for (int i = 0; i < snap->nfiles && i < top_files; ++i) {
+        const SmapsFileEntry *e = &snap->files[order[i]];
+        print_counters(out, snap->paths + e->path_off, &e->c);
+    }
+    free(order);
+}
+
+typedef struct {
+    const char *path;
+    long long rss, pss, dirty, swap;
+} file_delta_t;
+
+static int cmp_delta(const void *a, const void *b) {
+    const file_delta_t *x = a, *y = b;
+    long long ax = x->rss < 0 ? -x->rss : x->rss;
+    long long ay = y->rss < 0 ? -y->rss : y->rss;
+    return (ax < ay) ? 1 : (ax > ay) ? -1 : 0;
+}
+
+static void print_delta(FILE *out, const char *label, long long vmas, long long rss,
+                        long long pss, long long dirty, long long swap, long long huge) {
+    fprintf(out, "  %-56.56s %+8lld %+12lld %+12lld %+12lld %+12lld %+12lld\n",
+            label, vmas, rss, pss, dirty, swap, huge);
+}
+
+#define D(after, before, f) ((long long)(after).f - (long long)(before).f)
+
+void smaps_print_diff(FILE *out, const SmapsSnapshot *before, const SmapsSnapshot *after, int top_files) {
+    fprintf(out, "Memory map growth of pid %d\n", (int)after->pid);
+    print_counters_header(out, "class");
+    for (int i = 0; i < SMAPS_CLASS_COUNT; ++i) {
+        const SmapsCounters *a = &after->classes[i], *b = &before->classes[i];
+        print_delta(out, class_names[i], D(*a, *b, vmas), D(*a, *b, rss_kb), D(*a, *b, pss_kb),
+                    D(*a, *b, dirty_kb), D(*a, *b, swap_kb), D(*a, *b, anon_huge_kb));
+    }
+    print_delta(out, "total", D(after->total, before->total, vmas), D(after->total, before->total, rss_kb),
+                D(after->total, before->total, pss_kb), D(after->total, before->total, dirty_kb),
+                D(after->total, before->total, swap_kb), D(after->total, before->total, anon_huge_kb));
+
+    if (top_files <= 0) return;
+    /* Paths present in either snapshot */
+    file_delta_t *d = calloc((size_t)(after->nfiles + before->nfiles) + 1, sizeof(file_delta_t));
+    if (!d) return;
+    int n = 0;
+    for (int i = 0; i < after->nfiles; ++i) {
+        const SmapsFileEntry *e = &after->files[i];
+        const char *p = after->paths + e->path_off;
+        int j = find_file(before, p, strlen(p), e->hash);
+        SmapsCounters zero = {0};
+        const SmapsCounters *b = (j >= 0) ? &before->files[j].c : &zero;
+        d[n++] = (file_delta_t){p, D(e->c, *b, rss_kb), D(e->c, *b, pss_kb), D(e->c, *b, dirty_kb), D(e->c, *b, swap_kb)};
+    }
+    for (int i = 0; i < before->nfiles; ++i) {
+        const SmapsFileEntry *e = &before->files[i];
+        const char *p = before->paths + e->path_off;
+        if (find_file(after, p, strlen(p), e->hash) >= 0) continue;
+        d[n++] = (file_delta_t){p, -(long long)e->c.rss_kb, -(long long)e->c.pss_kb,
+                                -(long long)e->c.dirty_kb, -(long long)e->c.swap_kb};
+    }
+    qsort(d, (size_t)n, sizeof(file_delta_t), cmp_delta);
+    fprintf(out, "\nTop %d file-backed Rss changes\n", top_files);
+    print_counters_header(out, "path");
+    for (int i = 0; i < n && i < top_files && d[i].rss != 0; ++i) {
+        print_delta(out, d[i].path, 0, d[i].rss, d[i].pss, d[i].dirty, d[i].swap, 0);
+    }
+    free(d);
+}
+
+int smaps_analyze(pid_t pid, int interval_ms, int top_files, const char *output_file) {
+    FILE *out = stdout;
+    if (output_file) {
+        out = fopen(output_file, "w");
+        if (!out) { perror("fopen"); return -1; }
+    }
+    SmapsSnapshot before = {0}, after = {0};
+    int rc = 0;
+    if (smaps_snapshot_read(pid, &before) != 0) {
+        fprintf(stderr, "smaps: cannot read /proc/%d/smaps\n", (int)pid);
+        rc = -1;
+    } else {
+        smaps_print_report(out, &before, top_files);
+    }
+    if (rc == 0 && interval_ms > 0) {
+        usleep((useconds_t)interval_ms * 1000);
+        if (smaps_snapshot_read(pid, &after) != 0) {
+            fprintf(stderr, "smaps: pid %d exited during the interval\n", (int)pid);
+            rc = -1;
+        } else {
+            fprintf(out, "\n");
+            smaps_print_diff(out, &before, &after, top_files);
+        }
+    }
+    smaps_snapshot_free(&before);
+    smaps_snapshot_free(&after);
+    if (output_file) fclose(out);
+    return rc;
+}
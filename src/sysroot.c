@@ -0,0 +1,303 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../include/sysroot.h"
+
+static pthread_once_t env_once = PTHREAD_ONCE_INIT;
+static char proc_root[PATH_MAX] = "/proc";
+static char sys_root[PATH_MAX] = "/sys";
+static char cgroup_root[PATH_MAX] = "/sys/fs/cgroup";
+
+static SysrootMode mode = SYSROOT_LIVE;
+static char session_dir[PATH_MAX];     /* record or replay directory */
+static int tick, ticks;                /* current tick (1-based), replay length */
+static long long tick_time_ms;
+
+static void set_tree(char *dst, const char *value) {
+    snprintf(dst, PATH_MAX, "%s", value);
+    size_t len = strlen(dst);
+    while (len > 1 && dst[len - 1] == '/') dst[--len] = '\0';
+    if (snprintf(cgroup_root, sizeof(cgroup_root), "%s/fs/cgroup", sys_root) >= (int)sizeof(cgroup_root)) {
+        cgroup_root[0] = '\0';
+    }
+}
+
+static int set_root_dir(const char *root) {
+    char proc[PATH_MAX], sys[PATH_MAX];
+    if (snprintf(proc, sizeof(proc), "%s/proc", root) >= (int)sizeof(proc) ||
+        snprintf(sys, sizeof(sys), "%s/sys", root) >= (int)sizeof(sys)) return -1;
+    set_tree(proc_root, proc);
+    set_tree(sys_root, sys);
+    return 0;
+}
+
+static void load_env(void) {
+    const char *root = getenv("RESMON_ROOT");
+    if (root && *root) set_root_dir(root);
+    const char *p = getenv("RESMON_PROC_ROOT");
+    if (p && *p) set_tree(proc_root, p);
+    const char *s = getenv("RESMON_SYS_ROOT");
+    if (s && *s) set_tree(sys_root, s);
+}
+
+/* The first lookup may come from any collector thread */
+static void init_from_env(void) {
+    pthread_once(&env_once, load_env);
+}
+
+const char *sysroot_proc(void) {
+    init_from_env();
+    return proc_root;
+}
+
+const char *sysroot_sys(void) {
+    init_from_env();
+    return sys_root;
+}
+
+const char *sysroot_cgroup(void) {
+    init_from_env();
+    return cgroup_root;
+}
+
+int sysroot_overridden(void) {
+    init_from_env();
+    return strcmp(proc_root, "/proc") != 0 || strcmp(sys_root, "/sys") != 0;
+}
+
+int sysroot_sys_overridden(void) {
+    init_from_env();
+    return strcmp(sys_root, "/sys") != 0;
+}
+
+int sysroot_set(const char *root) {
+    init_from_env();
+    set_tree(proc_root, "/proc");
+    set_tree(sys_root, "/sys");
+    load_env();
+    return root ? set_root_dir(root) : 0;
+}
+
+int sysroot_set_proc(const char *root) {
+    init_from_env();
+    set_tree(proc_root, root ? root : "/proc");
+    return 0;
+}
+
+int sysroot_set_sys(const char *root) {
+    init_from_env();
+    set_tree(sys_root, root ? root : "/sys");
+    return 0;
+}
+
+/* /proc/self and /proc/thread-self describe the monitor, not the target */
+static int is_self(const char *rest) {
+    static const char *const selves[2] = { "/self", "/thread-self" };
+    for (int i = 0; i < 2; ++i) {
+        size_t len = strlen(selves[i]);
+        if (strncmp(rest, selves[i], len) == 0 && (rest[len] == '/' || rest[len] == '\0')) return 1;
+    }
+    return 0;
+}
+
+/* Split a canonical path into its tree and the remainder ("/stat").
+ * Returns NULL for paths that are not redirected. */
+static const char *tree_of(const char *path, const char **rest, const char **name) {
+    static const struct { const char *prefix; size_t len; } trees[2] = { { "/proc", 5 }, { "/sys", 4 } };
+    for (int i = 0; i < 2; ++i) {
+        if (strncmp(path, trees[i].prefix, trees[i].len) != 0) continue;
+        const char *r = path + trees[i].len;
+        if (*r != '/' && *r != '\0') continue;
+        if (i == 0 && is_self(r)) return NULL;
+        *rest = r;
+        *name = trees[i].prefix + 1;
+        return i == 0 ? sysroot_proc() : sysroot_sys();
+    }
+    return NULL;
+}
+
+int sysroot_path(char *buf, size_t size, const char *path) {
+    const char *rest, *name;
+    const char *root = tree_of(path, &rest, &name);
+    int n = root ? snprintf(buf, size, "%s%s", root, rest) : snprintf(buf, size, "%s", path);
+    return (n < 0 || (size_t)n >= size) ? -1 : 0;
+}
+
+static int make_parents(char *path) {
+    for (char *p = strchr(path + 1, '/'); p; p = strchr(p + 1, '/')) {
+        *p = '\0';
+        int rc = mkdir(path, 0755);
+        *p = '/';
+        if (rc != 0 && errno != EEXIST) return -1;
+    }
+    return 0;
+}
+
+/* <session_dir>/<tick n>[/leaf] */
+static int tick_path(char *buf, size_t size, int n, const char *leaf) {
+    int len = snprintf(buf, size, "%s/%06d%s%s", session_dir, n, leaf ? "/" : "", leaf ? leaf : "");
+    return (len < 0 || (size_t)len >= size) ? -1 : 0;
+}
+
+/* Copy the live file into the current tick and return the copy's path */
+static int record_copy(const char *real, const char *name, const char *rest, char *copy, size_t size) {
+    char leaf[PATH_MAX];
+    if (snprintf(leaf, sizeof(leaf), "%s%s", name, rest) >= (int)sizeof(leaf) ||
+        tick_path(copy, size, tick, leaf) != 0) return -1;
+    int in = open(real, O_RDONLY | O_CLOEXEC);
+    if (in < 0) return -1;
+    int out = -1;
+    if (make_parents(copy) == 0) out = open(copy, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0) {
+        int err = errno;
+        close(in);
+        errno = err;
+        return -1;
+    }
+    char buf[65536];
+    ssize_t r;
+    int rc = 0;
+    while ((r = read(in, buf, sizeof(buf))) > 0) {
+        if (write(out, buf, (size_t)r) != r) { rc = -1; break; }
+    }
+    if (r < 0) rc = -1;
+    close(in);
+    close(out);
+    return rc;
+}
+
+/* Real path for a read: the recorded copy when recording */
+static int resolve_for_read(const char *path, char *buf, size_t size) {
+    const char *rest, *name;
+    const char *root = tree_of(path, &rest, &name);
+    if (!root) return snprintf(buf, size, "%s", path) < (int)size ? 0 : -1;
+    char real[PATH_MAX];
+    int n = snprintf(real, sizeof(real), "%s%s", root, rest);
+    if (n < 0 || (size_t)n >= sizeof(real)) return -1;
+    if (mode == SYSROOT_RECORD && tick > 0) return record_copy(real, name, rest, buf, size);
+    return snprintf(buf, size, "%s", real) < (int)size ? 0 : -1;
+}
+
+FILE *sysroot_fopen(const char *path, const char *fmode) {
+    char real[PATH_MAX];
+    int rd = (fmode[0] == 'r' && !strchr(fmode, '+'));
+    if ((rd ? resolve_for_read(path, real, sizeof(real)) : sysroot_path(real, sizeof(real), path)) != 0) return NULL;
+    return fopen(real, fmode);
+}
+
+int sysroot_open(const char *path, int flags) {
+    char real[PATH_MAX];
+    int rd = ((flags & O_ACCMODE) == O_RDONLY && !(flags & O_DIRECTORY));
+    if ((rd ? resolve_for_read(path, real, sizeof(real)) : sysroot_path(real, sizeof(real), path)) != 0) return -1;
+    return open(real, flags);
+}
+
+DIR *sysroot_opendir(const char *path) {
+    char real[PATH_MAX];
+    if (sysroot_path(real, sizeof(real), path) != 0) return NULL;
+    return opendir(real);
+}
+
+SysrootMode sysroot_mode(void) {
+    return mode;
+}
+
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int sysroot_record_start(const char *dir, int interval_ms) {
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) return -1;
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/interval_ms", dir);
+    FILE *f = fopen(path, "w");
+    if (!f) return -1;
+    fprintf(f, "%d\n", interval_ms);
+    fclose(f);
+    snprintf(session_dir, sizeof(session_dir), "%s", dir);
+    mode = SYSROOT_RECORD;
+    tick = 0;
+    return 0;
+}
+
+void sysroot_record_stop(void) {
+    if (mode == SYSROOT_RECORD) mode = SYSROOT_LIVE;
+}
+
+static int tick_exists(int n) {
+    char path[PATH_MAX];
+    struct stat st;
+    return tick_path(path, sizeof(path), n, NULL) == 0 && stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+static int replay_point(int n) {
+    char path[PATH_MAX];
+    if (tick_path(path, sizeof(path), n, NULL) != 0 || set_root_dir(path) != 0) return -1;
+    tick_time_ms = 0;
+    FILE *f = tick_path(path, sizeof(path), n, "time_ms") == 0 ? fopen(path, "r") : NULL;
+    if (f) {
+        if (fscanf(f, "%lld", &tick_time_ms) != 1) tick_time_ms = 0;
+        fclose(f);
+    }
+    return 0;
+}
+
+int sysroot_replay_start(const char *dir, int *interval_ms) {
+    init_from_env();
+    snprintf(session_dir, sizeof(session_dir), "%s", dir);
+    int n = 0;
+    while (tick_exists(n + 1)) n++;
+    if (n == 0) return 0;
+    if (interval_ms) {
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/interval_ms", dir);
+        FILE *f = fopen(path, "r");
+        if (f) {
+            if (fscanf(f, "%d", interval_ms) != 1) *interval_ms = 0;
+            fclose(f);
+        }
+    }
+    mode = SYSROOT_REPLAY;
+    ticks = n;
+    tick = 0;
+    /* Reads made before the first tick already see the recording */
+    return replay_point(1) == 0 ? n : -1;
+}
+
+void sysroot_replay_stop(void) {
+    if (mode != SYSROOT_REPLAY) return;
+    mode = SYSROOT_LIVE;
+    sysroot_set(NULL);
+}
+
+int sysroot_next_tick(void) {
+    if (mode == SYSROOT_LIVE) return 0;
+    if (mode == SYSROOT_REPLAY) {
+        if (tick >= ticks) return -1;
+        return replay_point(++tick) == 0 ? tick : -1;
+    }
+    char path[PATH_MAX];
+    if (tick_path(path, sizeof(path), ++tick, NULL) != 0) return -1;
+    if (mkdir(path, 0755) != 0 && errno != EEXIST) return -1;
+    tick_time_ms = now_ms();
+    FILE *f = tick_path(path, sizeof(path), tick, "time_ms") == 0 ? fopen(path, "w") : NULL;
+    if (f) {
+        fprintf(f, "%lld\n", tick_time_ms);
+        fclose(f);
+    }
+    return tick;
+}
+
+long long sysroot_time_ms(void) {
+    return (mode != SYSROOT_LIVE && tick_time_ms > 0) ? tick_time_ms : now_ms();
+}
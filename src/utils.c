@@ -85,6 +85,13 @@ int parse_line_value_ull(const char *line, const char *key, unsigned long long *
     return 0;
 }
 
+pid_t parse_pid_name(const char *name) {
+    if (name[0] < '1' || name[0] > '9') return 0;
+    char *end;
+    long v = strtol(name, &end, 10);
+    return (*end == '\0') ? (pid_t)v : 0;
+}
+
 void get_timestamp(char *buffer, size_t size) {
     time_t now = time(NULL);
     struct tm *tm_info = localtime(&now);
@@ -106,6 +113,24 @@ double calculate_rate(unsigned long long current, unsigned long long previous, d
     return (current - previous) / time_diff;
 }
 
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+void sort_doubles(double *values, int n) {
+    if (n > 1) qsort(values, (size_t)n, sizeof(double), cmp_double);
+}
+
+double percentile_sorted(const double *sorted, int n, double p) {
+    if (n <= 0) return 0.0;
+    if (p <= 0.0) return sorted[0];
+    if (p >= 100.0) return sorted[n - 1];
+    int rank = (int)((p / 100.0) * n + 0.999999);   /* nearest-rank */
+    if (rank < 1) rank = 1;
+    return sorted[rank - 1];
+}
+
 void log_message(const char *level, const char *format, ...) {
     char timestamp[64];
     get_timestamp(timestamp, sizeof(timestamp));
@@ -0,0 +1,140 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../include/cgroup_autoscale.h"
+#include "test_fixture.h"
+
+static int first_line_is(const char *dir, const char *name, const char *want) {
+    char path[600], buf[256] = "";
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+    if (!fgets(buf, sizeof(buf), f)) buf[0] = '\0';
+    fclose(f);
+    return strncmp(buf, want, strlen(want)) == 0;
+}
+
+static int check(const char *what, int ok) {
+    if (!ok) printf("test_cgroup_autoscale: %s wrong\n", what);
+    return ok ? 0 : 1;
+}
+
+int main(void) {
+    int failed = 0;
+    CgroupAutoscalePolicy p;
+    cgroup_autoscale_policy_default(&p);
+    CgroupAutoscaleTarget t;
+    memset(&t, 0, sizeof(t));
+    t.cpu = 1;
+    t.cpu_min_usec = 10000;
+    t.cpu_max_usec = 200000;
+    t.mem = 1;
+    t.mem_min = 16 << 20;
+    t.mem_max = 64 << 20;
+
+    /* The rule on its own */
+    CgroupAutoscaleState st = { 20000, 100000, 32 << 20, 0, 0 };
+    CgroupAutoscaleInput in;
+    CgroupAutoscaleDecision d;
+    memset(&in, 0, sizeof(in));
+    in.has_cpu = 1;
+    in.throttle_ratio = 0.5;
+    in.cpu_util = 1.0;
+    in.has_mem = 1;
+    in.memory_current = 20 << 20;
+    in.mem_some_avg10 = 5.0;                    /* between the thresholds: hold */
+    cgroup_autoscale_decide(&p, &t, &in, &st, &d);
+    failed |= check("throttled step", d.cpu_change && d.new_quota_usec == 25000 &&
+                    strcmp(d.cpu_reason, "throttled") == 0 && st.cpu_cooldown == p.cooldown_ticks &&
+                    !d.mem_change && !d.mem_reason);
+    st.quota_usec = d.new_quota_usec;
+    cgroup_autoscale_decide(&p, &t, &in, &st, &d);
+    failed |= check("cooldown", !d.cpu_change && strcmp(d.cpu_reason, "cooldown") == 0 &&
+                    st.cpu_cooldown == p.cooldown_ticks - 1);
+
+    st.cpu_cooldown = 0;
+    st.quota_usec = 200000;
+    cgroup_autoscale_decide(&p, &t, &in, &st, &d);
+    failed |= check("upper bound", !d.cpu_change && strcmp(d.cpu_reason, "at-max") == 0);
+
+    in.throttle_ratio = 0.0;
+    in.cpu_util = 0.1;
+    st.quota_usec = 100000;
+    cgroup_autoscale_decide(&p, &t, &in, &st, &d);
+    failed |= check("idle step", d.cpu_change && d.new_quota_usec == 90000 && strcmp(d.cpu_reason, "idle") == 0);
+    st.cpu_cooldown = 0;
+    st.quota_usec = 10000;
+    cgroup_autoscale_decide(&p, &t, &in, &st, &d);
+    failed |= check("idle at floor", !d.cpu_change && !d.cpu_reason);
+
+    st.quota_usec = -1;
+    in.has_cpu = 0;
+    cgroup_autoscale_decide(&p, &t, &in, &st, &d);
+    failed |= check("clamp max", d.cpu_change && d.new_quota_usec == 200000 && strcmp(d.cpu_reason, "clamp") == 0);
+
+    in.mem_some_avg10 = 40.0;
+    cgroup_autoscale_decide(&p, &t, &in, &st, &d);
+    failed |= check("memory pressure", d.mem_change && d.new_mem_high == (40ULL << 20) &&
+                    strcmp(d.mem_reason, "memory-pressure") == 0);
+    st.mem_cooldown = 0;
+    st.mem_high = 40 << 20;
+    in.mem_some_avg10 = 0.0;
+    in.memory_current = 30 << 20;               /* floor: 37.5M */
+    cgroup_autoscale_decide(&p, &t, &in, &st, &d);
+    failed |= check("headroom floor", d.mem_change && d.new_mem_high == 37.5 * (1 << 20) &&
+                    strcmp(d.mem_reason, "headroom") == 0);
+
+    /* The loop against a fake tree: two ticks */
+    char root[64];
+    if (!fixture_dir(root, sizeof(root), "test_cgroup_autoscale")) return 1;
+    char web[600], targets[600], logpath[600];
+    snprintf(web, sizeof(web), "%s/web", root);
+    snprintf(targets, sizeof(targets), "%s/targets", root);
+    snprintf(logpath, sizeof(logpath), "%s/log.csv", root);
+    mkdir(web, 0755);
+    fixture_put(web, "cpu.max", "20000 100000\n");
+    fixture_put(web, "cpu.stat", "usage_usec 1000\nnr_periods 10\nnr_throttled 0\n");
+    fixture_put(web, "cpu.pressure", "some avg10=0.00 avg60=0.00 avg300=0.00 total=0\n");
+    fixture_put(web, "memory.high", "max\n");
+    fixture_put(web, "memory.current", "8388608\n");
+    fixture_put(web, "memory.pressure", "some avg10=0.00 avg60=0.00 avg300=0.00 total=0\n"
+                                "full avg10=0.00 avg60=0.00 avg300=0.00 total=0\n");
+    fixture_put(root, "targets", "# cgroup  quota range  memory.high range\nweb cpu=10000-200000 mem=16M-64M\n");
+
+    CgroupAutoscaleTarget *tv = NULL;
+    int n = cgroup_autoscale_load(targets, &tv);
+    failed |= check("load", n == 1 && tv[0].cpu && tv[0].mem_max == (64ULL << 20));
+    FILE *log = fopen(logpath, "w+");
+    CgroupAutoscaler a;
+    if (n == 1 && log && cgroup_autoscale_init(&a, root, tv, n, NULL, 0, log) == 0) {
+        int w1 = cgroup_autoscale_tick(&a);
+        failed |= check("tick 1", w1 == 1 && first_line_is(web, "memory.high", "67108864") &&
+                        first_line_is(web, "cpu.max", "20000 100000"));
+        fixture_put(web, "cpu.stat", "usage_usec 2001000\nnr_periods 110\nnr_throttled 50\n");
+        int w2 = cgroup_autoscale_tick(&a);
+        failed |= check("tick 2", w2 == 1 && first_line_is(web, "cpu.max", "25000 100000"));
+        cgroup_autoscale_free(&a);
+
+        char buf[2048];
+        rewind(log);
+        size_t len = fread(buf, 1, sizeof(buf) - 1, log);
+        buf[len] = '\0';
+        failed |= check("log", strstr(buf, ",web,memory.high,max,67108864,clamp,") &&
+                        strstr(buf, ",web,cpu.max,20000,25000,throttled,0.5000,1.0000,") &&
+                        strstr(buf, ",web,memory.high,67108864,67108864,cooldown,"));
+    } else {
+        printf("test_cgroup_autoscale: init failed\n");
+        failed = 1;
+    }
+    if (log) fclose(log);
+    free(tv);
+
+    if (fixture_cleanup(root) != 0) failed = 1;
+
+    printf("test_cgroup_autoscale: %s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
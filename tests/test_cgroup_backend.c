@@ -0,0 +1,100 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../include/cgroup_backend.h"
+#include "test_fixture.h"
+
+static const char *mountinfo_hybrid =
+    "24 1 0:22 / /sys rw,nosuid - sysfs sysfs rw\n"
+    "32 24 0:28 / /sys/fs/cgroup rw,relatime - tmpfs tmpfs rw,mode=755\n"
+    "33 32 0:29 / /sys/fs/cgroup/cpu,cpuacct rw,relatime shared:9 - cgroup cgroup rw,cpu,cpuacct\n"
+    "36 32 0:32 / /sys/fs/cgroup/memory rw,relatime - cgroup cgroup rw,memory\n"
+    "39 32 0:35 / /sys/fs/cgroup/blkio rw,relatime - cgroup cgroup rw,blkio\n"
+    "41 32 0:37 / /sys/fs/cgroup/systemd rw,relatime - cgroup cgroup rw,xattr,name=systemd\n"
+    "42 32 0:38 / /sys/fs/cgroup/unified rw,relatime - cgroup2 cgroup2 rw,nsdelegate\n";
+
+int main(void) {
+    int failed = 0;
+    CgroupMounts m;
+    if (cgroup_mounts_parse(mountinfo_hybrid, &m) != 0 || m.mode != CG_MODE_HYBRID ||
+        strcmp(m.v2, "/sys/fs/cgroup/unified") != 0 || strcmp(m.v1[CG_V1_CPU], "/sys/fs/cgroup/cpu,cpuacct") != 0 ||
+        strcmp(m.v1[CG_V1_CPUACCT], m.v1[CG_V1_CPU]) != 0 || strcmp(m.v1[CG_V1_MEMORY], "/sys/fs/cgroup/memory") != 0) {
+        printf("test_cgroup_backend: hybrid mountinfo parsed wrong (mode %s)\n", cgroup_mode_name(m.mode));
+        failed = 1;
+    }
+    if (cgroup_mounts_parse("50 1 0:40 / /sys/fs/cgroup rw - cgroup2 cgroup2 rw\n", &m) != 0 || m.mode != CG_MODE_V2 ||
+        m.v1[CG_V1_MEMORY][0]) {
+        printf("test_cgroup_backend: v2 mountinfo parsed wrong\n");
+        failed = 1;
+    }
+
+    /* Fake v1 mounts: cpu and cpuacct co-mounted, memory and blkio separate */
+    char root[64];
+    if (!fixture_dir(root, sizeof(root), "test_cgroup_backend")) return 1;
+    memset(&m, 0, sizeof(m));
+    m.mode = CG_MODE_V1;
+    snprintf(m.v1[CG_V1_CPU], sizeof(m.v1[0]), "%s/cpu", root);
+    snprintf(m.v1[CG_V1_CPUACCT], sizeof(m.v1[0]), "%s/cpu", root);
+    snprintf(m.v1[CG_V1_MEMORY], sizeof(m.v1[0]), "%s/memory", root);
+    snprintf(m.v1[CG_V1_BLKIO], sizeof(m.v1[0]), "%s/blkio", root);
+    char dir[700];
+    const char *hier[] = { "cpu", "memory", "blkio" };
+    for (int h = 0; h < 3; ++h) {
+        snprintf(dir, sizeof(dir), "%s/%s", root, hier[h]);
+        mkdir(dir, 0755);
+        snprintf(dir, sizeof(dir), "%s/%s/web", root, hier[h]);
+        mkdir(dir, 0755);
+    }
+    snprintf(dir, sizeof(dir), "%s/cpu/web", root);
+    fixture_put(dir, "cpuacct.usage", "2500000\n");
+    fixture_put(dir, "cpuacct.stat", "user 100\nsystem 50\n");
+    fixture_put(dir, "cpu.stat", "nr_periods 40\nnr_throttled 10\nthrottled_time 3000000\n");
+    snprintf(dir, sizeof(dir), "%s/memory/web", root);
+    fixture_put(dir, "memory.usage_in_bytes", "1048576\n");
+    fixture_put(dir, "memory.stat", "cache 1\nrss 2\ntotal_cache 8192\ntotal_rss 4096\ntotal_shmem 12\n"
+                            "total_inactive_file 2048\ntotal_pgmajfault 3\n");
+    snprintf(dir, sizeof(dir), "%s/blkio/web", root);
+    fixture_put(dir, "blkio.throttle.io_service_bytes", "8:0 Read 100\n8:0 Write 200\n8:0 Sync 300\n8:0 Total 300\n"
+                                                "8:16 Read 10\n8:16 Write 20\nTotal 330\n");
+    fixture_put(dir, "blkio.throttle.io_serviced", "8:0 Read 1\n8:0 Write 2\n8:16 Read 3\n8:16 Write 4\nTotal 10\n");
+
+    CgroupBackend b;
+    CgroupSampler s;
+    if (cgroup_backend_v1(&b, &m, "") != 0 || b.version != 1 || b.primary != CG_V1_MEMORY || b.nsources != 7) {
+        printf("test_cgroup_backend: v1 backend wrong\n");
+        failed = 1;
+    } else if (cgroup_sampler_init_backend(&s, &b, 2) != 0 || s.count != 2) {
+        printf("test_cgroup_backend: v1 sampler init failed\n");
+        failed = 1;
+    } else {
+        cgroup_sampler_tick(&s);
+        int web = strcmp(s.nodes[1].path, "web") == 0 ? 1 : -1;
+        const CgroupSample *c = cgroup_sampler_get(&s, 0, web);
+        long hz = sysconf(_SC_CLK_TCK);
+        const unsigned int want = (1u << CG_FILE_CPU_STAT) | (1u << CG_FILE_MEMORY_CURRENT) |
+                                  (1u << CG_FILE_MEMORY_STAT) | (1u << CG_FILE_IO_STAT);
+        if (!c || c->valid != want || c->usage_usec != 2500 || c->user_usec != 100ULL * (1000000ULL / (unsigned long long)hz) ||
+            c->nr_throttled != 10 || c->throttled_usec != 3000 || c->memory_current != 1048576 ||
+            c->mem_anon != 4096 || c->mem_file != 8192 || c->memstat[CG_MEMSTAT_INACTIVE_FILE] != 2048 ||
+            c->io_rbytes != 110 || c->io_wbytes != 220 || c->io_rios != 4 || c->io_wios != 6) {
+            printf("test_cgroup_backend: v1 values not mapped onto CgroupSample\n");
+            failed = 1;
+        }
+        cgroup_sampler_free(&s);
+    }
+
+    /* A subtree of the v1 mounts */
+    if (cgroup_backend_v1(&b, &m, "web") != 0 || cgroup_sampler_init_backend(&s, &b, 2) != 0 || s.count != 1) {
+        printf("test_cgroup_backend: v1 subtree wrong\n");
+        failed = 1;
+    } else {
+        cgroup_sampler_free(&s);
+    }
+
+    if (fixture_cleanup(root) != 0) failed = 1;
+    printf("test_cgroup_backend: %s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
@@ -0,0 +1,77 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../include/cgroup_events.h"
+#include "test_fixture.h"
+
+static CgroupEvent seen[16];
+static char seen_cg[16][64];
+static int nseen;
+
+static void record(const CgroupEvent *ev, void *ctx) {
+    (void)ctx;
+    if (nseen >= 16) return;
+    seen[nseen] = *ev;
+    snprintf(seen_cg[nseen], sizeof(seen_cg[nseen]), "%s", ev->cgroup);
+    nseen++;
+}
+
+static const CgroupEvent *find(const char *cg, const char *event) {
+    for (int i = 0; i < nseen; ++i) {
+        if (strcmp(seen_cg[i], cg) == 0 && strcmp(seen[i].event, event) == 0) return &seen[i];
+    }
+    return NULL;
+}
+
+int main(void) {
+    char root[64];
+    if (!fixture_dir(root, sizeof(root), "test_cgroup_events")) return 1;
+    char child[512];
+    snprintf(child, sizeof(child), "%s/db", root);
+    mkdir(child, 0755);
+    fixture_put(child, "memory.events", "low 0\nhigh 5\nmax 0\noom 0\noom_kill 0\noom_group_kill 0\n");
+    fixture_put(child, "cgroup.events", "populated 1\nfrozen 0\n");
+
+    int failed = 0;
+    CgroupWatcher w;
+    if (cgroup_watcher_init(&w, root) != 0 || w.ngroups != 2 || w.nwatches != 2) {
+        printf("test_cgroup_events: init failed\n");
+        return 1;
+    }
+    /* Nothing changed yet: the initial read is only a baseline */
+    if (cgroup_watcher_poll(&w, 0, record, NULL) != 0) failed = 1;
+
+    fixture_put(child, "memory.events", "low 0\nhigh 7\nmax 0\noom 1\noom_kill 1\noom_group_kill 0\n");
+    fixture_put(child, "cgroup.events", "populated 0\nfrozen 0\n");
+    for (int i = 0; i < 5 && nseen < 4; ++i) cgroup_watcher_poll(&w, 200, record, NULL);
+    const CgroupEvent *high = find("db", "high"), *kill = find("db", "oom_kill"), *pop = find("db", "populated");
+    if (!high || high->delta != 2 || !kill || kill->value != 1 || !pop || pop->delta != -1 || find("db", "low")) {
+        printf("test_cgroup_events: change events wrong (%d seen)\n", nseen);
+        failed = 1;
+    }
+
+    /* A cgroup appearing later is picked up from the parent directory watch */
+    char staged[512], moved[512];
+    snprintf(staged, sizeof(staged), "%s.new", root);
+    snprintf(moved, sizeof(moved), "%s/cache", root);
+    mkdir(staged, 0755);
+    fixture_put(staged, "pids.events", "max 0\n");
+    if (rename(staged, moved) != 0) failed = 1;
+    cgroup_watcher_poll(&w, 200, record, NULL);
+    nseen = 0;
+    fixture_put(moved, "pids.events", "max 3\n");
+    for (int i = 0; i < 5 && nseen < 1; ++i) cgroup_watcher_poll(&w, 200, record, NULL);
+    const CgroupEvent *pmax = find("cache", "max");
+    if (w.ngroups != 3 || !pmax || strcmp(pmax->source, "pids") != 0 || pmax->delta != 3) {
+        printf("test_cgroup_events: new cgroup not watched\n");
+        failed = 1;
+    }
+    cgroup_watcher_free(&w);
+
+    if (fixture_cleanup(root) != 0) failed = 1;
+    printf("test_cgroup_events: %s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
@@ -0,0 +1,68 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "../include/cgroup_handle.h"
+#include "test_fixture.h"
+
+static CgroupHandle shared;
+static CgroupHandle fresh;          /* nothing read through it before the threads start */
+static pthread_barrier_t start;
+static int thread_failures;
+
+static void *reader(void *arg) {
+    (void)arg;
+    pthread_barrier_wait(&start);
+    for (int i = 0; i < 1000; ++i) {
+        unsigned long long v;
+        if (cgroup_handle_read_key(&fresh, CG_ATTR_CPU_STAT, "nr_throttled", &v) != 0 || v != 3) {
+            __atomic_add_fetch(&thread_failures, 1, __ATOMIC_RELAXED);
+        }
+    }
+    return NULL;
+}
+
+int main(void) {
+    char root[64];
+    if (!fixture_dir(root, sizeof(root), "test_cgroup_handle")) return 1;
+    fixture_put(root, "cpu.stat", "usage_usec 10\nnr_periods 5\nnr_throttled 3\n");
+    fixture_put(root, "memory.current", "4096\n");
+    fixture_put(root, "memory.max", "max\n");
+    fixture_put(root, "cpu.max", "max 100000\n");
+
+    int failed = 0;
+    if (cgroup_handle_open(&shared, root) != 0) { printf("test_cgroup_handle: open failed\n"); return 1; }
+
+    unsigned long long v = 0;
+    if (cgroup_handle_read_ull(&shared, CG_ATTR_MEMORY_CURRENT, &v) != 0 || v != 4096) failed = 1;
+    if (cgroup_handle_read_ull(&shared, CG_ATTR_MEMORY_MAX, &v) != 0 || v != ULLONG_MAX) failed = 1;
+    if (cgroup_handle_read_key(&shared, CG_ATTR_CPU_STAT, "missing", &v) == 0) failed = 1;
+    if (cgroup_handle_read_ull(&shared, CG_ATTR_PIDS_MAX, &v) == 0) failed = 1;  /* no such file */
+
+    if (cgroup_handle_write(&shared, CG_ATTR_CPU_MAX, "50000 100000\n") != 0) failed = 1;
+    char buf[64];
+    if (cgroup_handle_read(&shared, CG_ATTR_CPU_MAX, buf, sizeof(buf)) < 0 || strncmp(buf, "50000 100000", 12) != 0) failed = 1;
+    if (failed) printf("test_cgroup_handle: single-thread checks failed\n");
+
+    /* Many threads racing on the first open of the same attribute: a new
+     * handle, so CPU_STAT has no cached descriptor yet */
+    if (cgroup_handle_open(&fresh, root) != 0) { printf("test_cgroup_handle: second open failed\n"); return 1; }
+    pthread_t t[8];
+    pthread_barrier_init(&start, NULL, 8);
+    for (int i = 0; i < 8; ++i) pthread_create(&t[i], NULL, reader, NULL);
+    for (int i = 0; i < 8; ++i) pthread_join(t[i], NULL);
+    pthread_barrier_destroy(&start);
+    if (thread_failures) {
+        printf("test_cgroup_handle: %d concurrent reads failed\n", thread_failures);
+        failed = 1;
+    }
+    cgroup_handle_close(&fresh);
+    cgroup_handle_close(&shared);
+
+    if (fixture_cleanup(root) != 0) failed = 1;
+    printf("test_cgroup_handle: %s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
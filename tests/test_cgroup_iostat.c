@@ -0,0 +1,83 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../include/cgroup_iostat.h"
+#include "test_fixture.h"
+
+int main(void) {
+    int failed = 0;
+    CgroupIoDev devs[4];
+    const char *stat =
+        "8:0 rbytes=4096 wbytes=8192 rios=1 wios=2 dbytes=0 dios=0\n"
+        "259:0 rbytes=1 wbytes=2 rios=3 wios=4 dbytes=5 dios=6 cost.vrate=100.00 cost.usage=10 cost.wait=2000 "
+        "cost.indebt=0 cost.indelay=0 avg_lat=350 win=100\n";
+    if (cgroup_parse_io_stat_devices(stat, devs, 4) != 2 || devs[0].major != 8 || devs[0].wbytes != 8192 ||
+        devs[0].has_cost || devs[1].minor != 0 || devs[1].dios != 6 || devs[1].cost_wait != 2000 ||
+        !devs[1].has_lat || devs[1].avg_lat != 350) {
+        printf("test_cgroup_iostat: io.stat parse wrong\n");
+        failed = 1;
+    }
+
+    char root[64];
+    if (!fixture_dir(root, sizeof(root), "test_cgroup_iostat")) return 1;
+    char a[600], b[600];
+    snprintf(a, sizeof(a), "%s/a", root);
+    snprintf(b, sizeof(b), "%s/b", root);
+    mkdir(a, 0755);
+    mkdir(b, 0755);
+    fixture_put(a, "io.stat", "8:0 rbytes=0 wbytes=0 rios=0 wios=0 dbytes=0 dios=0\n");
+    fixture_put(b, "io.stat", "8:0 rbytes=0 wbytes=0 rios=0 wios=0 dbytes=0 dios=0\n");
+    fixture_put(b, "io.pressure", "some avg10=1.50 avg60=0.00 avg300=0.00 total=10\nfull avg10=0.50 avg60=0.00 avg300=0.00 total=5\n");
+
+    CgroupIoTop t;
+    CgroupIoRate rates[2];
+    if (cgroup_iotop_init(&t, root) != 0 || cgroup_iotop_tick(&t, 2, rates) != 0) {
+        printf("test_cgroup_iostat: init / baseline tick wrong\n");
+        failed = 1;
+    } else {
+        usleep(20000);
+        fixture_put(a, "io.stat", "8:0 rbytes=1000 wbytes=0 rios=10 wios=0 dbytes=0 dios=0\n");
+        fixture_put(b, "io.stat", "8:0 rbytes=0 wbytes=900000 rios=0 wios=90 dbytes=0 dios=0\n");
+        int n = cgroup_iotop_tick(&t, 2, rates);
+        if (n != 2 || strcmp(t.s.nodes[rates[0].node].path, "b") != 0 || rates[0].wbps <= rates[1].rbps ||
+            rates[0].io_some_avg10 != 1.5 || rates[1].io_some_avg10 != -1.0 || rates[0].avg_lat_us != -1 ||
+            !rates[0].device) {
+            printf("test_cgroup_iostat: rates / ranking wrong (n %d)\n", n);
+            failed = 1;
+        }
+        /* No new IO: nothing reported */
+        if (cgroup_iotop_tick(&t, 2, rates) != 0) {
+            printf("test_cgroup_iostat: idle tick reported entries\n");
+            failed = 1;
+        }
+        /* A removed cgroup's baseline is dropped once the sampler no longer sees it */
+        char stat_b[700];
+        snprintf(stat_b, sizeof(stat_b), "%s/io.stat", b);
+        unlink(stat_b);
+        unlink(strcat(strcpy(stat_b, b), "/io.pressure"));
+        rmdir(b);
+        if (cgroup_sampler_rescan(&t.s) != 0 || cgroup_iotop_tick(&t, 2, rates) != 0 || t.used != 1) {
+            printf("test_cgroup_iostat: stale baseline kept (used %u)\n", t.used);
+            failed = 1;
+        }
+        /* More devices than the initial parse scratch: none is dropped */
+        char many[70 * 64] = "";
+        for (int d = 0; d < 70; ++d) {
+            size_t len = strlen(many);
+            snprintf(many + len, sizeof(many) - len, "8:%d rbytes=0 wbytes=0 rios=0 wios=0 dbytes=0 dios=0\n", d * 16);
+        }
+        fixture_put(a, "io.stat", many);
+        if (cgroup_iotop_tick(&t, 2, rates) != 0 || t.used != 70) {
+            printf("test_cgroup_iostat: devices dropped (used %u)\n", t.used);
+            failed = 1;
+        }
+        cgroup_iotop_free(&t);
+    }
+
+    if (fixture_cleanup(root) != 0) failed = 1;
+    printf("test_cgroup_iostat: %s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
@@ -0,0 +1,102 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../include/cgroup_limits.h"
+#include "test_fixture.h"
+
+/* First line of a fake attribute file (pwrite at offset 0 leaves old tails behind) */
+static int first_line_is(const char *dir, const char *name, const char *want) {
+    char path[600], buf[256] = "";
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+    if (!fgets(buf, sizeof(buf), f)) buf[0] = '\0';
+    fclose(f);
+    return strncmp(buf, want, strlen(want)) == 0;
+}
+
+int main(void) {
+    int failed = 0;
+    CgroupLimitBatch b;
+
+    /* Syntax and normalization */
+    cgroup_limits_init(&b);
+    cgroup_limits_add_line(&b, "# comment", 1);
+    cgroup_limits_add_line(&b, "a cpu.max 50000/100000", 2);
+    cgroup_limits_add_line(&b, "a memory.max 2M\n", 3);
+    cgroup_limits_add_line(&b, "a io.max 8:0 rbps=1048576  wbps=max", 4);
+    cgroup_limits_add_line(&b, "a cpu.weight 0", 5);
+    cgroup_limits_add_line(&b, "a io.max 8:0 rbps=fast", 6);
+    cgroup_limits_add_line(&b, "a pids.max 10", 7);
+    cgroup_limits_add_line(&b, "../etc cpu.weight 10", 8);
+    if (b.count != 7 || b.invalid != 3 || strcmp(b.entries[0].value, "50000 100000\n") != 0 ||
+        strcmp(b.entries[1].value, "2097152\n") != 0 || strcmp(b.entries[2].value, "8:0 rbps=1048576 wbps=max\n") != 0 ||
+        b.entries[3].status != CG_LIMIT_INVALID || b.entries[5].status != CG_LIMIT_INVALID) {
+        printf("test_cgroup_limits: parse wrong (count %d invalid %d)\n", b.count, b.invalid);
+        failed = 1;
+    }
+    cgroup_limits_free(&b);
+
+    char root[64];
+    if (!fixture_dir(root, sizeof(root), "test_cgroup_limits")) return 1;
+    char a[600], c[600];
+    snprintf(a, sizeof(a), "%s/a", root);
+    snprintf(c, sizeof(c), "%s/c", root);
+    mkdir(a, 0755);
+    mkdir(c, 0755);
+    fixture_put(a, "cpu.max", "max 100000\n");
+    fixture_put(a, "io.max", "");
+    fixture_put(c, "memory.max", "max\n");
+
+    /* Validation rejects the whole batch: missing controller file and a duplicate */
+    cgroup_limits_init(&b);
+    cgroup_limits_add_line(&b, "a cpu.max 20000 100000", 1);
+    cgroup_limits_add_line(&b, "a memory.max 1G", 2);
+    cgroup_limits_add_line(&b, "a cpu.max max", 3);
+    if (cgroup_limits_validate(&b, root) != 2 || cgroup_limits_apply(&b, 4, 1) != -1 ||
+        !first_line_is(a, "cpu.max", "max 100000")) {
+        printf("test_cgroup_limits: validation did not block the batch\n");
+        failed = 1;
+    }
+    cgroup_limits_free(&b);
+
+    /* Successful parallel apply */
+    cgroup_limits_init(&b);
+    cgroup_limits_add_line(&b, "a cpu.max 20000 100000", 1);
+    cgroup_limits_add_line(&b, "a io.max 8:0 wbps=1000", 2);
+    cgroup_limits_add_line(&b, "c memory.max 1G", 3);
+    if (cgroup_limits_validate(&b, root) != 0 || strcmp(b.entries[1].old, "8:0 rbps=max wbps=max riops=max wiops=max\n") ||
+        cgroup_limits_apply(&b, 3, 1) != 0 || !first_line_is(a, "cpu.max", "20000 100000") ||
+        !first_line_is(c, "memory.max", "1073741824")) {
+        printf("test_cgroup_limits: apply wrong\n");
+        failed = 1;
+    }
+    cgroup_limits_free(&b);
+
+    /* A write failing after validation rolls back the entries already applied */
+    cgroup_limits_init(&b);
+    cgroup_limits_add_line(&b, "a cpu.max 30000 100000", 1);
+    cgroup_limits_add_line(&b, "c memory.max 2G", 2);
+    if (cgroup_limits_validate(&b, root) != 0) {
+        printf("test_cgroup_limits: rollback batch did not validate\n");
+        failed = 1;
+    } else {
+        char path[700];
+        snprintf(path, sizeof(path), "%s/memory.max", c);
+        unlink(path);
+        mkdir(path, 0755);   /* opening it for writing now fails with EISDIR */
+        if (cgroup_limits_apply(&b, 1, 1) != -1 || b.failed != 1 ||
+            b.entries[0].status != CG_LIMIT_ROLLED_BACK || !first_line_is(a, "cpu.max", "20000 100000")) {
+            printf("test_cgroup_limits: rollback wrong (status %d)\n", b.entries[0].status);
+            failed = 1;
+        }
+    }
+    cgroup_limits_free(&b);
+
+    if (fixture_cleanup(root) != 0) failed = 1;
+    printf("test_cgroup_limits: %s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
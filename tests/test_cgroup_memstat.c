@@ -0,0 +1,60 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include "../include/cgroup_memstat.h"
+
+static const char *stat_t0 =
+    "anon 1000\nfile 5000\nkernel 300\nkernel_stack 16\npagetables 20\nsock 0\nshmem 7\n"
+    "file_mapped 100\nfile_dirty 0\ninactive_anon 10\nactive_anon 990\ninactive_file 4000\n"
+    "active_file 1000\nunevictable 0\nslab 64\nworkingset_refault_anon 0\nworkingset_refault_file 100\n"
+    "workingset_activate_anon 0\nworkingset_activate_file 10\npgscan 500\npgsteal 400\nsome_future_key 9\n";
+
+static const char *stat_t1 =
+    "anon 1200\nfile 5100\nkernel 300\nkernel_stack 16\npagetables 20\nsock 0\nshmem 7\n"
+    "file_mapped 100\nfile_dirty 0\ninactive_anon 10\nactive_anon 990\ninactive_file 4100\n"
+    "active_file 1000\nunevictable 0\nslab 64\nworkingset_refault_anon 20\nworkingset_refault_file 300\n"
+    "workingset_activate_anon 0\nworkingset_activate_file 30\npgscan 1500\npgsteal 900\nsome_future_key 9\n";
+
+/* Pre-5.9 layout: different line order and combined workingset counters */
+static const char *stat_old = "file 77\nanon 33\ninactive_file 50\nworkingset_refault 12";
+
+int main(void) {
+    int failed = 0;
+    CgroupMemStatLayout layout;
+    unsigned long long v0[CG_MEMSTAT_COUNT], v1[CG_MEMSTAT_COUNT];
+    cgroup_memstat_layout_init(&layout);
+
+    if (cgroup_memstat_parse(&layout, stat_t0, v0) != 22 || v0[CG_MEMSTAT_INACTIVE_FILE] != 4000 ||
+        v0[CG_MEMSTAT_PGSCAN] != 500 || v0[CG_MEMSTAT_ZSWAP] != 0) {
+        printf("test_cgroup_memstat: first parse wrong\n");
+        failed = 1;
+    }
+    /* Same kernel, same layout: no rebuild */
+    if (cgroup_memstat_parse(&layout, stat_t1, v1) != 22 || layout.rebuilds != 1 ||
+        v1[CG_MEMSTAT_ANON] != 1200 || v1[CG_MEMSTAT_WORKINGSET_REFAULT_FILE] != 300) {
+        printf("test_cgroup_memstat: layout reuse wrong (rebuilds %d)\n", layout.rebuilds);
+        failed = 1;
+    }
+
+    CgroupMemDerived d;
+    cgroup_memstat_derive(10000, v1, v0, 2.0, &d);
+    if (d.working_set != 5900 || d.refault_per_s != 110.0 || d.activate_per_s != 10.0 ||
+        d.pgscan_per_s != 500.0 || d.reclaim_efficiency != 0.5) {
+        printf("test_cgroup_memstat: derived metrics wrong (ws %llu refault %.1f)\n", d.working_set, d.refault_per_s);
+        failed = 1;
+    }
+    cgroup_memstat_derive(100, v1, NULL, 1.0, &d);
+    if (d.working_set != 0 || d.refault_per_s != 0.0) {
+        printf("test_cgroup_memstat: first-sample derive wrong\n");
+        failed = 1;
+    }
+
+    unsigned long long vo[CG_MEMSTAT_COUNT];
+    if (cgroup_memstat_parse(&layout, stat_old, vo) != 4 || layout.rebuilds != 2 ||
+        vo[CG_MEMSTAT_FILE] != 77 || vo[CG_MEMSTAT_WORKINGSET_REFAULT] != 12 || vo[CG_MEMSTAT_PGSCAN] != 0) {
+        printf("test_cgroup_memstat: layout change not detected\n");
+        failed = 1;
+    }
+    printf("test_cgroup_memstat: %s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
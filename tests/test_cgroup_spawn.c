@@ -0,0 +1,115 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "../include/cgroup_spawn.h"
+#include "test_fixture.h"
+
+static int child_exit(void *arg) {
+    return *(int *)arg;
+}
+
+/* Cgroup the given pid is in on the v2 hierarchy ("0::/path") */
+static int v2_cgroup_of(pid_t pid, char *out, size_t len) {
+    char path[64], line[512];
+    snprintf(path, sizeof(path), "/proc/%d/cgroup", (int)pid);
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    int found = -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "0::", 3) == 0) {
+            snprintf(out, len, "%.*s", (int)strcspn(line + 3, "\n"), line + 3);
+            found = 0;
+        }
+    }
+    fclose(f);
+    return found;
+}
+
+int main(void) {
+    int failed = 0;
+
+    /* A plain directory is not a cgroup: clone3 refuses it and the fork + self-move
+     * fallback writes "0" into the fake cgroup.procs */
+    char root[64];
+    if (!fixture_dir(root, sizeof(root), "test_cgroup_spawn")) return 1;
+    char procs[600];
+    snprintf(procs, sizeof(procs), "%s/cgroup.procs", root);
+    FILE *f = fopen(procs, "w");
+    if (f) fclose(f);
+
+    CgroupHandle h;
+    int code = 7, status = 0;
+    pid_t pid = -1;
+    if (cgroup_handle_open(&h, root) == 0) {
+        pid = cgroup_spawn_fn(&h, child_exit, &code);
+        cgroup_handle_close(&h);
+    }
+    if (pid <= 0 || waitpid(pid, &status, 0) != pid || WEXITSTATUS(status) != 7 ||
+        cgroup_spawn_last_method() != CG_SPAWN_FORK_MOVE) {
+        printf("test_cgroup_spawn: fork+move fallback wrong\n");
+        failed = 1;
+    }
+    f = fopen(procs, "r");
+    char buf[16] = "";
+    if (!f || !fgets(buf, sizeof(buf), f) || strcmp(buf, "0\n") != 0) {
+        printf("test_cgroup_spawn: child did not move itself\n");
+        failed = 1;
+    }
+    if (f) fclose(f);
+
+    /* exec failures come back as errno instead of a pid */
+    char *bad[] = { "/nonexistent/binary", NULL };
+    if (cgroup_handle_open(&h, root) == 0) {
+        errno = 0;
+        if (cgroup_spawn_exec(&h, bad) != -1 || errno != ENOENT) {
+            printf("test_cgroup_spawn: exec failure not reported\n");
+            failed = 1;
+        }
+        cgroup_handle_close(&h);
+    }
+    unlink(procs);
+    rmdir(root);
+
+    /* Real cgroup v2 (needs root and a writable v2 hierarchy): the child must be
+     * inside the cgroup from the start */
+    const char *bases[] = { "/sys/fs/cgroup/unified", "/sys/fs/cgroup" };
+    for (int b = 0; b < 2; ++b) {
+        char cg[256], probe[300];
+        snprintf(probe, sizeof(probe), "%s/cgroup.subtree_control", bases[b]);
+        if (access(probe, F_OK) != 0 && b == 0) continue;
+        snprintf(cg, sizeof(cg), "%s/test_cgroup_spawn.%d", bases[b], (int)getpid());
+        if (mkdir(cg, 0755) != 0) {
+            printf("test_cgroup_spawn: no writable cgroup v2 hierarchy, skipping live check\n");
+            break;
+        }
+        char *cmd[] = { "sh", "-c", "exit 3", NULL };
+        if (cgroup_handle_open(&h, cg) == 0) {
+            pid = cgroup_spawn_fn(&h, child_exit, &code);
+            char where[256] = "";
+            int in_cg = (pid > 0 && v2_cgroup_of(pid, where, sizeof(where)) == 0 &&
+                         strstr(where, "test_cgroup_spawn.") != NULL);
+            if (pid > 0) waitpid(pid, &status, 0);
+            if (!in_cg || cgroup_spawn_last_method() != CG_SPAWN_CLONE3) {
+                printf("test_cgroup_spawn: child not born in cgroup (method %d, at %s)\n",
+                       cgroup_spawn_last_method(), where);
+                failed = 1;
+            }
+            pid = cgroup_spawn_exec(&h, cmd);
+            if (pid <= 0 || waitpid(pid, &status, 0) != pid || WEXITSTATUS(status) != 3) {
+                printf("test_cgroup_spawn: exec in cgroup wrong\n");
+                failed = 1;
+            }
+            cgroup_handle_close(&h);
+        }
+        rmdir(cg);
+        break;
+    }
+
+    printf("test_cgroup_spawn: %s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
@@ -0,0 +1,54 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../include/cgroup_throttle.h"
+#include "test_fixture.h"
+
+int main(void) {
+    int failed = 0;
+
+    double v[] = {5, 1, 4, 2, 3, 10, 6, 7, 8, 9};
+    if (cgroup_throttle_percentile(v, 10, 50) != 5 || cgroup_throttle_percentile(v, 10, 99) != 10 ||
+        cgroup_throttle_percentile(v, 10, 90) != 9) {
+        printf("test_cgroup_throttle: percentile wrong\n");
+        failed = 1;
+    }
+    /* 10 periods, 400 ms used + 300 ms throttled -> 70 ms of demand per period */
+    if (cgroup_throttle_demand(400000, 300000, 10) != 70000.0 || cgroup_throttle_demand(1, 1, 0) != 0.0) {
+        printf("test_cgroup_throttle: demand wrong\n");
+        failed = 1;
+    }
+    double d[] = {20000.0, 50500.0, 30000.0, 70100.0};
+    if (cgroup_throttle_suggest_quota(d, 4, 75) != 51000 || cgroup_throttle_suggest_quota(d, 0, 99) != -1) {
+        printf("test_cgroup_throttle: quota suggestion wrong\n");
+        failed = 1;
+    }
+
+    /* Only cgroups exposing cpu.max (CPU controller enabled) are analyzed */
+    char root[64];
+    if (!fixture_dir(root, sizeof(root), "test_cgroup_throttle")) return 1;
+    char limited[512], plain[512];
+    snprintf(limited, sizeof(limited), "%s/batch", root);
+    snprintf(plain, sizeof(plain), "%s/misc", root);
+    mkdir(limited, 0755);
+    mkdir(plain, 0755);
+    fixture_put(limited, "cpu.max", "50000 100000\n");
+    fixture_put(limited, "cpu.stat", "usage_usec 100\nnr_periods 10\nnr_throttled 5\nthrottled_usec 900\n");
+    fixture_put(plain, "cpu.stat", "usage_usec 100\n");
+
+    CgroupThrottleStat *stats = NULL;
+    int n = cgroup_throttle_analyze(root, 1, 2, 99.0, &stats);
+    if (n != 1 || strcmp(stats[0].path, "batch") != 0 || stats[0].quota_usec != 50000 ||
+        stats[0].period_usec != 100000 || stats[0].suggested_quota_usec != -1) {
+        printf("test_cgroup_throttle: analyze wrong (n=%d)\n", n);
+        failed = 1;
+    }
+    free(stats);
+
+    if (fixture_cleanup(root) != 0) failed = 1;
+    printf("test_cgroup_throttle: %s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
@@ -0,0 +1,32 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "../include/experiments.h"
+
+int main(void) {
+    int failed = 0;
+    if (geteuid() != 0) {
+        printf("test_experiment_cpu_throttling: OK (skipped, needs root)\n");
+        return 0;
+    }
+    /* Unlimited reference and a 20% quota on a short period, one after the other */
+    ThrottleCell cells[2] = { { 0, 10000, 0 }, { 20, 10000, 0 } };
+    ThrottleCellResult r[2];
+    if (experiment_throttle_run(cells, 2, 400, 1, r) != 0) {
+        printf("test_experiment_cpu_throttling: OK (skipped, no writable cpu controller)\n");
+        return 0;
+    }
+    if (r[0].error[0] || r[1].error[0] || r[0].quota_us != -1 || r[1].quota_us != 2000 ||
+        r[1].configured_percent != 20.0) {
+        printf("test_experiment_cpu_throttling: cell setup wrong (%s%s)\n", r[0].error, r[1].error);
+        failed = 1;
+    } else if (r[1].achieved_percent > 30.0 || r[1].achieved_percent <= 0.0 || r[1].nr_throttled == 0 ||
+               r[1].nr_periods < r[1].nr_throttled || r[0].nr_throttled != 0 || r[1].units_per_sec <= 0) {
+        printf("test_experiment_cpu_throttling: implausible accounting (achieved %.1f%%, %llu/%llu throttled)\n",
+               r[1].achieved_percent, r[1].nr_throttled, r[1].nr_periods);
+        failed = 1;
+    }
+
+    printf("test_experiment_cpu_throttling: %s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
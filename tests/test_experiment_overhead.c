@@ -0,0 +1,27 @@
+#include <stdio.h>
+#include <string.h>
+#include "../include/experiments.h"
+
+int main(void) {
+    int failed = 0;
+    if (overhead_workload_from_name("memory") != OVH_WORK_MEMORY || overhead_monitor_from_name("cgroup") != OVH_MON_CGROUP ||
+        overhead_workload_from_name("disk") != -1 || strcmp(overhead_monitor_name(OVH_MON_PROCTREE), "proctree") != 0) {
+        printf("test_experiment_overhead: name lookup wrong\n");
+        failed = 1;
+    }
+
+    OverheadCase c = { OVH_WORK_CPU, OVH_MON_PROCTREE, 50, 2, 200, 0 };
+    OverheadCaseResult r;
+    if (experiment_overhead_run(&c, &r) != 0) {
+        printf("test_experiment_overhead: run failed\n");
+        failed = 1;
+    } else if (r.base_ops <= 0 || r.mon_ops <= 0 || r.observations_per_sec <= 0 || r.base_ci < 0 ||
+               r.monitor_cpu_percent < 0 || r.c.trials != 2) {
+        printf("test_experiment_overhead: implausible result (base %.1f mon %.1f obs %.1f)\n",
+               r.base_ops, r.mon_ops, r.observations_per_sec);
+        failed = 1;
+    }
+
+    printf("test_experiment_overhead: %s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
@@ -0,0 +1,37 @@
+#ifndef TEST_FIXTURE_H
+#define TEST_FIXTURE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Scratch-directory helpers for the tests that build fake /proc, /sys or
+ * cgroup trees under /tmp. */
+
+/* Create /tmp/<test>.XXXXXX into buf; NULL (with a message) on failure */
+static inline char *fixture_dir(char *buf, size_t len, const char *test) {
+    snprintf(buf, len, "/tmp/%s.XXXXXX", test);
+    if (!mkdtemp(buf)) {
+        printf("%s: mkdtemp failed\n", test);
+        return NULL;
+    }
+    return buf;
+}
+
+/* Write text to dir/name, replacing the file */
+static inline void fixture_put(const char *dir, const char *name, const char *text) {
+    char path[600];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    FILE *f = fopen(path, "w");
+    if (!f) return;
+    fputs(text, f);
+    fclose(f);
+}
+
+/* Remove the scratch tree; 0 on success */
+static inline int fixture_cleanup(const char *dir) {
+    char cmd[700];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+    return system(cmd) == 0 ? 0 : -1;
+}
+
+#endif // TEST_FIXTURE_H
@@ -0,0 +1,105 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "../include/memory_accounting.h"
+#include "../include/sysroot.h"
+#include "test_fixture.h"
+
+#define ROLLUP "5607209f2000-7ffdd3d54000 ---p 00000000 00:00 0                          [rollup]\n" \
+               "Rss:                1416 kB\nPss:                 467 kB\nPss_Dirty:           100 kB\n" \
+               "Pss_Anon:            100 kB\nPss_File:            367 kB\nPss_Shmem:             0 kB\n" \
+               "Shared_Clean:       1248 kB\nShared_Dirty:          0 kB\nPrivate_Clean:        68 kB\n" \
+               "Private_Dirty:       100 kB\nAnonymous:           100 kB\nSwap:                 12 kB\n" \
+               "SwapPss:                6 kB\n"
+
+static void add_task(const char *host, int pid, const char *rollup) {
+    char dir[128];
+    snprintf(dir, sizeof(dir), "%s/proc/%d", host, pid);
+    mkdir(dir, 0755);
+    fixture_put(dir, "smaps_rollup", rollup);
+}
+
+int main(void) {
+    int failed = 0;
+    char host[64], dir[128];
+    if (!fixture_dir(host, sizeof(host), "test_memory_accounting")) return 1;
+    snprintf(dir, sizeof(dir), "%s/proc", host);
+    mkdir(dir, 0755);
+    add_task(host, 10, ROLLUP);
+    add_task(host, 20, "header [rollup]\nRss: 8 kB\nPss: 4 kB\n");
+    sysroot_set(host);
+
+    SmapsRollup r;
+    if (read_smaps_rollup(10, &r) != 0 || r.rss_kb != 1416 || r.pss_kb != 467 || r.pss_anon_kb != 100 ||
+        r.pss_file_kb != 367 || r.uss_kb != 168 || r.shared_kb != 1248 || r.swap_kb != 12 || r.swap_pss_kb != 6) {
+        printf("test_memory_accounting: rollup parsed wrong (pss %lu uss %lu)\n", r.pss_kb, r.uss_kb);
+        failed = 1;
+    }
+    if (read_smaps_rollup(30, &r) == 0) {
+        printf("test_memory_accounting: missing pid read\n");
+        failed = 1;
+    }
+    if (mem_acct_percent(&r, 0) != 0.0) failed = 1;
+
+    /* Cache: both read once, then served from the cache until refresh_ms passes */
+    MemAcctCache cache;
+    pid_t sel[2] = { 10, 20 };
+    if (mem_acct_init(&cache, 60000) != 0 || mem_acct_update(&cache, sel, NULL, 2) != 2) {
+        printf("test_memory_accounting: first update failed\n");
+        failed = 1;
+    }
+    add_task(host, 20, "header [rollup]\nRss: 8 kB\nPss: 6 kB\n");
+    int reads = mem_acct_update(&cache, sel, NULL, 2);
+    const SmapsRollup *m = mem_acct_get(&cache, 20);
+    if (reads != 0 || !m || m->pss_kb != 4) {
+        printf("test_memory_accounting: cached entry re-read\n");
+        failed = 1;
+    }
+    /* Dropping 10 from the selection drops its entry */
+    if (mem_acct_update(&cache, &sel[1], NULL, 1) != 0 || mem_acct_get(&cache, 10) || cache.count != 1) {
+        printf("test_memory_accounting: unselected entry kept\n");
+        failed = 1;
+    }
+    /* Same pid, another process: its cached baseline is thrown away at once */
+    unsigned long long start = 4242;
+    m = NULL;
+    if (mem_acct_update(&cache, &sel[1], &start, 1) != 1 || !(m = mem_acct_get(&cache, 20)) || m->pss_kb != 6 ||
+        mem_acct_update(&cache, &sel[1], &start, 1) != 0) {
+        printf("test_memory_accounting: reused pid served from the cache\n");
+        failed = 1;
+    }
+    mem_acct_free(&cache);
+    sysroot_set(NULL);
+
+    /* Top-k by RSS over a hand-built table; kernel threads (rss 0) never qualify */
+    ProcessTreeNode nodes[5];
+    memset(nodes, 0, sizeof(nodes));
+    const struct { int pid; unsigned long rss; const char *name; } t[5] = {
+        { 1, 50, "init" }, { 2, 0, "kthreadd" }, { 3, 900, "postgres" }, { 4, 300, "postgres" }, { 5, 700, "nginx" }
+    };
+    for (int i = 0; i < 5; ++i) {
+        nodes[i].pid = t[i].pid;
+        nodes[i].rss = t[i].rss;
+        snprintf(nodes[i].name, sizeof(nodes[i].name), "%s", t[i].name);
+    }
+    ProcessTree tree;
+    memset(&tree, 0, sizeof(tree));
+    tree.nodes = nodes;
+    tree.capacity = 5;
+    pid_t top[3];
+    int n = mem_acct_select_top_k(&tree, 3, "postgres", top);
+    if (n != 2 || top[0] != 3 || top[1] != 4) {
+        printf("test_memory_accounting: name filter wrong\n");
+        failed = 1;
+    }
+    n = mem_acct_select_top_k(&tree, 2, NULL, top);
+    if (n != 2 || top[0] != 3 || top[1] != 5) {
+        printf("test_memory_accounting: top-k order wrong (%d %d)\n", (int)top[0], (int)top[1]);
+        failed = 1;
+    }
+
+    if (fixture_cleanup(host) != 0) failed = 1;
+    printf("test_memory_accounting: %s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
@@ -0,0 +1,59 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include "../include/namespace_bench.h"
+
+int main(void) {
+    int failed = 0;
+    int flags = -1;
+    if (namespace_bench_parse_flags("none", &flags) != 0 || flags != 0 ||
+        namespace_bench_parse_flags("user+pid", &flags) != 0 || flags != (CLONE_NEWUSER | CLONE_NEWPID) ||
+        namespace_bench_parse_flags("cgroup", &flags) != 0 || flags != CLONE_NEWCGROUP ||
+        namespace_bench_parse_flags("net+bogus", &flags) != -1) {
+        printf("test_namespace_bench: flag parsing wrong\n");
+        failed = 1;
+    }
+
+    /* Plain processes must always work, with every method and two creators */
+    for (int m = 0; m < NS_BENCH_METHOD_COUNT; ++m) {
+        NsBenchCase bc;
+        memset(&bc, 0, sizeof(bc));
+        snprintf(bc.label, sizeof(bc.label), "none");
+        bc.method = (NsBenchMethod)m;
+        bc.threads = 2;
+        bc.iterations = 20;
+        bc.warmup = 2;
+        NsBenchResult r;
+        int rc = namespace_bench_run(&bc, &r);
+        if (m == NS_BENCH_CLONE3 && rc != 0 && r.err == ENOSYS) continue;
+        if (rc != 0 || r.samples != 40 || r.failed != 0 || r.min_us > r.p50_us || r.p50_us > r.p99_us ||
+            r.p99_us > r.max_us || r.ops_per_sec <= 0.0) {
+            printf("test_namespace_bench: %s run wrong (%d samples, err %d)\n",
+                   namespace_bench_method_name(bc.method), r.samples, r.err);
+            failed = 1;
+        }
+    }
+
+    /* A new UTS namespace needs privilege: either it is measured or the error is kept */
+    NsBenchCase bc;
+    memset(&bc, 0, sizeof(bc));
+    snprintf(bc.label, sizeof(bc.label), "uts");
+    namespace_bench_parse_flags("uts", &bc.flags);
+    bc.threads = 1;
+    bc.iterations = 10;
+    NsBenchResult r;
+    if (namespace_bench_run(&bc, &r) == 0) {
+        if (r.samples != 10 || r.c.flags != CLONE_NEWUTS) {
+            printf("test_namespace_bench: uts run wrong\n");
+            failed = 1;
+        }
+    } else if (r.err != EPERM || r.failed != 10) {
+        printf("test_namespace_bench: uts failure not reported (err %d)\n", r.err);
+        failed = 1;
+    }
+
+    printf("test_namespace_bench: %s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
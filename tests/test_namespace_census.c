@@ -0,0 +1,99 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../include/namespace_census.h"
+#include "test_fixture.h"
+
+static const char *types[] = {"mnt", "pid", "net", "ipc", "uts", "user", "cgroup"};
+
+/* <root>/<dir>/ns/<type> for every type; a fake namespace is just an inode */
+static void make_task(const char *root, const char *dir) {
+    char path[600];
+    snprintf(path, sizeof(path), "%s/%s", root, dir);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/%s/ns", root, dir);
+    mkdir(path, 0755);
+    for (int t = 0; t < 7; ++t) {
+        snprintf(path, sizeof(path), "%s/%s/ns/%s", root, dir, types[t]);
+        FILE *f = fopen(path, "w");
+        if (f) fclose(f);
+    }
+}
+
+/* Make <to> share the namespace of <from> (a hard link is the same inode) */
+static void share(const char *root, const char *from, const char *to, const char *type) {
+    char a[600], b[600];
+    snprintf(a, sizeof(a), "%s/%s/ns/%s", root, from, type);
+    snprintf(b, sizeof(b), "%s/%s/ns/%s", root, to, type);
+    unlink(b);
+    if (link(a, b) != 0) perror("link");
+}
+
+int main(void) {
+    int failed = 0;
+    char root[64];
+    if (!fixture_dir(root, sizeof(root), "test_namespace_census")) return 1;
+    /* 1 and 20 share everything but net; 300 has its own everything; "self" is skipped */
+    make_task(root, "1");
+    make_task(root, "20");
+    make_task(root, "300");
+    make_task(root, "self");
+    for (int t = 0; t < 7; ++t) {
+        if (strcmp(types[t], "net") != 0) share(root, "1", "20", types[t]);
+    }
+    /* Threads of 20: tid 20 and tid 21, which has its own mount namespace */
+    char path[600];
+    snprintf(path, sizeof(path), "%s/20/task", root);
+    mkdir(path, 0755);
+    make_task(root, "20/task/20");
+    make_task(root, "20/task/21");
+    for (int t = 0; t < 7; ++t) {
+        share(root, "20", "20/task/20", types[t]);
+        if (strcmp(types[t], "mnt") != 0) share(root, "20", "20/task/21", types[t]);
+    }
+
+    NsCensus c;
+    if (namespace_census(&c, root, 0) != 0) {
+        printf("test_namespace_census: census failed\n");
+        return 1;
+    }
+    if (c.ntasks != 3 || c.per_type[NS_NET] != 3 || c.per_type[NS_MNT] != 2 || c.count != 15 ||
+        c.tasks_per_type[NS_PID] != 3 || c.tasks[0].id != 1 || c.tasks[2].id != 300) {
+        printf("test_namespace_census: counts wrong (tasks %d ns %d net %d mnt %d)\n",
+               c.ntasks, c.count, c.per_type[NS_NET], c.per_type[NS_MNT]);
+        failed = 1;
+    } else {
+        const NsEntry *e = &c.ns[c.tasks[0].ns[NS_PID]];
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/300/ns/uts", root);
+        stat(path, &st);
+        int k = namespace_census_find(&c, st.st_dev, st.st_ino);
+        if (e->nmembers != 2 || c.members[e->first] != 1 || c.members[e->first + 1] != 20 ||
+            k != c.tasks[2].ns[NS_UTS] || c.ns[k].nmembers != 1 || c.ns[k].type != NS_UTS) {
+            printf("test_namespace_census: member lists wrong\n");
+            failed = 1;
+        }
+    }
+    namespace_census_free(&c);
+
+    if (namespace_census(&c, root, 1) != 0 || c.ntasks != 2 || c.per_type[NS_MNT] != 2 ||
+        c.per_type[NS_NET] != 1 || c.tasks[1].id != 21) {
+        printf("test_namespace_census: thread census wrong (tasks %d)\n", c.ntasks);
+        failed = 1;
+    }
+    namespace_census_free(&c);
+
+    if (namespace_type_from_name("mount") != NS_MNT || namespace_type_from_name("bogus") != -1 ||
+        strcmp(namespace_type_name(NS_CGROUP), "cgroup") != 0) {
+        printf("test_namespace_census: type names wrong\n");
+        failed = 1;
+    }
+
+    if (fixture_cleanup(root) != 0) failed = 1;
+
+    printf("test_namespace_census: %s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
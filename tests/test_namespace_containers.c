@@ -0,0 +1,83 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "../include/namespace_containers.h"
+
+static const Container *find_member(const ContainerMonitor *m, pid_t pid) {
+    for (int k = 0; k < m->count; ++k) {
+        if (m->ctr[k].init_pid == pid) return &m->ctr[k];
+    }
+    return NULL;
+}
+
+int main(void) {
+    int failed = 0;
+    int ready[2];
+    if (pipe(ready) != 0) return 1;
+
+    /* A one-process "container": its own UTS namespace, same cgroup as us */
+    pid_t child = fork();
+    if (child == 0) {
+        char ok = unshare(CLONE_NEWUTS) == 0 ? 1 : 0;
+        if (write(ready[1], &ok, 1) != 1) _exit(1);
+        pause();
+        _exit(0);
+    }
+    char ok = 0;
+    if (child < 0 || read(ready[0], &ok, 1) != 1) return 1;
+
+    ContainerMonitor m;
+    if (container_monitor_init(&m) != 0 || container_monitor_refresh(&m) < 0) {
+        printf("test_namespace_containers: init/refresh failed\n");
+        kill(child, SIGKILL);
+        return 1;
+    }
+    int first = m.resolved;
+    if (container_monitor_refresh(&m) < 0 || m.resolved >= first) {
+        printf("test_namespace_containers: second refresh re-read %d of %d tasks\n", m.resolved, first);
+        failed = 1;
+    }
+
+    const Container *self = NULL;
+    for (int k = 0; k < m.count; ++k) {
+        if (m.ctr[k].host) self = &m.ctr[k];
+    }
+    if (!self || self->totals.procs < 1) {
+        printf("test_namespace_containers: no host group\n");
+        failed = 1;
+    }
+    if (ok) {
+        const Container *c = find_member(&m, child);
+        if (!c || c->host || c->totals.procs != 1 || c->totals.threads != 1) {
+            printf("test_namespace_containers: unshared child not found as its own container\n");
+            failed = 1;
+        }
+        kill(child, SIGKILL);
+        waitpid(child, NULL, 0);
+        /* The container disappears with its last process */
+        if (container_monitor_refresh(&m) < 0 || find_member(&m, child)) {
+            printf("test_namespace_containers: exited container still listed\n");
+            failed = 1;
+        }
+    } else {
+        printf("test_namespace_containers: unshare(CLONE_NEWUTS) not permitted, skipping container check\n");
+        kill(child, SIGKILL);
+        waitpid(child, NULL, 0);
+    }
+
+    char id[24];
+    container_format_id(0x0123456789abcdefULL, id, sizeof(id));
+    if (strcmp(id, "c0123456789ab") != 0) {
+        printf("test_namespace_containers: id format wrong (%s)\n", id);
+        failed = 1;
+    }
+    container_monitor_free(&m);
+
+    printf("test_namespace_containers: %s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
@@ -0,0 +1,93 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "../include/namespace_matrix.h"
+
+static int column(const NsMatrix *m, pid_t pid) {
+    for (int i = 0; i < m->npids; ++i) {
+        if (m->pids[i] == pid) return i;
+    }
+    return -1;
+}
+
+int main(void) {
+    int failed = 0;
+    pid_t *pids = NULL;
+    if (namespace_select_pids(NULL, "30,10,20,10", &pids) != 3 || pids[0] != 10 || pids[2] != 30) {
+        printf("test_namespace_matrix: pid list not sorted/deduplicated\n");
+        failed = 1;
+    }
+    free(pids);
+    if (namespace_select_pids(NULL, "12,abc", &pids) != -1 || namespace_select_pids(NULL, "comm=", &pids) != -1) {
+        printf("test_namespace_matrix: bad selector accepted\n");
+        failed = 1;
+    }
+    int n = namespace_select_pids(NULL, "all", &pids);
+    int found = 0;
+    for (int i = 0; i < n; ++i) found |= (pids[i] == getpid());
+    if (n < 1 || !found) {
+        printf("test_namespace_matrix: 'all' misses this process\n");
+        failed = 1;
+    }
+    free(pids);
+
+    /* Two children: one in our UTS namespace, one in a new one */
+    int ready[2];
+    if (pipe(ready) != 0) return 1;
+    pid_t kid[2];
+    for (int k = 0; k < 2; ++k) {
+        kid[k] = fork();
+        if (kid[k] == 0) {
+            char ok = (k == 0 || unshare(CLONE_NEWUTS) == 0) ? 1 : 0;
+            if (write(ready[1], &ok, 1) != 1) _exit(1);
+            pause();
+            _exit(0);
+        }
+    }
+    char ok[2] = { 0, 0 };
+    if (read(ready[0], &ok[0], 1) != 1 || read(ready[0], &ok[1], 1) != 1) return 1;
+    int unshared = ok[0] && ok[1];
+
+    pid_t set[4] = { kid[1], getpid(), kid[0], 999999999 };
+    NsMatrix m;
+    if (namespace_matrix_build(&m, NULL, set, 4) != 0 || m.npids != 3 || m.words != 1) {
+        printf("test_namespace_matrix: build failed or gone PID kept\n");
+        failed = 1;
+    } else {
+        int self = column(&m, getpid()), a = column(&m, kid[0]), b = column(&m, kid[1]);
+        if (!namespace_matrix_shared(&m, NS_NET, self, a) || !namespace_matrix_shared(&m, NS_NET, self, b) ||
+            !namespace_matrix_shared(&m, NS_UTS, self, a)) {
+            printf("test_namespace_matrix: shared namespaces not detected\n");
+            failed = 1;
+        }
+        if (unshared && namespace_matrix_shared(&m, NS_UTS, self, b)) {
+            printf("test_namespace_matrix: separate UTS namespace reported as shared\n");
+            failed = 1;
+        } else if (!unshared) {
+            printf("test_namespace_matrix: unshare(CLONE_NEWUTS) not permitted, skipping split check\n");
+        }
+        /* The net group holds all three columns */
+        int g = m.group_of[NS_NET * m.npids + self];
+        if (g < 0 || m.groups[g].nmembers != 3 || m.groups[g].bits[0] != 7) {
+            printf("test_namespace_matrix: net bitset wrong\n");
+            failed = 1;
+        }
+        if (unshared && m.first[NS_UTS + 1] - m.first[NS_UTS] != 2) {
+            printf("test_namespace_matrix: expected two UTS groups\n");
+            failed = 1;
+        }
+        namespace_matrix_free(&m);
+    }
+    for (int k = 0; k < 2; ++k) {
+        kill(kid[k], SIGKILL);
+        waitpid(kid[k], NULL, 0);
+    }
+
+    printf("test_namespace_matrix: %s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
@@ -0,0 +1,109 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include "../include/netns_stats.h"
+
+/* One RTM_NEWLINK message with a name and 64-bit stats, then NLMSG_DONE */
+static size_t build_dump(char *buf, size_t len) {
+    memset(buf, 0, len);
+    struct nlmsghdr *h = (struct nlmsghdr *)buf;
+    struct ifinfomsg *ifi = NLMSG_DATA(h);
+    ifi->ifi_index = 7;
+    struct rtattr *a = IFLA_RTA(ifi);
+    a->rta_type = IFLA_IFNAME;
+    a->rta_len = RTA_LENGTH(5);
+    memcpy(RTA_DATA(a), "veth0", 5);
+    size_t alen = RTA_ALIGN(a->rta_len);
+    a = (struct rtattr *)((char *)a + RTA_ALIGN(a->rta_len));
+    a->rta_type = IFLA_STATS64;
+    a->rta_len = RTA_LENGTH(sizeof(struct rtnl_link_stats64));
+    struct rtnl_link_stats64 st;
+    memset(&st, 0, sizeof(st));
+    st.rx_bytes = 1000;
+    st.tx_bytes = 2000;
+    st.rx_dropped = 3;
+    memcpy(RTA_DATA(a), &st, sizeof(st));
+    alen += RTA_ALIGN(a->rta_len);
+    h->nlmsg_type = RTM_NEWLINK;
+    h->nlmsg_len = NLMSG_LENGTH(sizeof(*ifi)) + alen;
+    struct nlmsghdr *done = (struct nlmsghdr *)(buf + NLMSG_ALIGN(h->nlmsg_len));
+    done->nlmsg_type = NLMSG_DONE;
+    done->nlmsg_len = NLMSG_LENGTH(sizeof(int));
+    return NLMSG_ALIGN(h->nlmsg_len) + done->nlmsg_len;
+}
+
+static const NetnsEntry *find_ns(const NetnsCollector *c, ino_t ino) {
+    for (int i = 0; i < c->count; ++i) {
+        if (c->ns[i].ino == ino) return &c->ns[i];
+    }
+    return NULL;
+}
+
+int main(void) {
+    int failed = 0;
+    char buf[1024];
+    NetnsLink *links = NULL;
+    int n = 0, cap = 0;
+    size_t len = build_dump(buf, sizeof(buf));
+    if (netns_parse_links(buf, len, &links, &n, &cap) != 1 || n != 1 || links[0].ifindex != 7 ||
+        strcmp(links[0].name, "veth0") != 0 || links[0].st.rx_bytes != 1000 ||
+        links[0].st.tx_bytes != 2000 || links[0].st.rx_dropped != 3) {
+        printf("test_netns_stats: parse wrong (n %d)\n", n);
+        failed = 1;
+    }
+    free(links);
+
+    /* A child in its own network namespace must show up with its loopback */
+    int ready[2];
+    if (pipe(ready) != 0) return 1;
+    pid_t child = fork();
+    if (child == 0) {
+        char ok = unshare(CLONE_NEWNET) == 0 ? 1 : 0;
+        if (write(ready[1], &ok, 1) != 1) _exit(1);
+        pause();
+        _exit(0);
+    }
+    char ok = 0;
+    if (child < 0 || read(ready[0], &ok, 1) != 1) return 1;
+    char path[64];
+    struct stat st;
+    snprintf(path, sizeof(path), "/proc/%d/ns/net", (int)child);
+    ino_t child_ino = (stat(path, &st) == 0) ? st.st_ino : 0;
+
+    NetnsCollector c;
+    if (netns_collector_init(&c) != 0 || netns_collector_rescan(&c) < 1 || netns_collector_tick(&c) < 1) {
+        printf("test_netns_stats: collector failed on the host namespace\n");
+        failed = 1;
+    } else if (!find_ns(&c, c.self_ino) || find_ns(&c, c.self_ino)->nlinks < 1) {
+        printf("test_netns_stats: own namespace has no links\n");
+        failed = 1;
+    }
+    if (ok && !failed) {
+        const NetnsEntry *e = find_ns(&c, child_ino);
+        if (!e || e->sock < 0 || e->nlinks != 1 || strcmp(e->links[0].name, "lo") != 0) {
+            printf("test_netns_stats: child namespace not sampled (%s)\n", e ? "no links" : "not found");
+            failed = 1;
+        }
+    } else if (!ok) {
+        printf("test_netns_stats: unshare(CLONE_NEWNET) not permitted, skipping namespace check\n");
+    }
+    kill(child, SIGKILL);
+    waitpid(child, NULL, 0);
+    /* Its socket must not keep the namespace around once nobody is in it */
+    if (ok && !failed && (netns_collector_rescan(&c) < 0 || find_ns(&c, child_ino))) {
+        printf("test_netns_stats: exited namespace still held\n");
+        failed = 1;
+    }
+    netns_collector_free(&c);
+
+    printf("test_netns_stats: %s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
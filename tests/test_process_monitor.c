@@ -0,0 +1,63 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "../include/process_monitor.h"
+#include "../include/sysroot.h"
+#include "test_fixture.h"
+
+/* comm "a) b (c" as the kernel prints it: only the last ')' ends the name */
+#define STAT_LINE "4242 (a) b (c) S 1 4242 4242 0 -1 4194560 120 0 0 0 " \
+                  "35 12 0 0 20 0 3 0 9876 10485760 256 18446744073709551615 1 1 0 0 0 0 0 0 0 0 0 0 17 0 0 0\n"
+
+int main(void) {
+    int failed = 0;
+    ProcessStats st;
+    memset(&st, 0, sizeof(st));
+    if (parse_process_stat(STAT_LINE, &st) != 0 || strcmp(st.name, "a) b (c") != 0 || st.state != 'S' ||
+        st.ppid != 1 || st.utime != 35 || st.stime != 12 || st.num_threads != 3 || st.vsize != 10485760 ||
+        st.rss != 256) {
+        printf("test_process_monitor: parse wrong (name '%s' state %c utime %lu rss %lu)\n", st.name, st.state,
+               st.utime, st.rss);
+        failed = 1;
+    }
+    if (parse_process_stat("4242 (truncated", &st) == 0 || parse_process_stat("4242 (x) S 1 2", &st) == 0 ||
+        parse_process_stat("1 (x) ", &st) == 0 || parse_process_stat("1 (x)", &st) == 0) {
+        printf("test_process_monitor: malformed line accepted\n");
+        failed = 1;
+    }
+
+    /* Batch over a fixture /proc: one good PID, one gone, one unparsable */
+    char host[64], dir[128];
+    if (!fixture_dir(host, sizeof(host), "test_process_monitor")) return 1;
+    snprintf(dir, sizeof(dir), "%s/proc", host);
+    mkdir(dir, 0755);
+    snprintf(dir, sizeof(dir), "%s/proc/4242", host);
+    mkdir(dir, 0755);
+    fixture_put(dir, "stat", STAT_LINE);
+    snprintf(dir, sizeof(dir), "%s/proc/77", host);
+    mkdir(dir, 0755);
+    fixture_put(dir, "stat", "garbage\n");
+    sysroot_set(host);
+
+    ProcessStatsContext ctx = { 1000, 4096, 100 };
+    pid_t pids[3] = { 4242, 5555, 77 };
+    ProcessStats out[3];
+    int status[3] = { 1, 1, 1 };
+    int ok = read_process_stats_batch(&ctx, pids, 3, out, status);
+    if (ok != 1 || status[0] != 0 || status[1] != -ENOENT || status[2] != -EINVAL || out[0].pid != 4242 ||
+        out[0].mem_percent < 102.3 || out[0].mem_percent > 102.5) {
+        printf("test_process_monitor: batch returned %d, status %d/%d/%d\n", ok, status[0], status[1], status[2]);
+        failed = 1;
+    }
+    if (read_process_stats(5555, &st) == 0 || read_process_stats(4242, &st) != 0 || st.rss != 256) {
+        printf("test_process_monitor: read_process_stats wrong\n");
+        failed = 1;
+    }
+    sysroot_set(NULL);
+
+    if (fixture_cleanup(host) != 0) failed = 1;
+    printf("test_process_monitor: %s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
@@ -0,0 +1,38 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include "../include/process_tree.h"
+
+int main(void) {
+    /* Fork a child and check it is linked under us and counted in our subtree */
+    pid_t child = fork();
+    if (child == 0) { pause(); _exit(0); }
+
+    ProcessTree tree;
+    if (process_tree_init(&tree) != 0 || process_tree_refresh(&tree) <= 0) {
+        printf("test_process_tree: refresh failed (may not be Linux)\n");
+        kill(child, SIGKILL); waitpid(child, NULL, 0);
+        return 1;
+    }
+    const ProcessTreeNode *c = process_tree_find(&tree, child);
+    ProcessTreeTotals t;
+    int ok = c && c->ppid == getpid() &&
+             process_tree_subtree_totals(&tree, getpid(), &t) == 0 && t.procs >= 2;
+
+    kill(child, SIGKILL);
+    waitpid(child, NULL, 0);
+    process_tree_refresh(&tree);
+    ok = ok && process_tree_find(&tree, child) == NULL &&
+         process_tree_subtree_totals(&tree, getpid(), &t) == 0 && t.procs == 1;
+    process_tree_free(&tree);
+
+    if (!ok) {
+        printf("test_process_tree: parent/child map not updated as expected\n");
+        return 1;
+    }
+    printf("test_process_tree: OK (child linked, removed after exit)\n");
+    return 0;
+}
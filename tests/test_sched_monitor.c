@@ -0,0 +1,57 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <unistd.h>
+#include "../include/sched_monitor.h"
+
+static const char *fixture =
+    "version 15\n"
+    "timestamp 4295000000\n"
+    "cpu0 0 0 1000 200 500 300 9000000000 1000000000 4000\n"
+    "domain0 00000003 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20 21 22 23 24 25 26 27 28 29 30 31 32 33 34 35 36\n"
+    "cpu1 0 0 800 100 400 250 7000000000 3000000000 2000\n";
+
+int main(void) {
+    CpuSchedStat cpus[4];
+    int version = 0;
+    int n = sched_parse_system(fixture, cpus, 4, &version);
+    if (n != 2 || version != 15 || cpus[1].cpu != 1 || cpus[1].s.wait_ns != 3000000000ULL || cpus[0].s.timeslices != 4000) {
+        printf("test_sched_monitor: parse failed (n=%d version=%d)\n", n, version);
+        return 1;
+    }
+    if (sched_parse_system("version 10\ncpu0 1 2 3 4 5 6 7 8 9\n", cpus, 4, &version) != -1) {
+        printf("test_sched_monitor: old schedstat version accepted\n");
+        return 1;
+    }
+
+    SchedStat a = {1000000, 500000, 10}, b = {3000000, 1500000, 20};
+    SchedDelta d;
+    sched_delta(&a, &b, &d);
+    if (d.timeslices != 10 || d.wait_run_ratio != 0.5 || d.avg_wait_us != 100.0) {
+        printf("test_sched_monitor: delta wrong (ratio %.3f avg %.3f)\n", d.wait_run_ratio, d.avg_wait_us);
+        return 1;
+    }
+    /* An exiting thread makes the summed counters go backwards */
+    sched_delta(&b, &a, &d);
+    if (d.run_ms != 0.0 || d.timeslices != 0) {
+        printf("test_sched_monitor: negative delta not clamped\n");
+        return 1;
+    }
+
+    SchedHistogram h = {0};
+    SchedDelta fast = {0, 0, 99, 0, 3.0}, slow = {0, 0, 1, 0, 5000.0};
+    sched_hist_add(&h, &fast);
+    sched_hist_add(&h, &slow);
+    if (h.count != 100 || sched_hist_percentile(&h, 50) != 4.0 || sched_hist_percentile(&h, 100) != 8192.0) {
+        printf("test_sched_monitor: histogram wrong (p50 %.0f p100 %.0f)\n",
+               sched_hist_percentile(&h, 50), sched_hist_percentile(&h, 100));
+        return 1;
+    }
+
+    SchedStat self;
+    if (read_process_schedstat(getpid(), &self) != 0 || self.timeslices == 0) {
+        printf("test_sched_monitor: could not read own schedstat\n");
+        return 1;
+    }
+    printf("test_sched_monitor: OK\n");
+    return 0;
+}
@@ -0,0 +1,104 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../include/sysroot.h"
+#include "../include/monitors.h"
+#include "test_fixture.h"
+
+static int write_text(const char *path, const char *text) {
+    FILE *f = fopen(path, "w");
+    if (!f) return -1;
+    fputs(text, f);
+    return fclose(f);
+}
+
+int main(void) {
+    int failed = 0;
+    char buf[512];
+    unsetenv("RESMON_ROOT");
+    unsetenv("RESMON_PROC_ROOT");
+    unsetenv("RESMON_SYS_ROOT");
+    sysroot_set(NULL);
+    if (sysroot_path(buf, sizeof(buf), "/proc/1/stat") != 0 || strcmp(buf, "/proc/1/stat") != 0 ||
+        strcmp(sysroot_cgroup(), "/sys/fs/cgroup") != 0 || sysroot_overridden()) {
+        printf("test_sysroot: live paths changed\n");
+        failed = 1;
+    }
+
+    char host[64];
+    if (!fixture_dir(host, sizeof(host), "test_sysroot")) return 1;
+    char path[600];
+    snprintf(path, sizeof(path), "%s/proc", host);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/proc/stat", host);
+    write_text(path, "cpu  100 0 50 800 10 0 0 0 0 0\n");
+
+    sysroot_set(host);
+    char want[600];
+    snprintf(want, sizeof(want), "%s/sys/fs/cgroup", host);
+    if (sysroot_path(buf, sizeof(buf), "/proc/stat") != 0 || strcmp(buf, path) != 0 ||
+        strcmp(sysroot_cgroup(), want) != 0 || !sysroot_overridden()) {
+        printf("test_sysroot: root not applied (%s)\n", buf);
+        failed = 1;
+    }
+    /* The monitor's own entries and unrelated paths stay where they are */
+    if (sysroot_path(buf, sizeof(buf), "/proc/self/stat") != 0 || strcmp(buf, "/proc/self/stat") != 0 ||
+        sysroot_path(buf, sizeof(buf), "/procfs/x") != 0 || strcmp(buf, "/procfs/x") != 0) {
+        printf("test_sysroot: /proc/self or a lookalike prefix redirected\n");
+        failed = 1;
+    }
+    setenv("RESMON_PROC_ROOT", "/somewhere/proc", 1);
+    sysroot_set(NULL);
+    if (strcmp(sysroot_proc(), "/somewhere/proc") != 0 || strcmp(sysroot_sys(), "/sys") != 0 ||
+        sysroot_sys_overridden()) {
+        printf("test_sysroot: RESMON_PROC_ROOT ignored\n");
+        failed = 1;
+    }
+    unsetenv("RESMON_PROC_ROOT");
+
+    /* Record two ticks through a real collector, change the file in between */
+    char rec[600];
+    snprintf(rec, sizeof(rec), "%s/rec", host);
+    sysroot_set(host);
+    CPUStats s;
+    if (sysroot_record_start(rec, 250) != 0 || sysroot_next_tick() != 1 || read_cpu_stats(&s) != 0 ||
+        s.user != 100) {
+        printf("test_sysroot: record tick 1 failed\n");
+        failed = 1;
+    }
+    write_text(path, "cpu  300 0 50 900 10 0 0 0 0 0\n");
+    if (sysroot_next_tick() != 2 || read_cpu_stats(&s) != 0 || s.user != 300) {
+        printf("test_sysroot: record tick 2 failed\n");
+        failed = 1;
+    }
+    sysroot_record_stop();
+    write_text(path, "cpu  999 0 50 900 10 0 0 0 0 0\n");
+
+    int interval = 0;
+    sysroot_set(NULL);
+    if (sysroot_replay_start(rec, &interval) != 2 || interval != 250) {
+        printf("test_sysroot: recording not found (interval %d)\n", interval);
+        failed = 1;
+    }
+    unsigned long long seen[2] = { 0, 0 };
+    for (int i = 0; i < 2; ++i) {
+        if (sysroot_next_tick() != i + 1 || read_cpu_stats(&s) != 0) break;
+        seen[i] = s.user;
+    }
+    if (seen[0] != 100 || seen[1] != 300 || sysroot_next_tick() != -1) {
+        printf("test_sysroot: replay returned %llu,%llu\n", seen[0], seen[1]);
+        failed = 1;
+    }
+    sysroot_replay_stop();
+    if (sysroot_overridden()) {
+        printf("test_sysroot: replay_stop left the roots moved\n");
+        failed = 1;
+    }
+
+    if (fixture_cleanup(host) != 0) failed = 1;
+    printf("test_sysroot: %s\n", failed ? "FAILED" : "OK");
+    return failed;
+}